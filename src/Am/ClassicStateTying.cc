@@ -14,7 +14,9 @@
  */
 #include <Fsa/Static.hh>
 
+#include <Core/Application.hh>
 #include <Core/CompressedStream.hh>
+#include <Core/MD5.hh>
 
 #include "ClassicAcousticModel.hh"
 #include "ClassicStateTying.hh"
@@ -62,6 +64,104 @@ void EmissionAlphabet::writeXml(Core::XmlWriter& os) const {
 const Core::ParameterString ClassicStateTying::paramFilename(
         "file",
         "external source defining the state tying");
+const Core::ParameterBool ClassicStateTying::paramCompileTable(
+        "compiled-table",
+        "compile the state tying of all allophone states into a dense table for lock-free lookup",
+        true);
+const Core::ParameterString ClassicStateTying::paramCacheArchive(
+        "cache-archive",
+        "cache archive in which the compiled state tying table should be cached",
+        "global-cache");
+
+namespace {
+const std::string stateTyingTableMagic   = "SPRINT-STATE-TYING";
+const u32         stateTyingTableVersion = 1;
+const std::string stateTyingTableEntry   = "state-tying-table";
+}  // namespace
+
+/**
+ * Checksum over the allophone states of the alphabet, which identifies
+ * the allophone state indices of a compiled table.
+ */
+u64 ClassicStateTying::allophoneStatesChecksum(u32& nAllophones, u32& nStates) const {
+    const u64            prime = 1099511628211ull;
+    u64                  hash  = 14695981039346656037ull;
+    AllophoneState::Hash ash;
+    nAllophones = nStates = 0;
+    std::pair<AllophoneStateIterator, AllophoneStateIterator> it = alphabetRef_->allophoneStates();
+    for (; it.first != it.second; ++it.first) {
+        AllophoneStateIndex index = it.first.id();
+        AllophoneState      as    = it.first.allophoneState();
+        nAllophones = std::max(nAllophones, (u32(index) & ~u32(AllophoneStateAlphabet::StateMask)) + 1);
+        nStates     = std::max(nStates, u32(as.state()) + 1);
+        hash        = (hash ^ u32(index)) * prime;
+        hash        = (hash ^ ash(as)) * prime;
+    }
+    return hash;
+}
+
+bool ClassicStateTying::readTable(u32 checksum, u64 allophonesChecksum, u32 nAllophones, u32 nStates) {
+    Core::MappedArchiveReader in = Core::Application::us()->getCacheArchiveReader(paramCacheArchive(config), stateTyingTableEntry);
+    if (!in.good())
+        return false;
+    if (!in.check<std::string>(stateTyingTableMagic, "magic token") ||
+        !in.check<u32>(stateTyingTableVersion, "format version") ||
+        !in.check<u32>(checksum, "dependency checksum") ||
+        !in.check<u64>(allophonesChecksum, "allophone checksum") ||
+        !in.check<u32>(nAllophones, "number of allophones") ||
+        !in.check<u32>(nStates, "number of states"))
+        return false;
+    Core::ConstantVector<Mm::MixtureIndex> table;
+    in >> table;
+    if (!in.good() || table.size() != size_t(nAllophones) * nStates)
+        return false;
+    table_            = table;
+    nTableAllophones_ = nAllophones;
+    return true;
+}
+
+bool ClassicStateTying::writeTable(u32 checksum, u64 allophonesChecksum, u32 nAllophones, u32 nStates) const {
+    Core::MappedArchiveWriter out = Core::Application::us()->getCacheArchiveWriter(paramCacheArchive(config), stateTyingTableEntry);
+    if (!out.good())
+        return false;
+    out << stateTyingTableMagic << stateTyingTableVersion << checksum << allophonesChecksum << nAllophones << nStates;
+    out.writeVector(table_);
+    return out.good();
+}
+
+void ClassicStateTying::compileTable() {
+    u32 nAllophones, nStates;
+    u64 allophonesChecksum = allophoneStatesChecksum(nAllophones, nStates);
+    if (nAllophones == 0)
+        return;
+    Core::DependencySet dependencies;
+    getDependencies(dependencies);
+    u32 checksum = dependencies.getChecksum();
+
+    if (readTable(checksum, allophonesChecksum, nAllophones, nStates)) {
+        log("mapped compiled state tying table of %d allophones from cache", nAllophones);
+        return;
+    }
+
+    table_ = Core::ConstantVector<Mm::MixtureIndex>();
+    table_.resize(size_t(nAllophones) * nStates, Mm::invalidMixture);
+    u32                                                       nUndefined = 0;
+    std::pair<AllophoneStateIterator, AllophoneStateIterator> it         = alphabetRef_->allophoneStates();
+    for (; it.first != it.second; ++it.first) {
+        u32              index = it.first.id();
+        u32              state = (index & AllophoneStateAlphabet::StateMask) >> stateShift;
+        Mm::MixtureIndex mix;
+        // undefined allophone states stay invalid and are reported when they are classified
+        if (tableEntry(index, mix))
+            table_.edit(size_t(state) * nAllophones + (index & ~u32(AllophoneStateAlphabet::StateMask))) = mix;
+        else
+            ++nUndefined;
+    }
+    nTableAllophones_ = nAllophones;
+    log("compiled state tying table of %d allophones and %d states, %d allophone states undefined", nAllophones, nStates, nUndefined);
+    if (!writeTable(checksum, allophonesChecksum, nAllophones, nStates))
+        log("compiled state tying table not cached");
+}
 
 Core::Ref<const ClassicStateTying> ClassicStateTying::createClassicStateTyingRef(
         const Core::Configuration& config, ClassicStateModelRef stateModelRef) {
@@ -175,6 +275,11 @@ bool LutStateTying::loadLut(const std::string& filename) {
     nClasses_ = topMixtureId + 1;
     progress->finish();
     delete progress;
+    Core::MD5 md5;
+    if (md5.updateFromFile(filename))
+        dependency_.setValue(md5);
+    else
+        warning("could not derive md5 sum from file '%s'", filename.c_str());
     return true;
 }
 
@@ -19,7 +19,9 @@
 #include <Bliss/Fsa.hh>
 #include <Bliss/Phonology.hh>
 #include <Core/Component.hh>
+#include <Core/Dependency.hh>
 #include <Core/Hash.hh>
+#include <Core/MappedArchive.hh>
 #include <Core/Parameter.hh>
 #include <Core/ReferenceCounting.hh>
 #include <Core/Version.hh>
@@ -64,29 +66,85 @@ public:
 };
 typedef Core::Ref<const EmissionAlphabet> ConstEmissionAlphabetRef;
 
+/** Position of the lowest set bit of a non-zero mask. */
+constexpr u32 lowestSetBit(u32 mask) {
+    return (mask & 1) ? 0 : 1 + lowestSetBit(mask >> 1);
+}
+
 class ClassicStateTying : public virtual Core::Component,
                           public Core::ReferenceCounted {
 public:
     static const Core::ParameterString paramFilename;
+    static const Core::ParameterBool   paramCompileTable;
+    static const Core::ParameterString paramCacheArchive;
 
 private:
     typedef Core::HashMap<AllophoneStateIndex, Mm::MixtureIndex> CacheMap;
     mutable CacheMap                                             classifyIndexCache_;
 
+    /**
+     * Dense table of the mixtures of all allophone states known at
+     * compilation, indexed by state * nTableAllophones_ + allophone index;
+     * invalidMixture for allophone states which do not exist.
+     * The table is either owned or mapped from the cache archive.
+     */
+    Core::ConstantVector<Mm::MixtureIndex> table_;
+    u32                                    nTableAllophones_;
+    /** position of the state in an allophone state index */
+    static const u32 stateShift = lowestSetBit(AllophoneStateAlphabet::StateMask);
+
+    u64  allophoneStatesChecksum(u32& nAllophones, u32& nStates) const;
+    bool readTable(u32 checksum, u64 allophonesChecksum, u32 nAllophones, u32 nStates);
+    bool writeTable(u32 checksum, u64 allophonesChecksum, u32 nAllophones, u32 nStates) const;
+
 protected:
     ConstAllophoneStateAlphabetRef alphabetRef_;
     mutable Core::Channel          classifyDumpChannel_;
 
+    /**
+     * Compiles the mixtures of all allophone states of the alphabet into
+     * the dense table, or maps the table from the cache archive if it was
+     * compiled for the same dependencies and allophones before.
+     * Called at the end of the constructor of state tyings with expensive
+     * classify(), if compiled-table is set.
+     */
+    void compileTable();
+
+    /**
+     * Mixture of an allophone state for the compiled table, false if the
+     * state tying does not define the allophone state.  Must not report
+     * errors, all allophone states of the alphabet are probed.
+     */
+    virtual bool tableEntry(AllophoneStateIndex index, Mm::MixtureIndex& mix) const {
+        mix = classify(alphabetRef_->allophoneState(index));
+        return true;
+    }
+
+    /** Table lookup without locking; invalidMixture if not in the table. */
+    Mm::MixtureIndex tableClassifyIndex(AllophoneStateIndex index) const {
+        u32    allophone = u32(index) & ~u32(AllophoneStateAlphabet::StateMask);
+        size_t i         = size_t((u32(index) & AllophoneStateAlphabet::StateMask) >> stateShift) * nTableAllophones_ + allophone;
+        return ((allophone < nTableAllophones_) && (i < table_.size())) ? table_[i] : Mm::invalidMixture;
+    }
+
 public:
     ClassicStateTying(const Core::Configuration& config, ClassicStateModelRef stateModel)
             : Core::Component(config),
+              nTableAllophones_(0),
               alphabetRef_(stateModel->getAllophoneStateAlphabet()),
               classifyDumpChannel_(config, "dump-state-tying") {}
     virtual ~ClassicStateTying() {}
     virtual void             getDependencies(Core::DependencySet&) const {}
     virtual Mm::MixtureIndex nClasses() const                         = 0;
     virtual Mm::MixtureIndex classify(const AllophoneState& as) const = 0;
+    /**
+     * Thread-safe for all allophone states in the compiled table;
+     * other allophone states are classified and memoized.
+     */
     virtual Mm::MixtureIndex classifyIndex(AllophoneStateIndex index) const {
+        Mm::MixtureIndex mix = tableClassifyIndex(index);
+        if (mix != Mm::invalidMixture)
+            return mix;
         CacheMap::const_iterator iter = classifyIndexCache_.find(index);
         if (iter == classifyIndexCache_.end()) {
             Mm::MixtureIndex mix       = classify(alphabetRef_->allophoneState(index));
@@ -99,6 +157,9 @@ public:
     ConstAllophoneStateAlphabetRef allophoneStateAlphabet() const {
         return alphabetRef_;
     }
+    bool hasCompiledTable() const {
+        return table_.size() > 0;
+    }
 
     /*
      //TODO
@@ -191,6 +252,7 @@ private:
 private:
     Mm::MixtureIndex nClasses_;
     LookupTable      lut_;
+    Core::Dependency dependency_;
 
 private:
     bool loadLut(const std::string& filename);
@@ -204,17 +266,34 @@ public:
             error("error while reading lookup table from file \"%s\"", paramFilename(config).c_str());
             return;
         }
+        if (paramCompileTable(config))
+            compileTable();
     }
 
     Mm::MixtureIndex nClasses() const {
         return nClasses_;
     }
 
+    virtual void getDependencies(Core::DependencySet& d) const {
+        d.add(name(), dependency_);
+    }
+
+    bool tableEntry(AllophoneStateIndex index, Mm::MixtureIndex& mix) const {
+        LookupTable::const_iterator it = lut_.find(index);
+        if (it == lut_.end())
+            return false;
+        mix = it->second;
+        return true;
+    }
+
     Mm::MixtureIndex classify(const AllophoneState& as) const {
         return classifyIndex(alphabetRef_->index(as));
     }
 
     Mm::MixtureIndex classifyIndex(AllophoneStateIndex index) const {
+        Mm::MixtureIndex mix = tableClassifyIndex(index);
+        if (mix != Mm::invalidMixture)
+            return mix;
         LookupTable::const_iterator it = lut_.find(index);
         if (it != lut_.end()) {
             return it->second;
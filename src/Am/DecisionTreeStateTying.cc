@@ -36,6 +36,8 @@ DecisionTreeStateTying::DecisionTreeStateTying(const Core::Configuration& config
     log("dependency value: %s", std::string(md5).c_str());
 
     props_ = new Properties(tree_.getMap());
+    if (paramCompileTable(config))
+        compileTable();
 }
 
 DecisionTreeStateTying::~DecisionTreeStateTying() {
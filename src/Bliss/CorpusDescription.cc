@@ -616,9 +616,7 @@ void CorpusDescription::accept(CorpusVisitor* visitor) {
     parser.accept(file(), visitor);
 }
 
-u32 CorpusDescription::totalSegmentCount() {
-    SegmentCountingVisitor* counter = new SegmentCountingVisitor();
-    counter->reset();
+void CorpusDescription::acceptWithoutReporting(CorpusVisitor* visitor) {
     // Note: An accept() call is problematic because we don't
     // want certain side-effects like the reporter or the indicator.
     // Also, it would change the internal state of ordering,
@@ -626,7 +624,6 @@ u32 CorpusDescription::totalSegmentCount() {
     SegmentOrderingVisitor* ordering = ordering_ ? ordering_->copy() : 0;
     {
         CorpusDescriptionParser parser(config);
-        CorpusVisitor*          visitor = counter;
         if (selector_) {
             selector_->setVisitor(visitor);
             visitor = selector_;
@@ -638,6 +635,12 @@ u32 CorpusDescription::totalSegmentCount() {
         parser.accept(file(), visitor);
     }
     delete ordering;
+}
+
+u32 CorpusDescription::totalSegmentCount() {
+    SegmentCountingVisitor* counter = new SegmentCountingVisitor();
+    counter->reset();
+    acceptWithoutReporting(counter);
     u32 nSegments = counter->nSegments();
     delete counter;
     return nSegments;
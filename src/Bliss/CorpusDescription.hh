@@ -606,6 +606,14 @@ public:
      */
     void accept(CorpusVisitor*);
 
+    /**
+     * Traverse corpus with the same segment selection and order as
+     * accept(), but without progress reporting and indication and
+     * without changing the state of the segment ordering.
+     * Used for look-ahead passes over the corpus.
+     */
+    void acceptWithoutReporting(CorpusVisitor*);
+
     u32 totalSegmentCount();
 };
 
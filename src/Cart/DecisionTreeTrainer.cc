@@ -130,6 +130,7 @@ private:
     typedef DecisionTreeTrainer::TrainingPlan TrainingPlan;
 
     bool parallel_;
+    bool useStatistics_;
 
     /**
      * Collection of some information about
@@ -157,13 +158,16 @@ private:
     typedef std::vector<QuestionStatistic> QuestionStatisticList;
 
     /**
-     * A node together with associated examples.
+     * A node together with associated examples;
+     * if splits are searched on sufficient statistics, exampleIds
+     * holds the index of each example in examplePtrs.
      */
     struct Node {
-        u32             depth;
-        Score           score;
-        u32             nObs;
-        ExamplePtrList* examplePtrs;
+        u32              depth;
+        Score            score;
+        u32              nObs;
+        ExamplePtrList*  examplePtrs;
+        std::vector<u32> exampleIds;
 
         QuestionId questionId;
         u32        order;
@@ -349,6 +353,18 @@ private:
     QuestionIdList         questionIdMap_;
     ClusterPtrList         clusters_;
 
+    /**
+     * Sufficient statistics:
+     * per example the number of observations and the statistics of the scorer
+     * (example-major), per question the answers as bit mask over the examples.
+     */
+    typedef std::vector<u64> AnswerMask;
+    ExamplePtrList          examplePtrs_;
+    std::vector<f64>        exampleNObs_;
+    size_t                  nStatistics_;
+    std::vector<f64>        statistics_;
+    std::vector<AnswerMask> answers_;
+
 private:
     Node* init() {
         ExamplePtrList*          examplePtrs  = new ExamplePtrList(examples_.size());
@@ -365,9 +381,53 @@ private:
         }
         Node* root  = new Node(0, score_, nObs_, examplePtrs);
         root->order = nNumber_++;
+        if (useStatistics_)
+            initStatistics(root);
         return root;
     }
 
+    /**
+     * collect the sufficient statistics of all examples
+     */
+    void initStatistics(Node* root) {
+        examplePtrs_ = *root->examplePtrs;
+        root->exampleIds.resize(examplePtrs_.size());
+        for (u32 id = 0; id < root->exampleIds.size(); ++id)
+            root->exampleIds[id] = id;
+        if (examplePtrs_.empty())
+            return;
+        nStatistics_ = scorer_.nStatistics(*examplePtrs_.front());
+        exampleNObs_.resize(examplePtrs_.size());
+        statistics_.resize(examplePtrs_.size() * nStatistics_);
+        for (size_t id = 0; id < examplePtrs_.size(); ++id) {
+            verify(scorer_.nStatistics(*examplePtrs_[id]) == nStatistics_);
+            exampleNObs_[id] = examplePtrs_[id]->nObs;
+            scorer_.statistics(*examplePtrs_[id], &statistics_[id * nStatistics_]);
+        }
+        log() << Core::XmlFull("sufficient-statistics", nStatistics_) + Core::XmlAttribute("nExamples", examplePtrs_.size());
+    }
+
+    /**
+     * answer the questions added since the last call for all examples
+     */
+    void updateAnswers() {
+        const size_t nWords = (examplePtrs_.size() + 63) / 64;
+        const size_t first  = answers_.size();
+        answers_.resize(questionRefs_.size(), AnswerMask(nWords, 0));
+#pragma omp parallel for schedule(dynamic) if (parallel_)
+        for (size_t questionId = first; questionId < answers_.size(); ++questionId) {
+            const Question& question = *(questionRefs_[questionId]);
+            AnswerMask&     answers  = answers_[questionId];
+            for (size_t id = 0; id < examplePtrs_.size(); ++id)
+                if (question(*(examplePtrs_[id]->properties)) == RASR_TRUE)
+                    answers[id >> 6] |= u64(1) << (id & 63);
+        }
+    }
+
+    static bool isAnswerTrue(const AnswerMask& answers, u32 id) {
+        return (answers[id >> 6] >> (id & 63)) & 1;
+    }
+
     void writeXml(Core::XmlWriter& xml, const Split& split) {
         xml << Core::XmlOpen("split")
             << Core::XmlFull("depth", split.node->depth)
@@ -397,6 +457,8 @@ private:
     Split* splitNode(Node* node, QuestionIdList* questionIds, bool strict = false) {
         if (node->nObs < 2 * step_->minObs)
             return 0;
+        if (useStatistics_)
+            return splitNodeOnStatistics(node, questionIds, strict);
 
         ExamplePtrList* examplePtrs = node->examplePtrs;
 
@@ -524,6 +586,115 @@ private:
         return split;
     }
 
+    /**
+     * same as splitNode(), but the examples are not partitioned for each question:
+     * the statistics of both children are accumulated from the precomputed statistics,
+     * selected by the answer mask of the question.
+     * Questions are evaluated in parallel, each by a single thread, and the hypotheses
+     * are collected in question order afterwards; thus, the result does not depend on
+     * the number of threads.
+     */
+    Split* splitNodeOnStatistics(Node* node, QuestionIdList* questionIds, bool strict) {
+        enum Status { rejected,
+                      accepted,
+                      negativeGain };
+        const std::vector<u32>&      exampleIds = node->exampleIds;
+        std::vector<SplitHypothesis> splitHyps(questionIds->size());
+        std::vector<u8>              status(questionIds->size(), rejected);
+        verify(splitHyps_.empty());
+
+#pragma omp parallel if (parallel_)
+        {
+            std::vector<f64> leftStatistics(nStatistics_), rightStatistics(nStatistics_);
+#pragma omp for schedule(dynamic)
+            for (size_t questionIdId = 0; questionIdId < questionIds->size(); ++questionIdId) {
+                const AnswerMask& answers  = answers_[(*questionIds)[questionIdId]];
+                SplitHypothesis&  splitHyp = splitHyps[questionIdId];
+                splitHyp.questionIdId      = questionIdId;
+                splitHyp.nLeftExamples = splitHyp.nRightExamples = 0;
+                splitHyp.nLeftObs = splitHyp.nRightObs = 0;
+                f64 nLeftObs = 0.0, nRightObs = 0.0;
+                std::fill(leftStatistics.begin(), leftStatistics.end(), 0.0);
+                std::fill(rightStatistics.begin(), rightStatistics.end(), 0.0);
+                for (std::vector<u32>::const_iterator itId = exampleIds.begin(); itId != exampleIds.end(); ++itId) {
+                    const f64* itStatistic = &statistics_[*itId * nStatistics_];
+                    f64*       itSum;
+                    if (isAnswerTrue(answers, *itId)) {
+                        ++splitHyp.nLeftExamples;
+                        splitHyp.nLeftObs += exampleNObs_[*itId];
+                        nLeftObs += exampleNObs_[*itId];
+                        itSum = &leftStatistics[0];
+                    }
+                    else {
+                        ++splitHyp.nRightExamples;
+                        splitHyp.nRightObs += exampleNObs_[*itId];
+                        nRightObs += exampleNObs_[*itId];
+                        itSum = &rightStatistics[0];
+                    }
+                    for (const f64* endStatistic = itStatistic + nStatistics_; itStatistic != endStatistic; ++itStatistic, ++itSum)
+                        *itSum += *itStatistic;
+                }
+                if ((splitHyp.nLeftObs < step_->minObs) || (splitHyp.nRightObs < step_->minObs))
+                    continue;
+                if (strict && ((splitHyp.nLeftObs == 0) || (splitHyp.nRightObs == 0)))
+                    continue;
+                splitHyp.leftScore  = scorer_.score(nLeftObs, &leftStatistics[0], nStatistics_);
+                splitHyp.rightScore = scorer_.score(nRightObs, &rightStatistics[0], nStatistics_);
+                splitHyp.gain       = node->score - (splitHyp.leftScore + splitHyp.rightScore);
+                if (splitHyp.gain < 0.0) {
+                    if (!Core::isAlmostEqualUlp(f32(splitHyp.gain), f32(0.0), 20))
+                        status[questionIdId] = negativeGain;
+                    continue;
+                }
+                if (splitHyp.gain < step_->minGain)
+                    continue;
+                if (strict && (splitHyp.gain == 0.0))
+                    continue;
+                status[questionIdId] = accepted;
+            }
+        }
+        for (size_t questionIdId = 0; questionIdId < questionIds->size(); ++questionIdId) {
+            if (status[questionIdId] == negativeGain)
+                error() << "negative split gain of " << splitHyps[questionIdId].gain << "; gain must be positive";
+            else if (status[questionIdId] == accepted)
+                splitHyps_.push(splitHyps[questionIdId]);
+        }
+
+        Split* split = 0;
+        if (!splitHyps_.empty()) {
+            const SplitHypothesis& bestSplitHyp     = splitHyps_.get();
+            const AnswerMask&      answers          = answers_[(*questionIds)[bestSplitHyp.questionIdId]];
+            ExamplePtrList*        leftExamplePtrs  = new ExamplePtrList();
+            ExamplePtrList*        rightExamplePtrs = new ExamplePtrList();
+            leftExamplePtrs->reserve(bestSplitHyp.nLeftExamples);
+            rightExamplePtrs->reserve(bestSplitHyp.nRightExamples);
+            node->left  = new Node(node->depth + 1,
+                                  bestSplitHyp.leftScore,
+                                  bestSplitHyp.nLeftObs,
+                                  leftExamplePtrs);
+            node->right = new Node(node->depth + 1,
+                                   bestSplitHyp.rightScore,
+                                   bestSplitHyp.nRightObs,
+                                   rightExamplePtrs);
+            node->left->exampleIds.reserve(bestSplitHyp.nLeftExamples);
+            node->right->exampleIds.reserve(bestSplitHyp.nRightExamples);
+            for (std::vector<u32>::const_iterator itId = exampleIds.begin(); itId != exampleIds.end(); ++itId) {
+                Node* child = isAnswerTrue(answers, *itId) ? node->left : node->right;
+                child->examplePtrs->push_back(examplePtrs_[*itId]);
+                child->exampleIds.push_back(*itId);
+            }
+            delete node->examplePtrs;
+            node->examplePtrs = 0;
+            std::vector<u32>().swap(node->exampleIds);
+            split = new Split(node,
+                              questionIds,
+                              bestSplitHyp.questionIdId,
+                              bestSplitHyp.gain);
+        }
+        splitHyps_.reset();
+        return split;
+    }
+
     /**
      * insert split into tree
      */
@@ -603,6 +774,10 @@ private:
         node->examplePtrs->insert(node->examplePtrs->end(),
                                   node->right->examplePtrs->begin(),
                                   node->right->examplePtrs->end());
+        node->exampleIds.swap(node->left->exampleIds);
+        node->exampleIds.insert(node->exampleIds.end(),
+                                node->right->exampleIds.begin(),
+                                node->right->exampleIds.end());
         delete node->right->examplePtrs;
         delete node->left;
         delete node->right;
@@ -629,6 +804,8 @@ private:
             questionRefs_[questionId] = (*(step_->questionRefs))[i];
             questionIds[i]            = questionId;
         }
+        if (useStatistics_)
+            updateAnswers();
 
         for (size_t i = nodes_.size(); i > 0; nodes_.pop_front(), --i)
             suggestSplit(nodes_.front(), new QuestionIdList(questionIds));
@@ -655,6 +832,8 @@ private:
             questionRefs_[questionId] = (*(step_->questionRefs))[i];
             questionIds[i]            = questionId;
         }
+        if (useStatistics_)
+            updateAnswers();
 
         for (size_t i = nodes_.size(); i > 0; nodes_.pop_front(), --i)
             suggestSplit(nodes_.front(), new QuestionIdList(questionIds));
@@ -768,6 +947,7 @@ private:
 
 public:
     static const Core::ParameterBool paramDoParallel;
+    static const Core::ParameterBool paramUseSufficientStatistics;
 
     Training(const Core::Configuration& config,
              const Scorer&              scorer,
@@ -786,13 +966,19 @@ public:
               nLeaf_(0),
               nCluster_(0),
               gain_(0.0),
-              step_(0) {
+              step_(0),
+              nStatistics_(0) {
         if (plan_.map.get() != examples_.getMap().get()) {
             PropertyMapDiff diff(config, *plan.map, examples_.map(), false);
             if (diff.hasDifferences())
                 criticalError("differences in property maps of training and example list");
         }
-        parallel_ = paramDoParallel(config);
+        parallel_      = paramDoParallel(config);
+        useStatistics_ = paramUseSufficientStatistics(config);
+        if (useStatistics_ && (examples_.size() > 0) && (scorer_.nStatistics(**examples_.begin()) == 0)) {
+            warning("scorer does not support sufficient statistics; partition examples for each question");
+            useStatistics_ = false;
+        }
     }
 
     ClusterList* train() {
@@ -851,6 +1037,10 @@ const Core::ParameterBool Training::paramDoParallel(
         "cluster-parallel",
         "use OpenMP (e.g. OMP_NUM_THREADS environment value) to parallelize preparation in splitNode(); due to backward compatibility explicit flag", false);
 
+const Core::ParameterBool Training::paramUseSufficientStatistics(
+        "use-sufficient-statistics",
+        "search splits on precomputed per-example statistics instead of partitioning the examples for each question; requires scorer support, results are independent of cluster-parallel", false);
+
 bool DecisionTreeTrainer::loadFromString(const std::string& str) {
     verify(!plan_);
     plan_ = new TrainingPlan(map_);
@@ -79,6 +79,24 @@ public:
         Score dummy;
         operator()(examples, ExamplePtrRange(ExamplePtrList::const_iterator(), ExamplePtrList::const_iterator()), 0.0, score, dummy);
     }
+
+    /**
+     * Optional support for split search on sufficient statistics.
+     * A scorer supporting it maps each example to a fixed number of
+     * statistics, such that the statistics of a set of examples are the
+     * sums of the statistics of its examples, and computes the score of a
+     * set from the accumulated statistics and number of observations alone.
+     * The gain of a split must be fatherScore - leftScore - rightScore.
+     * nStatistics() returns 0, if not supported.
+     */
+    virtual size_t nStatistics(const Example& example) const {
+        return 0;
+    }
+    virtual void statistics(const Example& example, f64* statistics) const {}
+    virtual Score score(f64 nObs, const f64* statistics, size_t nStatistics) const {
+        defect();
+        return 0.0;
+    }
 };
 typedef Core::Ref<const Scorer> ConstScorerRef;
 
@@ -12,7 +12,9 @@
  *  See the License for the specific language governing permissions and
  *  limitations under the License.
  */
+#include <Core/BinaryStream.hh>
 #include <Core/CompressedStream.hh>
+#include <unordered_map>
 
 #include "Example.hh"
 #include "Parser.hh"
@@ -110,6 +112,15 @@ const Core::ParameterStringVector ExampleList::paramExampleFilenamesToMerge(
 const Core::ParameterString ExampleList::paramExampleFileEncoding(
         "encoding",
         "utf-8");
+const Core::Choice ExampleList::choiceExampleFileFormat(
+        "xml", fileFormatXml,
+        "binary", fileFormatBinary,
+        Core::Choice::endMark());
+const Core::ParameterChoice ExampleList::paramExampleFileFormat(
+        "example-file-format", &choiceExampleFileFormat,
+        "format of written example files, the format of read example files is detected",
+        fileFormatXml);
+const char* const ExampleList::binaryMagic = "CARTEXPL";
 
 bool ExampleList::loadFromString(const std::string& str) {
     XmlExampleListParser parser(config);
@@ -126,22 +137,183 @@ bool ExampleList::loadFromFile(std::string filename) {
         filename = paramExampleFilename(config);
         verify(!filename.empty());
     }
+    if (isBinaryFile(filename))
+        return loadFromBinaryFile(filename);
     log() << "load example list from \"" << filename << "\"";
     XmlExampleListParser parser(config);
     return parser.parseFile(filename, this);
 }
 
+bool ExampleList::isBinaryFile(const std::string& filename) {
+    Core::BinaryInputStream is(filename);
+    char                    magic[8];
+    return is.isOpen() && is.read(magic, 8) && (::strncmp(magic, binaryMagic, 8) == 0);
+}
+
+bool ExampleList::loadFromBinaryFile(const std::string& filename) {
+    log() << "load binary example list from \"" << filename << "\"";
+    Core::BinaryInputStream is(filename);
+    char                    magic[8];
+    u32                     version = 0;
+    if (!is.isOpen() || !is.read(magic, 8) || (::strncmp(magic, binaryMagic, 8) != 0) || !(is >> version) || (version != 1)) {
+        error("\"%s\" is not a binary example file of version 1", filename.c_str());
+        return false;
+    }
+
+    u32                                  nKeys = 0;
+    PropertyMap::StringList              keys;
+    PropertyMap::ListOfIndexedStringList values;
+    is >> nKeys;
+    for (u32 k = 0; is && (k < nKeys); ++k) {
+        std::string key;
+        u32         nValues = 0;
+        is >> key >> nValues;
+        keys.push_back(key);
+        values.push_back(PropertyMap::IndexedStringList(nValues));
+        for (PropertyMap::IndexedStringList::iterator it = values.back().begin(); is && (it != values.back().end()); ++it) {
+            s32 id = 0;
+            is >> it->first >> id;
+            it->second = id;
+        }
+    }
+    if (!is) {
+        error("failed to read properties definition from \"%s\"", filename.c_str());
+        return false;
+    }
+    // like the xml parser: keep the map of the example list, if defined
+    PropertyMapRef fileMap;
+    if (map_->empty()) {
+        const_cast<PropertyMap*>(map_.get())->set(keys, values);
+        fileMap = map_;
+    }
+    else {
+        fileMap = PropertyMapRef(new PropertyMap(keys, values));
+        if (!(map() == *fileMap)) {
+            log("keep properties definition from example list");
+            PropertyMapDiff diff(config, map(), *fileMap, true);
+            if (diff.hasDifferences())
+                warning("differences in property map of example list and property map defined in file");
+        }
+    }
+    const bool isSameMap = (fileMap == map_) || (map() == *fileMap);
+
+    u32 nExamples = 0;
+    is >> nExamples;
+    std::vector<PropertyMap::Index> valueIndexes(nKeys);
+    for (u32 e = 0; is && (e < nExamples); ++e) {
+        f64 nObs = 0.0;
+        u32 rows = 0, columns = 0;
+        is >> nObs >> rows >> columns;
+        for (u32 k = 0; k < nKeys; ++k) {
+            s32 id = 0;
+            is >> id;
+            valueIndexes[k] = id;
+        }
+        Properties* properties = 0;
+        if (isSameMap) {
+            properties = new StoredProperties(map_, valueIndexes);
+        }
+        else {
+            StoredProperties::StringList exampleKeys, exampleValues;
+            for (u32 k = 0; k < nKeys; ++k)
+                if (fileMap->isDefined(valueIndexes[k])) {
+                    exampleKeys.push_back(keys[k]);
+                    exampleValues.push_back((*fileMap)[k][valueIndexes[k]]);
+                }
+            properties = new StoredProperties(map_, exampleKeys, exampleValues);
+        }
+        FloatBox* box = new FloatBox(rows, columns);
+        is.read(box->begin(), box->size());
+        Example* example = new Example(properties, box);
+        example->nObs    = nObs;
+        add(example);
+    }
+    if (!is) {
+        error("failed to read examples from \"%s\"", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ExampleList::writeBinary(const std::string& filename) const {
+    Core::BinaryOutputStream os(filename);
+    if (!os.isOpen()) {
+        error("cannot open \"%s\" for writing", filename.c_str());
+        return false;
+    }
+    os.write(binaryMagic, 8);
+    os << u32(1);
+
+    os << u32(map_->size());
+    for (size_t k = 0; k < map_->size(); ++k) {
+        const Core::Choice& values = (*map_)[k];
+        os << map_->key(k) << u32(values.nChoices());
+        for (Core::Choice::const_iterator it = values.begin(); it != values.end(); ++it)
+            os << it->ident() << s32(it->value());
+    }
+
+    u32 nExamples = 0;
+    for (const_iterator it = exampleRefs_.begin(); it != exampleRefs_.end(); ++it)
+        if (*it)
+            ++nExamples;
+    os << nExamples;
+    for (const_iterator it = exampleRefs_.begin(); it != exampleRefs_.end(); ++it)
+        if (*it) {
+            const Example& example = **it;
+            os << example.nObs << u32(example.values->rows()) << u32(example.values->columns());
+            for (size_t k = 0; k < map_->size(); ++k)
+                os << s32((*example.properties)[PropertyMap::Index(k)]);
+            os.write(example.values->begin(), example.values->size());
+        }
+    if (!os) {
+        error("failed to write examples to \"%s\"", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
 bool ExampleList::mergeFromFiles(std::vector<std::string> filenames) {
     if (filenames.empty()) {
         filenames = paramExampleFilenamesToMerge(config);
         verify(!filenames.empty());
     }
-    Cart::XmlExampleListMerger merger(config, this);
     for (std::vector<std::string>::const_iterator itFilename = filenames.begin();
          itFilename != filenames.end(); ++itFilename) {
         log() << "merge example list from \"" << *itFilename << "\"";
-        if (!merger.parseFile(*itFilename))
-            return false;
+        if (isBinaryFile(*itFilename)) {
+            if (!mergeFromBinaryFile(*itFilename))
+                return false;
+        }
+        else {
+            // the merger indexes the examples merged so far, including those of binary files
+            Cart::XmlExampleListMerger merger(config, this);
+            if (!merger.parseFile(*itFilename))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool ExampleList::mergeFromBinaryFile(const std::string& filename) {
+    ExampleList examples(config, map_);
+    if (!examples.loadFromBinaryFile(filename))
+        return false;
+    // like the xml merger: examples with equal properties are accumulated
+    typedef std::unordered_map<Properties*, Example*, Properties::PtrHashFcn, Properties::PtrEqual> ExampleMap;
+    ExampleMap                                                                                      exampleMap;
+    for (iterator itExample = exampleRefs_.begin(); itExample != exampleRefs_.end(); ++itExample)
+        if (*itExample)
+            exampleMap.insert(std::make_pair((*itExample)->properties, itExample->get()));
+    for (iterator itExample = examples.begin(); itExample != examples.end(); ++itExample) {
+        std::pair<ExampleMap::iterator, bool> result = exampleMap.insert(std::make_pair((*itExample)->properties, itExample->get()));
+        if (result.second) {
+            add(*itExample);
+        }
+        else {
+            Example& trgExample = *result.first->second;
+            trgExample.nObs += (*itExample)->nObs;
+            *trgExample.values += *(*itExample)->values;
+        }
     }
     return true;
 }
@@ -175,7 +347,11 @@ void ExampleList::writeXml(Core::XmlWriter& xml) const {
 void ExampleList::writeToFile() const {
     std::string filename = paramExampleFilename(config);
     std::string encoding = paramExampleFileEncoding(config);
-    if (!filename.empty()) {
+    if (!filename.empty() && (paramExampleFileFormat(config) == fileFormatBinary)) {
+        log() << "write binary example list to \"" << filename << "\"";
+        writeBinary(filename);
+    }
+    else if (!filename.empty()) {
         log() << "write example list to \"" << filename << "\"";
         Core::XmlOutputStream xml(new Core::CompressedOutputStream(filename));
         xml.generateFormattingHints(true);
@@ -488,6 +488,13 @@ public:
     static const Core::ParameterStringVector paramExampleFilenamesToMerge;
     static const Core::ParameterString       paramExampleFileEncoding;
 
+    enum FileFormat {
+        fileFormatXml,
+        fileFormatBinary
+    };
+    static const Core::Choice          choiceExampleFileFormat;
+    static const Core::ParameterChoice paramExampleFileFormat;
+
 private:
     PropertyMapRef   map_;
     ExampleRefVector exampleRefs_;
@@ -551,13 +558,26 @@ public:
 
     bool loadFromString(const std::string& str);
     bool loadFromStream(std::istream& i);
+    /** Loads XML or binary example files, the format is detected from the file. */
     bool loadFromFile(std::string filename = "");
 
+    /** Merges XML or binary example files, examples with equal properties are accumulated. */
     bool mergeFromFiles(std::vector<std::string> filenames = std::vector<std::string>());
 
     void write(std::ostream& os) const;
     void writeXml(Core::XmlWriter& xml) const;
     void writeToFile() const;
+
+    /**
+     * Binary example file: the property map followed by number of
+     * observations, property value indexes and values of each example;
+     * avoids parsing the values from text for large example lists.
+     */
+    static const char* const binaryMagic;
+    static bool              isBinaryFile(const std::string& filename);
+    bool                     loadFromBinaryFile(const std::string& filename);
+    bool                     mergeFromBinaryFile(const std::string& filename);
+    bool                     writeBinary(const std::string& filename) const;
 };
 }  // namespace Cart
 
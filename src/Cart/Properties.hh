@@ -295,6 +295,16 @@ public:
                      const StringList& keys,
                      const StringList& values);
 
+    StoredProperties(PropertyMapRef map, const std::vector<Index>& valueIndexes)
+            : Properties(map),
+              valueIndexes_(valueIndexes) {
+        require(valueIndexes_.size() == map_->size());
+    }
+
+    const std::vector<Index>& valueIndexes() const {
+        return valueIndexes_;
+    }
+
     const std::string& operator[](const std::string& key) const {
         return Properties::operator[](key);
     }
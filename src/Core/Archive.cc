@@ -12,8 +12,11 @@
  *  See the License for the specific language governing permissions and
  *  limitations under the License.
  */
+#include <condition_variable>
+#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <thread>
 #include <zlib.h>
 
 #include "Application.hh"
@@ -25,8 +28,140 @@
 
 using namespace Core;
 
+namespace {
+
+std::mutex                      sharedArchivesMutex;
+std::map<std::string, Archive*> sharedArchives;
+u32                             nSharingEnabled = 0;
+
+thread_local DeferredArchiveWrites* activeDeferredWrites = 0;
+
+ArchiveWriteListener* writeListener = 0;
+
+}  // namespace
+
+const ParameterInt Archive::paramReadAhead(
+        "read-ahead",
+        "number of files following the last file read which are read and decompressed in the background (read-only archives)",
+        0, 0);
+
+/**
+ * Reads the files following the last file requested in a background
+ * thread, and keeps them decompressed until they are requested.
+ */
+class Archive::ReadAhead {
+private:
+    struct Entry {
+        bool        isReady;
+        bool        status;
+        std::string data;
+        Entry()
+                : isReady(false), status(false) {}
+    };
+
+    const Archive&                 archive_;
+    u32                            size_;
+    std::map<std::string, Entry>   entries_;
+    std::deque<std::string>        order_;     // names of the entries, oldest first
+    std::deque<std::string>        requests_;  // entries to be read
+    bool                           terminate_;
+    std::mutex                     mutex_;
+    std::condition_variable        condition_;
+    std::thread                    thread_;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            while (requests_.empty() && !terminate_)
+                condition_.wait(lock);
+            if (terminate_)
+                break;
+            std::string name = requests_.front();
+            requests_.pop_front();
+            lock.unlock();
+            std::string data;
+            bool        status = archive_.readAndDecompress(name, data);
+            lock.lock();
+            std::map<std::string, Entry>::iterator e = entries_.find(name);
+            if (e != entries_.end()) {
+                e->second.isReady = true;
+                e->second.status  = status;
+                e->second.data.swap(data);
+                condition_.notify_all();
+            }
+        }
+    }
+
+public:
+    ReadAhead(const Archive& archive, u32 size)
+            : archive_(archive), size_(size), terminate_(false) {
+        thread_ = std::thread(&ReadAhead::run, this);
+    }
+    ~ReadAhead() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            terminate_ = true;
+            condition_.notify_all();
+        }
+        thread_.join();
+    }
+
+    /** @return true if the file has been read ahead, its data is moved to @c buffer then */
+    bool take(const std::string& name, std::string& buffer, bool& status) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::map<std::string, Entry>::iterator e = entries_.find(name);
+        if (e == entries_.end())
+            return false;
+        while (!e->second.isReady)
+            condition_.wait(lock);
+        status = e->second.status;
+        buffer.swap(e->second.data);
+        entries_.erase(e);
+        return true;
+    }
+
+    /** Requests the files following @c name. */
+    void schedule(const std::string& name) {
+        std::vector<std::string> names;
+        if (!archive_.nextFiles(name, size_, names))
+            return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::vector<std::string>::const_iterator n = names.begin(); n != names.end(); ++n) {
+            if (entries_.insert(std::make_pair(*n, Entry())).second) {
+                order_.push_back(*n);
+                requests_.push_back(*n);
+            }
+        }
+        // forget the oldest files which have not been requested (e.g. skipped segments)
+        while (order_.size() > 2 * size_) {
+            std::map<std::string, Entry>::iterator e = entries_.find(order_.front());
+            if (e != entries_.end()) {
+                if (!e->second.isReady)
+                    break;
+                entries_.erase(e);
+            }
+            order_.pop_front();
+        }
+        condition_.notify_all();
+    }
+};
+
 Archive::Archive(const Core::Configuration& config, const std::string& path, AccessMode access)
-        : Component(config), path_(path), access_(access) {
+        : Component(config),
+          path_(path),
+          access_(access),
+          readAheadSize_(paramReadAhead(config)),
+          readAhead_(0),
+          nSharedUsers_(0) {
+}
+
+Archive::~Archive() {
+    stopReadAhead();
+}
+
+void Archive::stopReadAhead() {
+    delete readAhead_;
+    readAhead_ = 0;
 }
 
 bool Archive::hasFile(const std::string& name) const {
@@ -47,14 +182,44 @@ bool Archive::removeFile(const std::string& name) {
 }
 
 bool Archive::readFile(const std::string& name, std::string& b) {
-    lock();
+    if (readAheadSize_ && !hasAccess(AccessModeWrite)) {
+        std::call_once(readAheadCreated_, [this]() { readAhead_ = new ReadAhead(*this, readAheadSize_); });
+        bool status = false;
+        if (!readAhead_->take(name, b, status))
+            status = readAndDecompress(name, b);
+        readAhead_->schedule(name);
+        return status;
+    }
+    return readAndDecompress(name, b);
+}
 
-    Sizes sizes;
-    if (!discover(name, sizes)) {
-        release();
-        return false;
+bool Archive::readAndDecompress(const std::string& name, std::string& b) const {
+    // decompression does not need the lock
+    const bool concurrent = supportsConcurrentReads();
+    if (!concurrent)
+        lock();
+    Sizes       sizes;
+    std::string compressed;
+    bool        status = discover(name, sizes);
+    if (status) {
+        if (sizes.compressed() > 0) {
+            compressed.resize(sizes.compressed());
+            status = read(name, compressed);
+        }
+        else {
+            b.resize(sizes.uncompressed());
+            status = read(name, b);
+        }
     }
+    if (!concurrent)
+        release();
 
+    if (status && sizes.compressed() > 0)
+        status = decompress(compressed, sizes, b);
+    return status;
+}
+
+bool Archive::decompress(std::string& tmp, const Sizes& sizes, std::string& b) {
     /* from zlib.h:
      *
      * ZEXTERN int ZEXPORT uncompress OF((Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourceLen));
@@ -76,69 +241,55 @@ bool Archive::readFile(const std::string& name, std::string& b) {
      */
 
     bool status = false;
-    if (sizes.compressed() > 0) {
-        std::string tmp;
-        tmp.resize(sizes.compressed());
-        if (read(name, tmp)) {
-            // We might want to check the CRC32 here.
-            b.resize(sizes.uncompressed());
-            uLongf tmplen         = b.size();
-            uLongf compressedSize = tmp.size() - 10 + 2;
-
-            // check for extra gzip header data and skip it (zlib does not detect it)
-            u32 base = 10;
-            if (tmp[3] & 0x04)
-                base += (int(tmp[base]) + int(tmp[base + 1])) << 8;  // extra field
-            if (tmp[3] & 0x08) {
-                for (; (base < compressedSize) && (tmp[base]); base++)
-                    ;  // filename
-                base++;
-            }
-            if (tmp[3] & 0x10) {
-                for (; (base < compressedSize) && (tmp[base]); base++)
-                    ;  // comment
-                base++;
-            }
-            if (tmp[3] & 0x02)
-                base += 2;  // crc16
-
-            // restore bogus zlib header
-            base -= 2;
-            tmp[base]     = 0x78;
-            tmp[base + 1] = 0x9c;
-            switch (uncompress((Bytef*)&b[0], &tmplen, (Bytef*)&tmp[base], compressedSize)) {
-                case Z_MEM_ERROR:
-                    std::cerr << "no memory to decompress." << std::endl;
-                    break;
-                case Z_BUF_ERROR:
-                    std::cerr << "unpack buffer was too small (" << sizes.compressed() << ", "
-                              << sizes.uncompressed() << ", " << tmplen << ")." << std::endl;
-                    break;
-                case Z_DATA_ERROR:
-                    /* CAUTION! Zlib thinks that data was corrupted because we replaced
-                 * the adler32 checksum by a gzip compatible crc32. So we ignore the error.
-                 */
-                    // fall through
-                case Z_OK:
-                default:
-                    b.resize(tmplen);
-                    status = true;
-                    break;
-            }
-        }
+    // We might want to check the CRC32 here.
+    b.resize(sizes.uncompressed());
+    uLongf tmplen         = b.size();
+    uLongf compressedSize = tmp.size() - 10 + 2;
+
+    // check for extra gzip header data and skip it (zlib does not detect it)
+    u32 base = 10;
+    if (tmp[3] & 0x04)
+        base += (int(tmp[base]) + int(tmp[base + 1])) << 8;  // extra field
+    if (tmp[3] & 0x08) {
+        for (; (base < compressedSize) && (tmp[base]); base++)
+            ;  // filename
+        base++;
     }
-    else {
-        b.resize(sizes.uncompressed());
-        status = read(name, b);
+    if (tmp[3] & 0x10) {
+        for (; (base < compressedSize) && (tmp[base]); base++)
+            ;  // comment
+        base++;
+    }
+    if (tmp[3] & 0x02)
+        base += 2;  // crc16
+
+    // restore bogus zlib header
+    base -= 2;
+    tmp[base]     = 0x78;
+    tmp[base + 1] = 0x9c;
+    switch (uncompress((Bytef*)&b[0], &tmplen, (Bytef*)&tmp[base], compressedSize)) {
+        case Z_MEM_ERROR:
+            std::cerr << "no memory to decompress." << std::endl;
+            break;
+        case Z_BUF_ERROR:
+            std::cerr << "unpack buffer was too small (" << sizes.compressed() << ", "
+                      << sizes.uncompressed() << ", " << tmplen << ")." << std::endl;
+            break;
+        case Z_DATA_ERROR:
+            /* CAUTION! Zlib thinks that data was corrupted because we replaced
+             * the adler32 checksum by a gzip compatible crc32. So we ignore the error.
+             */
+            // fall through
+        case Z_OK:
+        default:
+            b.resize(tmplen);
+            status = true;
+            break;
     }
-
-    release();
     return status;
 }
 
 bool Archive::writeFile(const std::string& name, const std::string& b, bool compress) {
-    lock();
-
     /* from zlib.h:
      *
      * ZEXTERN int ZEXPORT compress OF((Bytef *dest, uLongf *destLen, const Bytef *source, uLong sourceLen));
@@ -156,8 +307,7 @@ bool Archive::writeFile(const std::string& name, const std::string& b, bool comp
      * buffer.
      */
 
-    // compress buffer
-    // we could do the compression in a separate thread, but we don't...
+    // compress buffer (without holding the lock)
     std::string compressed;
     if (compress) {
         size_t header_length = 10;
@@ -211,17 +361,47 @@ bool Archive::writeFile(const std::string& name, const std::string& b, bool comp
         }
     }
 
+    DeferredArchiveWrites* deferred = DeferredArchiveWrites::active();
+    if (deferred) {
+        if (compressed.empty()) {
+            std::string data(b);
+            deferred->add(this, name, data, Sizes(b.size(), 0));
+        }
+        else
+            deferred->add(this, name, compressed, Sizes(b.size(), compressed.size()));
+        return true;
+    }
+
     // add file data to archive
-    bool status = false;
     if (compressed.size())
-        status = write(name, compressed, Sizes(b.size(), compressed.size()));
-    else
-        status = write(name, b, Sizes(b.size(), 0));
+        return writeCompressed(name, compressed, Sizes(b.size(), compressed.size()));
+    return writeCompressed(name, b, Sizes(b.size(), 0));
+}
 
+bool Archive::writeCompressed(const std::string& name, const std::string& data, const Sizes& sizes) {
+    ArchiveWriteListener* listener = writeListener;
+    lock();
+    Sizes existing;
+    if (listener && listener->replaceFile(*this, name) && discover(name, existing))
+        remove(name);
+    bool status = write(name, data, sizes);
+    if (status && listener)
+        status = sync();
     release();
+    if (status && listener)
+        listener->fileWritten(*this, name);
     return status;
 }
 
+void Archive::setWriteListener(ArchiveWriteListener* listener) {
+    require(!listener || !writeListener);
+    writeListener = listener;
+}
+
+bool Archive::hasWriteListener() {
+    return writeListener != 0;
+}
+
 bool Archive::copyFile(const Archive& srcArchive, const std::string& name, const std::string& prefix) {
     Sizes sizes;
     srcArchive.lock();
@@ -319,6 +499,143 @@ Archive* Archive::create(const Configuration& config, const std::string& path, A
     return result;
 }
 
+Archive* Archive::createShared(const Configuration& config, const std::string& path, AccessMode access) {
+    std::lock_guard<std::mutex> lock(sharedArchivesMutex);
+    if (nSharingEnabled == 0)
+        return create(config, path, access);
+    std::map<std::string, Archive*>::iterator a = sharedArchives.find(path);
+    if (a != sharedArchives.end() && (a->second->access_ & access) == access) {
+        ++a->second->nSharedUsers_;
+        return a->second;
+    }
+    // an archive opened with less access is not shared any more, but kept by its users
+    Archive* result = create(config, path, access);
+    if (result) {
+        result->nSharedUsers_ = 1;
+        sharedArchives[path]  = result;
+    }
+    return result;
+}
+
+void Archive::releaseShared(Archive* archive) {
+    if (!archive)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(sharedArchivesMutex);
+        if (archive->nSharedUsers_ > 1) {
+            --archive->nSharedUsers_;
+            return;
+        }
+        std::map<std::string, Archive*>::iterator a = sharedArchives.find(archive->path_);
+        if (a != sharedArchives.end() && a->second == archive)
+            sharedArchives.erase(a);
+    }
+    delete archive;
+}
+
+void Archive::enableSharing() {
+    std::lock_guard<std::mutex> lock(sharedArchivesMutex);
+    ++nSharingEnabled;
+}
+
+void Archive::disableSharing() {
+    std::lock_guard<std::mutex> lock(sharedArchivesMutex);
+    require(nSharingEnabled > 0);
+    --nSharingEnabled;
+}
+
+bool Archive::isSharingEnabled() {
+    std::lock_guard<std::mutex> lock(sharedArchivesMutex);
+    return nSharingEnabled > 0;
+}
+
+bool Archive::acquireShared(Archive* archive) {
+    std::lock_guard<std::mutex> lock(sharedArchivesMutex);
+    if (archive->nSharedUsers_ == 0)
+        return false;
+    ++archive->nSharedUsers_;
+    return true;
+}
+
+// ===========================================================================
+DeferredArchiveWrites::DeferredArchiveWrites()
+        : previous_(0), isActive_(false) {}
+
+DeferredArchiveWrites::~DeferredArchiveWrites() {
+    if (isActive_)
+        deactivate();
+    clear();
+}
+
+DeferredArchiveWrites* DeferredArchiveWrites::active() {
+    return activeDeferredWrites;
+}
+
+void DeferredArchiveWrites::activate() {
+    require(!isActive_);
+    previous_            = activeDeferredWrites;
+    activeDeferredWrites = this;
+    isActive_            = true;
+}
+
+void DeferredArchiveWrites::deactivate() {
+    require(isActive_ && activeDeferredWrites == this);
+    activeDeferredWrites = previous_;
+    previous_            = 0;
+    isActive_            = false;
+}
+
+void DeferredArchiveWrites::add(Archive* archive, const std::string& name, std::string& data, const Archive::Sizes& sizes) {
+    writes_.push_back(Write());
+    Write& w = writes_.back();
+    w.archive  = archive;
+    w.name     = name;
+    w.sizes    = sizes;
+    w.isShared = Archive::acquireShared(archive);
+    w.data.swap(data);
+}
+
+void DeferredArchiveWrites::append(DeferredArchiveWrites& other) {
+    require(&other != this);
+    for (std::vector<Write>::iterator w = other.writes_.begin(); w != other.writes_.end(); ++w) {
+        writes_.push_back(Write());
+        Write& to = writes_.back();
+        to.archive  = w->archive;
+        to.name.swap(w->name);
+        to.data.swap(w->data);
+        to.sizes    = w->sizes;
+        to.isShared = w->isShared;
+    }
+    other.writes_.clear();
+}
+
+bool DeferredArchiveWrites::handOver() {
+    DeferredArchiveWrites* target = active();
+    if (!target)
+        return commit();
+    target->append(*this);
+    return true;
+}
+
+bool DeferredArchiveWrites::commit() {
+    bool status = true;
+    for (std::vector<Write>::iterator w = writes_.begin(); w != writes_.end(); ++w) {
+        if (!w->archive->writeCompressed(w->name, w->data, w->sizes))
+            status = false;
+        if (w->isShared)
+            Archive::releaseShared(w->archive);
+    }
+    writes_.clear();
+    return status;
+}
+
+void DeferredArchiveWrites::clear() {
+    for (std::vector<Write>::iterator w = writes_.begin(); w != writes_.end(); ++w)
+        if (w->isShared)
+            Archive::releaseShared(w->archive);
+    writes_.clear();
+}
+
 ArchiveReader::ArchiveReader(Archive& a, const std::string& name) {
     std::string buffer;
     isOpen_ = a.readFile(name, buffer);
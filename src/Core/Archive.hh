@@ -16,17 +16,22 @@
 #define _CORE_ARCHIVE_HH
 
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "Component.hh"
+#include "Parameter.hh"
 #include "ReferenceCounting.hh"
 #include "Thread.hh"
 #include "Types.hh"
 
 namespace Core {
 
+class ArchiveWriteListener;
+class DeferredArchiveWrites;
+
 /**
  * Abstract base class for archives.
  *
@@ -117,10 +122,25 @@ public:
     };
 
 private:
+    static const ParameterInt paramReadAhead;
+
     std::string   path_;
     AccessMode    access_;
     mutable Mutex mutex_;
 
+    class ReadAhead;
+    u32            readAheadSize_;
+    ReadAhead*     readAhead_;
+    std::once_flag readAheadCreated_;
+
+    /** Number of users of a shared archive, zero if not shared. */
+    u32 nSharedUsers_;
+
+    bool readAndDecompress(const std::string& name, std::string& buffer) const;
+    bool writeCompressed(const std::string& name, const std::string& data, const Sizes& sizes);
+    static bool acquireShared(Archive* archive);
+    friend class DeferredArchiveWrites;
+
 protected:
     // manipulate configuration context
     bool setAccess(AccessMode access) {
@@ -139,6 +159,31 @@ protected:
     virtual bool discover(const std::string& name, Sizes& sizes) const {
         return false;
     }
+    /**
+     * Returns true if discover() and read() may be called by several
+     * threads at the same time, without locking.
+     */
+    virtual bool supportsConcurrentReads() const {
+        return false;
+    }
+    /**
+     * Returns the names of (at most) @c n files following file @c name in
+     * archive order, which typically is the order in which the files have
+     * been written.  Used for read-ahead.
+     * @return false if not supported
+     */
+    virtual bool nextFiles(const std::string& name, u32 n, std::vector<std::string>& names) const {
+        return false;
+    }
+    /** Must be called by the destructors of archives supporting read-ahead. */
+    void stopReadAhead();
+    static bool decompress(std::string& compressed, const Sizes& sizes, std::string& buffer);
+
+    /** Passes the data written so far to the operating system. */
+    virtual bool sync() {
+        return true;
+    }
+
     virtual bool read(const std::string& name, std::string& buffer) const                      = 0;
     virtual bool write(const std::string& name, const std::string& buffer, const Sizes& sizes) = 0;
     virtual bool remove(const std::string& name)                                               = 0;
@@ -149,7 +194,7 @@ protected:
     friend class BundleArchive;
 
 public:
-    virtual ~Archive() {}
+    virtual ~Archive();
 
     const std::string& path() const {
         return path_;
@@ -162,6 +207,14 @@ public:
     virtual const_iterator files() const = 0;
 
     bool hasFile(const std::string& name) const;
+    /**
+     * Reads and decompresses a file.
+     * Can be called by several threads at the same time.  Archives
+     * supporting concurrent reads (e.g. file archives opened read-only)
+     * are read without locking.  If read-ahead is configured and supported,
+     * the following files are read and decompressed in a background
+     * thread.
+     */
     bool readFile(const std::string& name, std::string& buffer);
     bool writeFile(const std::string& name, const std::string& ufferb, bool compress = true);
     bool removeFile(const std::string& name);
@@ -192,6 +245,97 @@ public:
      * @return zero on failure, a valid archive otherwise
      **/
     static Archive* create(const Configuration& config, const std::string& path = "", AccessMode access = AccessModeReadWrite);
+
+    /**
+     * Like create(), but while sharing is enabled all callers requesting
+     * the same path get the same archive, as long as it is in use.
+     * Several writers of one archive (e.g. the caches of the flow networks
+     * of parallel workers) must share one instance.  While sharing is
+     * disabled (the default), a private archive is created.  Archives
+     * created by createShared() must be released by releaseShared().
+     **/
+    static Archive* createShared(const Configuration& config, const std::string& path, AccessMode access = AccessModeReadWrite);
+    /** Deletes the archive, if it is not shared or this was its last user. */
+    static void releaseShared(Archive* archive);
+
+    /**
+     * Enables sharing of archives by createShared() until the matching
+     * call of disableSharing(), e.g. for the lifetime of a
+     * Speech::ParallelCorpusVisitor.  Calls may be nested.
+     **/
+    static void enableSharing();
+    static void disableSharing();
+    static bool isSharingEnabled();
+
+    /** Registers the listener notified about the files written to all archives, 0 to unregister. */
+    static void setWriteListener(ArchiveWriteListener* listener);
+    static bool hasWriteListener();
+};
+
+/**
+ * Observes the files written to any archive, e.g. to journal the output
+ * of a corpus run.  While a listener is registered, each archive is
+ * synced after a file has been written, then fileWritten() is called.
+ * replaceFile() allows to overwrite a file left behind by an interrupted
+ * run, even if the archive does not allow overwriting.
+ **/
+class ArchiveWriteListener {
+public:
+    virtual ~ArchiveWriteListener() {}
+    virtual bool replaceFile(const Archive& archive, const std::string& name) {
+        return false;
+    }
+    virtual void fileWritten(const Archive& archive, const std::string& name) = 0;
+};
+
+/**
+ * Defers the archive writes of a thread.
+ *
+ * While an instance is active in a thread, Archive::writeFile() called
+ * by this thread compresses the data, but only records the file.
+ * commit() writes the recorded files, possibly from another thread.
+ * Thus several threads can produce archive files concurrently, while
+ * the files are written to the archives in a deterministic order.
+ * Shared archives are kept alive until the writes are committed or
+ * cleared, other archives must outlive this object.
+ **/
+class DeferredArchiveWrites {
+private:
+    struct Write {
+        Archive*       archive;
+        std::string    name;
+        std::string    data;
+        Archive::Sizes sizes;
+        bool           isShared;
+    };
+    std::vector<Write>     writes_;
+    DeferredArchiveWrites* previous_;
+    bool                   isActive_;
+
+    friend class Archive;
+    static DeferredArchiveWrites* active();
+    void                          add(Archive* archive, const std::string& name, std::string& data, const Archive::Sizes& sizes);
+
+public:
+    DeferredArchiveWrites();
+    ~DeferredArchiveWrites();
+
+    /** Defers the writes of the calling thread until deactivate(). */
+    void activate();
+    void deactivate();
+
+    size_t size() const {
+        return writes_.size();
+    }
+    /** Moves the recorded files of @c other behind the files recorded here. */
+    void append(DeferredArchiveWrites& other);
+    /** Moves the recorded files to the writes active in the calling thread,
+     *  or writes them if there are none. */
+    bool handOver();
+    /** Writes the recorded files in the order they were written, and clears them. */
+    bool commit();
+    /** Discards the recorded files. */
+    void clear();
 };
 
 class ArchiveReader : public std::istringstream {
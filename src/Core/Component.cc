@@ -18,6 +18,7 @@
 
 #include <cerrno>
 #include <cstring>
+#include <mutex>
 
 #include "Application.hh"
 #include "Assertions.hh"
@@ -26,6 +27,18 @@
 
 namespace Core {
 
+namespace {
+/**
+ * Held by a thread from the start of a message until its Message object
+ * is destroyed, so that messages of concurrent threads do not interleave.
+ * Never destroyed: messages may be written during static destruction.
+ */
+std::recursive_mutex& messageMutex() {
+    static std::recursive_mutex* mutex = new std::recursive_mutex;
+    return *mutex;
+}
+}  // namespace
+
 const Choice Component::errorActionChoice(
         "ignore", ErrorActionIgnore,
         "delayed-exit", ErrorActionDelayedExit,
@@ -165,9 +178,11 @@ void Component::exit() const {
             "This is the exit status to be returned when the program aborts "
             "due to a runtime error within this component.");
 
+    messageMutex().lock();
     *errorChannel(ErrorTypeCriticalError) << XmlOpen(errorNames[ErrorTypeCriticalError]) + XmlAttribute("component", fullName())
                                           << "Terminating due to previous errors"
                                           << XmlClose(errorNames[ErrorTypeCriticalError]);
+    messageMutex().unlock();
 
     Application::us()->exit(errorCode(config));
 }
@@ -177,6 +192,8 @@ XmlChannel* Component::vErrorMessage(ErrorType type, const char* msg, va_list ap
 
     XmlChannel* chn = errorChannel(type);
 
+    // released by ~Message()
+    messageMutex().lock();
     *chn << XmlOpen(errorNames[type]) + XmlAttribute("component", fullName());
     if (msg) {
         (*chn) << vform(msg, ap);
@@ -201,6 +218,14 @@ XmlChannel* Component::vErrorMessage(ErrorType type, const char* msg, va_list ap
     return chn;
 }
 
+Component::MessageLock::MessageLock() {
+    messageMutex().lock();
+}
+
+Component::MessageLock::~MessageLock() {
+    messageMutex().unlock();
+}
+
 Component::Message Component::log(const char* msg, ...) const {
     va_list ap;
     require(msg);
@@ -213,6 +238,7 @@ Component::Message Component::log(const char* msg, ...) const {
 
 Component::Message Component::log() const {
     XmlChannel* chn = errorChannel(ErrorTypeInfo);
+    messageMutex().lock();
     *chn << XmlOpen(errorNames[ErrorTypeInfo]) + XmlAttribute("component", fullName());
     return Message(this, ErrorTypeInfo, chn);
 }
@@ -278,6 +304,7 @@ Component::Message& Component::Message::form(const char* msg, ...) {
 Component::Message::~Message() {
     if (component_) {
         *ostream_ << XmlClose(errorNames[type_]);
+        messageMutex().unlock();
         component_->errorOccured(type_);
     }
 }
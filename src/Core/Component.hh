@@ -170,6 +170,10 @@ public:
      *
      * Note: Message uses an std::auto_ptr<> style copy policy.
      *
+     * Messages are serialized: while a Message is alive, messages of
+     * other threads wait, thus do not wait for other threads while
+     * holding one.
+     *
      * Rule: Call warning(), error() or criticalError() once per
      * event you wish to report.  Use Message to avoid
      * multiple calls.
@@ -208,6 +212,21 @@ public:
     };
 
 public:
+    /**
+     * Holds the message lock for its lifetime, so that output written
+     * through several messages or clog() calls appears as one block.
+     * Recursive: messages of the holding thread pass.
+     */
+    class MessageLock {
+    public:
+        MessageLock();
+        ~MessageLock();
+
+    private:
+        MessageLock(const MessageLock&);
+        MessageLock& operator=(const MessageLock&);
+    };
+
     XmlWriter& clog() const {
         return *errorChannel(ErrorTypeInfo);
     }
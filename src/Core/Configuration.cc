@@ -15,6 +15,7 @@
 // $Id$
 
 #include "Configuration.hh"
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
@@ -25,6 +26,7 @@
 #include "Application.hh"
 #include "ArithmeticExpressionParser.hh"
 #include "Directory.hh"
+#include "Hash.hh"
 #include "StringUtilities.hh"
 #include "Tokenizer.hh"
 #include "Utility.hh"
@@ -102,14 +104,6 @@ public:
         os << name_ << " = " << value_;
     }
 
-    /**
-     * Determine if the resource matches a configurtion path.
-     * @param components the coponents of the configuration path
-     * @return the number of path components matched by the resource,
-     * or -1 of the resource does not match.
-     */
-    s32 match(const std::vector<std::string>& components) const;
-
     void registerUsage(const std::string& n, const AbstractParameter* p, const std::string& v) const {
         Usage u;
         u.fullParameterName = n;
@@ -121,38 +115,6 @@ public:
     void writeUsage(XmlWriter&) const;
 };
 
-/**
- * Finds best match using dynamic programming:
- * Runtime is at most |Component| * |Resource|
- **/
-s32 Configuration::Resource::match(const std::vector<std::string>& components) const {
-    std::vector<s16> nMatches(components.size() + 1, Core::Type<s16>::min);
-    nMatches.front()         = 0;
-    bool            hasMatch = true;
-    StringTokenizer tokenizer(getName(), resource_separation_string);
-    for (StringTokenizer::Iterator itResource = tokenizer.begin(), endResource = tokenizer.end(); hasMatch && (itResource != endResource); ++itResource) {
-        hasMatch = false;
-        if (*itResource == resource_wildcard_string) {
-            for (std::vector<s16>::iterator itMatches = nMatches.begin() + 1; itMatches != nMatches.end(); ++itMatches)
-                if (*(itMatches - 1) > *itMatches)
-                    *itMatches = *(itMatches - 1);
-            hasMatch = true;
-        }
-        else {
-            std::vector<std::string>::const_reverse_iterator itComponent = components.rbegin();
-            for (std::vector<s16>::reverse_iterator itMatches = nMatches.rbegin(); itMatches != nMatches.rend() - 1; ++itMatches, ++itComponent)
-                if ((*(itMatches + 1) >= 0) && (*itComponent == *itResource)) {
-                    *itMatches = *(itMatches + 1) + 1;
-                    hasMatch   = true;
-                }
-                else
-                    *itMatches = Core::Type<s16>::min;
-            nMatches.front() = Core::Type<s16>::min;
-        }
-    }
-    return (nMatches.back() >= 0) ? nMatches.back() : -1;
-}
-
 void Configuration::Resource::writeUsage(XmlWriter& os) const {
     for (std::vector<Usage>::const_iterator u = usage.begin(); u != usage.end(); ++u) {
         os << "! used as: " << u->fullParameterName
@@ -164,6 +126,114 @@ void Configuration::Resource::writeUsage(XmlWriter& os) const {
     }
 }
 
+namespace {
+
+/**
+ * Selector index of the resources.
+ *
+ * Trie over the components of the resource names, wildcards are
+ * separate edges.  A resource matches a configuration path iff the
+ * path can be consumed along the resource name, where a component
+ * consumes exactly one equal path component and a wildcard consumes
+ * zero or more path components.  The specificity of a match is the
+ * number of non-wildcard components of the resource name.
+ */
+class ResourceIndex {
+public:
+    typedef Configuration::Resource Resource;
+
+    struct Match {
+        const Resource* resource;
+        s32             specificity;
+        Match(const Resource* resource, s32 specificity)
+                : resource(resource), specificity(specificity) {}
+        bool operator<(const Match& m) const {
+            return resource->getName() < m.resource->getName();
+        }
+    };
+
+private:
+    struct Node {
+        StringHashMap<Node*> components;
+        Node*                wildcard;
+        const Resource*      resource;
+        s32                  specificity;
+
+        Node(s32 specificity)
+                : wildcard(0), resource(0), specificity(specificity) {}
+        ~Node() {
+            for (StringHashMap<Node*>::iterator it = components.begin(); it != components.end(); ++it)
+                delete it->second;
+            delete wildcard;
+        }
+
+    private:
+        Node(const Node&);
+        Node& operator=(const Node&);
+    };
+    typedef std::pair<const Node*, u32> Hypothesis;
+
+    Node root_;
+
+public:
+    ResourceIndex()
+            : root_(0) {}
+
+    /** Add the resource, or replace the resource with the same name. */
+    void set(const Resource* resource);
+
+    /** All resources matching the path, in no particular order. */
+    void find(const std::vector<std::string>& path, std::vector<Match>& matches) const;
+};
+
+void ResourceIndex::set(const Resource* resource) {
+    Node*           node = &root_;
+    StringTokenizer tokenizer(resource->getName(), Configuration::resource_separation_string);
+    for (StringTokenizer::Iterator token = tokenizer.begin(); token != tokenizer.end(); ++token) {
+        if (*token == Configuration::resource_wildcard_string) {
+            if (!node->wildcard)
+                node->wildcard = new Node(node->specificity);
+            node = node->wildcard;
+        }
+        else {
+            Node*& next = node->components[*token];
+            if (!next)
+                next = new Node(node->specificity + 1);
+            node = next;
+        }
+    }
+    node->resource = resource;
+}
+
+void ResourceIndex::find(const std::vector<std::string>& path, std::vector<Match>& matches) const {
+    const u32               n = path.size();
+    std::vector<Hypothesis> stack(1, Hypothesis(&root_, 0));
+    // a node may be reached with the same number of consumed components on several ways
+    std::set<Hypothesis> visited;
+    while (!stack.empty()) {
+        Hypothesis h = stack.back();
+        stack.pop_back();
+        if (!visited.insert(h).second)
+            continue;
+        const Node* node = h.first;
+        u32         i    = h.second;
+        if (i == n) {
+            if (node->resource)
+                matches.push_back(Match(node->resource, node->specificity));
+        }
+        else {
+            StringHashMap<Node*>::const_iterator next = node->components.find(path[i]);
+            if (next != node->components.end())
+                stack.push_back(Hypothesis(next->second, i + 1));
+        }
+        if (node->wildcard)
+            for (u32 j = i; j <= n; ++j)
+                stack.push_back(Hypothesis(node->wildcard, j));
+    }
+}
+
+}  // namespace
+
 /**
  * Central storage place for all resources.
  */
@@ -173,6 +243,11 @@ private:
     std::set<Resource> resources;
     Resource           noResource_;
     bool               isLogging_;
+    ResourceIndex      index_;
+
+    /** memo of find() and of the resolved values, cleared by set() */
+    mutable StringHashMap<const Resource*> matches_;
+    mutable StringHashMap<std::string>     values_;
 
     typedef std::list<SourceDescriptor*> SourceList;
     SourceList                           sources_;
@@ -196,6 +271,21 @@ public:
      */
     const Resource* find(const std::string& parameter) const;
 
+    /**
+     * Memo of resolved values of fully qualified parameters.
+     * The resolved value of a parameter depends only on the resources.
+     */
+    bool getResolvedValue(const std::string& parameter, std::string& value) const {
+        StringHashMap<std::string>::const_iterator it = values_.find(parameter);
+        if (it == values_.end())
+            return false;
+        value = it->second;
+        return true;
+    }
+    void setResolvedValue(const std::string& parameter, const std::string& value) const {
+        values_[parameter] = value;
+    }
+
     const std::set<Resource>& getResources() const {
         return resources;
     }
@@ -243,15 +333,24 @@ void Configuration::ResourceDataBase::set(
     // delete existing resources with the same name
     resources.erase(res);
 
-    bool isInserted = resources.insert(res).second;
+    std::pair<std::set<Resource>::iterator, bool> inserted = resources.insert(res);
 
-    ensure(isInserted);
+    ensure(inserted.second);
+    index_.set(&*inserted.first);
+    matches_.clear();
+    values_.clear();
 }
 
 const Configuration::Resource* Configuration::ResourceDataBase::find(
         const std::string& parameter) const {
     require(isWellFormedParameterName(parameter));
 
+    if (!isLogging_) {
+        StringHashMap<const Resource*>::const_iterator it = matches_.find(parameter);
+        if (it != matches_.end())
+            return it->second;
+    }
+
     // split parameter string into components
     std::vector<std::string> components;
     StringTokenizer          tokenizer(parameter, resource_separation_string);
@@ -259,40 +358,36 @@ const Configuration::Resource* Configuration::ResourceDataBase::find(
         components.push_back(*token);
     }
 
+    // all matching resources in the order of the resource names
+    std::vector<ResourceIndex::Match> matches;
+    index_.find(components, matches);
+    std::sort(matches.begin(), matches.end());
+
     s32             specific = 0;
     u32             ties     = 0;
     const Resource* result   = 0;
 
-    // try all resources to find best (most specific) match
-    std::set<Resource>::const_iterator it;
-
-    // debug
-    // std::cerr << "match " << parameter << "(" << resources.size() << "):" << std::endl;
-
-    for (it = resources.begin(); it != resources.end(); it++) {
-        s32 m = it->match(components);
-
-        // debug
-        // if (m > 0) std::cerr << it->getName() << " matches with score " << m << std::endl;
-
+    // find best (most specific) match, on ties the first resource name wins
+    std::vector<ResourceIndex::Match>::const_iterator it;
+    for (it = matches.begin(); it != matches.end(); ++it) {
+        s32 m = it->specificity;
         if (m > specific) {
             specific = m;
             ties     = 0;
-            result   = &(*it);
+            result   = it->resource;
         }
         else if (m == specific) {
             ++ties;
         }
     }
 
-    if (ties > 0) {
+    if (result && (ties > 0)) {
         std::cerr << "configuration warning: \""
                   << parameter << "\" is matched by "
                   << (ties + 1) << " equally specific resources:" << std::endl;
-        for (it = resources.begin(); it != resources.end(); it++) {
-            s32 m = it->match(components);
-            if (m == specific)
-                std::cerr << "  - \"" << it->getName() << "\"" << std::endl;
+        for (it = matches.begin(); it != matches.end(); ++it) {
+            if (it->specificity == specific)
+                std::cerr << "  - \"" << it->resource->getName() << "\"" << std::endl;
         }
 
         std::cerr << "using: \""
@@ -310,6 +405,9 @@ const Configuration::Resource* Configuration::ResourceDataBase::find(
             std::cerr << parameter << "\" is not matched."
                       << std::endl;
     }
+    else {
+        matches_[parameter] = result;
+    }
 
     return result;
 }
@@ -959,7 +1057,10 @@ bool Configuration::get(const std::string& parameter, std::string& value) const
     // get value for parameter
     const Resource* resource = find(query);
     if (resource) {
-        value = getResolvedValue(resource);
+        if (!db_->getResolvedValue(query, value)) {
+            value = getResolvedValue(resource);
+            db_->setResolvedValue(query, value);
+        }
         resource->registerUsage(query, 0, value);
         return true;
     }
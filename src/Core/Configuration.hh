@@ -262,6 +262,8 @@ public:
 private:
     /**
      * Find the resource for a given parameter.
+     * Resources are looked up in a selector index over the resource
+     * names; results are memoized until the next set().
      * @param parameter the parameter specification string
      * @return the most specific resource matching @c parameter
      */
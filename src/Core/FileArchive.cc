@@ -12,6 +12,7 @@
  *  See the License for the specific language governing permissions and
  *  limitations under the License.
  */
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #if !defined(OS_linux) && !defined(truncate64)
@@ -164,6 +165,7 @@ FileArchive::FileArchive(const Configuration& c, const std::string& p, AccessMod
         : Archive(c, p, access),
           allowOverwrite_(paramOverwrite(c)),
           stream_(0),
+          fd_(-1),
           open_(false),
           changed_(false) {
     // create file archive if necessary
@@ -211,10 +213,20 @@ FileArchive::FileArchive(const Configuration& c, const std::string& p, AccessMod
         open_ = true;
 
         readFileInfoTable();
+
+        // the file info table does not change any more, files can be read concurrently by pread()
+        if (!(access & AccessModeWrite)) {
+            fd_ = ::open(path().c_str(), O_RDONLY);
+            if (fd_ == -1)
+                warning("Failed to open archive file \"%s\" for concurrent reads.", path().c_str());
+        }
     }
 }
 
 FileArchive::~FileArchive() {
+    stopReadAhead();
+    if (fd_ != -1)
+        ::close(fd_);
     if (open_) {
         writeFileInfoTable();
         if (stream_)
@@ -463,6 +475,12 @@ u32 FileArchive::getChecksum(const std::string& b) const {
     return checksum;
 }
 
+bool FileArchive::sync() {
+    if (!open_)
+        return false;
+    return stream_->synchronizeBuffer();
+}
+
 bool FileArchive::discover(const std::string& name, Sizes& sizes) const {
     const FileInfo* fi = file(name);
     if (!fi)
@@ -479,17 +497,32 @@ bool FileArchive::read(const std::string& name, std::string& b) const {
     if (!fi)
         return false;
 
+    const u32 size = fi->sizes.compressed() ? fi->sizes.compressed() : fi->sizes.uncompressed();
+    if (fd_ != -1) {
+        // size, compressed size and checksum are followed by the data
+        u8     sizes[3 * sizeof(u32)];
+        bool   ok       = (::pread(fd_, sizes, sizeof(sizes), fi->position) == ssize_t(sizeof(sizes)));
+        u64    position = fi->position + sizeof(sizes);
+        size_t done     = 0;
+        while (ok && done < size) {
+            ssize_t n = ::pread(fd_, &b[done], size - done, position + done);
+            if (n <= 0)
+                ok = false;
+            else
+                done += n;
+        }
+        // checksum is stored in little endian byte order
+        u32 checksum = u32(sizes[8]) | (u32(sizes[9]) << 8) | (u32(sizes[10]) << 16) | (u32(sizes[11]) << 24);
+        return ok && getChecksum(b) == checksum;
+    }
+
     stream_->clear();
     stream_->BinaryInputStream::seek(fi->position);
     u32 tmp;
     *stream_ >> tmp;  // read size
     *stream_ >> tmp;  // read compressed
     *stream_ >> tmp;  // read checksum
-    bool ok;
-    if (fi->sizes.compressed())
-        ok = stream_->read(&b[0], fi->sizes.compressed());
-    else
-        ok = stream_->read(&b[0], fi->sizes.uncompressed());
+    bool ok = stream_->read(&b[0], size);
     // check if checksum is ok
     if (getChecksum(b) != tmp)
         ok = false;
@@ -497,6 +530,17 @@ bool FileArchive::read(const std::string& name, std::string& b) const {
     return ok;
 }
 
+bool FileArchive::nextFiles(const std::string& name, u32 n, std::vector<std::string>& names) const {
+    std::map<std::string, u32>::const_iterator i = hashedFiles_.find(name);
+    if (i == hashedFiles_.end())
+        return false;
+    for (u32 f = i->second + 1; f < files_.size() && names.size() < n; ++f) {
+        if (!files_[f].isEmpty())
+            names.push_back(files_[f].name);
+    }
+    return true;
+}
+
 bool FileArchive::write(const std::string& name, const std::string& b, const Sizes& sizes) {
     require(hasAccess(AccessModeWrite));
     if (!open_)
@@ -30,6 +30,7 @@ private:
     struct FileInfo;
 
     BinaryStream*              stream_;
+    int                        fd_;  // for concurrent reads of read-only archives, -1 otherwise
     bool                       open_;
     bool                       changed_;
     std::streampos             endOfArchive_;
@@ -57,6 +58,11 @@ private:
 
 protected:
     virtual bool discover(const std::string& name, Sizes& sizes) const;
+    virtual bool supportsConcurrentReads() const {
+        return fd_ != -1;
+    }
+    virtual bool nextFiles(const std::string& name, u32 n, std::vector<std::string>& names) const;
+    virtual bool sync();
     virtual bool read(const std::string& name, std::string& b) const;
     virtual bool write(const std::string& name, const std::string& b, const Sizes& sizes);
     virtual bool remove(const std::string& name);
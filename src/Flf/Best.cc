@@ -46,22 +46,23 @@ std::pair<ConstLatticeRef, Score> bestProjection(ConstLatticeRef l) {
     ConstStateMapRef topologicalSort = sortTopologically(l);
     Fsa::StateId     initialSid      = topologicalSort->front();
     Traceback        traceback(topologicalSort->maxSid + 1);
+    StateViewer      viewer(l.get());
     traceback[initialSid].score = 0.0;
     TraceElement bestTrace;
     for (u32 i = 0; i < topologicalSort->size(); ++i) {
         const Fsa::StateId sid = (*topologicalSort)[i];
-        ConstStateRef      sr  = l->getState(sid);
+        const StateView    sr  = viewer(sid);
 
         const TraceElement& currentTrace = traceback[sid];
-        if (sr->isFinal()) {
-            const Score score = add(currentTrace.score, semiring.project(sr->weight()));
+        if (sr.isFinal()) {
+            const Score score = add(currentTrace.score, semiring.project(sr.weight()));
             if (score < bestTrace.score) {
                 bestTrace.score = score;
                 bestTrace.sid   = sid;
             }
         }
         Fsa::StateId aid = 0;
-        for (State::const_iterator a = sr->begin(), end = sr->end(); a != end; ++a, ++aid) {
+        for (StateView::const_iterator a = sr.begin(), end = sr.end(); a != end; ++a, ++aid) {
             const Score   score = add(currentTrace.score, semiring.project(a->weight()));
             TraceElement& trace = traceback[a->target()];
             if (score < trace.score) {
@@ -14,6 +14,7 @@
  */
 #include "Copy.hh"
 #include "FlfCore/Basic.hh"
+#include "FlfCore/ScoreColumns.hh"
 #include "FlfCore/Traverse.hh"
 
 namespace Flf {
@@ -255,8 +256,8 @@ ConstLatticeRef normalizeDeepCopy(ConstLatticeRef l) {
 // -------------------------------------------------------------------------
 
 // -------------------------------------------------------------------------
-class BoundariesCopyBuilder : public TraverseState {
-    typedef TraverseState Precursor;
+class BoundariesCopyBuilder : public TraverseStateView {
+    typedef TraverseStateView Precursor;
 
 private:
     ConstBoundariesRef boundaries_;
@@ -270,8 +271,8 @@ public:
     }
     virtual ~BoundariesCopyBuilder() {}
 
-    void exploreState(ConstStateRef sr) {
-        staticBoundaries_->set(sr->id(), boundaries_->get(sr->id()));
+    void exploreState(const StateView& s) {
+        staticBoundaries_->set(s.id(), boundaries_->get(s.id()));
     }
 };
 
@@ -294,17 +295,111 @@ ConstLatticeRef copyBoundaries(ConstLatticeRef l) {
 }
 // -------------------------------------------------------------------------
 
+// -------------------------------------------------------------------------
+class CompactCopyBuilder : public TraverseState {
+    typedef TraverseState Precursor;
+
+private:
+    ConstBoundariesRef boundaries_;
+    CompactLattice*    compactLattice_;
+    StaticBoundaries*  staticBoundaries_;
+
+public:
+    CompactCopyBuilder(ConstLatticeRef l, CompactLattice* compactLattice, StaticBoundaries* staticBoundaries)
+            : Precursor(l),
+              boundaries_(l->getBoundaries()),
+              compactLattice_(compactLattice),
+              staticBoundaries_(staticBoundaries) {
+        traverse();
+    }
+    virtual ~CompactCopyBuilder() {}
+
+    void exploreState(ConstStateRef sr) {
+        compactLattice_->addState(*sr);
+        if (staticBoundaries_)
+            staticBoundaries_->set(sr->id(), boundaries_->get(sr->id()));
+    }
+};
+
+ConstLatticeRef compactCopy(ConstLatticeRef l) {
+    if (!l || (l->initialStateId() == Fsa::InvalidStateId))
+        return l;
+    if (dynamic_cast<const CompactLattice*>(l.get()))
+        return l;
+    CompactLattice* compactLattice = new CompactLattice(l->type());
+    compactLattice->setDescription(Core::form("compact(%s)", l->describe().c_str()));
+    compactLattice->setProperties(l->knownProperties() & ~(Fsa::PropertyStorage | Fsa::PropertyCached), l->properties());
+    compactLattice->setInputAlphabet(l->getInputAlphabet());
+    if (l->type() != Fsa::TypeAcceptor)
+        compactLattice->setOutputAlphabet(l->getOutputAlphabet());
+    compactLattice->setSemiring(l->semiring());
+    compactLattice->setInitialStateId(l->initialStateId());
+    StaticBoundaries* staticBoundaries = l->getBoundaries()->valid() ? new StaticBoundaries : 0;
+    CompactCopyBuilder buildCompactCopy(l, compactLattice, staticBoundaries);
+    compactLattice->pack();
+    compactLattice->setTopologicalSort(l->getTopologicalSort());
+    if (staticBoundaries)
+        compactLattice->setBoundaries(ConstBoundariesRef(staticBoundaries));
+    return ConstLatticeRef(compactLattice);
+}
+
+ConstLatticeRef columnCopy(ConstLatticeRef l) {
+    if (!l || (l->initialStateId() == Fsa::InvalidStateId))
+        return l;
+    if (dynamic_cast<const ColumnLattice*>(l.get()))
+        return l;
+    ConstCompactLatticeRef c = ConstCompactLatticeRef(static_cast<const CompactLattice*>(compactCopy(l).get()));
+    ConstSemiringRef       semiring = c->semiring();
+    CompactLattice*        topology = new CompactLattice(c->type());
+    topology->setDescription(l->describe());
+    topology->setProperties(c->knownProperties() & ~(Fsa::PropertyStorage | Fsa::PropertyCached), c->properties());
+    topology->setInputAlphabet(c->getInputAlphabet());
+    if (c->type() != Fsa::TypeAcceptor)
+        topology->setOutputAlphabet(c->getOutputAlphabet());
+    topology->setSemiring(semiring);
+    topology->setInitialStateId(c->initialStateId());
+    ScoreColumnsRef arcScores(new ScoreColumns(semiring->size(), c->nArcs()));
+    ScoreColumnsRef finalScores(new ScoreColumns(semiring->size(), c->size()));
+    State           sr;
+    for (Fsa::StateId s = 0; s < c->size(); ++s) {
+        StateView view = c->state(s);
+        if (!view.valid())
+            continue;
+        // the arcs of the topology keep the order of c, i.e. the arc indices do not change
+        sr.clear();
+        sr.setId(s);
+        sr.setTags(view.tags());
+        if (view.isFinal())
+            finalScores->setRow(s, view.weight());
+        u32 row = c->arcIndex(s);
+        for (StateView::const_iterator a = view.begin(), a_end = view.end(); a != a_end; ++a, ++row) {
+            arcScores->setRow(row, a->weight());
+            sr.newArc(a->target(), ScoresRef(), a->input(), a->output());
+        }
+        topology->addState(sr);
+    }
+    topology->pack();
+    topology->setTopologicalSort(c->getTopologicalSort());
+    topology->setBoundaries(c->getBoundaries());
+    return ConstLatticeRef(new ColumnLattice(ConstCompactLatticeRef(topology), semiring, arcScores, finalScores));
+}
+// -------------------------------------------------------------------------
+
 // -------------------------------------------------------------------------
 class CopyNode : public FilterNode {
 public:
     static const Core::ParameterBool paramDeepCopy;
     static const Core::ParameterBool paramTrim;
     static const Core::ParameterBool paramNormalize;
+    static const Core::ParameterBool paramCompact;
+    static const Core::ParameterBool paramScoreColumns;
 
 private:
     bool deepCopy_;
     bool trim_;
     bool normalize_;
+    bool compact_;
+    bool scoreColumns_;
 
 protected:
     virtual ConstLatticeRef filter(ConstLatticeRef l) {
@@ -330,18 +425,29 @@ protected:
         else if (normalize_) {
             l = deepCopy_ ? normalizeDeepCopy(l) : normalizeCopy(l);
         }
+        else if (compact_ || scoreColumns_) {
+            // the compact copy is made below; a column copy copies the scores by value anyway
+            if (deepCopy_ && !scoreColumns_)
+                l = deepCopy(l);
+        }
         else {
             l = deepCopy_ ? deepCopy(l) : persistent(l);
         }
+        if (scoreColumns_)
+            l = columnCopy(l);
+        else if (compact_)
+            l = compactCopy(l);
         return l;
     }
 
 public:
     CopyNode(const std::string& name, const Core::Configuration& config)
             : FilterNode(name, config) {
-        deepCopy_  = paramDeepCopy(config);
-        trim_      = paramTrim(config);
-        normalize_ = paramNormalize(config);
+        deepCopy_     = paramDeepCopy(config);
+        trim_         = paramTrim(config);
+        normalize_    = paramNormalize(config);
+        compact_      = paramCompact(config);
+        scoreColumns_ = paramScoreColumns(config);
     }
     virtual ~CopyNode() {}
 };
@@ -357,6 +463,14 @@ const Core::ParameterBool CopyNode::paramNormalize(
         "normalize",
         "normalize lattice",
         false);
+const Core::ParameterBool CopyNode::paramCompact(
+        "compact",
+        "store lattice in compact layout, i.e. in a few contiguous arrays",
+        false);
+const Core::ParameterBool CopyNode::paramScoreColumns(
+        "score-columns",
+        "store lattice in compact layout and the scores per dimension in contiguous columns; implies compact",
+        false);
 NodeRef createCopyNode(const std::string& name, const Core::Configuration& config) {
     return NodeRef(new CopyNode(name, config));
 }
@@ -49,6 +49,24 @@ ConstLatticeRef       persistent(ConstLatticeRef l);
 ConstLatticeRef       copy(ConstLatticeRef l);
 ConstLatticeRef       deepCopy(ConstLatticeRef l);
 
+/**
+ * Compact Copy:
+ *  Copy states and weight references into a CompactLattice, i.e. a few contiguous arrays;
+ *  boundaries and topological order are kept
+ *  -> used for lattices which are traversed many times, e.g. by confusion network construction;
+ *     only traversals reading states by StateViewer/TraverseStateView profit (see Fsa/tCompact.hh),
+ *     getState() allocates a new state per call
+ **/
+ConstLatticeRef compactCopy(ConstLatticeRef l);
+
+/**
+ * Column Copy:
+ *  Compact copy of the topology, the scores are copied into per-dimension columns,
+ *  see FlfCore/ScoreColumns.hh; boundaries and topological order are kept
+ *  -> used for whole-lattice score operations on lattices with many dimensions
+ **/
+ConstLatticeRef columnCopy(ConstLatticeRef l);
+
 /**
  * Normalize state numbering,
  * Copy,
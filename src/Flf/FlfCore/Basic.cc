@@ -18,6 +18,7 @@
 #include "Basic.hh"
 #include "Ftl.hh"
 #include "LatticeInternal.hh"
+#include "ScoreColumns.hh"
 #include "Traverse.hh"
 
 namespace Flf {
@@ -28,6 +29,9 @@ ConstLatticeRef changeSemiring(ConstLatticeRef l, ConstSemiringRef targetSemirin
         Core::Application::us()->criticalError(
                 "Cannot replace semiring \"%s\" by \"%s\"; semirings differ in size.",
                 l->semiring()->name().c_str(), targetSemiring->name().c_str());
+    const ColumnLattice* c = dynamic_cast<const ColumnLattice*>(l.get());
+    if (c)
+        return c->changeSemiring(targetSemiring);
     return FtlWrapper::changeSemiring(l, targetSemiring);
 }
 
@@ -85,6 +89,17 @@ public:
     }
 };
 ConstLatticeRef projectSemiring(ConstLatticeRef l, ConstSemiringRef targetSemiring, const ProjectionMatrix& mapping) {
+    const ColumnLattice* c = dynamic_cast<const ColumnLattice*>(l.get());
+    if (c) {
+        // project whole columns; the scores of non-final states are ignored as in ProjectSemiringLattice
+        verify(mapping.size() <= targetSemiring->size());
+        for (ProjectionMatrix::const_iterator itScales = mapping.begin(); itScales != mapping.end(); ++itScales)
+            verify(itScales->size() == c->semiring()->size());
+        return ConstLatticeRef(new ColumnLattice(
+                c->topology(), targetSemiring,
+                c->arcScores()->project(mapping, targetSemiring->size()),
+                c->finalScores()->project(mapping, targetSemiring->size())));
+    }
     return ConstLatticeRef(new ProjectSemiringLattice(l, targetSemiring, mapping));
 }
 // -------------------------------------------------------------------------
@@ -19,6 +19,7 @@
 #include <Core/ReferenceCounting.hh>
 #include <Core/Vector.hh>
 #include <Fsa/tAutomaton.hh>
+#include <Fsa/tCompact.hh>
 #include <Fsa/tStatic.hh>
 
 #include "Boundaries.hh"
@@ -159,6 +160,15 @@ typedef Core::Vector<ConstLatticeRef> ConstLatticeRefList;
 typedef Ftl::StaticAutomaton<Lattice> StaticLattice;
 typedef Core::Ref<StaticLattice>      StaticLatticeRef;
 
+/**
+ * Immutable lattice in compressed sparse row layout, see Fsa/tCompact.hh;
+ * use Flf::compactCopy() to keep boundaries and topological order.
+ **/
+typedef Ftl::CompactAutomaton<Lattice>  CompactLattice;
+typedef Core::Ref<const CompactLattice> ConstCompactLatticeRef;
+typedef Ftl::StateView<Lattice>         StateView;
+typedef Ftl::StateViewer<Lattice>       StateViewer;
+
 /**
  * Abstract Confusion Networks;
  * arc type is abstract.
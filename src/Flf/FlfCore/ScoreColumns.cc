@@ -0,0 +1,132 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Core/Assertions.hh>
+#include <Core/StringUtilities.hh>
+#include <Core/Types.hh>
+
+#include "ScoreColumns.hh"
+
+namespace Flf {
+
+// -------------------------------------------------------------------------
+ScoreColumns::ScoreColumns(size_t nDimensions, size_t nRows, Score init)
+        : nDimensions_(nDimensions),
+          nRows_(nRows),
+          scores_(nDimensions * nRows, init) {}
+
+void ScoreColumns::setRow(size_t row, const ScoresRef& a) {
+    require(row < nRows_);
+    Scores::const_iterator itScore = a->begin();
+    for (Score *s = scores_.data() + row, *end = s + nDimensions_ * nRows_; s != end; s += nRows_, ++itScore)
+        *s = *itScore;
+}
+
+ScoresRef ScoreColumns::getRow(size_t row, const Semiring& semiring) const {
+    require(row < nRows_);
+    verify_(semiring.size() == nDimensions_);
+    ScoresRef        a       = semiring.create();
+    Scores::iterator itScore = a->begin();
+    for (const Score *s = scores_.data() + row, *end = s + nDimensions_ * nRows_; s != end; s += nRows_, ++itScore)
+        *itScore = *s;
+    return a;
+}
+
+void ScoreColumns::project(const ScoreList& scales, Score* out) const {
+    verify(scales.size() <= nDimensions_);
+    std::fill(out, out + nRows_, Score(0.0));
+    // accumulate in the order of the dimensions as Scores::project does,
+    // rows with Max in an unmasked dimension are set to Max afterwards
+    std::vector<u8> isMax(nRows_, 0);
+    for (ScoreId id = 0; id < scales.size(); ++id) {
+        const Score scale = scales[id];
+        if (scale == 0.0)
+            continue;
+        const Score* x = column(id);
+        for (size_t i = 0; i < nRows_; ++i) {
+            isMax[i] |= (x[i] == Core::Type<Score>::max);
+            out[i] += scale * x[i];
+        }
+    }
+    for (size_t i = 0; i < nRows_; ++i)
+        if (isMax[i])
+            out[i] = Core::Type<Score>::max;
+}
+
+ScoreColumnsRef ScoreColumns::project(const std::vector<ScoreList>& mapping, size_t nDimensions) const {
+    verify(mapping.size() <= nDimensions);
+    ScoreColumnsRef result(new ScoreColumns(nDimensions, nRows_));
+    for (ScoreId id = 0; id < mapping.size(); ++id)
+        project(mapping[id], result->column(id));
+    return result;
+}
+// -------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------
+ColumnLattice::ColumnLattice(ConstCompactLatticeRef topology, ConstSemiringRef semiring,
+                             ConstScoreColumnsRef arcScores, ConstScoreColumnsRef finalScores)
+        : Precursor(),
+          topology_(topology),
+          semiring_(semiring),
+          arcScores_(arcScores),
+          finalScores_(finalScores) {
+    verify(arcScores_->nRows() == topology_->nArcs());
+    verify(finalScores_->nRows() == topology_->size());
+    verify((arcScores_->nDimensions() == semiring_->size()) && (finalScores_->nDimensions() == semiring_->size()));
+    setProperties(topology_->knownProperties(), topology_->properties());
+    setBoundaries(topology_->getBoundaries());
+    setTopologicalSort(topology_->getTopologicalSort());
+}
+
+ConstColumnLatticeRef ColumnLattice::changeSemiring(ConstSemiringRef semiring) const {
+    verify(semiring->size() == semiring_->size());
+    return ConstColumnLatticeRef(new ColumnLattice(topology_, semiring, arcScores_, finalScores_));
+}
+
+ConstStateRef ColumnLattice::getState(Fsa::StateId s) const {
+    StateView view = topology_->state(s);
+    if (!view.valid())
+        return ConstStateRef();
+    if (states_.empty())
+        states_.resize(topology_->size());
+    ConstStateRef& sr = states_[s];
+    if (!sr) {
+        State* sp = new State(s, view.tags(), view.isFinal() ? finalScores_->getRow(s, *semiring_) : semiring_->one());
+        u32    row = topology_->arcIndex(s);
+        for (StateView::const_iterator a = view.begin(), a_end = view.end(); a != a_end; ++a, ++row)
+            sp->newArc(a->target(), arcScores_->getRow(row, *semiring_), a->input(), a->output());
+        sr = ConstStateRef(sp);
+    }
+    return sr;
+}
+
+size_t ColumnLattice::getMemoryUsed() const {
+    return sizeof(ColumnLattice) + topology_->getMemoryUsed() + arcScores_->getMemoryUsed() + finalScores_->getMemoryUsed();
+}
+
+void ColumnLattice::dumpMemoryUsage(Core::XmlWriter& o) const {
+    o << Core::XmlOpen("columns");
+    topology_->dumpMemoryUsage(o);
+    o << Core::XmlFull("arc-scores", arcScores_->getMemoryUsed())
+      << Core::XmlFull("final-scores", finalScores_->getMemoryUsed())
+      << Core::XmlFull("total", getMemoryUsed())
+      << Core::XmlClose("columns");
+}
+
+std::string ColumnLattice::describe() const {
+    return Core::form("columns(%s)", topology_->describe().c_str());
+}
+// -------------------------------------------------------------------------
+
+}  // namespace Flf
@@ -0,0 +1,161 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _FLF_CORE_SCORE_COLUMNS_HH
+#define _FLF_CORE_SCORE_COLUMNS_HH
+
+#include <Core/ReferenceCounting.hh>
+#include <Core/XmlStream.hh>
+#include <vector>
+
+#include "Lattice.hh"
+#include "Semiring.hh"
+#include "Weight.hh"
+
+namespace Flf {
+
+/**
+ * Score columns:
+ * scores of a set of rows (e.g. all arcs of a lattice) in structure-of-arrays layout,
+ * i.e. dimension id of all rows is stored in one contiguous column.
+ *
+ * Operations on whole columns are plain loops over contiguous arrays and
+ * are vectorized by the compiler; compared to per-arc Scores objects there is
+ * neither an allocation nor a reference count per row.
+ **/
+class ScoreColumns : public Core::ReferenceCounted {
+private:
+    size_t    nDimensions_;
+    size_t    nRows_;
+    ScoreList scores_;
+
+public:
+    ScoreColumns(size_t nDimensions, size_t nRows, Score init = Semiring::One);
+
+    size_t nDimensions() const {
+        return nDimensions_;
+    }
+    size_t nRows() const {
+        return nRows_;
+    }
+
+    Score* column(ScoreId id) {
+        return scores_.data() + id * nRows_;
+    }
+    const Score* column(ScoreId id) const {
+        return scores_.data() + id * nRows_;
+    }
+    Score get(size_t row, ScoreId id) const {
+        return scores_[id * nRows_ + row];
+    }
+    void set(size_t row, ScoreId id, Score s) {
+        scores_[id * nRows_ + row] = s;
+    }
+
+    /** Copy the scores a, which have at least nDimensions() dimensions, to row. */
+    void setRow(size_t row, const ScoresRef& a);
+    /** Copy row to newly allocated scores of the semiring. */
+    ScoresRef getRow(size_t row, const Semiring& semiring) const;
+
+    /**
+     * Linear combination of each row, out[row] = project(row);
+     * the result equals Scores::project, i.e. a scale of 0.0 masks a
+     * dimension and Max in an unmasked dimension results in Max.
+     **/
+    void project(const ScoreList& scales, Score* out) const;
+
+    /**
+     * Projection of all rows: dimension i of the result is the
+     * linear combination of the rows with scales mapping[i] (see project);
+     * the dimensions mapping.size() to nDimensions - 1 are One.
+     **/
+    Core::Ref<ScoreColumns> project(const std::vector<ScoreList>& mapping, size_t nDimensions) const;
+
+    size_t getMemoryUsed() const {
+        return sizeof(ScoreColumns) + scores_.size() * sizeof(Score);
+    }
+};
+typedef Core::Ref<ScoreColumns>       ScoreColumnsRef;
+typedef Core::Ref<const ScoreColumns> ConstScoreColumnsRef;
+
+/**
+ * Column lattice:
+ * the topology is a CompactLattice without weights, the scores are stored
+ * in score columns.  Row i of arcScores() are the scores of the arc
+ * with index i in the topology (see CompactAutomaton::arcIndex),
+ * row s of finalScores() is the final weight of state s.
+ *
+ * getState() materializes the state including the scores of all arcs on
+ * first access and keeps it, i.e. repeated traversals do not allocate
+ * (the materialized states need as much memory as a static lattice);
+ * algorithms aware of the column layout operate on the columns directly,
+ * e.g. rescale, changeSemiring, projectSemiring and the fwd./bwd. algorithm.
+ * Boundaries and topological order are those of the topology.
+ * Use Flf::columnCopy() to convert an arbitrary lattice.
+ **/
+class ColumnLattice : public Lattice {
+    typedef Lattice Precursor;
+
+private:
+    ConstCompactLatticeRef topology_;
+    ConstSemiringRef       semiring_;
+    ConstScoreColumnsRef   arcScores_;
+    ConstScoreColumnsRef   finalScores_;
+    /** materialized states, see getState() */
+    mutable std::vector<ConstStateRef> states_;
+
+public:
+    ColumnLattice(ConstCompactLatticeRef topology, ConstSemiringRef semiring,
+                  ConstScoreColumnsRef arcScores, ConstScoreColumnsRef finalScores);
+    virtual ~ColumnLattice() {}
+
+    ConstCompactLatticeRef topology() const {
+        return topology_;
+    }
+    ConstScoreColumnsRef arcScores() const {
+        return arcScores_;
+    }
+    ConstScoreColumnsRef finalScores() const {
+        return finalScores_;
+    }
+
+    /** Same topology and scores, different semiring of the same size. */
+    Core::Ref<const ColumnLattice> changeSemiring(ConstSemiringRef semiring) const;
+
+    virtual Fsa::Type type() const {
+        return topology_->type();
+    }
+    virtual ConstSemiringRef semiring() const {
+        return semiring_;
+    }
+    virtual Fsa::StateId initialStateId() const {
+        return topology_->initialStateId();
+    }
+    virtual Fsa::ConstAlphabetRef getInputAlphabet() const {
+        return topology_->getInputAlphabet();
+    }
+    virtual Fsa::ConstAlphabetRef getOutputAlphabet() const {
+        return topology_->getOutputAlphabet();
+    }
+    virtual ConstStateRef getState(Fsa::StateId s) const;
+
+    virtual size_t      getMemoryUsed() const;
+    virtual void        dumpMemoryUsage(Core::XmlWriter& o) const;
+    virtual std::string describe() const;
+};
+typedef Core::Ref<const ColumnLattice> ConstColumnLatticeRef;
+
+}  // namespace Flf
+
+#endif  // _FLF_CORE_SCORE_COLUMNS_HH
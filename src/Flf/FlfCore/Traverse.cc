@@ -63,4 +63,47 @@ void TraverseState::traverse() {
 }
 // -------------------------------------------------------------------------
 
+// -------------------------------------------------------------------------
+void TraverseStateView::traverseDfs() {
+    Core::Vector<bool>         visited;
+    Core::Vector<Fsa::StateId> S;
+    S.push_back(l->initialStateId());
+    while (!S.empty()) {
+        Fsa::StateId sid(S.back());
+        S.pop_back();
+        visited.grow(sid, false);
+        if (visited[sid])
+            continue;
+        visited[sid]      = true;
+        const StateView s = viewer(sid);
+        exploreState(s);
+        for (StateView::const_iterator a = s.begin(); a != s.end(); ++a) {
+            exploreArc(s, *a);
+            S.push_back(a->target());
+        }
+    }
+}
+
+void TraverseStateView::traverseInTopologicalOrder() {
+    if (!sortTopologically(l))
+        Core::Application::us()->criticalError(
+                "\"%s\" has no topological order", l->describe().c_str());
+    for (StateMap::const_iterator itSid  = l->getTopologicalSort()->begin(),
+                                  endSid = l->getTopologicalSort()->end();
+         itSid != endSid; ++itSid) {
+        const StateView s = viewer(*itSid);
+        exploreState(s);
+        for (StateView::const_iterator a = s.begin(); a != s.end(); ++a)
+            exploreArc(s, *a);
+    }
+}
+
+void TraverseStateView::traverse() {
+    if (l->getTopologicalSort())
+        traverseInTopologicalOrder();
+    else
+        traverseDfs();
+}
+// -------------------------------------------------------------------------
+
 }  // namespace Flf
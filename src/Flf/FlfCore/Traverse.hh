@@ -55,6 +55,29 @@ public:
     virtual void traverse();
 };
 
+/**
+ * As TraverseState, but states are passed as StateView, see Fsa/tCompact.hh:
+ * traversing a CompactLattice neither allocates nor reference counts states.
+ * Use it, if states are only read during the traversal.
+ **/
+class TraverseStateView {
+protected:
+    ConstLatticeRef l;
+    StateViewer     viewer;
+
+protected:
+    virtual void exploreState(const StateView& s) {}
+    virtual void exploreArc(const StateView& from, const Arc& a) {}
+
+public:
+    TraverseStateView(ConstLatticeRef l)
+            : l(l), viewer(l.get()) {}
+    virtual ~TraverseStateView() {}
+    void         traverseDfs();
+    void         traverseInTopologicalOrder();
+    virtual void traverse();
+};
+
 }  // namespace Flf
 
 #endif  // _FLF_CORE_TRAVERSE_HH
@@ -29,6 +29,7 @@
 #include "Copy.hh"
 #include "Filter.hh"
 #include "FlfCore/Basic.hh"
+#include "FlfCore/ScoreColumns.hh"
 
 namespace Flf {
 
@@ -232,6 +233,37 @@ protected:
         virtual ~TraverseSubLattice() {}
     };
 
+    /*
+     * Posterior scores of a column lattice, projected column by column in advance;
+     * invalid for all other lattices.
+     */
+    class ProjectedScores {
+    private:
+        const ColumnLattice* c_;
+        ScoreList            arcScores_, finalScores_;
+
+    public:
+        ProjectedScores(ConstLatticeRef l, ConstSemiringRef posteriorSemiring)
+                : c_(dynamic_cast<const ColumnLattice*>(l.get())) {
+            if (c_) {
+                arcScores_.resize(c_->arcScores()->nRows());
+                c_->arcScores()->project(posteriorSemiring->scales(), arcScores_.data());
+                finalScores_.resize(c_->finalScores()->nRows());
+                c_->finalScores()->project(posteriorSemiring->scales(), finalScores_.data());
+            }
+        }
+        bool valid() const {
+            return c_;
+        }
+        // i-th arc of state sid
+        Score arc(Fsa::StateId sid, u32 i) const {
+            return arcScores_[c_->topology()->arcIndex(sid) + i];
+        }
+        Score final(Fsa::StateId sid) const {
+            return finalScores_[sid];
+        }
+    };
+
     struct ScoreArc {
         Fsa::LabelId target;
         f64          score;
@@ -280,6 +312,7 @@ public:
         Properties       properties;
         TraverseLattice  traverse(l, properties, *s, *b);
         ConstStateMapRef topologicalSort = properties.topologicalSort;
+        ProjectedScores  projected(l, posteriorSemiring);
         s->setInitialStateId(topologicalSort->front());
         /*
          * Data structures
@@ -323,7 +356,7 @@ public:
             const Flf::State* sp = s->fastState(sid);
             if (!sp->hasArcs()) {
                 verify(sp->isFinal());
-                stateScore.bwdScore = posteriorSemiring->project(sp->weight());
+                stateScore.bwdScore = projected.valid() ? projected.final(sid) : posteriorSemiring->project(sp->weight());
                 if (hasRisk)
                     stateScore.cost = stateScore.genBwdScore = sp->weight()->get(params.costId);
             }
@@ -334,7 +367,7 @@ public:
                     stateScore.fwdEnd->target       = targetSid;
                     ScoreState& targetStateScore    = stateScores[targetSid];
                     targetStateScore.bwdEnd->target = sid;
-                    f64 score                       = posteriorSemiring->project(a->weight());
+                    f64 score                       = projected.valid() ? projected.arc(sid, a - sp->begin()) : posteriorSemiring->project(a->weight());
                     stateScore.fwdEnd->score        = score;
                     targetStateScore.bwdEnd->score  = score;
                     f64 bwdScore                    = targetStateScore.bwdScore + score;
@@ -625,6 +658,7 @@ public:
             ScoreArc *       nextFwdArcScores = fwdArcScores, *endFwdArcScores = fwdArcScores + properties.nArcs;
             ScoreArc *       nextBwdArcScores = bwdArcScores, *endBwdArcScores = bwdArcScores + properties.nArcs;
             ConstSemiringRef posteriorSemiring = posteriorSemirings[i];
+            ProjectedScores  projected(lats[i], posteriorSemiring);
             const Semiring&  semiring          = *semiringCombo.semiring();
             u32              paramIndex        = indexMap[i];
             Fsa::LabelId     systemLabel       = hasSystemLabels ? params.systemLabels[paramIndex] : Fsa::Epsilon;
@@ -653,13 +687,13 @@ public:
                 const Flf::State* unionSp  = unionL->fastState(unionSid);
                 if (!unionSp->hasArcs()) {
                     verify(unionSp->isFinal());
-                    stateScore.bwdScore = posteriorSemiring->project(unionSp->weight());
+                    stateScore.bwdScore = projected.valid() ? projected.final(sid) : posteriorSemiring->project(unionSp->weight());
                 }
                 else {
                     stateScore.score = 0.0;
                     for (Flf::State::const_iterator a = unionSp->begin(), a_end = unionSp->end(); a != a_end; ++a) {
                         Fsa::StateId targetSid    = a->target() - offsetSid;
-                        f64          score        = posteriorSemiring->project(a->weight());
+                        f64          score        = projected.valid() ? projected.arc(sid, a - unionSp->begin()) : posteriorSemiring->project(a->weight());
                         stateScore.fwdEnd->target = targetSid;
                         stateScore.fwdEnd->score  = score;
                         ++stateScore.fwdEnd;
@@ -741,12 +741,12 @@ Lexicon::LemmaToEvaluationTokenTransducerRef Lexicon::lemmaToPreferredEvaluation
 // -------------------------------------------------------------------------
 class WordListExtractorNode : public FilterNode {
 protected:
-    class WordListExtractor : public TraverseState {
+    class WordListExtractor : public TraverseStateView {
     private:
         Core::Vector<bool>& hasLid_;
 
     protected:
-        virtual void exploreArc(ConstStateRef from, const Arc& a) {
+        virtual void exploreArc(const StateView& from, const Arc& a) {
             Fsa::LabelId lid = a.input();
             if ((Fsa::FirstLabelId <= lid) && (lid <= Fsa::LastLabelId)) {
                 hasLid_.grow(lid, false);
@@ -756,7 +756,7 @@ protected:
 
     public:
         WordListExtractor(ConstLatticeRef l, Core::Vector<bool>& hasLid)
-                : TraverseState(l), hasLid_(hasLid) {
+                : TraverseStateView(l), hasLid_(hasLid) {
             traverse();
         }
         virtual ~WordListExtractor() {}
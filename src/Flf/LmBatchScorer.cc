@@ -0,0 +1,137 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "LmBatchScorer.hh"
+
+#include <algorithm>
+#include <chrono>
+
+#include <Lm/ScaledLanguageModel.hh>
+
+namespace Flf {
+
+void LmBatchScorer::Statistics::clear() {
+    nLattices   = 0;
+    nRequests   = 0;
+    nCacheHits  = 0;
+    nQueries    = 0;
+    nBatches    = 0;
+    latticeTime = 0.0;
+    lmTime      = 0.0;
+}
+
+void LmBatchScorer::Statistics::write(Core::XmlWriter& os) const {
+    os << Core::XmlOpen("lm-batch-statistics")
+       << Core::XmlFull("lattices", nLattices)
+       << Core::XmlFull("lattices-per-second", (latticeTime > 0.0) ? nLattices / latticeTime : 0.0)
+       << Core::XmlFull("requests", nRequests)
+       << Core::XmlFull("cache-hits", nCacheHits)
+       << Core::XmlFull("lm-queries", nQueries)
+       << Core::XmlFull("batches", nBatches)
+       << Core::XmlFull("lm-queries-per-batch", nBatches ? f64(nQueries) / nBatches : 0.0)
+       << Core::XmlFull("lm-time", lmTime) + Core::XmlAttribute("unit", "seconds")
+       << Core::XmlClose("lm-batch-statistics");
+}
+
+LmBatchScorer::LmBatchScorer(Core::Ref<const Lm::LanguageModel> lm, u32 maxCacheSize)
+        : lm_(lm),
+          maxCacheSize_(maxCacheSize) {
+    const Lm::ScaledLanguageModel* scaled = dynamic_cast<const Lm::ScaledLanguageModel*>(lm_.get());
+    if (scaled)
+        lm_ = scaled->unscaled();
+}
+
+LmBatchScorer::RequestId LmBatchScorer::request(const Lm::History& history, const Bliss::Lemma* lemma) {
+    require(lemma);
+    require(history.isValid());
+    ++statistics_.nRequests;
+    RequestId id = requests_.size();
+    requests_.push_back(Request{history, lemma, 0.0, id});
+    Request& r   = requests_.back();
+    Key      key = std::make_pair(history.handle(), lemma->id());
+
+    Cache::const_iterator c = cache_.find(key);
+    if (c != cache_.end()) {
+        ++statistics_.nCacheHits;
+        r.history = c->second.to;
+        r.score   = c->second.score;
+        return id;
+    }
+    std::pair<PendingMap::iterator, bool> p = pending_.insert(std::make_pair(key, id));
+    if (!p.second)
+        r.source = p.first->second;
+    return id;
+}
+
+void LmBatchScorer::flush() {
+    if (pending_.empty())
+        return;
+    auto start = std::chrono::steady_clock::now();
+
+    if (cache_.size() + pending_.size() > maxCacheSize_)
+        cache_.clear();
+
+    std::vector<RequestId> active;
+    active.reserve(pending_.size());
+    for (PendingMap::const_iterator p = pending_.begin(); p != pending_.end(); ++p) {
+        const Request& r = requests_[p->second];
+        cache_.insert(std::make_pair(p->first, CacheEntry{r.history, r.history, 0.0}));
+        active.push_back(p->second);
+    }
+    // deterministic order of the LM queries
+    std::sort(active.begin(), active.end());
+
+    for (u32 ti = 0; !active.empty(); ++ti) {
+        std::vector<RequestId>::iterator end = active.begin();
+        for (std::vector<RequestId>::const_iterator a = active.begin(); a != active.end(); ++a) {
+            if (requests_[*a].lemma->syntacticTokenSequence().length() > ti)
+                *end++ = *a;
+        }
+        active.erase(end, active.end());
+        if (active.empty())
+            break;
+        ++statistics_.nBatches;
+        statistics_.nQueries += active.size();
+        for (std::vector<RequestId>::const_iterator a = active.begin(); a != active.end(); ++a) {
+            Request&                     r  = requests_[*a];
+            const Bliss::SyntacticToken* st = r.lemma->syntacticTokenSequence()[ti];
+            r.score += lm_->score(r.history, st) + st->classEmissionScore();
+        }
+        for (std::vector<RequestId>::const_iterator a = active.begin(); a != active.end(); ++a) {
+            Request& r = requests_[*a];
+            r.history  = lm_->extendedHistory(r.history, r.lemma->syntacticTokenSequence()[ti]);
+        }
+    }
+
+    for (PendingMap::const_iterator p = pending_.begin(); p != pending_.end(); ++p) {
+        CacheEntry& e = cache_[p->first];
+        e.to          = requests_[p->second].history;
+        e.score       = requests_[p->second].score;
+    }
+    pending_.clear();
+
+    auto end = std::chrono::steady_clock::now();
+    statistics_.lmTime += std::chrono::duration<double>(end - start).count();
+}
+
+void LmBatchScorer::clearRequests() {
+    requests_.clear();
+    pending_.clear();
+}
+
+void LmBatchScorer::clearCache() {
+    cache_.clear();
+}
+
+}  // namespace Flf
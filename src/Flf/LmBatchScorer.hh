@@ -0,0 +1,130 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _FLF_LM_BATCH_SCORER_HH
+#define _FLF_LM_BATCH_SCORER_HH
+
+#include <Bliss/Lexicon.hh>
+#include <Core/XmlStream.hh>
+#include <Lm/LanguageModel.hh>
+
+#include <unordered_map>
+
+namespace Flf {
+
+/**
+ * Language model scoring of (history, lemma) pairs in batches.
+ *
+ * Rescorers collect all extensions of a lattice time slice by request()
+ * and score them together by flush(): the first tokens of all requests
+ * are scored, then all histories are extended, then the second tokens
+ * are scored, and so on.  Language models which evaluate all pending
+ * histories at once, as the recurrent neural network LMs do, thereby see
+ * all requests of a time slice in a single forward pass.
+ *
+ * Results are cached by history and lemma.  The cache is kept across
+ * flushes and lattices until clearCache() is called, e.g. at the start
+ * of a new recording, or until it exceeds its maximum size.
+ *
+ * Scores are unscaled, i.e. an Lm::ScaledLanguageModel is unwrapped,
+ * and include the class emission scores of the syntactic tokens.
+ */
+class LmBatchScorer {
+public:
+    typedef u32 RequestId;
+
+    struct Statistics {
+        u32 nLattices;
+        u64 nRequests;
+        u64 nCacheHits;
+        u64 nQueries;
+        u64 nBatches;
+        f64 latticeTime;  // seconds
+        f64 lmTime;       // seconds
+
+        Statistics() {
+            clear();
+        }
+        void clear();
+        void write(Core::XmlWriter& os) const;
+    };
+
+private:
+    typedef std::pair<Lm::HistoryHandle, Bliss::Lemma::Id> Key;
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return reinterpret_cast<size_t>(key.first) * 2654435761u + key.second;
+        }
+    };
+    struct CacheEntry {
+        Lm::History from;  // keeps the handle of the key valid
+        Lm::History to;
+        Lm::Score   score;
+    };
+    typedef std::unordered_map<Key, CacheEntry, KeyHash> Cache;
+    typedef std::unordered_map<Key, u32, KeyHash>        PendingMap;
+
+    struct Request {
+        Lm::History         history;
+        const Bliss::Lemma* lemma;
+        Lm::Score           score;
+        RequestId           source;  // request computing the result
+    };
+
+    Core::Ref<const Lm::LanguageModel> lm_;
+    u32                                maxCacheSize_;
+    Cache                              cache_;
+    std::vector<Request>               requests_;
+    PendingMap                         pending_;  // uncached requests of the current batch
+    Statistics                         statistics_;
+
+public:
+    LmBatchScorer(Core::Ref<const Lm::LanguageModel> lm, u32 maxCacheSize = 100000);
+
+    Core::Ref<const Lm::LanguageModel> languageModel() const {
+        return lm_;
+    }
+
+    /** Queue the extension of history by lemma; results are valid after flush(). */
+    RequestId request(const Lm::History& history, const Bliss::Lemma* lemma);
+    /** Score all queued requests. */
+    void flush();
+    /** Score of request id, requires flush() */
+    Lm::Score score(RequestId id) const {
+        return requests_[requests_[id].source].score;
+    }
+    /** History extended by the lemma of request id, requires flush() */
+    const Lm::History& history(RequestId id) const {
+        return requests_[requests_[id].source].history;
+    }
+    /** Drop all requests; request ids become invalid. */
+    void clearRequests();
+    void clearCache();
+
+    /** Account a rescored lattice and the time spent on it. */
+    void addLattice(f64 seconds) {
+        ++statistics_.nLattices;
+        statistics_.latticeTime += seconds;
+    }
+    const Statistics& statistics() const {
+        return statistics_;
+    }
+    void clearStatistics() {
+        statistics_.clear();
+    }
+};
+
+}  // namespace Flf
+
+#endif  // _FLF_LM_BATCH_SCORER_HH
@@ -414,13 +414,18 @@ void registerNodeCreators(NodeFactory* factory) {
                     "Make static copy of incoming lattice.\n"
                     "By default, scores are copied by reference.\n"
                     "Optional in-sito trimming and/or state numbering normalization\n"
-                    "is supported.",
+                    "is supported; a compact copy avoids per-state allocations.",
                     "[*.network.copy]\n"
                     "type                        = copy\n"
                     "# make deep copy, i.e. copy scores by value and not by reference\n"
                     "deep                        = false\n"
                     "trim                        = false\n"
-                    "normalize                   = false",
+                    "normalize                   = false\n"
+                    "# store states and arcs in a few contiguous arrays (immutable)\n"
+                    "compact                     = false\n"
+                    "# additionally store scores per dimension in contiguous columns;\n"
+                    "# rescale, projection and fwd./bwd. operate on whole columns\n"
+                    "score-columns               = false",
                     "input:\n"
                     "  0:lattice\n"
                     "output:\n"
@@ -846,13 +851,17 @@ void registerNodeCreators(NodeFactory* factory) {
                     "Performs a pruned rescoring/decoding on the lattice.\n"
                     "This is most useful to expand mesh lattices (see the mesh node).\n"
                     "The applied word end pruning is equivalent to the one applied\n"
-                    "during decoding (the threshold is relative to the LM scale).\n",
+                    "during decoding (the threshold is relative to the LM scale).\n"
+                    "The LM scores of a timeframe are computed in one batch; the\n"
+                    "score cache is kept for all lattices of a recording, if the\n"
+                    "segment is connected to port 1.\n",
                     "[*.network.decode-rescore]\n"
                     "type                        = decode-rescore-lm\n",
                     "word-end-beam               = 20.0\n"
                     "word-end-limit              = 50000\n"
+                    "lm-cache-size               = 100000\n"
                     "input:\n"
-                    "  0:lattice\n"
+                    "  0:lattice [1:segment]\n"
                     "output:\n"
                     "  0:lattice",
                     &createDecodeRescoreLmNode));
@@ -1881,9 +1890,10 @@ void registerNodeCreators(NodeFactory* factory) {
                     "max-hypotheses    = 5\n"
                     "pruning-threshold = 14.0\n"
                     "history-limit     = 0 (no limit)\n"
-                    "lookahead-scale   = 1.0\n",
+                    "lookahead-scale   = 1.0\n"
+                    "lm-cache-size     = 100000\n",
                     "input:\n"
-                    "  0:lattice\n"
+                    "  0:lattice [1:segment]\n"
                     "output:\n"
                     "  0:rescored-lattice",
                     &createPushForwardRescoringNode));
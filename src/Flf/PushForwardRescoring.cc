@@ -25,6 +25,7 @@
 #include "FlfCore/Basic.hh"
 #include "FlfCore/LatticeInternal.hh"
 #include "Lexicon.hh"
+#include "LmBatchScorer.hh"
 
 namespace {
 struct Hypothesis {
@@ -52,6 +53,14 @@ struct CompareSeqProspectScore {
     }
 };
 
+struct Expansion {
+    Hypothesis                    hyp;
+    Fsa::StateId                  to;
+    Flf::Score                    arc_score;
+    Flf::LmBatchScorer::RequestId request;
+    bool                          has_request;
+};
+
 using SeqScorePriorityQueue      = std::priority_queue<Hypothesis, std::vector<Hypothesis>, CompareSeqScore>;
 using ProspectScorePriorityQueue = std::priority_queue<Hypothesis, std::vector<Hypothesis>, CompareSeqProspectScore>;
 
@@ -186,6 +195,7 @@ const Core::ParameterInt    PushForwardRescorer::paramHistoryLimit("history-limi
 const Core::ParameterFloat  PushForwardRescorer::paramLookaheadScale("lookahead-scale", "scale lookahead with this factor", 1.0);
 const Core::ParameterBool   PushForwardRescorer::paramDelayedRescoring("delayed-rescoring", "delay computation of rescored lm scores, allows batching of more hypotheses", false);
 const Core::ParameterInt    PushForwardRescorer::paramDelayedRescoringMaxHyps("delayed-rescoring-max-hyps", "how many hypotheses need to be in a node to trigger rescoring", 100, 0);
+const Core::ParameterInt    PushForwardRescorer::paramLmCacheSize("lm-cache-size", "maximum number of cached lm scores; the cache is kept for all lattices of a recording, if a segment is connected to port 1", 100000, 1);
 
 PushForwardRescorer::PushForwardRescorer(Core::Configuration const& config, Core::Ref<Lm::LanguageModel> lm)
         : Precursor(config),
@@ -196,9 +206,12 @@ PushForwardRescorer::PushForwardRescorer(Core::Configuration const& config, Core
           history_limit_(paramHistoryLimit(config)),
           lookahead_scale_(paramLookaheadScale(config)),
           delayed_rescoring_(paramDelayedRescoring(config)),
-          delayed_rescoring_max_hyps_(paramDelayedRescoringMaxHyps(config)) {
+          delayed_rescoring_max_hyps_(paramDelayedRescoringMaxHyps(config)),
+          scorer_(new LmBatchScorer(lm, paramLmCacheSize(config))) {
 }
 
+PushForwardRescorer::~PushForwardRescorer() {}
+
 ConstLatticeRef PushForwardRescorer::rescore(ConstLatticeRef l, ScoreId id) {
     if (l->initialStateId() == Fsa::InvalidStateId) {
         return l;  // empty lattice
@@ -239,6 +252,10 @@ ConstLatticeRef PushForwardRescorer::rescore(ConstLatticeRef l, ScoreId id) {
     std::vector<Flf::Score> lookahead = calculate_lookahead(l, toposort);
     std::transform(lookahead.begin(), lookahead.end(), lookahead.begin(), std::bind(std::multiplies<Flf::Score>(), lookahead_scale_, std::placeholders::_1));
 
+    // expansions of the current time slice, scored in one batch
+    std::vector<Expansion> expansions;
+    bool                   same_time_successor = false;
+
     // insert inital hypothesis
     all_hyps[toposort->front()].push(Hypothesis{lm_->startHistory(), 0.0, lookahead[toposort->front()], 0.0, 0u, 0u, toposort->front(), 0ul, Fsa::Epsilon, true});
 
@@ -306,29 +323,28 @@ ConstLatticeRef PushForwardRescorer::rescore(ConstLatticeRef l, ScoreId id) {
                 Fsa::LabelId label_id = a->input();
 
                 Hypothesis new_hyp{hyp.history, hyp.seq_score, 0.0, 0.0, 0u, predecessor, current_state, arc_counter, label_id, false};
+                Expansion  expansion{new_hyp, to, rescaled_semiring->project(a->weight()), 0u, false};
 
                 if (label_id != Fsa::Epsilon) {
                     Bliss::Lemma const* lemma = l_alphabet ? l_alphabet->lemma(label_id) : lp_alphabet->lemmaPronunciation(label_id)->lemma();
                     if (delayed_rescoring_) {
-                        Lm::extendHistoryByLemma(lm_, lemma, new_hyp.history);
-                        new_hyp.score = a->weight()->get(id);
+                        Lm::extendHistoryByLemma(lm_, lemma, expansion.hyp.history);
+                        expansion.hyp.score = a->weight()->get(id);
                     }
                     else {
-                        Lm::addLemmaScore(lm_, 1.0, lemma, 1.0, new_hyp.history, new_hyp.score);
+                        expansion.request     = scorer_->request(hyp.history, lemma);
+                        expansion.has_request = true;
                     }
                 }
                 else if (to == toposort->back()) {  // word end symbol
                     // no delay here
-                    new_hyp.score = lm_->sentenceEndScore(new_hyp.history);
+                    expansion.hyp.score = lm_->sentenceEndScore(expansion.hyp.history);
                 }
                 else {
-                    new_hyp.score = a->weight()->get(id);
+                    expansion.hyp.score = a->weight()->get(id);
                 }
-                new_hyp.seq_score += original_scale * new_hyp.score + rescaled_semiring->project(a->weight());
-                new_hyp.seq_prospect_score = new_hyp.seq_score + lookahead[to];
-
-                best_score_per_time[boundaries->time(to)] = std::min(best_score_per_time[boundaries->time(to)], new_hyp.seq_prospect_score);
-                all_hyps[to].push(new_hyp);
+                same_time_successor = same_time_successor or boundaries->time(to) == current_time;
+                expansions.push_back(expansion);
                 num_expansions += 1ul;
                 arc_counter += 1ul;
             }
@@ -336,6 +352,26 @@ ConstLatticeRef PushForwardRescorer::rescore(ConstLatticeRef l, ScoreId id) {
             hyps.pop();
         }
         state_end.push_back(traceback.size());
+
+        // the expansions of all states of a time slice are scored together, a slice ends after
+        // a state with a successor in the same timeframe (whose pruning depends on the expansions)
+        if (same_time_successor or topo_idx + 1ul == toposort->size() or boundaries->time((*toposort)[topo_idx + 1ul]) != current_time) {
+            scorer_->flush();
+            for (Expansion& e : expansions) {
+                if (e.has_request) {
+                    e.hyp.history = scorer_->history(e.request);
+                    e.hyp.score   = scorer_->score(e.request);
+                }
+                e.hyp.seq_score += original_scale * e.hyp.score + e.arc_score;
+                e.hyp.seq_prospect_score = e.hyp.seq_score + lookahead[e.to];
+
+                best_score_per_time[boundaries->time(e.to)] = std::min(best_score_per_time[boundaries->time(e.to)], e.hyp.seq_prospect_score);
+                all_hyps[e.to].push(e.hyp);
+            }
+            expansions.clear();
+            scorer_->clearRequests();
+            same_time_successor = false;
+        }
     }
 
     log("num expansions: ") << static_cast<double>(num_expansions) / static_cast<double>(total_num_arcs);
@@ -521,16 +557,35 @@ ConstLatticeRef PushForwardRescoringNode::rescore(ConstLatticeRef l, ScoreId id)
         return l;
     }
     if (!rescored_lattice_) {
+        if (connected(1)) {
+            // the lm score cache is kept for all lattices of a recording
+            ConstSegmentRef segment = requestSegment(1);
+            if (segment and segment->hasRecordingId() and segment->recordingId() != recording_id_) {
+                rescorer_->scorer().clearCache();
+                recording_id_ = segment->recordingId();
+            }
+        }
+        else {
+            rescorer_->scorer().clearCache();
+        }
         auto timer_start  = std::chrono::steady_clock::now();
         rescored_lattice_ = rescorer_->rescore(l, id);
         auto   timer_end  = std::chrono::steady_clock::now();
         double duration   = std::chrono::duration<double, std::milli>(timer_end - timer_start).count();
+        rescorer_->scorer().addLattice(duration / 1000.0);
         clog() << Core::XmlOpen("flf-push-forward-rescoring-time") + Core::XmlAttribute("unit", "milliseconds") << duration << Core::XmlClose("flf-push-forward-rescoring-time");
     }
 
     return rescored_lattice_;
 }
 
+void PushForwardRescoringNode::finalize() {
+    if (rescorer_) {
+        rescorer_->scorer().statistics().write(clog());
+        rescorer_->scorer().clearStatistics();
+    }
+}
+
 // ----------------------------------------------------------------------
 
 NodeRef createPushForwardRescoringNode(const std::string& name, const Core::Configuration& config) {
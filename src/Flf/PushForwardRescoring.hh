@@ -15,12 +15,16 @@
 #ifndef _FLF_PUSH_FORWARD_RESCORING_HH
 #define _FLF_PUSH_FORWARD_RESCORING_HH
 
+#include <memory>
+
 #include <Lm/LanguageModel.hh>
 
 #include "FlfCore/Lattice.hh"
 #include "RescoreInternal.hh"
 
 namespace Flf {
+class LmBatchScorer;
+
 class PushForwardRescorer : public Core::Component {
 public:
     typedef Core::Component Precursor;
@@ -39,12 +43,18 @@ public:
     static const Core::ParameterFloat  paramLookaheadScale;
     static const Core::ParameterBool   paramDelayedRescoring;
     static const Core::ParameterInt    paramDelayedRescoringMaxHyps;
+    static const Core::ParameterInt    paramLmCacheSize;
 
     PushForwardRescorer(Core::Configuration const& config, Core::Ref<Lm::LanguageModel> lm);
-    ~PushForwardRescorer() = default;
+    ~PushForwardRescorer();
 
     virtual ConstLatticeRef rescore(ConstLatticeRef l, ScoreId id);
 
+    /** batches the lm requests of a time slice, caches the scores and collects statistics */
+    LmBatchScorer& scorer() {
+        return *scorer_;
+    }
+
 private:
     Core::Ref<Lm::LanguageModel> lm_;
     RescorerType                 rescoring_type_;
@@ -54,6 +64,8 @@ private:
     Flf::Score                   lookahead_scale_;
     bool                         delayed_rescoring_;
     unsigned                     delayed_rescoring_max_hyps_;
+
+    std::unique_ptr<LmBatchScorer> scorer_;
 };
 
 class PushForwardRescoringNode : public RescoreSingleDimensionNode {
@@ -68,6 +80,7 @@ public:
     virtual void sync() {
         rescored_lattice_.reset();
     }
+    virtual void finalize();
 
 protected:
     virtual ConstLatticeRef rescore(ConstLatticeRef l, ScoreId id);
@@ -76,6 +89,7 @@ private:
     std::unique_ptr<PushForwardRescorer> rescorer_;
 
     ConstLatticeRef rescored_lattice_;
+    std::string     recording_id_;
 };
 
 NodeRef createPushForwardRescoringNode(std::string const& name, Core::Configuration const& config);
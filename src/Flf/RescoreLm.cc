@@ -16,12 +16,15 @@
 #include <Core/Application.hh>
 #include <Core/Choice.hh>
 #include <Core/Parameter.hh>
+#include <chrono>
+#include <memory>
 
 #include <Lm/Module.hh>
 #include <Lm/ScaledLanguageModel.hh>
 #include "Convert.hh"
 #include "Copy.hh"
 #include "FlfCore/Basic.hh"
+#include "LmBatchScorer.hh"
 
 namespace Flf {
 struct WordEndHypothesis {
@@ -39,25 +42,16 @@ struct CompareSecond {
     }
 };
 
-template<class Key>
-struct StandardHash {
-    inline u32 operator()(Key a) const {
-        a = (a ^ 0xc761c23c) ^ (a >> 19);
-        a = (a + 0xfd7046c5) + (a << 3);
-        return a;
-    }
-};
-
-struct HistoryLemmaPairHash {
-    std::size_t operator()(const std::pair<Lm::HistoryHandle, Bliss::Lemma::Id>& item) const {
-        return reinterpret_cast<size_t>(item.first) + StandardHash<std::size_t>()(item.second + reinterpret_cast<size_t>(item.first));
-    }
+struct Expansion {
+    WordEndHypothesis        hyp;
+    LmBatchScorer::RequestId request;
+    bool                     hasRequest;
 };
 
 // Expands the incoming lattice. The ideal structure for the incoming lattice is a mesh.
 // If no LM is given, then only the transits are expanded.
 // The word end beam is relative to the LM scale.
-ConstLatticeRef decodeRescoreLm(ConstLatticeRef lat, Core::Ref<Lm::LanguageModel> lm, float wordEndBeam, u32 wordEndLimit, const std::vector<const Bliss::Lemma*>& prefix, const std::vector<const Bliss::Lemma*>& suffix) {
+ConstLatticeRef decodeRescoreLm(ConstLatticeRef lat, Core::Ref<Lm::LanguageModel> lm, float wordEndBeam, u32 wordEndLimit, const std::vector<const Bliss::Lemma*>& prefix, const std::vector<const Bliss::Lemma*>& suffix, LmBatchScorer* scorer) {
     verify(lat->getBoundaries()->valid());
     lat = sortByTopologicalOrder(lat);
 
@@ -97,13 +91,11 @@ ConstLatticeRef decodeRescoreLm(ConstLatticeRef lat, Core::Ref<Lm::LanguageModel
 
     wordEndBeam *= lmScale;
 
-    const u32 maxCacheSize = 10000;
+    LmBatchScorer  localScorer(lm);
+    LmBatchScorer& lmScorer = scorer ? *scorer : localScorer;
 
     std::vector<std::pair<Fsa::StateId, Lm::History>> appendFinalState;
 
-    typedef std::unordered_map<std::pair<Lm::HistoryHandle, Bliss::Lemma::Id>, std::pair<Score, Lm::History>, HistoryLemmaPairHash> LmCache;
-    LmCache                                                                                                                         lmCache;
-
     typedef std::multimap<std::pair<Speech::TimeframeIndex, Fsa::StateId>, WordEndHypothesis> Hypotheses;
     Hypotheses                                                                                hypotheses;
 
@@ -162,98 +154,107 @@ ConstLatticeRef decodeRescoreLm(ConstLatticeRef lat, Core::Ref<Lm::LanguageModel
 
         verify(!hypotheses.empty());
 
-        Fsa::StateId  stateId = hypotheses.begin()->first.second;
-        ConstStateRef state   = lat->getState(stateId);
-
-        Hypotheses::iterator stateEnd = hypotheses.upper_bound(std::make_pair(time, stateId));
-
         // Step 2: Recombine and build (create a state for each each distinct history, and build the corresponding incoming arcs)
-        std::multimap<Lm::History, WordEndHypothesis> historyHyps;
-        for (Hypotheses::iterator hypIt = hypotheses.begin(); hypIt != stateEnd; ++hypIt)
-            historyHyps.insert(std::make_pair(hypIt->second.h, hypIt->second));
-
-        while (!historyHyps.empty()) {
-            Lm::History                                             history = historyHyps.begin()->first;
-            std::multimap<Lm::History, WordEndHypothesis>::iterator endIt   = historyHyps.upper_bound(historyHyps.begin()->first);
-
-            State* newState = s->newState(state->tags());
-            b->set(newState->id(), lat->boundary(stateId));
-            Score best = Core::Type<Score>::max;
-
-            if (newState->isFinal()) {
-                bool hadSentenceEnd = false;
-                if (historyHyps.begin()->second.preState != Fsa::InvalidStateId) {
-                    Fsa::LabelId labelId = historyHyps.begin()->second.arc.input();
-
-                    if (Fsa::FirstLabelId <= labelId && labelId <= Fsa::LastLabelId) {
-                        const Bliss::Lemma* lemma = (lAlphabet) ? lAlphabet->lemma(labelId) : lpAlphabet->lemmaPronunciation(labelId)->lemma();
-                        verify(lemma);
-                        if (lemma->hasSyntacticTokenSequence() && lemma->syntacticTokenSequence().size() && lemma->syntacticTokenSequence().operator[](lemma->syntacticTokenSequence().size() - 1) == lm->sentenceEndToken()) {
-                            hadSentenceEnd = true;
+        // for a slice of states of this timeframe; the slice ends after a state with a successor in the same timeframe
+        std::vector<Expansion> expansions;
+        Fsa::StateId           lastStateId       = Fsa::InvalidStateId;
+        bool                   sameTimeSuccessor = false;
+        for (Hypotheses::iterator stateBegin = hypotheses.begin();
+             stateBegin != hypotheses.end() && stateBegin->first.first == time && !sameTimeSuccessor;) {
+            Fsa::StateId  stateId = stateBegin->first.second;
+            ConstStateRef state   = lat->getState(stateId);
+
+            Hypotheses::iterator stateEnd = hypotheses.upper_bound(std::make_pair(time, stateId));
+
+            std::multimap<Lm::History, WordEndHypothesis> historyHyps;
+            for (Hypotheses::iterator hypIt = stateBegin; hypIt != stateEnd; ++hypIt)
+                historyHyps.insert(std::make_pair(hypIt->second.h, hypIt->second));
+
+            while (!historyHyps.empty()) {
+                Lm::History                                             history = historyHyps.begin()->first;
+                std::multimap<Lm::History, WordEndHypothesis>::iterator endIt   = historyHyps.upper_bound(historyHyps.begin()->first);
+
+                State* newState = s->newState(state->tags());
+                b->set(newState->id(), lat->boundary(stateId));
+                Score best = Core::Type<Score>::max;
+
+                if (newState->isFinal()) {
+                    bool hadSentenceEnd = false;
+                    if (historyHyps.begin()->second.preState != Fsa::InvalidStateId) {
+                        Fsa::LabelId labelId = historyHyps.begin()->second.arc.input();
+
+                        if (Fsa::FirstLabelId <= labelId && labelId <= Fsa::LastLabelId) {
+                            const Bliss::Lemma* lemma = (lAlphabet) ? lAlphabet->lemma(labelId) : lpAlphabet->lemmaPronunciation(labelId)->lemma();
+                            verify(lemma);
+                            if (lemma->hasSyntacticTokenSequence() && lemma->syntacticTokenSequence().size() && lemma->syntacticTokenSequence().operator[](lemma->syntacticTokenSequence().size() - 1) == lm->sentenceEndToken()) {
+                                hadSentenceEnd = true;
+                            }
                         }
                     }
-                }
 
-                if (!hadSentenceEnd) {
-                    appendFinalState.push_back(std::make_pair(newState->id(), history));
-                    newState->setTags(newState->tags() & ~Fsa::StateTagFinal);
+                    if (!hadSentenceEnd) {
+                        appendFinalState.push_back(std::make_pair(newState->id(), history));
+                        newState->setTags(newState->tags() & ~Fsa::StateTagFinal);
+                    }
                 }
-            }
-
-            for (std::multimap<Lm::History, WordEndHypothesis>::const_iterator hypIt = historyHyps.begin();
-                 hypIt != endIt; ++hypIt) {
-                if (hypIt->second.score < best)
-                    best = hypIt->second.score;
 
-                if (hypIt->second.preState != Fsa::InvalidStateId)
-                    const_cast<State&>(*s->getState(hypIt->second.preState)).newArc(newState->id(), hypIt->second.arc.weight(), hypIt->second.arc.input(), hypIt->second.arc.output());
-            }
-
-            // Step 3: Create successor hypotheses
-            for (u32 arcI = 0; arcI < state->nArcs(); ++arcI) {
-                const Arc*        arc = state->getArc(arcI);
-                WordEndHypothesis nextHyp;
-                nextHyp.h        = history;
-                nextHyp.score    = best;
-                nextHyp.preState = newState->id();
-                nextHyp.arc      = *arc;
-                nextHyp.arc.setWeight(semiring->clone(nextHyp.arc.weight()));
+                for (std::multimap<Lm::History, WordEndHypothesis>::const_iterator hypIt = historyHyps.begin();
+                     hypIt != endIt; ++hypIt) {
+                    if (hypIt->second.score < best)
+                        best = hypIt->second.score;
 
-                Fsa::LabelId labelId = arc->input();
+                    if (hypIt->second.preState != Fsa::InvalidStateId)
+                        const_cast<State&>(*s->getState(hypIt->second.preState)).newArc(newState->id(), hypIt->second.arc.weight(), hypIt->second.arc.input(), hypIt->second.arc.output());
+                }
 
-                if (Fsa::FirstLabelId <= labelId && labelId <= Fsa::LastLabelId) {
-                    const Bliss::Lemma* lemma = (lAlphabet) ? lAlphabet->lemma(labelId) : lpAlphabet->lemmaPronunciation(labelId)->lemma();
-                    verify(lemma);
+                // Step 3: Create successor hypotheses, the LM scores are requested for the whole slice
+                for (u32 arcI = 0; arcI < state->nArcs(); ++arcI) {
+                    const Arc* arc = state->getArc(arcI);
+                    Expansion  e;
+                    e.hyp.h        = history;
+                    e.hyp.score    = best;
+                    e.hyp.preState = newState->id();
+                    e.hyp.arc      = *arc;
+                    e.hyp.arc.setWeight(semiring->clone(e.hyp.arc.weight()));
+                    e.hasRequest = false;
 
-                    Bliss::Lemma::Id        id        = lemma->id();
-                    LmCache::const_iterator lmCacheIt = lmCache.find(std::make_pair(history.handle(), id));
+                    Fsa::LabelId labelId = arc->input();
 
-                    if (lmCacheIt != lmCache.end()) {
-                        nextHyp.h = lmCacheIt->second.second;
-                        nextHyp.arc.setScore(lmScoreId, lmCacheIt->second.first);
+                    if (Fsa::FirstLabelId <= labelId && labelId <= Fsa::LastLabelId) {
+                        const Bliss::Lemma* lemma = (lAlphabet) ? lAlphabet->lemma(labelId) : lpAlphabet->lemmaPronunciation(labelId)->lemma();
+                        verify(lemma);
+                        e.request    = lmScorer.request(history, lemma);
+                        e.hasRequest = true;
                     }
                     else {
-                        Score rawScore = 0;
-                        verify(nextHyp.h.isValid());
-                        Lm::addLemmaScore(lm, 1.0, lemma, 1.0, nextHyp.h, rawScore);
-                        nextHyp.arc.setScore(lmScoreId, rawScore);
-                        lmCache.insert(std::make_pair(std::make_pair(history.handle(), id), std::make_pair(rawScore, nextHyp.h)));
+                        e.hyp.arc.setScore(lmScoreId, 0);
                     }
+                    if (lat->boundary(arc->target()).time() == time)
+                        sameTimeSuccessor = true;
+                    expansions.push_back(e);
                 }
-                else {
-                    nextHyp.arc.setScore(lmScoreId, 0);
-                }
-                nextHyp.score += semiring->project(nextHyp.arc.weight());
-                hypotheses.insert(std::make_pair(std::make_pair(lat->boundary(arc->target()).time(), arc->target()), nextHyp));
+
+                historyHyps.erase(historyHyps.begin(), endIt);
             }
 
-            historyHyps.erase(historyHyps.begin(), endIt);
+            lastStateId = stateId;
+            stateBegin  = stateEnd;
         }
 
-        hypotheses.erase(hypotheses.begin(), hypotheses.upper_bound(std::make_pair(time, stateId)));
+        // Step 4: Score the slice in one batch
+        lmScorer.flush();
+        for (std::vector<Expansion>::iterator e = expansions.begin(); e != expansions.end(); ++e) {
+            if (e->hasRequest) {
+                e->hyp.h = lmScorer.history(e->request);
+                e->hyp.arc.setScore(lmScoreId, lmScorer.score(e->request));
+            }
+            e->hyp.score += semiring->project(e->hyp.arc.weight());
+            Fsa::StateId target = e->hyp.arc.target();
+            hypotheses.insert(std::make_pair(std::make_pair(lat->boundary(target).time(), target), e->hyp));
+        }
+        lmScorer.clearRequests();
 
-        if (lmCache.size() > maxCacheSize)
-            lmCache.clear();
+        hypotheses.erase(hypotheses.begin(), hypotheses.upper_bound(std::make_pair(time, lastStateId)));
     }
 
     s->setInitialStateId(lat->initialStateId());
@@ -299,19 +300,38 @@ class DecodeRescoreLmNode : public FilterNode {
 public:
     static const Core::ParameterFloat paramWordEndBeam;
     static const Core::ParameterInt   paramWordEndLimit;
+    static const Core::ParameterInt   paramCacheSize;
 
 private:
-    ConstLatticeRef              latL_;
-    f32                          wordEndBeam_;
-    u32                          wordEndLimit_;
-    Core::Ref<Lm::LanguageModel> lm_;
+    ConstLatticeRef                latL_;
+    f32                            wordEndBeam_;
+    u32                            wordEndLimit_;
+    Core::Ref<Lm::LanguageModel>   lm_;
+    std::unique_ptr<LmBatchScorer> scorer_;
+    std::string                    recordingId_;
 
 protected:
     ConstLatticeRef filter(ConstLatticeRef l) {
         if (!l)
             return ConstLatticeRef();
-        if (!latL_)
-            latL_ = decodeRescoreLm(l, lm_, wordEndBeam_, wordEndLimit_);
+        if (!latL_) {
+            if (connected(1)) {
+                // the LM score cache is kept for all lattices of a recording
+                ConstSegmentRef segment = requestSegment(1);
+                if (segment && segment->hasRecordingId() && (segment->recordingId() != recordingId_)) {
+                    scorer_->clearCache();
+                    recordingId_ = segment->recordingId();
+                }
+            }
+            else {
+                scorer_->clearCache();
+            }
+            auto start = std::chrono::steady_clock::now();
+            latL_      = decodeRescoreLm(l, lm_, wordEndBeam_, wordEndLimit_,
+                                    std::vector<const Bliss::Lemma*>(), std::vector<const Bliss::Lemma*>(), scorer_.get());
+            auto end   = std::chrono::steady_clock::now();
+            scorer_->addLattice(std::chrono::duration<double>(end - start).count());
+        }
 
         return latL_;
     }
@@ -329,11 +349,19 @@ public:
         lm_ = Lm::Module::instance().createLanguageModel(select("lm"), Lexicon::us());
         if (!lm_)
             criticalError("DecodeRescoreLmNode: failed to load language model");
+        scorer_.reset(new LmBatchScorer(lm_, paramCacheSize(config)));
     }
 
     virtual void sync() {
         latL_.reset();
     }
+
+    virtual void finalize() {
+        if (scorer_) {
+            scorer_->statistics().write(clog());
+            scorer_->clearStatistics();
+        }
+    }
 };
 const Core::ParameterFloat DecodeRescoreLmNode::paramWordEndBeam(
         "word-end-beam",
@@ -347,6 +375,12 @@ const Core::ParameterInt DecodeRescoreLmNode::paramWordEndLimit(
         50000,
         1);
 
+const Core::ParameterInt DecodeRescoreLmNode::paramCacheSize(
+        "lm-cache-size",
+        "maximum number of cached LM scores; the cache is kept for all lattices of a recording, if a segment is connected to port 1",
+        100000,
+        1);
+
 NodeRef createDecodeRescoreLmNode(const std::string& name, const Core::Configuration& config) {
     return NodeRef(new DecodeRescoreLmNode(name, config));
 }
@@ -27,6 +27,8 @@ class Lemma;
 }
 
 namespace Flf {
+class LmBatchScorer;
+
 /**
  * Performs a time-synchronous rescoring.
  * The input lattice may be a mesh lattice, in which case
@@ -35,12 +37,17 @@ namespace Flf {
  *
  * wordEndBeam and wordEndLimit are equivalent to word end pruning used during
  * standard decoding (wordEndBeam is relative to the LM scale)
+ *
+ * The LM scores of all hypotheses of a timeframe are computed in one batch
+ * by scorer, whose cache may be kept across lattices; if no scorer is given,
+ * a scorer local to the call is used.
  **/
 ConstLatticeRef decodeRescoreLm(ConstLatticeRef lat, Core::Ref<Lm::LanguageModel> lm,
                                 float                                   wordEndBeam  = 20,
                                 u32                                     wordEndLimit = 50000,
                                 const std::vector<const Bliss::Lemma*>& prefix       = std::vector<const Bliss::Lemma*>(),
-                                const std::vector<const Bliss::Lemma*>& suffix       = std::vector<const Bliss::Lemma*>());
+                                const std::vector<const Bliss::Lemma*>& suffix       = std::vector<const Bliss::Lemma*>(),
+                                LmBatchScorer*                          scorer       = 0);
 
 NodeRef createDecodeRescoreLmNode(const std::string& name, const Core::Configuration& config);
 }  // namespace Flf
@@ -1281,20 +1281,20 @@ std::pair<ConstConfusionNetworkRef, ConstLatticeRef> ClusteredLattice::getNormal
 }
 
 namespace {
-class StateIndexBuilder : public TraverseState {
+class StateIndexBuilder : public TraverseStateView {
 private:
     Core::Vector<Fsa::StateId>& stateIndex;
 
 protected:
-    void exploreState(ConstStateRef sr) {
-        Fsa::StateId targetSid = sr->id() + 1;
+    void exploreState(const StateView& s) {
+        Fsa::StateId targetSid = s.id() + 1;
         stateIndex.grow(targetSid, 0);
-        stateIndex[targetSid] = sr->nArcs();
+        stateIndex[targetSid] = s.nArcs();
     }
 
 public:
     StateIndexBuilder(ConstLatticeRef l, Core::Vector<Fsa::StateId>& stateIndex)
-            : TraverseState(l), stateIndex(stateIndex) {}
+            : TraverseStateView(l), stateIndex(stateIndex) {}
 
     void build() {
         if (l->getTopologicalSort())
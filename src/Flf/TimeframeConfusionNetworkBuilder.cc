@@ -53,21 +53,21 @@ void scoresToProbabilities(PosteriorCn& cn, bool normalize = false) {
  * The result is a list of posterior distributions p(*|t) for t = 1,...,T
  **/
 template<class ArcScores>
-class FramewiseCollector : public TraverseState {
+class FramewiseCollector : public TraverseStateView {
 private:
     ArcScores    arcScores_;
     PosteriorCn& cn_;
     Time         begin_, end_;
 
 protected:
-    virtual void exploreState(ConstStateRef sr) {
-        typename ArcScores::const_iterator itScore = arcScores_(sr->id()).first;
-        for (State::const_iterator a = sr->begin(), end_a = sr->end();
+    virtual void exploreState(const StateView& s) {
+        typename ArcScores::const_iterator itScore = arcScores_(s.id()).first;
+        for (StateView::const_iterator a = s.begin(), end_a = s.end();
              a != end_a; ++a, ++itScore) {
             if (a->input() == Fsa::InvalidLabelId)
                 Core::Application::us()->criticalError("Frame-wise score collector: label id is invalid.");
             PosteriorCn::Arc cnArc(a->input(), itScore->score());
-            Time             t = l->boundary(sr->id()).time(), end_t = l->boundary(a->target()).time();
+            Time             t = l->boundary(s.id()).time(), end_t = l->boundary(a->target()).time();
             if ((t == InvalidTime) || (end_t == InvalidTime) || (t > end_t) || (end_t >= 2147483647))
                 Core::Application::us()->criticalError("Frame-wise score collector: interval [%d,%d] is invalid. Label id: %d", t, end_t, a->input());
 
@@ -94,7 +94,7 @@ public:
             PosteriorCn&     cn,
             ConstLatticeRef  l,
             const ArcScores& arcScores)
-            : TraverseState(l), arcScores_(arcScores), cn_(cn), begin_(Core::Type<Time>::max), end_(0) {
+            : TraverseStateView(l), arcScores_(arcScores), cn_(cn), begin_(Core::Type<Time>::max), end_(0) {
         if (!l->getBoundaries()->valid())
             Core::Application::us()->criticalError("FramewiseCollector: Lattice \"%s\" has no time boundaries", l->describe().c_str());
         traverse();
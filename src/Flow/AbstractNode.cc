@@ -13,6 +13,7 @@
  *  limitations under the License.
  */
 #include "AbstractNode.hh"
+#include <Core/Archive.hh>
 
 using namespace Flow;
 
@@ -29,14 +30,26 @@ const Core::ParameterBool AbstractNode::paramIgnoreUnknownParameters(
 
 AbstractNode::AbstractNode(const Core::Configuration& c)
         : Component(c),
-          //Thread(),
           threaded_(false),
-          ignoreUnknownParameters_(paramIgnoreUnknownParameters(c)) {
+          ignoreUnknownParameters_(paramIgnoreUnknownParameters(c)),
+          threadLink_(0),
+          threadWrites_(0),
+          pendingRuns_(0),
+          isRunning_(false),
+          terminateThread_(false),
+          interruptRun_(false) {
     setThreaded(paramThreaded(c));
 }
 
 /******************************************************************************/
 
+AbstractNode::~AbstractNode() {
+    // The owning network stops the thread before the derived classes are destroyed.
+    terminateThread();
+}
+
+/******************************************************************************/
+
 void AbstractNode::setThreaded(const std::string& threaded) {
     setThreaded(paramThreaded(threaded));
 }
@@ -113,29 +126,109 @@ bool AbstractNode::setNetworkParameter(const std::string& parameterName,
 
 /******************************************************************************/
 
-void AbstractNode::Run() {
-    // infinite loop until filter has any input data
-    while (1) {
-        // loop over all connected output ports
-        for (PortId i = 0; i < nOutputs(); i++) {
-            if (nOutputLinks(i) > 0)
-                work(i);
+bool AbstractNode::runsOwnThread() {
+    if (!threaded_)
+        return false;
+    u32 nLinks = 0;
+    for (PortId out = 0; out < nOutputs(); ++out)
+        nLinks += nOutputLinks(out);
+    if (nLinks != 1) {
+        warning("Threaded node requires exactly one output link, running node '%s' in the thread of its successor.",
+                name().c_str());
+        threaded_ = false;
+    }
+    return threaded_;
+}
+
+/******************************************************************************/
+
+void AbstractNode::threadMain() {
+    Core::DeferredArchiveWrites writes;
+    writes.activate();
+    threadWrites_ = &writes;
+
+    std::unique_lock<std::mutex> lock(threadMutex_);
+    while (true) {
+        while (pendingRuns_ == 0 && !terminateThread_)
+            threadCondition_.wait(lock);
+        if (terminateThread_)
+            break;
+        --pendingRuns_;
+        isRunning_ = true;
+        lock.unlock();
+
+        Link*  link = threadLink_;
+        PortId out  = link->getFromPort();
+        link->startRun();
+        while (!interruptRun_) {
+            bool success = work(out);
+            if (link->hasEndedRun())
+                break;
+            if (!success) {
+                link->putFailure();
+                break;
+            }
         }
+
+        lock.lock();
+        isRunning_ = false;
+        threadCondition_.notify_all();
     }
+
+    threadWrites_ = 0;
+    writes.deactivate();
+}
+
+/******************************************************************************/
+
+void AbstractNode::requestRun() {
+    std::lock_guard<std::mutex> lock(threadMutex_);
+    if (!thread_.joinable())
+        thread_ = std::thread(&AbstractNode::threadMain, this);
+    ++pendingRuns_;
+    threadCondition_.notify_all();
 }
 
 /******************************************************************************/
 
-#if 0
-void AbstractNode::startThread() {
-        if (isThreaded()) start();
+void AbstractNode::interruptThread() {
+    if (!thread_.joinable())
+        return;
+    interruptRun_ = true;
+    if (threadLink_)
+        threadLink_->interrupt();
 }
 
+/******************************************************************************/
 
 void AbstractNode::stopThread() {
-        stop();
+    if (!thread_.joinable() || std::this_thread::get_id() == thread_.get_id())
+        return;
+    interruptThread();
+    std::unique_lock<std::mutex> lock(threadMutex_);
+    pendingRuns_ = 0;
+    while (isRunning_)
+        threadCondition_.wait(lock);
+    interruptRun_ = false;
+    // data sent ahead is discarded, as well as the request of the consumer
+    if (threadLink_)
+        threadLink_->releaseData();
+}
+
+/******************************************************************************/
+
+void AbstractNode::terminateThread() {
+    if (!thread_.joinable())
+        return;
+    stopThread();
+    {
+        std::lock_guard<std::mutex> lock(threadMutex_);
+        terminateThread_ = true;
+        threadCondition_.notify_all();
+    }
+    thread_.join();
+    terminateThread_ = false;
 }
-#endif
 
 /******************************************************************************/
 
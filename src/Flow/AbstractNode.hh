@@ -15,6 +15,11 @@
 #ifndef _FLOW_ABSTRACT_NODE_HH
 #define _FLOW_ABSTRACT_NODE_HH
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include <Core/Component.hh>
 #include <Core/Hash.hh>
 #include <Core/Parameter.hh>
@@ -34,10 +39,24 @@ namespace Flow {
  *   - unresolvedParameters_ : map<string,string> - stores the attributes
  *   - addUnresolvedAttribute(key, value) - adds a new attribute
  *   - unresolvedAttributes() - returns the stored attributes
+ *
+ * Threaded nodes:
+ * A node with parameter threaded=true and exactly one output link runs
+ * work() in its own thread, together with all (non-threaded) nodes it
+ * pulls data from.  It is connected to its successor by a bounded queue
+ * (size given by the buffer attribute of the link).  The thread works
+ * ahead in "runs": a run is requested when the successor needs data,
+ * and it ends after the node has sent a non-data object (end-of-stream,
+ * out-of-data), so the node never works beyond a segment boundary on
+ * its own.  Resetting or reconfiguring the network stops all threads.
+ * All nodes pulled by a threaded node must not be used by other nodes.
+ * Archive files written in the thread are deferred and handed over to
+ * the consumer together with the next packet, so that they are written
+ * in the same order as without the thread (see Core::DeferredArchiveWrites).
  */
-class AbstractNode : public virtual Core::Component  //, public Core::Thread
-{
+class AbstractNode : public virtual Core::Component {
     friend class Network;
+    friend class Link;
 
 public:
     static const Core::ParameterBool           paramThreaded;
@@ -52,6 +71,26 @@ private:
     Parameters           parameters_;
     UnresolvedAttributes dumpParameters_;
 
+    // thread of threaded nodes
+    std::thread                  thread_;
+    std::mutex                   threadMutex_;
+    std::condition_variable      threadCondition_;
+    Link*                        threadLink_;    // the only output link
+    Core::DeferredArchiveWrites* threadWrites_;  // archive writes of the thread, see Link
+    u32                          pendingRuns_;
+    bool                         isRunning_;
+    bool                         terminateThread_;
+    std::atomic<bool>            interruptRun_;
+
+    void threadMain();
+    /** Requests another run of the thread; the thread is started on demand. */
+    void requestRun();
+    /** Interrupts the current run, does not wait for it. */
+    void interruptThread();
+    /** Interrupts the current run and waits until the thread is idle. */
+    void stopThread();
+    void terminateThread();
+
     /** setNetworkParameter is called by the Network
      * if a network parameter gets a new value.
      *
@@ -106,7 +145,13 @@ protected:
     template<class T>
     bool getData(Link* l, DataPtr<T>& d) {
         if (l != 0) {
-            if (l->isDataAvailable())
+            if (!l->isFast()) {
+                if (l->getData(d) || !l->hasFailed())
+                    return d;
+                error("Node '%s' could not generate any output.",
+                      l->getFromNode()->name().c_str());
+            }
+            else if (l->isDataAvailable())
                 return l->getData(d);
             else {
                 if (l->getFromNode()->work(l->getFromPort()))
@@ -123,10 +168,7 @@ protected:
 
 public:
     AbstractNode(const Core::Configuration& c);
-    virtual ~AbstractNode() {}
-
-    // threads
-    virtual void Run();
+    virtual ~AbstractNode();
 
     // external configuration
     void setThreaded(bool threaded = true) {
@@ -136,6 +178,8 @@ public:
     bool isThreaded() const {
         return threaded_;
     }
+    /** True if work() is called in a separate thread, see class description. */
+    virtual bool runsOwnThread();
 
     /** addParameter adds a parameter to the node
      * Constant parameters are simply delegated to setParameter,
@@ -152,7 +152,8 @@ bool Cache::open(Core::Archive::AccessMode _access) {
         (!Core::isValidPath(path_) &&
          !(_access & Core::Archive::AccessModeWrite)))
         return false;
-    archive_ = Core::Archive::create(config, path_, _access);
+    // the caches of several (e.g. cloned) flow networks share the archive
+    archive_ = Core::Archive::createShared(config, path_, _access);
     return isOpen();
 }
 
@@ -161,7 +162,7 @@ bool Cache::open(Core::Archive::AccessMode _access) {
 void Cache::close() {
     if (!isOpen())
         return;
-    delete archive_;
+    Core::Archive::releaseShared(archive_);
     archive_ = 0;
 }
 
@@ -350,6 +351,13 @@ bool CacheNode::work(PortId output) {
         getData(0, in);
         if (writer_ && in)
             writer_->putData(in.get());
+        else if (writer_ && in.get() == Data::eos() && (Core::Archive::isSharingEnabled() || Core::Archive::hasWriteListener())) {
+            // in parallel processing or with a progress journal, store the file at the end of
+            // the stream (i.e. with the writes deferred for the segment, before the segment is
+            // journaled), not when the next context is created
+            delete writer_;
+            writer_ = 0;
+        }
         if (hasOutput_)
             return putData(0, in.get());
         return true;
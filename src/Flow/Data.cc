@@ -28,7 +28,10 @@ const Datatype* Data::type() {
 
 void Data::free() const {
     verify_(isNotSentinel(this));
-    delete this;
+    if (datatype_)
+        datatype_->freeData(this);
+    else
+        delete this;
 }
 
 /******************************************************************************/
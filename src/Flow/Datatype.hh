@@ -18,7 +18,10 @@
 #include <Core/Assertions.hh>
 #include <Core/BinaryStream.hh>
 #include <Core/Types.hh>
+#include <atomic>
 #include <iostream>
+#include <typeinfo>
+#include <vector>
 
 #include "Data.hh"
 
@@ -31,7 +34,7 @@ class Application;
  *
  * Currently, datatypes in flow are used for:
  *
- * - abstract creation (method newData())
+ * - abstract creation (method newData()) and disposal (method freeData())
  * - identification (method name())
  * - abstract gathered i/o (methods readGatheredData(), writeGatheredData())
  *
@@ -81,7 +84,27 @@ protected:
     }
 
 public:
+    /** Heap allocation counters of data types recycling their objects */
+    struct AllocationStatistics {
+        u64 nAllocations;    /**< objects allocated on the heap */
+        u64 nDeallocations;  /**< objects returned to the heap */
+        u64 nReuses;         /**< objects taken from a free list */
+        AllocationStatistics()
+                : nAllocations(0), nDeallocations(0), nReuses(0) {}
+    };
+
     virtual Data* newData() const = 0;
+    /** Called when the reference count of @param d has dropped to zero */
+    virtual void freeData(const Data* d) const {
+        delete d;
+    }
+
+    virtual bool isPooled() const {
+        return false;
+    }
+    virtual AllocationStatistics allocationStatistics() const {
+        return AllocationStatistics();
+    }
 };
 
 /** Flow data type definition */
@@ -97,6 +120,102 @@ public:
     }
 };
 
+/**
+ * Flow data type definition recycling its data objects
+ *
+ * Objects whose reference count drops to zero are put on a free list of
+ * the releasing thread and handed out again by create() and newData()
+ * instead of allocating a new object.  As vectors keep their capacity,
+ * a network processing frames of constant size does not allocate in the
+ * steady state.  The free lists are per thread and need no locking;
+ * objects may migrate between threads, e.g. over threaded links.
+ *
+ * T must implement recycle(), which resets the object to the state after
+ * default construction.  Objects of classes derived from T are deleted.
+ *
+ * Objects may be released as long as they exist, e.g. by destructors of
+ * static objects.  Therefore instances must be allocated on the heap and
+ * never be destroyed.
+ */
+template<class T>
+class PooledDatatypeTemplate : public DatatypeTemplate<T> {
+public:
+    /** Maximum number of objects kept per thread */
+    static const size_t maxFreeListSize = 256;
+
+private:
+    struct FreeList {
+        std::vector<T*> objects;
+        bool&           isDestroyed;
+        FreeList(bool& destroyed)
+                : isDestroyed(destroyed) {}
+        ~FreeList() {
+            isDestroyed = true;
+            for (size_t i = 0; i < objects.size(); ++i)
+                delete objects[i];
+        }
+    };
+
+    /** Free list of the calling thread, 0 during destruction of the thread */
+    static FreeList* freeList() {
+        static thread_local bool isDestroyed = false;
+        if (isDestroyed)
+            return 0;
+        static thread_local FreeList freeList(isDestroyed);
+        return &freeList;
+    }
+
+    mutable std::atomic<u64> nAllocations_;
+    mutable std::atomic<u64> nDeallocations_;
+    mutable std::atomic<u64> nReuses_;
+
+public:
+    PooledDatatypeTemplate(const std::string& _name)
+            : DatatypeTemplate<T>(_name), nAllocations_(0), nDeallocations_(0), nReuses_(0) {}
+
+    T* create() const {
+        FreeList* list = freeList();
+        if (list && !list->objects.empty()) {
+            T* t = list->objects.back();
+            list->objects.pop_back();
+            nReuses_.fetch_add(1, std::memory_order_relaxed);
+            return t;
+        }
+        nAllocations_.fetch_add(1, std::memory_order_relaxed);
+        T* t = new T();
+        this->brand(t);
+        return t;
+    }
+
+    virtual Data* newData() const {
+        return create();
+    }
+
+    virtual void freeData(const Data* d) const {
+        FreeList* list = freeList();
+        if (list && list->objects.size() < maxFreeListSize && typeid(*d) == typeid(T)) {
+            T* t = const_cast<T*>(static_cast<const T*>(d));
+            t->recycle();
+            list->objects.push_back(t);
+        }
+        else {
+            nDeallocations_.fetch_add(1, std::memory_order_relaxed);
+            delete d;
+        }
+    }
+
+    virtual bool isPooled() const {
+        return true;
+    }
+    virtual Datatype::AllocationStatistics allocationStatistics() const {
+        Datatype::AllocationStatistics result;
+        result.nAllocations   = nAllocations_.load(std::memory_order_relaxed);
+        result.nDeallocations = nDeallocations_.load(std::memory_order_relaxed);
+        result.nReuses        = nReuses_.load(std::memory_order_relaxed);
+        return result;
+    }
+};
+
 }  // namespace Flow
 
 #endif  // _FLOW_DATATYPE_HH
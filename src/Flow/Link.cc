@@ -12,8 +12,11 @@
  *  See the License for the specific language governing permissions and
  *  limitations under the License.
  */
+#include <algorithm>
 #include <iostream>
 
+#include <Core/Archive.hh>
+
 #include "Link.hh"
 #include "Node.hh"
 #include "Registry.hh"
@@ -27,21 +30,37 @@ Link::Link() {
     from_port_ = IllegalPortId;
     to_node_   = 0;
     to_port_   = IllegalPortId;
-    is_fast_   = false;
+    is_fast_   = true;  // until configured
     buffer_    = 0;
     datatype_  = 0;
     fast_data_ = sentinelEmpty();
+    needRun_   = true;
+    failed_    = false;
+    endOfRun_  = false;
+
+    nPendingWrites_ = 0;
+    nPutPackets_    = 0;
+    nTakenPackets_  = 0;
 }
 
 /******************************************************************************/
 
 Link::~Link() {
-    clear();
+    // threads have been terminated by the network already, the from-node may be gone
+    releaseData();
 }
 
 /******************************************************************************/
 
 void Link::clear() {
+    if (!is_fast_ && getFromNode())
+        getFromNode()->stopThread();
+    releaseData();
+}
+
+/******************************************************************************/
+
+void Link::releaseData() {
     queue_.clear();
 
     if (!isEmpty(fast_data_)) {
@@ -49,6 +68,94 @@ void Link::clear() {
             fast_data_->free();
         fast_data_ = sentinelEmpty();
     }
+
+    std::vector<Data*> removed;
+    threadedQueue_.clear(removed);
+    for (std::vector<Data*>::iterator d = removed.begin(); d != removed.end(); ++d) {
+        if ((*d)->decrement())
+            (*d)->free();
+    }
+    threadedQueue_.resume();
+    needRun_ = true;
+    failed_  = false;
+
+    // like the data sent ahead, the files written ahead are discarded
+    for (std::deque<std::pair<u64, Core::DeferredArchiveWrites*>>::iterator w = pendingWrites_.begin(); w != pendingWrites_.end(); ++w)
+        delete w->second;
+    pendingWrites_.clear();
+    nPendingWrites_ = 0;
+    nPutPackets_    = 0;
+    nTakenPackets_  = 0;
+}
+
+/******************************************************************************/
+
+bool Link::getThreadedData(Data*& d) {
+    if (needRun_) {
+        needRun_ = false;
+        getFromNode()->requestRun();
+    }
+    d       = threadedQueue_.get();
+    failed_ = (d == Data::sentinel());
+    if (!d) {
+        // interrupted
+        needRun_ = true;
+        return false;
+    }
+    if (nPendingWrites_.load())
+        handOverWrites();
+    ++nTakenPackets_;
+    if (Data::isSentinel(d))
+        needRun_ = true;
+    return true;
+}
+
+/******************************************************************************/
+
+void Link::putThreadedData(Data* d) {
+    if (Data::isSentinel(d))
+        endOfRun_ = true;
+    // the files written by the thread so far have to be written before the consumer processes this packet
+    Core::DeferredArchiveWrites* writes = getFromNode()->threadWrites_;
+    if (writes && writes->size()) {
+        Core::DeferredArchiveWrites* pending = new Core::DeferredArchiveWrites();
+        pending->append(*writes);
+        std::lock_guard<std::mutex> lock(pendingWritesMutex_);
+        pendingWrites_.push_back(std::make_pair(nPutPackets_, pending));
+        ++nPendingWrites_;
+    }
+    ++nPutPackets_;
+    d->increment();
+    if (!threadedQueue_.put(d)) {
+        // interrupted, nobody is going to fetch the packet
+        if (d->decrement())
+            d->free();
+    }
+}
+
+/******************************************************************************/
+
+void Link::putFailure() {
+    putThreadedData(Data::sentinel());
+}
+
+/******************************************************************************/
+
+void Link::handOverWrites() {
+    std::vector<Core::DeferredArchiveWrites*> ready;
+    {
+        std::lock_guard<std::mutex> lock(pendingWritesMutex_);
+        while (!pendingWrites_.empty() && pendingWrites_.front().first == nTakenPackets_) {
+            ready.push_back(pendingWrites_.front().second);
+            pendingWrites_.pop_front();
+            --nPendingWrites_;
+        }
+    }
+    for (std::vector<Core::DeferredArchiveWrites*>::iterator w = ready.begin(); w != ready.end(); ++w) {
+        if (!(*w)->handOver())
+            getFromNode()->error("Failed to write the archive files of the thread.");
+        delete *w;
+    }
 }
 
 /******************************************************************************/
@@ -83,8 +190,20 @@ std::ostream& Flow::operator<<(std::ostream& o, const Link& l) {
 /******************************************************************************/
 
 void Link::configure() {
-    if (getFromNode())
-        is_fast_ = !getFromNode()->isThreaded();
+    if (!getFromNode())
+        return;
+    bool isFast = !getFromNode()->runsOwnThread();
+    if (!isFast)
+        getFromNode()->threadLink_ = this;
+    if (isFast != is_fast_) {
+        clear();
+        is_fast_ = isFast;
+    }
+    if (!is_fast_ && threadedQueue_.capacity() < std::max<size_t>(buffer_, defaultThreadedBuffer)) {
+        getFromNode()->stopThread();
+        clear();
+        threadedQueue_.setCapacity(std::max<size_t>(buffer_, defaultThreadedBuffer));
+    }
 }
 
 /******************************************************************************/
@@ -110,6 +229,8 @@ void Link::setAttributes(Core::Ref<const Attributes> a) {
 }
 
 ssize_t Link::getRemainingDataLen() {
+    if (!is_fast_)
+        return -1;  // the from-node is working in its own thread
     AbstractNode* fromNode   = getFromNode();
     PortId        fromPortId = getFromPort();
     require(fromNode);
@@ -16,6 +16,9 @@
 #define _FLOW_LINK_HH
 
 //#include <ostream.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <ostream>
 
 #include <Core/Assertions.hh>
@@ -24,10 +27,16 @@
 #include "Queue.hh"
 #include "Types.hh"
 
+namespace Core {
+class DeferredArchiveWrites;
+}
+
 namespace Flow {
 
 class AbstractNode;
 class Link {
+    friend class AbstractNode;
+
 private:
     // connection
     AbstractNode* from_node_;
@@ -42,6 +51,7 @@ private:
     // dynamic data
     u32                         buffer_;
     Queue                       queue_;
+    BoundedQueue                threadedQueue_;  // used instead of queue_ if the from-node runs its own thread
     const Datatype*             datatype_;
     Core::Ref<const Attributes> attributes_;
     Data*                       fast_data_;
@@ -58,6 +68,28 @@ private:
         return (t == sentinelEmpty());
     }
 
+    /** Threaded links only.
+     *  needRun_ (consumer side): the from-node has to be asked for a new run,
+     *  because the last packet taken ended the previous run.
+     *  failed_ (consumer side): the last run of the from-node failed.
+     *  endOfRun_ (producer side): a non-data object has been sent in the current run. */
+    bool needRun_, failed_, endOfRun_;
+    enum { defaultThreadedBuffer = 64 };
+
+    /** Threaded links only.
+     *  Archive writes of the from-node thread, numbered by the packet they precede.
+     *  The consumer hands them over when it takes that packet, so that the files are
+     *  written in the same order as without threads. */
+    std::mutex                                               pendingWritesMutex_;
+    std::deque<std::pair<u64, Core::DeferredArchiveWrites*>> pendingWrites_;
+    std::atomic<u32>                                         nPendingWrites_;
+    u64                                                      nPutPackets_, nTakenPackets_;
+
+    void releaseData();
+    bool getThreadedData(Data*& d);
+    void putThreadedData(Data* d);
+    void handOverWrites();
+
 public:
     Link();
     ~Link();
@@ -66,11 +98,19 @@ public:
     inline bool isDataAvailable() {
         if (is_fast_)
             return (!isEmpty(fast_data_) || (!queue_.isEmpty()));
-        return (!queue_.isEmptyAtomar());
+        return (!threadedQueue_.isEmpty());
     }
     template<class T>
     inline bool getData(DataPtr<T>& d) {
-        if (is_fast_) {
+        if (!is_fast_) {
+            Data* p;
+            if (getThreadedData(p))
+                d.take(p);
+            else
+                d.reset();
+            return d;
+        }
+        else {
             if (!isEmpty(fast_data_)) {
                 d.take(fast_data_);
                 fast_data_ = sentinelEmpty();
@@ -82,9 +122,6 @@ public:
                 queue_.get(d);
             }
         }
-        else
-            queue_.getBlocking(d);
-
         return d;
     }
 
@@ -114,10 +151,30 @@ public:
             queue_.put(d);
             return true;
         }
-        queue_.putAtomar(d);
+        putThreadedData(d);
         return true;
     }
 
+    /** Threaded links: the from-node starts a new run of its thread.
+     *  @see AbstractNode::requestRun */
+    void startRun() {
+        endOfRun_ = false;
+    }
+    /** Threaded links: true if the current run of the from-node sent a non-data object. */
+    bool hasEndedRun() const {
+        return endOfRun_;
+    }
+    /** Threaded links: ends the current run of the from-node, because its work() failed. */
+    void putFailure();
+    /** Threaded links: true if the last data fetched failed, because work() of the from-node failed. */
+    bool hasFailed() const {
+        return failed_;
+    }
+    /** Threaded links: wakes up and fails blocked producer and consumer, until clear() is called. */
+    void interrupt() {
+        threadedQueue_.interrupt();
+    }
+
     /** Datatype as advertised by source node. */
     const Datatype* datatype() const {
         return datatype_;
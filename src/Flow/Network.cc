@@ -80,7 +80,7 @@ Network::~Network() {
         if (!dump(true, dumpChannel_))
             warning("dump of '%s' failed!", typeName_.c_str());
     }
-    //if (started_) stopThread();
+    terminateThreads();
     for (std::list<Link*>::const_iterator it = links_.begin(); it != links_.end();
          it++)
         delete *it;
@@ -239,6 +239,8 @@ bool Network::connectOutputFromInside(const std::string& fromNodeName,
     port.setNode(fromNode, fromPort);
     port.setLink(l);
     connectOutputPortLink(toPortId);
+    if (isThreaded())
+        fromNode->setThreaded(true);
 
     return true;
 }
@@ -504,38 +506,42 @@ const std::string Network::getAttribute(PortId out, const std::string& name) {
 
 /******************************************************************************/
 
-#if 0
-void Network::startThread() {
-    // if network is threaded, mark all output nodes threaded
-    if (isThreaded()) {
-        for (u32 i = 0; i < outputs_.size(); i++) {
-            outputs_[i].link()->getFromNode()->setThreaded(true);
-        }
+void Network::interruptThreads() {
+    for (std::list<AbstractNode*>::iterator it = nodes_.begin(); it != nodes_.end(); ++it) {
+        Network* network = dynamic_cast<Network*>(*it);
+        if (network)
+            network->interruptThreads();
+        else
+            (*it)->interruptThread();
     }
+}
 
-    // start all nodes
-    for (std::list<AbstractNode*>::iterator it = nodes_.begin(); it != nodes_.end(); it++) {
-        (*it)->startThread();
-    }
+/******************************************************************************/
 
-    started_ = true;
+void Network::stopThreads() {
+    // Interrupt all threads first: a thread may wait for data from another one.
+    interruptThreads();
+    for (std::list<AbstractNode*>::iterator it = nodes_.begin(); it != nodes_.end(); ++it) {
+        Network* network = dynamic_cast<Network*>(*it);
+        if (network)
+            network->stopThreads();
+        else
+            (*it)->stopThread();
+    }
 }
 
 /******************************************************************************/
 
-void Network::stopThread() {
-  // stop all nodes
-  for (std::list<AbstractNode*>::iterator it = nodes_.begin(); it != nodes_.end(); it++) {
-      (*it)->stopThread();
-  }
-
-#if 0
-  // clear all queues
-  for (u32 i = 0; i < links_.size(); i++) links_[i]->clear();
-#endif
-      started_ = false;
+void Network::terminateThreads() {
+    stopThreads();
+    for (std::list<AbstractNode*>::iterator it = nodes_.begin(); it != nodes_.end(); ++it) {
+        Network* network = dynamic_cast<Network*>(*it);
+        if (network)
+            network->terminateThreads();
+        else
+            (*it)->terminateThread();
+    }
 }
-#endif
 
 /******************************************************************************/
 
@@ -555,12 +561,12 @@ bool Network::setUserDefinedParameter(const std::string& name, const std::string
         }
     }
     if (found != 0) {
+        stopThreads();
         const std::vector<Parameter::Use>& list(found->getUses());
         for (std::vector<Parameter::Use>::const_iterator used = list.begin(); used != list.end(); ++used) {
             if (!used->by->setNetworkParameter(used->as, name, value))
                 return false;
         }
-        //stopThread();
         return true;
     }
     /*
@@ -682,6 +688,7 @@ ssize_t Network::getRemainingDataLen(PortId out) {
 /******************************************************************************/
 
 void Network::reset() {
+    stopThreads();
     for (std::vector<Port>::iterator inputPort = inputs_.begin();
          inputPort != inputs_.end(); ++inputPort) {
         inputPort->node()->eraseOutputAttributes();
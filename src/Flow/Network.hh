@@ -255,6 +255,9 @@ private:
      */
     void disconnectOutputPortLink(PortId);
 
+    void interruptThreads();
+    void terminateThreads();
+
     /** Configures the part of the network used by the output port @param out. */
     bool configureOutputPort(Port& out);
 
@@ -376,7 +379,6 @@ public:
         if (!started_) {
             if ((!l->areAttributesAvailable()) && (!configureOutputPort(port)))
                 return NULL;
-            //startThread();
         }
         return l;
     }
@@ -408,6 +410,15 @@ public:
     /** Resets all links and nodes. */
     void reset();
 
+    /** The threads of threaded nodes are started on demand, see AbstractNode.
+     *  Interrupts the current work of all threaded nodes, including those of
+     *  sub-networks, and waits until they are idle. */
+    void stopThreads();
+    /** Network nodes never run in their own thread, the sources of the outputs of a threaded network do. */
+    virtual bool runsOwnThread() {
+        return false;
+    }
+
     void go();
 
     friend std::ostream& operator<<(std::ostream& o, const Network& n);
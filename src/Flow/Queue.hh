@@ -15,7 +15,12 @@
 #ifndef _FLOW_QUEUE_HH
 #define _FLOW_QUEUE_HH
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <vector>
 
 #include <Core/Thread.hh>
 #include "Data.hh"
@@ -83,6 +88,121 @@ public:
     }
 };
 
+/**
+ * Bounded single-producer/single-consumer ring buffer of data packets.
+ *
+ * Used by links between threads: put() blocks while the buffer is full
+ * (back-pressure), get() blocks while it is empty.  Both sides spin
+ * shortly before they fall asleep; the mutex is only taken on this slow
+ * path.  interrupt() wakes up and fails all blocked and further calls
+ * until resume() is called.
+ * The queue does not own the packets, reference counting is left to the
+ * caller.
+ */
+class BoundedQueue {
+private:
+    enum { spinCount = 64 };
+
+    std::vector<Data*>      buffer_;
+    size_t                  mask_;
+    std::atomic<size_t>     head_;  // next position to read, changed by consumer only
+    std::atomic<size_t>     tail_;  // next position to write, changed by producer only
+    std::atomic<bool>       interrupted_;
+    std::atomic<bool>       consumerWaiting_, producerWaiting_;
+    std::mutex              mutex_;
+    std::condition_variable condition_;
+
+    void wakeUp() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        condition_.notify_all();
+    }
+
+public:
+    BoundedQueue()
+            : mask_(0), head_(0), tail_(0), interrupted_(false), consumerWaiting_(false), producerWaiting_(false) {}
+
+    /** Must only be called while the queue is empty and not used by other threads. */
+    void setCapacity(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        if (size != buffer_.size())
+            std::vector<Data*>(size, (Data*)0).swap(buffer_);
+        mask_ = size - 1;
+        head_ = tail_ = 0;
+    }
+    size_t capacity() const {
+        return buffer_.size();
+    }
+    bool isEmpty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    /** @return false if the queue is interrupted, the packet is not enqueued then */
+    bool put(Data* d) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        for (u32 spin = 0; tail - head_.load(std::memory_order_acquire) >= buffer_.size(); ++spin) {
+            if (interrupted_)
+                return false;
+            if (spin < spinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            producerWaiting_ = true;
+            while (tail - head_.load() >= buffer_.size() && !interrupted_)
+                condition_.wait(lock);
+            producerWaiting_ = false;
+        }
+        if (interrupted_)
+            return false;
+        buffer_[tail & mask_] = d;
+        tail_.store(tail + 1);
+        if (consumerWaiting_.load())
+            wakeUp();
+        return true;
+    }
+
+    /** @return the next packet, or 0 if the queue is interrupted */
+    Data* get() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        for (u32 spin = 0; tail_.load(std::memory_order_acquire) == head; ++spin) {
+            if (interrupted_)
+                return 0;
+            if (spin < spinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            consumerWaiting_ = true;
+            while (tail_.load() == head && !interrupted_)
+                condition_.wait(lock);
+            consumerWaiting_ = false;
+        }
+        Data* d = buffer_[head & mask_];
+        head_.store(head + 1);
+        if (producerWaiting_.load())
+            wakeUp();
+        return d;
+    }
+
+    void interrupt() {
+        interrupted_ = true;
+        wakeUp();
+    }
+    void resume() {
+        interrupted_ = false;
+    }
+
+    /** Removes all packets. Must only be called while no other thread uses the queue.
+     *  @return the removed packets are appended to @c removed */
+    void clear(std::vector<Data*>& removed) {
+        for (size_t i = head_; i != tail_; ++i)
+            removed.push_back(buffer_[i & mask_]);
+        head_ = tail_.load();
+    }
+};
+
 }  // namespace Flow
 
 #endif  // _FLOW_QUEUE_HH
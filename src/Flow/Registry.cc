@@ -74,6 +74,19 @@ void Registry_::dumpDatatypes(std::ostream& o) const {
 
 /******************************************************************************/
 
+void Registry_::writeAllocationStatistics(Core::XmlWriter& o) const {
+    o << Core::XmlOpen("data-allocation-statistics");
+    for (const std::pair<const std::string, const Datatype*>& datatype : datatypes_) {
+        if (!datatype.second->isPooled())
+            continue;
+        Datatype::AllocationStatistics statistics = datatype.second->allocationStatistics();
+        o << Core::XmlEmpty("datatype") + Core::XmlAttribute("name", datatype.first) + Core::XmlAttribute("allocations", statistics.nAllocations) + Core::XmlAttribute("deallocations", statistics.nDeallocations) + Core::XmlAttribute("reuses", statistics.nReuses);
+    }
+    o << Core::XmlClose("data-allocation-statistics");
+}
+
+/******************************************************************************/
+
 const Flow::Datatype* Registry_::getDatatype(const std::string& name) const {
     DatatypeMap::const_iterator found = datatypes_.find(name);
     if (found == datatypes_.end())
@@ -16,6 +16,7 @@
 #define _FLOW_REGISTRY_HH
 
 #include <Core/Singleton.hh>
+#include <Core/XmlStream.hh>
 #include <iostream>
 #include <map>
 #include <string>
@@ -59,6 +60,8 @@ public:
     }
     const Datatype* getDatatype(const std::string& name) const;
     void            dumpDatatypes(std::ostream& o) const;
+    /** Heap allocation counters of all datatypes recycling their objects */
+    void writeAllocationStatistics(Core::XmlWriter& o) const;
 };
 
 typedef Core::SingletonHolder<Registry_> Registry;
@@ -36,7 +36,7 @@ struct VectorConverter : public Converter<Vector<In>, Vector<Out>> {
     VectorConverter(const Core::Configuration&) {}
 
     Vector<Out>* operator()(const Vector<In>& v) {
-        Vector<Out>* result = new Vector<Out>(v.size());
+        Vector<Out>* result = Vector<Out>::create(v.size());
         std::copy(v.begin(), v.end(), result->begin());
         return result;
     }
@@ -39,12 +39,25 @@ protected:
         return (Timestamp::xmlOpen() + Core::XmlAttribute("size", this->size()));
     }
 
+    static const PooledDatatypeTemplate<Self>* pooledType() {
+        // never destroyed, vectors may still be released during static destruction
+        static const PooledDatatypeTemplate<Self>* dt = new PooledDatatypeTemplate<Self>(Core::NameHelper<Vector<T>>());
+        return dt;
+    }
+
 public:
     static const Datatype* type() {
-        static Core::NameHelper<Vector<T>> name;
-        static DatatypeTemplate<Self>      dt(name);
-        return &dt;
+        return pooledType();
     };
+    /**
+     * Returns a vector of @param size value-initialized elements, recycled
+     * if possible.  Prefer over new for per-frame data.
+     */
+    static Self* create(size_t size = 0) {
+        Self* v = pooledType()->create();
+        v->resize(size);
+        return v;
+    }
     Vector()
             : Timestamp(type()){};
     Vector(size_t size)
@@ -60,7 +73,16 @@ public:
     virtual ~Vector() {}
 
     virtual Data* clone() const {
-        return new Self(*this);
+        Self* v = pooledType()->create();
+        *v      = *this;
+        return v;
+    }
+
+    /** Reset before reuse by the datatype, keeps the capacity. */
+    void recycle() {
+        this->clear();
+        setStartTime(0);
+        setEndTime(0);
     }
 
     virtual Core::XmlWriter& dump(Core::XmlWriter& o) const;
@@ -54,7 +54,7 @@ public:
     }
 
     virtual Vector<T>* merge(std::vector<DataPtr<Vector<T>>>& inputData) {
-        Flow::Vector<T>* out = new Flow::Vector<T>;
+        Flow::Vector<T>* out = Flow::Vector<T>::create();
         if (output_size_ > 0)
             out->reserve(output_size_);
 
@@ -37,7 +37,8 @@ public:
      */
     virtual Vector<T>* merge(std::vector<DataPtr<Vector<T>>>& inputData) {
         require(inputData.size() > 0);
-        Flow::Vector<T>* out = new Flow::Vector<T>(*inputData[0]);
+        Flow::Vector<T>* out = Flow::Vector<T>::create();
+        *out                 = *inputData[0];
         for (u32 i = 1; i < inputData.size(); ++i) {
             Flow::Vector<T>& in(*inputData[i]);
             if (out->size() < in.size())
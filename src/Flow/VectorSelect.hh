@@ -117,7 +117,7 @@ bool VectorSelectNode<T>::work(Flow::PortId p) {
     if (getData(0, ptrFeatures)) {
         // select the features
         require(getOutputSize());  // If this fails, then no selection was specified
-        Flow::Vector<T>* out = new Flow::Vector<T>(getOutputSize());
+        Flow::Vector<T>* out = Flow::Vector<T>::create(getOutputSize());
         applyFeatureSelection(*(ptrFeatures.get()), *out);
 
         out->setTimestamp(*ptrFeatures);
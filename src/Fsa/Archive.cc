@@ -40,7 +40,10 @@ Archive::Archive(
     if (!pathname.size())
         pathname = paramPath(config);
 
-    archive_ = Core::Archive::create(config, pathname, accessMode);
+    if (accessMode & Core::Archive::AccessModeWrite)
+        archive_ = Core::Archive::createShared(config, pathname, accessMode);
+    else
+        archive_ = Core::Archive::create(config, pathname, accessMode);
     if (!archive_) {
         error("failed to open fsa archive \"%s\"", pathname.c_str());
         return;
@@ -49,7 +52,7 @@ Archive::Archive(
 }
 
 Archive::~Archive() {
-    delete archive_;
+    Core::Archive::releaseShared(archive_);
 }
 // -----------------------------------------------------------------------------
 
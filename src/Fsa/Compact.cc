@@ -0,0 +1,35 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "Compact.hh"
+
+namespace Fsa {
+ConstCompactAutomatonRef compactCopy(ConstAutomatonRef f) {
+    return Ftl::compactCopy<Automaton>(f);
+}
+
+bool writeCompact(ConstCompactAutomatonRef f, const std::string& filename) {
+    return f->write(filename);
+}
+
+ConstCompactAutomatonRef mapCompact(const std::string& filename, ConstSemiringRef semiring,
+                                    ConstAlphabetRef input, ConstAlphabetRef output) {
+    CompactAutomaton* f = new CompactAutomaton;
+    if (!f->map(filename, semiring, input, output)) {
+        delete f;
+        return ConstCompactAutomatonRef();
+    }
+    return ConstCompactAutomatonRef(f);
+}
+}  // namespace Fsa
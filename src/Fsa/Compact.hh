@@ -0,0 +1,48 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _FSA_COMPACT_HH
+#define _FSA_COMPACT_HH
+
+#include "Automaton.hh"
+#include "Types.hh"
+#include "tCompact.hh"
+
+namespace Ftl {
+template<>
+struct IsPlainWeight<Fsa::Weight> {
+    static const bool value = true;
+};
+}  // namespace Ftl
+
+namespace Fsa {
+typedef Ftl::CompactAutomaton<Automaton>  CompactAutomaton;
+typedef Core::Ref<const CompactAutomaton> ConstCompactAutomatonRef;
+typedef Ftl::StateView<Automaton>         StateView;
+typedef Ftl::StateViewer<Automaton>       StateViewer;
+
+ConstCompactAutomatonRef compactCopy(ConstAutomatonRef);
+
+/** Write a compact automaton image, see Ftl::CompactAutomaton. */
+bool writeCompact(ConstCompactAutomatonRef f, const std::string& filename);
+
+/**
+ * Map a compact automaton image read-only into memory.
+ * Returns an empty reference if the file is not a valid image.
+ **/
+ConstCompactAutomatonRef mapCompact(const std::string& filename, ConstSemiringRef semiring,
+                                    ConstAlphabetRef input, ConstAlphabetRef output = ConstAlphabetRef());
+}  // namespace Fsa
+
+#endif  // _FSA_COMPACT_HH
@@ -21,6 +21,7 @@
 #include "tAutomaton.hh"
 #include "tBest.hh"
 #include "tCache.hh"
+#include "tCompact.hh"
 #include "tDeterminize.hh"
 #include "tRational.hh"
 #include "tRemoveEpsilons.hh"
@@ -34,23 +35,25 @@ private:
 
 public:
     typedef typename _Automaton::Weight        _Weight;
+    typedef typename _Automaton::Arc           _Arc;
     typedef typename _Automaton::State         _State;
     typedef typename _Automaton::ConstStateRef _ConstStateRef;
     typedef typename _Automaton::ConstRef      _ConstAutomatonRef;
     typedef StatePotentials<_Weight>           _StatePotentials;
 
 private:
-    _StatePotentials potentials_;
+    _StatePotentials        potentials_;
+    StateViewer<_Automaton> states_;
 
 public:
     BestAutomaton(_ConstAutomatonRef f)
-            : Precursor(f), potentials_(sssp<_Automaton>(transpose<_Automaton>(f, false))) {
+            : Precursor(f), potentials_(sssp<_Automaton>(transpose<_Automaton>(f, false))), states_(f.get()) {
         this->setProperties(Fsa::PropertyStorage | Fsa::PropertyCached, Fsa::PropertyNone);
         this->addProperties(Fsa::PropertySorted);
         this->addProperties(Fsa::PropertyLinear | Fsa::PropertyAcyclic);
     }
     BestAutomaton(_ConstAutomatonRef f, const _StatePotentials& backward)
-            : Precursor(f), potentials_(backward) {
+            : Precursor(f), potentials_(backward), states_(f.get()) {
         this->setProperties(Fsa::PropertyStorage | Fsa::PropertyCached, Fsa::PropertyNone);
         this->addProperties(Fsa::PropertySorted);
         this->addProperties(Fsa::PropertyLinear | Fsa::PropertyAcyclic);
@@ -66,11 +69,11 @@ public:
      * \warning best() does not work when there are non-trivial zero-weight loops.
      */
     virtual _ConstStateRef getState(Fsa::StateId s) const {
-        _ConstStateRef                  _sp       = Precursor::fsa_->getState(s);
-        _State*                         sp        = new _State(_sp->id(), _sp->tags(), _sp->weight_);
-        typename _State::const_iterator bestArc   = _sp->end();
-        _Weight                         minWeight = Precursor::fsa_->semiring()->max();
-        for (typename _State::const_iterator a = _sp->begin(); a != _sp->end(); ++a) {
+        StateView<_Automaton> _sp       = states_(s);
+        _State*               sp        = new _State(_sp.id(), _sp.tags(), _sp.weight());
+        const _Arc*           bestArc   = _sp.end();
+        _Weight               minWeight = Precursor::fsa_->semiring()->max();
+        for (const _Arc* a = _sp.begin(); a != _sp.end(); ++a) {
             if (a->target() == s)
                 continue;
             _Weight w = Precursor::fsa_->semiring()->extend(a->weight_, potentials_[a->target()]);
@@ -82,10 +85,10 @@ public:
         if (sp->isFinal()) {
             if (Precursor::fsa_->semiring()->compare(sp->weight_, minWeight) < 0) {
                 minWeight = sp->weight_;
-                bestArc   = _sp->end();
+                bestArc   = _sp.end();
             }
         }
-        if (bestArc != _sp->end()) {
+        if (bestArc != _sp.end()) {
             sp->unsetFinal();
             *sp->newArc() = *bestArc;
         }
@@ -0,0 +1,375 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Core/Assertions.hh>
+#include <Core/XmlStream.hh>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tCompact.hh"
+
+namespace Ftl {
+
+/**
+ * Image file layout:
+ * header, arc begin indices (u32), state tags, final weights, arcs;
+ * each array starts at a multiple of 64 bytes.
+ */
+struct CompactAutomatonImageHeader {
+    static const u32 currentVersion = 1;
+
+    char magic[8];
+    u32  version;
+    u32  arcSize, weightSize;
+    u32  type;
+    u32  initial;
+    u32  nStates, nArcs;
+    u32  knownProperties, properties;
+    u32  reserved;
+    u64  tagsOffset, weightsOffset, arcsOffset, end;
+
+    static u64 align(u64 offset) {
+        return (offset + 63) & ~u64(63);
+    }
+    static const char* magicString() {
+        return "FSACSR\0";
+    }
+    void layout() {
+        tagsOffset    = align(sizeof(CompactAutomatonImageHeader) + (u64(nStates) + 1) * sizeof(u32));
+        weightsOffset = align(tagsOffset + u64(nStates) * sizeof(Fsa::StateTag));
+        arcsOffset    = align(weightsOffset + u64(nStates) * weightSize);
+        end           = arcsOffset + u64(nArcs) * arcSize;
+    }
+};
+
+template<class _Automaton>
+CompactAutomaton<_Automaton>::CompactAutomaton(Fsa::Type type)
+        : type_(type),
+          initial_(Fsa::InvalidStateId),
+          desc_("compact"),
+          nStates_(0),
+          nArcs_(0),
+          arcBegin_(0),
+          tags_(0),
+          weights_(0),
+          arcs_(0),
+          isSorted_(true),
+          mapping_(0),
+          mappingSize_(0) {
+    Precursor::setProperties(Fsa::PropertyStorage | Fsa::PropertyCached, Fsa::PropertyStorage | Fsa::PropertyCached);
+}
+
+template<class _Automaton>
+CompactAutomaton<_Automaton>::~CompactAutomaton() {
+    unmap();
+}
+
+template<class _Automaton>
+void CompactAutomaton<_Automaton>::unmap() {
+    if (mapping_) {
+        munmap(mapping_, mappingSize_);
+        mapping_     = 0;
+        mappingSize_ = 0;
+    }
+}
+
+template<class _Automaton>
+void CompactAutomaton<_Automaton>::setPointers() {
+    arcBegin_ = arcBeginStorage_.data();
+    tags_     = tagStorage_.data();
+    weights_  = weightStorage_.data();
+    arcs_     = arcStorage_.data();
+}
+
+template<class _Automaton>
+void CompactAutomaton<_Automaton>::addState(const _State& s) {
+    require(!arcBegin_);
+    Fsa::StateId id = s.id();
+    if (id >= tagStorage_.size()) {
+        tagStorage_.resize(id + 1, Fsa::InvalidStateId);
+        weightStorage_.resize(id + 1, _Weight());
+        arcBeginStorage_.resize(id + 1, 0);
+        nStateArcs_.resize(id + 1, 0);
+    }
+    else {
+        isSorted_ = false;
+    }
+    require(tagStorage_[id] == Fsa::InvalidStateId);
+    tagStorage_[id]      = s.tags();
+    weightStorage_[id]   = s.weight_;
+    arcBeginStorage_[id] = arcStorage_.size();
+    nStateArcs_[id]      = s.nArcs();
+    arcStorage_.insert(arcStorage_.end(), s.begin(), s.end());
+}
+
+template<class _Automaton>
+void CompactAutomaton<_Automaton>::pack() {
+    require(!arcBegin_);
+    require(arcStorage_.size() < size_t(Core::Type<u32>::max));
+    nStates_ = tagStorage_.size();
+    if (!isSorted_) {
+        std::vector<_Arc> arcs;
+        arcs.reserve(arcStorage_.size());
+        for (Fsa::StateId s = 0; s < nStates_; ++s)
+            arcs.insert(arcs.end(),
+                        arcStorage_.begin() + arcBeginStorage_[s],
+                        arcStorage_.begin() + arcBeginStorage_[s] + nStateArcs_[s]);
+        arcStorage_.swap(arcs);
+    }
+    arcBeginStorage_.resize(nStates_ + 1);
+    u32 n = 0;
+    for (Fsa::StateId s = 0; s < nStates_; ++s) {
+        arcBeginStorage_[s] = n;
+        n += nStateArcs_[s];
+    }
+    arcBeginStorage_[nStates_] = n;
+    nArcs_                     = n;
+    std::vector<u32>().swap(nStateArcs_);
+    arcStorage_.shrink_to_fit();
+    setPointers();
+}
+
+template<class _Automaton>
+Core::Ref<const typename _Automaton::State> CompactAutomaton<_Automaton>::getState(Fsa::StateId s) const {
+    if (!hasState(s))
+        return _ConstStateRef();
+    _State*     sp    = new _State(s, tags_[s], weights_[s]);
+    const _Arc *begin = arcs_ + arcBegin_[s], *end = arcs_ + arcBegin_[s + 1];
+    sp->resize(end - begin);
+    std::copy(begin, end, sp->begin());
+    return _ConstStateRef(sp);
+}
+
+template<class _Automaton>
+Core::Ref<const CompactAutomaton<_Automaton>> CompactAutomaton<_Automaton>::transpose() const {
+    Self* t = new Self(type_);
+    t->setSemiring(semiring_);
+    t->setInputAlphabet(input_);
+    t->setOutputAlphabet(output_);
+    t->setProperties(this->knownProperties() & ~(Fsa::PropertyStorage | Fsa::PropertyCached), this->properties());
+    t->setDescription("transpose(" + desc_ + ")");
+
+    std::vector<bool> accessible(nStates_, false);
+    u32               nFinals = 0;
+    if (hasState(initial_)) {
+        std::vector<Fsa::StateId> S(1, initial_);
+        accessible[initial_] = true;
+        while (!S.empty()) {
+            Fsa::StateId s = S.back();
+            S.pop_back();
+            if (tags_[s] & Fsa::StateTagFinal)
+                ++nFinals;
+            for (const _Arc *a = arcs_ + arcBegin_[s], *end = arcs_ + arcBegin_[s + 1]; a != end; ++a)
+                if (hasState(a->target()) && !accessible[a->target()]) {
+                    accessible[a->target()] = true;
+                    S.push_back(a->target());
+                }
+        }
+    }
+    if (nFinals == 0) {
+        t->pack();
+        return Core::Ref<const Self>(t);
+    }
+
+    // counting sort of the arcs by target, the new initial state gets id nStates_
+    const Fsa::StateId initial = nStates_;
+    t->nStates_                = nStates_ + 1;
+    t->arcBeginStorage_.assign(t->nStates_ + 1, 0);
+    t->tagStorage_.assign(t->nStates_, Fsa::InvalidStateId);
+    t->weightStorage_.assign(t->nStates_, _Weight());
+    std::vector<u32>& begin = t->arcBeginStorage_;
+    for (Fsa::StateId s = 0; s < nStates_; ++s)
+        if (accessible[s])
+            for (const _Arc *a = arcs_ + arcBegin_[s], *end = arcs_ + arcBegin_[s + 1]; a != end; ++a)
+                if (hasState(a->target()))
+                    ++begin[a->target() + 1];
+    begin[initial + 1] = nFinals;
+    for (Fsa::StateId s = 0; s < t->nStates_; ++s)
+        begin[s + 1] += begin[s];
+    t->nArcs_ = begin[t->nStates_];
+    t->arcStorage_.resize(t->nArcs_);
+    std::vector<u32> next(begin.begin(), begin.end() - 1);
+    for (Fsa::StateId s = 0; s < nStates_; ++s) {
+        if (!accessible[s])
+            continue;
+        Fsa::StateTag tags = tags_[s] & ~Fsa::StateTagFinal;
+        if (s == initial_) {
+            tags |= Fsa::StateTagFinal;
+            t->weightStorage_[s] = semiring_->one();
+        }
+        t->tagStorage_[s] = tags;
+        for (const _Arc *a = arcs_ + arcBegin_[s], *end = arcs_ + arcBegin_[s + 1]; a != end; ++a)
+            if (hasState(a->target())) {
+                _Arc& b   = t->arcStorage_[next[a->target()]++];
+                b         = *a;
+                b.target_ = s;
+            }
+        if (tags_[s] & Fsa::StateTagFinal)
+            t->arcStorage_[next[initial]++] = _Arc(s, weights_[s], Fsa::Epsilon, Fsa::Epsilon);
+    }
+    t->tagStorage_[initial] = Fsa::StateTagNone;
+    t->initial_             = initial;
+    t->setPointers();
+    return Core::Ref<const Self>(t);
+}
+
+template<class _Automaton>
+bool CompactAutomaton<_Automaton>::write(const std::string& filename) const {
+    static_assert(IsPlainWeight<_Weight>::value, "only automata with plain weights can be written as image");
+    CompactAutomatonImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CompactAutomatonImageHeader::magicString(), sizeof(header.magic));
+    header.version         = CompactAutomatonImageHeader::currentVersion;
+    header.arcSize         = sizeof(_Arc);
+    header.weightSize      = sizeof(_Weight);
+    header.type            = type_;
+    header.initial         = initial_;
+    header.nStates         = nStates_;
+    header.nArcs           = nArcs_;
+    header.knownProperties = this->knownProperties();
+    header.properties      = this->properties();
+    header.layout();
+
+    std::ofstream o(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!o)
+        return false;
+    const char zeros[64] = {0};
+    o.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    o.write(reinterpret_cast<const char*>(arcBegin_), (u64(nStates_) + 1) * sizeof(u32));
+    o.write(zeros, header.tagsOffset - u64(o.tellp()));
+    o.write(reinterpret_cast<const char*>(tags_), u64(nStates_) * sizeof(Fsa::StateTag));
+    o.write(zeros, header.weightsOffset - u64(o.tellp()));
+    o.write(reinterpret_cast<const char*>(weights_), u64(nStates_) * sizeof(_Weight));
+    o.write(zeros, header.arcsOffset - u64(o.tellp()));
+    o.write(reinterpret_cast<const char*>(arcs_), u64(nArcs_) * sizeof(_Arc));
+    o.close();
+    return o.good();
+}
+
+template<class _Automaton>
+bool CompactAutomaton<_Automaton>::map(const std::string& filename, _ConstSemiringRef semiring,
+                                       Fsa::ConstAlphabetRef input, Fsa::ConstAlphabetRef output) {
+    static_assert(IsPlainWeight<_Weight>::value, "only automata with plain weights can be mapped from an image");
+    require(!arcBegin_ && tagStorage_.empty());
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (size_t(st.st_size) < sizeof(CompactAutomatonImageHeader))) {
+        ::close(fd);
+        return false;
+    }
+    char* mapping = (char*)mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    CompactAutomatonImageHeader header;
+    memcpy(&header, mapping, sizeof(header));
+    CompactAutomatonImageHeader expected = header;
+    expected.layout();
+    if ((memcmp(header.magic, CompactAutomatonImageHeader::magicString(), sizeof(header.magic)) != 0) ||
+        (header.version != CompactAutomatonImageHeader::currentVersion) ||
+        (header.arcSize != sizeof(_Arc)) || (header.weightSize != sizeof(_Weight)) ||
+        (header.tagsOffset != expected.tagsOffset) || (header.weightsOffset != expected.weightsOffset) ||
+        (header.arcsOffset != expected.arcsOffset) || (header.end != expected.end) ||
+        (header.end > u64(st.st_size))) {
+        munmap(mapping, st.st_size);
+        return false;
+    }
+    mapping_     = mapping;
+    mappingSize_ = st.st_size;
+    type_        = Fsa::Type(header.type);
+    initial_     = header.initial;
+    nStates_     = header.nStates;
+    nArcs_       = header.nArcs;
+    arcBegin_    = reinterpret_cast<const u32*>(mapping_ + sizeof(header));
+    tags_        = reinterpret_cast<const Fsa::StateTag*>(mapping_ + header.tagsOffset);
+    weights_     = reinterpret_cast<const _Weight*>(mapping_ + header.weightsOffset);
+    arcs_        = reinterpret_cast<const _Arc*>(mapping_ + header.arcsOffset);
+    this->setProperties(header.knownProperties, header.properties);
+    this->setProperties(Fsa::PropertyStorage | Fsa::PropertyCached, Fsa::PropertyStorage | Fsa::PropertyCached);
+    semiring_ = semiring;
+    input_    = input;
+    output_   = output;
+    desc_     = "compact(" + filename + ")";
+    return true;
+}
+
+template<class _Automaton>
+size_t CompactAutomaton<_Automaton>::getMemoryUsed() const {
+    size_t size = sizeof(Self);
+    if (input_)
+        size += input_->getMemoryUsed();
+    if (output_ && output_ != input_)
+        size += output_->getMemoryUsed();
+    size += (size_t(nStates_) + 1) * sizeof(u32) + size_t(nStates_) * (sizeof(Fsa::StateTag) + sizeof(_Weight));
+    size += size_t(nArcs_) * sizeof(_Arc);
+    return size;
+}
+
+template<class _Automaton>
+void CompactAutomaton<_Automaton>::dumpMemoryUsage(Core::XmlWriter& o) const {
+    o << Core::XmlOpen("compact") + Core::XmlAttribute("mapped", isMapped() ? "true" : "false")
+      << Core::XmlFull("states", (size_t(nStates_) + 1) * sizeof(u32) + size_t(nStates_) * (sizeof(Fsa::StateTag) + sizeof(_Weight)))
+      << Core::XmlFull("arcs", size_t(nArcs_) * sizeof(_Arc))
+      << Core::XmlFull("total", getMemoryUsed())
+      << Core::XmlClose("compact");
+}
+
+template<class _Automaton>
+Core::Ref<const CompactAutomaton<_Automaton>> compactCopy(typename _Automaton::ConstRef f) {
+    typedef typename _Automaton::State         _State;
+    typedef typename _Automaton::ConstStateRef _ConstStateRef;
+    if (!f)
+        return Core::Ref<const CompactAutomaton<_Automaton>>();
+    const CompactAutomaton<_Automaton>* c = dynamic_cast<const CompactAutomaton<_Automaton>*>(f.get());
+    if (c)
+        return Core::Ref<const CompactAutomaton<_Automaton>>(c);
+
+    CompactAutomaton<_Automaton>* result = new CompactAutomaton<_Automaton>(f->type());
+    result->setSemiring(f->semiring());
+    result->setInputAlphabet(f->getInputAlphabet());
+    if (f->type() == Fsa::TypeTransducer)
+        result->setOutputAlphabet(f->getOutputAlphabet());
+    result->setProperties(f->knownProperties() & ~(Fsa::PropertyStorage | Fsa::PropertyCached), f->properties());
+    result->setDescription("compact(" + f->describe() + ")");
+    result->setInitialStateId(f->initialStateId());
+    if (f->initialStateId() != Fsa::InvalidStateId) {
+        Core::Vector<bool>        visited;
+        std::vector<Fsa::StateId> S(1, f->initialStateId());
+        while (!S.empty()) {
+            Fsa::StateId s = S.back();
+            S.pop_back();
+            visited.grow(s, false);
+            if (visited[s])
+                continue;
+            visited[s]        = true;
+            _ConstStateRef sp = f->getState(s);
+            if (!sp)
+                continue;
+            result->addState(*sp);
+            for (typename _State::const_iterator a = sp->begin(); a != sp->end(); ++a)
+                if ((a->target() >= visited.size()) || !visited[a->target()])
+                    S.push_back(a->target());
+        }
+    }
+    result->pack();
+    return Core::Ref<const CompactAutomaton<_Automaton>>(result);
+}
+
+}  // namespace Ftl
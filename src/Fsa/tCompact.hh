@@ -0,0 +1,302 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _T_FSA_COMPACT_HH
+#define _T_FSA_COMPACT_HH
+
+#include <Core/ReferenceCounting.hh>
+#include <Core/Vector.hh>
+#include <vector>
+#include "Types.hh"
+#include "tAutomaton.hh"
+
+namespace Ftl {
+
+/**
+ * Weights which can be written to and mapped from image files, i.e.
+ * plain values without pointers.  Specialize for such weight types.
+ */
+template<class _Weight>
+struct IsPlainWeight {
+    static const bool value = false;
+};
+
+/**
+ * Read-only, non reference counted view of a state.
+ *
+ * For a CompactAutomaton the view points directly into the arrays of the
+ * automaton.  For all other automata the view holds the reference
+ * returned by getState().  In both cases the arcs are a contiguous range
+ * [begin(), end()).  The view is valid as long as the automaton is.
+ */
+template<class _Automaton>
+class StateView {
+public:
+    typedef typename _Automaton::Weight        _Weight;
+    typedef typename _Automaton::Arc           _Arc;
+    typedef typename _Automaton::ConstStateRef _ConstStateRef;
+    typedef const _Arc*                        const_iterator;
+
+private:
+    _ConstStateRef ref_;
+    Fsa::StateId   id_;
+    Fsa::StateTag  tags_;
+    const _Weight* weight_;
+    const _Arc *   begin_, *end_;
+
+public:
+    StateView()
+            : id_(Fsa::InvalidStateId), tags_(Fsa::StateTagNone), weight_(0), begin_(0), end_(0) {}
+    StateView(Fsa::StateId id, Fsa::StateTag tags, const _Weight* weight, const _Arc* begin, const _Arc* end)
+            : id_(id), tags_(tags), weight_(weight), begin_(begin), end_(end) {}
+    explicit StateView(_ConstStateRef sp)
+            : ref_(sp), id_(Fsa::InvalidStateId), tags_(Fsa::StateTagNone), weight_(0), begin_(0), end_(0) {
+        if (sp) {
+            id_     = sp->id();
+            tags_   = sp->tags();
+            weight_ = &sp->weight_;
+            if (sp->hasArcs()) {
+                begin_ = &*sp->begin();
+                end_   = begin_ + sp->nArcs();
+            }
+        }
+    }
+
+    /** false if the state does not exist */
+    bool valid() const {
+        return id_ != Fsa::InvalidStateId;
+    }
+    Fsa::StateId id() const {
+        return id_;
+    }
+    Fsa::StateTag tags() const {
+        return tags_;
+    }
+    bool hasTags(Fsa::StateTag tags) const {
+        return tags_ & tags;
+    }
+    bool isFinal() const {
+        return hasTags(Fsa::StateTagFinal);
+    }
+    const _Weight& weight() const {
+        return *weight_;
+    }
+    u32 nArcs() const {
+        return end_ - begin_;
+    }
+    bool hasArcs() const {
+        return end_ != begin_;
+    }
+    const _Arc* getArc(u32 i) const {
+        return begin_ + i;
+    }
+    const_iterator begin() const {
+        return begin_;
+    }
+    const_iterator end() const {
+        return end_;
+    }
+};
+
+/**
+ * Immutable automaton in compressed sparse row layout.
+ *
+ * States, final weights and arcs are stored in a few contiguous arrays:
+ * the outgoing arcs of state s are arcs[arcBegin[s], arcBegin[s + 1]).
+ * State ids are those of the source automaton; ids which do not belong
+ * to a state are kept as empty rows.  Compared to StaticAutomaton there
+ * is no allocation and reference counting per state, and the memory used
+ * is about the size of the arcs.
+ *
+ * Algorithms should access states by state(), which returns a
+ * StateView without any allocation; StateViewer provides the same
+ * interface for arbitrary automata.  getState() is supported for
+ * compatibility: it materializes the state, i.e. allocates a new state
+ * object per call.  Both are thread-safe.
+ *
+ * Construction: addState() for each state in any order, then pack().
+ * Automata with plain weights (IsPlainWeight) can be written to an image
+ * file and mapped read-only from it, which makes loading independent of
+ * the size of the automaton.  Semiring and alphabets are not part of the
+ * image and are passed to map().
+ */
+template<class _Automaton>
+class CompactAutomaton : public _Automaton {
+    typedef _Automaton                  Precursor;
+    typedef CompactAutomaton<_Automaton> Self;
+
+public:
+    typedef typename _Automaton::Weight   _Weight;
+    typedef typename _Automaton::Arc      _Arc;
+    typedef typename _Automaton::State    _State;
+    typedef typename _Automaton::Semiring _Semiring;
+    typedef Core::Ref<const _State>       _ConstStateRef;
+    typedef Core::Ref<const _Semiring>    _ConstSemiringRef;
+    typedef StateView<_Automaton>         View;
+
+private:
+    Fsa::Type             type_;
+    _ConstSemiringRef     semiring_;
+    Fsa::StateId          initial_;
+    Fsa::ConstAlphabetRef input_;
+    Fsa::ConstAlphabetRef output_;
+    std::string           desc_;
+
+    u32                  nStates_, nArcs_;
+    const u32*           arcBegin_;
+    const Fsa::StateTag* tags_;
+    const _Weight*       weights_;
+    const _Arc*          arcs_;
+
+    std::vector<u32>           arcBeginStorage_;
+    std::vector<Fsa::StateTag> tagStorage_;
+    std::vector<_Weight>       weightStorage_;
+    std::vector<_Arc>          arcStorage_;
+    /** number of arcs per state while building */
+    std::vector<u32> nStateArcs_;
+    bool             isSorted_;
+
+    char*  mapping_;
+    size_t mappingSize_;
+
+    void unmap();
+    void setPointers();
+
+public:
+    CompactAutomaton(Fsa::Type type = Fsa::TypeUnknown);
+    virtual ~CompactAutomaton();
+
+    void setType(Fsa::Type type) {
+        type_ = type;
+    }
+    void setSemiring(_ConstSemiringRef semiring) {
+        semiring_ = semiring;
+    }
+    void setInitialStateId(Fsa::StateId initial) {
+        initial_ = initial;
+    }
+    void setInputAlphabet(Fsa::ConstAlphabetRef alphabet) {
+        input_ = alphabet;
+    }
+    void setOutputAlphabet(Fsa::ConstAlphabetRef alphabet) {
+        output_ = alphabet;
+    }
+    void setDescription(const std::string& desc) {
+        desc_ = desc;
+    }
+
+    /** Copy the state to the automaton; only allowed before pack(). */
+    void addState(const _State& s);
+    /** Build the row arrays from the added states. */
+    void pack();
+
+    virtual Fsa::Type type() const {
+        return type_;
+    }
+    virtual _ConstSemiringRef semiring() const {
+        return semiring_;
+    }
+    virtual Fsa::StateId initialStateId() const {
+        return initial_;
+    }
+    virtual Fsa::ConstAlphabetRef getInputAlphabet() const {
+        return input_;
+    }
+    virtual Fsa::ConstAlphabetRef getOutputAlphabet() const {
+        return (type_ == Fsa::TypeAcceptor) ? input_ : output_;
+    }
+
+    bool hasState(Fsa::StateId s) const {
+        return (s < nStates_) && (tags_[s] != Fsa::InvalidStateId);
+    }
+    View state(Fsa::StateId s) const {
+        if (!hasState(s))
+            return View();
+        return View(s, tags_[s], weights_ + s, arcs_ + arcBegin_[s], arcs_ + arcBegin_[s + 1]);
+    }
+    virtual _ConstStateRef getState(Fsa::StateId s) const;
+    /**
+     * Index of the first outgoing arc of state s, s <= maxStateId();
+     * the arcs of all states are numbered consecutively from 0 to nArcs() - 1.
+     */
+    u32 arcIndex(Fsa::StateId s) const {
+        return arcBegin_[s];
+    }
+
+    /** Highest state id, InvalidStateId if there are no states. */
+    Fsa::StateId maxStateId() const {
+        return nStates_ ? nStates_ - 1 : Fsa::InvalidStateId;
+    }
+    /** maxStateId() + 1 */
+    Fsa::StateId size() const {
+        return nStates_;
+    }
+    u32 nArcs() const {
+        return nArcs_;
+    }
+    bool isMapped() const {
+        return mapping_;
+    }
+
+    /**
+     * Transposed automaton with the same result as Ftl::transpose(),
+     * i.e. restricted to the states accessible from the initial state
+     * and with a new initial state connected to the final states.
+     */
+    Core::Ref<const Self> transpose() const;
+
+    bool write(const std::string& filename) const;
+    bool map(const std::string& filename, _ConstSemiringRef semiring,
+             Fsa::ConstAlphabetRef input, Fsa::ConstAlphabetRef output = Fsa::ConstAlphabetRef());
+
+    virtual size_t      getMemoryUsed() const;
+    virtual void        dumpMemoryUsage(Core::XmlWriter& o) const;
+    virtual std::string describe() const {
+        return desc_;
+    }
+};
+
+/**
+ * Uniform, non reference counted state access for arbitrary automata:
+ * uses the arrays of a CompactAutomaton directly and falls back to
+ * getState() for all other automata.  The automaton must outlive the
+ * viewer.
+ */
+template<class _Automaton>
+class StateViewer {
+    const _Automaton*                   f_;
+    const CompactAutomaton<_Automaton>* compact_;
+
+public:
+    explicit StateViewer(const _Automaton* f)
+            : f_(f), compact_(dynamic_cast<const CompactAutomaton<_Automaton>*>(f)) {}
+    const CompactAutomaton<_Automaton>* compact() const {
+        return compact_;
+    }
+    StateView<_Automaton> operator()(Fsa::StateId s) const {
+        if (compact_)
+            return compact_->state(s);
+        return StateView<_Automaton>(f_->getState(s));
+    }
+};
+
+/** Compact copy of the states accessible from the initial state; state ids are kept. */
+template<class _Automaton>
+Core::Ref<const CompactAutomaton<_Automaton>> compactCopy(typename _Automaton::ConstRef f);
+
+}  // namespace Ftl
+
+#include "tCompact.cc"
+
+#endif  // _T_FSA_COMPACT_HH
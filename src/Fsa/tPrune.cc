@@ -15,6 +15,7 @@
 #include "tPrune.hh"
 #include <Core/Vector.hh>
 #include "tAutomaton.hh"
+#include "tCompact.hh"
 #include "tDfs.hh"
 #include "tRational.hh"
 #include "tSssp.hh"
@@ -32,6 +33,7 @@ private:
 
 public:
     typedef typename _Automaton::Weight           _Weight;
+    typedef typename _Automaton::Arc              _Arc;
     typedef typename _Automaton::State            _State;
     typedef typename _Automaton::ConstStateRef    _ConstStateRef;
     typedef typename _Automaton::ConstRef         _ConstAutomatonRef;
@@ -44,12 +46,35 @@ private:
     _StatePotentials *      fw_, *bw_;
     const _StatePotentials &forward_, &backward_;
     bool                    relative_;
+    StateViewer<_Automaton> states_;
 
 private:
+    void discoverArcs(const StateView<_Automaton>& sp) {
+        _ConstSemiringRef semiring = DfsState<_Automaton>::fsa_->semiring();
+        for (const _Arc* a = sp.begin(); a != sp.end(); ++a) {
+            _Weight w = semiring->extend(a->weight(), backward_[a->target()]);
+            w         = semiring->extend(forward_[sp.id()], w);
+            if (semiring->compare(w, minWeight_) < 0)
+                minWeight_ = w;
+        }
+    }
+
+    /** visits the states of a compact automaton without dfs: accessible states have non-zero forward potentials */
+    void discoverCompactStates() {
+        const CompactAutomaton<_Automaton>* c        = states_.compact();
+        _ConstSemiringRef                   semiring = c->semiring();
+        for (Fsa::StateId s = 0; (s < forward_.size()) && (s < c->size()); ++s)
+            if (semiring->compare(forward_[s], semiring->zero()) != 0)
+                discoverArcs(c->state(s));
+    }
+
     void setMinWeight(const _Weight& threshold) {
         if (relative_) {
             minWeight_ = this->semiring()->max();
-            this->dfs();
+            if (states_.compact())
+                discoverCompactStates();
+            else
+                this->dfs();
             minWeight_ = this->semiring()->extend(minWeight_, threshold);
         }
         else {
@@ -59,7 +84,7 @@ private:
 
 public:
     PosteriorPruneAutomaton(_ConstAutomatonRef f, const _Weight& threshold, bool relative)
-            : Precursor(f), DfsState<_Automaton>(f), threshold_(threshold), fw_(new _StatePotentials), bw_(new _StatePotentials), forward_(*fw_), backward_(*bw_), relative_(relative) {
+            : Precursor(f), DfsState<_Automaton>(f), threshold_(threshold), fw_(new _StatePotentials), bw_(new _StatePotentials), forward_(*fw_), backward_(*bw_), relative_(relative), states_(f.get()) {
         this->setProperties(Fsa::PropertyStorage | Fsa::PropertyCached, Fsa::PropertyNone);
         Fsa::StateId initial = f->initialStateId();
         if (initial != Fsa::InvalidStateId) {
@@ -70,7 +95,7 @@ public:
     }
 
     PosteriorPruneAutomaton(_ConstAutomatonRef f, const _Weight& threshold, const _StatePotentials& fw, const _StatePotentials& bw, bool relative)
-            : Precursor(f), DfsState<_Automaton>(f), threshold_(threshold), fw_(0), bw_(0), forward_(fw), backward_(bw), relative_(relative) {
+            : Precursor(f), DfsState<_Automaton>(f), threshold_(threshold), fw_(0), bw_(0), forward_(fw), backward_(bw), relative_(relative), states_(f.get()) {
         this->setProperties(Fsa::PropertyStorage | Fsa::PropertyCached, Fsa::PropertyNone);
         setMinWeight(threshold);
     }
@@ -85,20 +110,14 @@ public:
     }
 
     virtual void discoverState(_ConstStateRef sp) {
-        _ConstSemiringRef semiring = DfsState<_Automaton>::fsa_->semiring();
-        for (typename _State::const_iterator a = sp->begin(); a != sp->end(); ++a) {
-            _Weight w = semiring->extend(a->weight(), backward_[a->target()]);
-            w         = semiring->extend(forward_[sp->id()], w);
-            if (semiring->compare(w, minWeight_) < 0)
-                minWeight_ = w;
-        }
+        discoverArcs(StateView<_Automaton>(sp));
     }
     virtual _ConstStateRef getState(Fsa::StateId s) const {
         if (s < forward_.size()) {
-            _ConstStateRef    _s       = Precursor::fsa_->getState(s);
-            _State*           sp       = new _State(_s->id(), _s->tags(), _s->weight_);
-            _ConstSemiringRef semiring = Precursor::fsa_->semiring();
-            for (typename _State::const_iterator a = _s->begin(); a != _s->end(); ++a) {
+            StateView<_Automaton> _s       = states_(s);
+            _State*               sp       = new _State(_s.id(), _s.tags(), _s.weight());
+            _ConstSemiringRef     semiring = Precursor::fsa_->semiring();
+            for (const _Arc* a = _s.begin(); a != _s.end(); ++a) {
                 _Weight w = semiring->extend(a->weight(), backward_[a->target()]);
                 w         = semiring->extend(forward_[s], w);
                 if (semiring->compare(w, minWeight_) <= 0)
@@ -146,12 +165,14 @@ private:
 
 public:
     typedef typename _Automaton::Weight           _Weight;
+    typedef typename _Automaton::Arc              _Arc;
     typedef typename _Automaton::State            _State;
     typedef typename _Automaton::ConstStateRef    _ConstStateRef;
     typedef typename _Automaton::ConstRef         _ConstAutomatonRef;
     typedef typename _Automaton::ConstSemiringRef _ConstSemiringRef;
 
 private:
+    StateViewer<_Automaton>            states_;
     _Weight                            threshold_, maxWeight_;
     mutable Core::Vector<Fsa::StateId> slice_;          // index: state
     mutable Core::Vector<_Weight>      potentials_;     // index: state
@@ -160,7 +181,7 @@ private:
 
 public:
     SyncPruneAutomaton(_ConstAutomatonRef f, const _Weight& threshold)
-            : Precursor(f), threshold_(threshold), maxWeight_(Precursor::fsa_->semiring()->max()) {
+            : Precursor(f), states_(f.get()), threshold_(threshold), maxWeight_(Precursor::fsa_->semiring()->max()) {
         this->setProperties(Fsa::PropertyStorage | Fsa::PropertyCached, Fsa::PropertyNone);
         Fsa::StateId initial = f->initialStateId();
         slice_.grow(initial, Fsa::InvalidStateId);
@@ -178,8 +199,8 @@ public:
         while (!sliceStates_.empty()) {
             Core::Vector<Fsa::StateId> epsilonStates;
             for (Core::Vector<Fsa::StateId>::const_iterator s = sliceStates_.begin(); s != sliceStates_.end(); ++s) {
-                _ConstStateRef sp = Precursor::fsa_->getState(*s);
-                for (typename _State::const_iterator a = sp->begin(); a != sp->end(); ++a) {
+                StateView<_Automaton> sp = states_(*s);
+                for (const _Arc* a = sp.begin(); a != sp.end(); ++a) {
                     _Weight w = semiring->extend(potentials_[*s], a->weight());
                     if (semiring->compare(w, worst) < 0) {
                         potentials_.grow(a->target(), maxWeight_);
@@ -223,11 +244,11 @@ public:
         if (s < slice_.size()) {
             if (slice_[s] >= minPotentials_.size() - 1)
                 calculateSlice();
-            _ConstStateRef _sp = Precursor::fsa_->getState(s);
+            StateView<_Automaton> _sp = states_(s);
             // we assume calculateSlice() creates entries in slice_ and potentials_ for each target state
-            _State*           sp       = new _State(_sp->id(), _sp->tags(), _sp->weight_);
+            _State*           sp       = new _State(_sp.id(), _sp.tags(), _sp.weight());
             _ConstSemiringRef semiring = Precursor::fsa_->semiring();
-            for (typename _State::const_iterator a = _sp->begin(); a != _sp->end(); ++a)
+            for (const _Arc* a = _sp.begin(); a != _sp.end(); ++a)
                 if ((a->target() < slice_.size()) && (slice_[a->target()] != Fsa::InvalidStateId) &&
                     (semiring->compare(semiring->extend(potentials_[s], a->weight()), minPotentials_[slice_[a->target()]]) < 0))
                     *sp->newArc() = *a;
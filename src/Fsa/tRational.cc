@@ -18,6 +18,7 @@
 #include "Types.hh"
 #include "tAutomaton.hh"
 #include "tBasic.hh"
+#include "tCompact.hh"
 #include "tDfs.hh"
 #include "tRational.hh"
 #include "tStatic.hh"
@@ -650,6 +651,9 @@ typename _Automaton::ConstRef transpose(
     typedef typename _Automaton::ConstStateRef _ConstStateRef;
     typedef typename _Automaton::ConstRef      _ConstAutomatonRef;
     require(f);
+    const CompactAutomaton<_Automaton>* c = dynamic_cast<const CompactAutomaton<_Automaton>*>(f.get());
+    if (c)
+        return c->transpose();
     Core::ProgressIndicator* p = 0;
     if (progress)
         p = new Core::ProgressIndicator("transposing", "states");
@@ -15,6 +15,7 @@
 #include "tSssp.hh"
 #include <Core/Vector.hh>
 #include "tAutomaton.hh"
+#include "tCompact.hh"
 #include "tInfo.hh"
 #include "tProperties.hh"
 #include "tRational.hh"
@@ -147,16 +148,20 @@ StatePotentials<typename _Automaton::Weight> ssspLoop(
         Queue& q, typename _Automaton::ConstRef f, Fsa::StateId start,
         const SsspArcFilter<_Automaton>& arcFilter, bool progress) {
     typedef typename _Automaton::Weight           _Weight;
-    typedef typename _Automaton::State            _State;
-    typedef typename _Automaton::ConstStateRef    _ConstStateRef;
+    typedef typename _Automaton::Arc              _Arc;
     typedef typename _Automaton::ConstSemiringRef _ConstSemiringRef;
-    typedef typename _Automaton::Weight           _Weight;
     typedef StatePotentials<_Weight>              _StatePotentials;
 
-    Fsa::StateId maxStateId = q.maxStateId();
+    StateViewer<_Automaton> states(f.get());
+    Fsa::StateId            maxStateId = q.maxStateId();
     if (maxStateId == Fsa::InvalidStateId) {
-        Fsa::AutomatonCounts counts = count<_Automaton>(f, progress);
-        maxStateId                  = counts.maxStateId_;
+        if (states.compact()) {
+            maxStateId = states.compact()->maxStateId();
+        }
+        else {
+            Fsa::AutomatonCounts counts = count<_Automaton>(f, progress);
+            maxStateId                  = counts.maxStateId_;
+        }
     }
     if ((start > maxStateId) || (maxStateId == Fsa::InvalidStateId))
         return _StatePotentials();
@@ -174,11 +179,11 @@ StatePotentials<typename _Automaton::Weight> ssspLoop(
         p->start();
     }
     while (!q.empty()) {
-        Fsa::StateId   s  = q.dequeue();
-        _ConstStateRef sp = f->getState(s);
-        _Weight        R  = r[s];
-        r[s]              = semiring->zero();
-        for (typename _State::const_iterator a = sp->begin(); a != sp->end(); ++a) {
+        Fsa::StateId          s  = q.dequeue();
+        StateView<_Automaton> sp = states(s);
+        _Weight               R  = r[s];
+        r[s]                     = semiring->zero();
+        for (const _Arc* a = sp.begin(); a != sp.end(); ++a) {
             if (arcFilter(*a)) {
                 // d[arc->target()] = d[arc->target()] + (R * arc->weight())
                 // r[arc->target()] = r[arc->target()] + (R * arc->weight())
@@ -216,8 +221,8 @@ StatePotentials<typename _Automaton::Weight> sssp(
                                                               arcFilter, progress);
     }
     // in case of a wrongly tagged automaton we gently fall back to a standard filo queue
-    Fsa::AutomatonCounts counts = count<_Automaton>(f, progress);
-    FifoSsspQueue        q(counts.maxStateId_);
+    const CompactAutomaton<_Automaton>* c = dynamic_cast<const CompactAutomaton<_Automaton>*>(f.get());
+    FifoSsspQueue                       q(c ? c->maxStateId() : count<_Automaton>(f, progress).maxStateId_);
     return ssspLoop<_Automaton, FifoSsspQueue>(q, f, start, arcFilter, progress);
 }
 
@@ -229,13 +234,12 @@ StatePotentials<typename _Automaton::Weight> sssp(typename _Automaton::ConstRef
 template<class _Automaton>
 StatePotentials<typename _Automaton::Weight> ssspBackward(typename _Automaton::ConstRef f, const SsspArcFilter<_Automaton>& arcFilter, bool progress) {
     typedef typename _Automaton::Weight           _Weight;
-    typedef typename _Automaton::State            _State;
-    typedef typename _Automaton::ConstStateRef    _ConstStateRef;
+    typedef typename _Automaton::Arc              _Arc;
     typedef typename _Automaton::ConstSemiringRef _ConstSemiringRef;
     typedef StatePotentials<_Weight>              _StatePotentials;
 
-    Fsa::AutomatonCounts counts     = count<_Automaton>(f, progress);
-    Fsa::StateId         maxStateId = counts.maxStateId_;
+    StateViewer<_Automaton> states(f.get());
+    Fsa::StateId            maxStateId = states.compact() ? states.compact()->maxStateId() : count<_Automaton>(f, progress).maxStateId_;
     if (maxStateId == Fsa::InvalidStateId)
         return _StatePotentials();
 
@@ -245,9 +249,9 @@ StatePotentials<typename _Automaton::Weight> ssspBackward(typename _Automaton::C
     _StatePotentials  r(maxStateId + 1, semiring->zero());
     std::vector<bool> changed(maxStateId + 1, false), oldChanged(maxStateId + 1, false);
     for (size_t s = 0; s <= maxStateId; ++s) {
-        _ConstStateRef sp = f->getState(s);
-        if ((sp) && (sp->isFinal())) {
-            d[s] = r[s]   = sp->weight();
+        StateView<_Automaton> sp = states(s);
+        if (sp.valid() && sp.isFinal()) {
+            d[s] = r[s]   = sp.weight();
             oldChanged[s] = true;
         }
     }
@@ -261,17 +265,17 @@ StatePotentials<typename _Automaton::Weight> ssspBackward(typename _Automaton::C
     while (potentialsHaveChanged) {
         potentialsHaveChanged = false;
         for (Fsa::StateId s = 0; s <= maxStateId; ++s) {
-            _ConstStateRef sp = f->getState(s);
-            if (sp) {
+            StateView<_Automaton> sp = states(s);
+            if (sp.valid()) {
                 bool targetHasChanged = false;
-                for (typename _State::const_iterator a = sp->begin(); a != sp->end(); ++a)
+                for (const _Arc* a = sp.begin(); a != sp.end(); ++a)
                     if (oldChanged[a->target()] && arcFilter(*a)) {
                         targetHasChanged = true;
                         break;
                     }
                 if (targetHasChanged) {
                     _Weight D = d[s], R = semiring->zero();
-                    for (typename _State::const_iterator a = sp->begin(); a != sp->end(); ++a)
+                    for (const _Arc* a = sp.begin(); a != sp.end(); ++a)
                         if (arcFilter(*a)) {
                             D = semiring->collect(D, semiring->extend(a->weight(), r[a->target()]));
                             R = semiring->collect(R, semiring->extend(a->weight(), r[a->target()]));
@@ -414,14 +414,14 @@ public:
             : Core::Component(config),
               Precursor(config, pathname, lexicon),
               htkWriter_(lexicon) {
-        archive_ = Core::Archive::create(config, pathname, Core::Archive::AccessModeWrite);
+        archive_ = Core::Archive::createShared(config, pathname, Core::Archive::AccessModeWrite);
         warning("operability of HtkArchiveWriter is not fully tested");
         if (!archive_)
             error("Failed to open lattice archive for writing");
     }
 
     virtual ~HtkArchiveWriter() {
-        delete archive_;
+        Core::Archive::releaseShared(archive_);
     }
 
     virtual void store(const std::string& id, ConstWordLatticeRef wordLattice) {
@@ -18,6 +18,7 @@
 #include <Bliss/SyntacticTokenMap.hh>
 #include <Core/Directory.hh>
 #include <Core/IoUtilities.hh>
+#include <Core/Statistics.hh>
 #include <Fsa/Sort.hh>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -292,6 +293,13 @@ void BackingOffLm::Internal::draw(std::ostream& os, const std::string& title) co
 
   HS = sizeof(header)
 
+  Since version 4 the header contains a checksum of the token string
+  table, and nodes and word scores start at page boundaries.  If the
+  symbols of the current token inventory reproduce the checksum, the
+  tokens do not need to be looked up by name when the image is mounted,
+  so that mounting takes constant time (apart from hashing the
+  inventory) and the pages of the image are only read on demand.
+
 */
 
 namespace BackingOffPrivate {
@@ -360,6 +368,12 @@ public:
     virtual void setEnd(u64 p) {
         data_->setEnd(p);
     }
+    virtual u64 tokensChecksum() const {
+        return data_->tokensChecksum();
+    }
+    virtual void setTokensChecksum(u64 c) {
+        data_->setTokensChecksum(c);
+    }
     virtual bool   read(int fd, std::string& info);
     virtual bool   write(int fd) const;
     virtual size_t size() const {
@@ -384,8 +398,14 @@ private:
         PositionType scoresOffset;
         PositionType end;
     };
-    Values values_;
-    enum { formatVersion = v };
+    /** Only stored since version 4 */
+    struct Extension {
+        u64 tokensChecksum;
+    };
+    Values    values_;
+    Extension extension_;
+    enum { formatVersion = v,
+           hasExtension  = (v >= 4) };
 
 public:
     virtual u64 nTokens() const {
@@ -430,10 +450,16 @@ public:
     virtual void setEnd(u64 p) {
         values_.end = p;
     }
+    virtual u64 tokensChecksum() const {
+        return hasExtension ? extension_.tokensChecksum : 0;
+    }
+    virtual void setTokensChecksum(u64 c) {
+        extension_.tokensChecksum = c;
+    }
     virtual bool   read(int fd, std::string& info);
     virtual bool   write(int fd) const;
     virtual size_t size() const {
-        return sizeof(values_);
+        return sizeof(values_) + (hasExtension ? sizeof(extension_) : 0);
     }
     virtual u32 version() const {
         return formatVersion;
@@ -490,22 +516,38 @@ bool ImageHeaderImpl<T, v>::read(int fd, std::string& info) {
         info = "image seems to be incomplete";
         return false;
     }
+    extension_.tokensChecksum = 0;
+    if (hasExtension) {
+        nBytes = sizeof(extension_);
+        if (::read(fd, &extension_, nBytes) != nBytes) {
+            info = Core::form("failed to read image header extension (version=%d)",
+                              version());
+            return false;
+        }
+    }
     return true;
 }
 
 template<class T, int v>
 bool ImageHeaderImpl<T, v>::write(int fd) const {
     ssize_t nBytes = sizeof(values_);
-    return (::write(fd, &values_, nBytes) == nBytes);
+    if (::write(fd, &values_, nBytes) != nBytes)
+        return false;
+    if (hasExtension) {
+        nBytes = sizeof(extension_);
+        return (::write(fd, &extension_, nBytes) == nBytes);
+    }
+    return true;
 }
 
 ImageHeader* ImageHeader::createData(int version) const {
     // When changing the file format, increment the version number!
     // Backward compatibility of image files is typically not needed.
-    // The next unused number is: 4
+    // The next unused number is: 5
 
     typedef ImageHeaderImpl<u32, 1> ImageHeaderV1;
     typedef ImageHeaderImpl<u64, 3> ImageHeaderV3;
+    typedef ImageHeaderImpl<u64, 4> ImageHeaderV4;
     ImageHeader*                    data = 0;
     switch (version) {
         case 1:
@@ -514,10 +556,42 @@ ImageHeader* ImageHeader::createData(int version) const {
         case 3:
             data = new ImageHeaderV3();
             break;
+        case 4:
+            data = new ImageHeaderV4();
+            break;
     }
     return data;
 }
 
+/**
+ * FNV-1a hash of the token table as written to an image (empty
+ * symbols for unused token indices), identifies the token indices
+ * used by the image.
+ */
+u64 tokensChecksum(const std::vector<const Bliss::Token*>& tokens) {
+    u64 hash = 0xcbf29ce484222325ull;
+    for (u32 ti = 0; ti < tokens.size(); ++ti) {
+        if (tokens[ti]) {
+            for (const char* c = tokens[ti]->symbol().str(); *c; ++c)
+                hash = (hash ^ u8(*c)) * 0x100000001b3ull;
+        }
+        hash = (hash ^ 0xff) * 0x100000001b3ull;  // separator
+    }
+    return hash;
+}
+
+/**
+ * Advances the file position to the next multiple of @c alignment.
+ * @return the new position, or -1 on failure
+ */
+off_t alignPosition(int fd, off_t alignment) {
+    off_t position = lseek(fd, 0, SEEK_CUR);
+    if (position == (off_t)-1)
+        return position;
+    off_t pad = (alignment - position % alignment) % alignment;
+    return lseek(fd, pad, SEEK_CUR);
+}
+
 }  // namespace BackingOffPrivate
 
 bool BackingOffLm::Internal::writeImageTokenTable(int fd) const {
@@ -559,9 +633,10 @@ bool BackingOffLm::Internal::writeImageTokenTable(int fd) const {
  * @return true if successful
  */
 bool BackingOffLm::Internal::writeImage(int fd, const std::string& info) const {
-    off_t       position, pad;
+    off_t       position;
     ssize_t     nBytes;
-    const u32   fileFormatVersion = 3;
+    const u32   fileFormatVersion = 4;
+    const off_t pageSize          = sysconf(_SC_PAGESIZE);
     ImageHeader header(fileFormatVersion);
     header.setTokensOffset(0);  // phony
     header.setTokens(tokens_.size());
@@ -570,6 +645,7 @@ bool BackingOffLm::Internal::writeImage(int fd, const std::string& info) const {
     header.setScoresOffset(0);  // phony
     header.setWordScores(nWordScores());
     header.setEnd(0);  // phony
+    header.setTokensChecksum(tokensChecksum(tokens_));
 
     // write phony header
     if (!header.write(fd))
@@ -588,11 +664,7 @@ bool BackingOffLm::Internal::writeImage(int fd, const std::string& info) const {
         return false;
 
     // write nodes
-    if ((position = lseek(fd, 0, SEEK_CUR)) == (off_t)-1)
-        return false;
-
-    pad = (position + 7) % 8;
-    if ((position = lseek(fd, pad, SEEK_CUR)) == (off_t)-1)
+    if ((position = alignPosition(fd, pageSize)) == (off_t)-1)
         return false;
     header.setNodesOffset(position);
     u64 nNodeBytes = (nodesTail_ - nodes_ + 1) * sizeof(Node);
@@ -600,10 +672,7 @@ bool BackingOffLm::Internal::writeImage(int fd, const std::string& info) const {
         return false;
 
     // write word scores
-    if ((position = lseek(fd, 0, SEEK_CUR)) == (off_t)-1)
-        return false;
-    pad = (position + 7) % 8;
-    if ((position = lseek(fd, pad, SEEK_CUR)) == (off_t)-1)
+    if ((position = alignPosition(fd, pageSize)) == (off_t)-1)
         return false;
     header.setScoresOffset(position);
     u64 nScoreBytes = (wordScoresTail_ - wordScores_ + 1) * sizeof(WordScore);
@@ -629,23 +698,40 @@ bool BackingOffLm::Internal::writeImage(int fd, const std::string& info) const {
 
 bool BackingOffLm::Internal::mountImage(
         int fd, std::string& info,
-        const Bliss::TokenInventory& inventory) {
+        const Bliss::TokenInventory& inventory, int advice) {
     ImageHeader header(0);
     if (!header.read(fd, info))
         return false;
     ::free(nodes_);
     ::free(wordScores_);
+    nodes_ = nodesTail_ = nodesEnd_ = NULL;
+    wordScores_ = wordScoresTail_ = wordScoresEnd_ = NULL;
 
     mmap_ = (char*)mmap(0, mmapSize_ = header.end(), PROT_READ, MAP_SHARED, fd, 0);
     if (mmap_ == MAP_FAILED) {
         info = "mapping of image failed";
+        mmap_ = NULL;
         return false;
     }
+    if (advice != -1)
+        madvise(mmap_, mmapSize_, advice);
 
     info = std::string(mmap_ + header.size());
 
     tokens_.resize(header.nTokens());
     char* str = mmap_ + header.tokensOffset();
+    if (header.tokensChecksum() && header.nTokens() <= inventory.size()) {
+        // take the tokens from the inventory by index, keeping the unused entries empty;
+        // if the result reproduces the checksum, the token indices are consistent and no lookup by name is needed
+        for (TokenIndex ti = 0; ti < TokenIndex(header.nTokens()); ++ti) {
+            tokens_[ti] = (*str) ? inventory[ti] : 0;
+            str += strlen(str) + 1;
+        }
+        if (header.tokensChecksum() == tokensChecksum(tokens_))
+            return mapArrays(header.nodesOffset(), header.nNodes(), header.scoresOffset(), header.nWordScores());
+        str = mmap_ + header.tokensOffset();
+    }
+
     for (TokenIndex ti = 0; ti < TokenIndex(header.nTokens()); ++ti) {
         const Bliss::Token* token = 0;
         if (*str) {
@@ -668,13 +754,17 @@ bool BackingOffLm::Internal::mountImage(
         ++str;
     }
 
-    nodes_     = (Node*)(mmap_ + header.nodesOffset());
-    nodesTail_ = nodesEnd_ = nodes_ + header.nNodes();
-    verify(nNodes() == header.nNodes());
+    return mapArrays(header.nodesOffset(), header.nNodes(), header.scoresOffset(), header.nWordScores());
+}
+
+bool BackingOffLm::Internal::mapArrays(u64 nodesOffset, u64 nNodes, u64 scoresOffset, u64 nScores) {
+    nodes_     = (Node*)(mmap_ + nodesOffset);
+    nodesTail_ = nodesEnd_ = nodes_ + nNodes;
+    verify(this->nNodes() == nNodes);
 
-    wordScores_     = (WordScore*)(mmap_ + header.scoresOffset());
-    wordScoresTail_ = wordScoresEnd_ = wordScores_ + header.nWordScores();
-    verify(nWordScores() == header.nWordScores());
+    wordScores_     = (WordScore*)(mmap_ + scoresOffset);
+    wordScoresTail_ = wordScoresEnd_ = wordScores_ + nScores;
+    verify(nWordScores() == nScores);
 
     ensure(isMapped());
     return true;
@@ -738,6 +828,42 @@ const Core::ParameterString BackingOffLm::paramImage(
         "image",
         "create and/or use language model binary image file");
 
+const Core::Choice BackingOffLm::choiceImageAccess(
+        "default", -1,
+        "normal", MADV_NORMAL,
+        "random", MADV_RANDOM,
+        "sequential", MADV_SEQUENTIAL,
+        "will-need", MADV_WILLNEED,
+        Core::Choice::endMark());
+
+const Core::ParameterChoice BackingOffLm::paramImageAccess(
+        "image-access",
+        &choiceImageAccess,
+        "access pattern hint for the mapped image (madvise). random avoids read-ahead of unused pages, will-need pre-loads the image",
+        -1);
+
+bool BackingOffLm::writeImage(const std::string& filename) {
+    require(internal_);
+    log("writing image file to \"%s\" ...", filename.c_str());
+    int fd = open(filename.c_str(),
+                  O_CREAT | O_WRONLY | O_TRUNC,
+                  S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (fd == -1) {
+        error("Failed to open image file \"%s\" for writing", filename.c_str());
+        return false;
+    }
+    if (!internal_->writeImage(fd, dependency_.value())) {
+        error("failed to write image file");
+        close(fd);
+        return false;
+    }
+    if (close(fd)) {
+        error("failed to write image file");
+        return false;
+    }
+    return true;
+}
+
 void BackingOffLm::load() {
     std::string image = paramImage(config);
     if (!image.size()) {
@@ -749,39 +875,30 @@ void BackingOffLm::load() {
         read();
         if (hasFatalErrors())
             return;
-        log("writing image file to \"%s\" ...", image.c_str());
-        int fd = open(image.c_str(),
-                      O_CREAT | O_WRONLY | O_TRUNC,
-                      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
-        if (fd == -1) {
-            error("Failed to open image file \"%s\" for writing", image.c_str());
-            return;
-        }
-        if (!internal_->writeImage(fd, dependency_.value())) {
-            error("failed to write image file");
-            close(fd);
-            return;
-        }
-        if (close(fd)) {
-            error("failed to write image file");
+        if (!writeImage(image))
             return;
-        }
     }
     else {
         internal_ = Core::ref(new Internal);
     }
 
     log("mounting image file \"%s\" ...", image.c_str());
+    Core::Timer timer;
+    timer.start();
     int fd = open(image.c_str(), O_RDONLY);
     if (fd == -1) {
         error("Failed to open image file \"%s\" for reading", image.c_str());
         return;
     }
     std::string info;
-    if (!internal_->mountImage(fd, info, tokenInventory())) {
+    if (!internal_->mountImage(fd, info, tokenInventory(), paramImageAccess(config))) {
         error("failed to mount image file: ") << info;
+        close(fd);
         return;
     }
+    close(fd);  // the mapping stays valid
+    timer.stop();
+    log("mounted image file in %.3fs", timer.elapsed());
     dependency_.setValue(info);
     initialize(internal_);
 }
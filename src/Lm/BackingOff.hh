@@ -39,6 +39,8 @@ public:
 
 private:
     static const Core::ParameterString paramImage;
+    static const Core::Choice          choiceImageAccess;
+    static const Core::ParameterChoice paramImageAccess;
     friend class Internal;
     Core::Ref<Internal> internal_;
     class Automaton;
@@ -91,6 +93,12 @@ protected:
 public:
     typedef Node HistoryDescriptor;
     virtual void load();
+    /**
+     * Writes the loaded language model as binary image, which can be
+     * mounted later on (see parameter "image").
+     * @return true if successful
+     */
+    bool writeImage(const std::string& filename);
     virtual ~BackingOffLm();
     virtual History                startHistory() const;
     virtual Lm::Score              sentenceBeginScore() const;
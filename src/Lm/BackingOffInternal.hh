@@ -130,6 +130,7 @@ protected:
     char*  mmap_;
     size_t mmapSize_;
     bool   writeImageTokenTable(int fd) const;
+    bool   mapArrays(u64 nodesOffset, u64 nNodes, u64 scoresOffset, u64 nWordScores);
 
 public:
     Internal();
@@ -138,7 +139,8 @@ public:
     void reserve(NodeIndex nNodes, WordScoreIndex nWordScores);
     void build(InitItem*, InitItem*);
     bool writeImage(int fd, const std::string& info) const;
-    bool mountImage(int fd, std::string& info, const Bliss::TokenInventory&);
+    /** @param advice madvise() hint for the mapping, or -1 for none */
+    bool mountImage(int fd, std::string& info, const Bliss::TokenInventory&, int advice = -1);
     bool isMapped() const {
         return (mmap_ != NULL);
     }
@@ -13,6 +13,7 @@
  *  limitations under the License.
  */
 #include "AbstractMixtureSetEstimator.hh"
+#include <thread>
 #include <Core/Directory.hh>
 #include <Core/StringUtilities.hh>
 #include "MixtureSet.hh"
@@ -168,6 +169,31 @@ bool AbstractMixtureSetEstimator::accumulate(const AbstractMixtureSetEstimator&
     return true;
 }
 
+bool AbstractMixtureSetEstimator::reduce(const std::vector<AbstractMixtureSetEstimator*>& estimators) {
+    require(!estimators.empty());
+    bool result = true;
+    for (size_t stride = 1; stride < estimators.size(); stride *= 2) {
+        // estimator i takes the statistics of estimator i + stride, each pair in its own thread
+        std::vector<size_t>      targets;
+        std::vector<std::thread> threads;
+        std::vector<char>        status(estimators.size(), true);
+        for (size_t i = 0; i + stride < estimators.size(); i += 2 * stride)
+            targets.push_back(i);
+        for (size_t t = 1; t < targets.size(); ++t) {
+            const size_t i = targets[t];
+            threads.push_back(std::thread([&estimators, &status, i, stride]() {
+                status[i] = estimators[i]->accumulate(*estimators[i + stride]);
+            }));
+        }
+        status[0] = estimators[0]->accumulate(*estimators[stride]);
+        for (size_t t = 0; t < threads.size(); ++t)
+            threads[t].join();
+        for (size_t t = 0; t < targets.size(); ++t)
+            result = result && status[targets[t]];
+    }
+    return result;
+}
+
 bool AbstractMixtureSetEstimator::accumulate(Core::BinaryInputStreams& is,
                                              Core::BinaryOutputStream& os) {
     u32 version = version_;
@@ -138,6 +138,13 @@ public:
     virtual bool accumulate(Core::BinaryInputStreams& is, Core::BinaryOutputStream& os);
     virtual void reset();
 
+    /**
+     * Adds the statistics of all estimators to the first one, e.g. the
+     * shards of a multi-threaded accumulation.  The estimators are merged
+     * pairwise in a tree reduction, the merges of one level run in parallel.
+     */
+    static bool reduce(const std::vector<AbstractMixtureSetEstimator*>& estimators);
+
     /**
      * add new mixture estimators
      */
@@ -16,7 +16,6 @@
 #include <Core/Allocator.hh>
 #include <Mm/CovarianceFeatureScorerElement.hh>
 #include <Mm/DensityClustering.hh>
-#include <Mm/SSE2CodeGenerator.hh>
 #include <Mm/Utilities.hh>
 #include <algorithm>
 #include <functional>
@@ -29,8 +28,8 @@ const Core::ParameterInt BatchFeatureScorerBase::paramBufferSize(
         "buffer-size", "number of pre-calculated scores", 4, 0);
 
 BatchFeatureScorerBase::BatchFeatureScorerBase(const Core::Configuration& c)
-        : Core::Component(c), FeatureScorer(c), scores_(0), paddedDimension_(0), dimension_(0), nMixtures_(0), nDensities_(0), currentFeature_(0), buffered_(0), bufferSize_(paramBufferSize(c)) {
-    log("batch feature scorer using buffer size %d", bufferSize_);
+        : Core::Component(c), FeatureScorer(c), scores_(0), paddedDimension_(0), dimension_(0), nMixtures_(0), nDensities_(0), currentFeature_(0), buffered_(0), bufferSize_(paramBufferSize(c)), kernels_(GaussianKernels::choose(c)) {
+    log("batch feature scorer using buffer size %d, %s kernels", bufferSize_, GaussianKernels::name(kernels_.instructionSet));
 }
 
 BatchFeatureScorerBase::~BatchFeatureScorerBase() {
@@ -158,8 +157,8 @@ void BatchFloatFeatureScorer::init(const MixtureSet& mixtureSet) {
               variance_);
     const float logNormFactor = covariance.logNormalizationFactor();
 
-    Core::allocateAlignedVector<f32>(&features_, bufferSize_ * paddedDimension_, 0.0, 16);
-    Core::allocateAlignedVector<f32>(&means_, nDensities_ * paddedDimension_, 0.0, 16);
+    Core::allocateAlignedVector<f32>(&features_, bufferSize_ * paddedDimension_, 0.0, 64);
+    Core::allocateAlignedVector<f32>(&means_, nDensities_ * paddedDimension_, 0.0, 64);
     Core::allocateAlignedVector<f32>(&constants_, nDensities_, 0.0, 16);
     for (size_t m = 0; m < nMixtures_; ++m) {
         const Mixture& mixture = *mixtureSet.mixture(m);
@@ -195,35 +194,20 @@ void BatchFloatFeatureScorer::fillScoreCacheTpl(EmissionIndex e, u32 featureInde
         scores_[pos] = Core::Type<f32>::max;
         cached_[pos] = true;
     }
-    __m128       x1, x2, s1, s2, c;
     const size_t endDns    = offsets_[e + 1];
     f32*         scoreBase = scores_ + posOffset;
     for (size_t dns = offsets_[e]; dns < endDns; ++dns) {
         const f32* mean     = means_ + dns * paddedDimension_;
-        const f32* dnsConst = constants_ + dns;
-        c                   = _mm_load_ss(dnsConst);
+        const f32  dnsConst = constants_[dns];
         for (u32 t = startIdx; t < endIdx; ++t) {
             const size_t rp = (t % bufferSize_);
             if (!selector(rp, dns))
                 continue;
             const f32* feature = features_ + (rp * paddedDimension_);
-            s1                 = c;
-            s2                 = _mm_setzero_ps();
-            for (int d = 0; d < paddedDimension_; d += BlockSize) {
-                x1 = _mm_sub_ps(_mm_load_ps(mean + d), _mm_load_ps(feature + d));
-                s1 = _mm_add_ps(s1, _mm_mul_ps(x1, x1));
-                x2 = _mm_sub_ps(_mm_load_ps(mean + d + 4), _mm_load_ps(feature + d + 4));
-                s2 = _mm_add_ps(s2, _mm_mul_ps(x2, x2));
-            }
-            s1         = _mm_add_ps(s1, s2);
-            s2         = s1;
-            s1         = _mm_shuffle_ps(s1, s2, _MM_SHUFFLE(1, 0, 3, 2));
-            s1         = _mm_add_ps(s1, s2);
-            s2         = s1;
-            s1         = _mm_shuffle_ps(s1, s2, _MM_SHUFFLE(2, 3, 0, 1));
-            s1         = _mm_add_ps(s1, s2);
-            f32* score = scoreBase + rp;
-            _mm_store_ss(score, _mm_min_ps(_mm_load_ss(score), s1));
+            const f32  s       = dnsConst + kernels_.floatDistance(mean, feature, paddedDimension_);
+            f32&       score   = scoreBase[rp];
+            if (s < score)
+                score = s;
         }
     }
     for (size_t t = startIdx; t < endIdx; ++t) {
@@ -359,7 +343,7 @@ void BatchIntFeatureScorer::init(const MixtureSet& mixtureSet) {
     const float logNormFactor = covariance.logNormalizationFactor() * scaleSquared;
 
     // allocate feature buffer and means in the same memory area.
-    Core::allocateAlignedVector<QuantizedType>(&features_, bufferSize_ * paddedDimension_ + nDensities_ * paddedDimension_, 0, 16);
+    Core::allocateAlignedVector<QuantizedType>(&features_, bufferSize_ * paddedDimension_ + nDensities_ * paddedDimension_, 0, 64);
     means_ = features_ + bufferSize_ * paddedDimension_;
     Core::allocateAlignedVector<s32>(&constants_, nDensities_, 0, 16);
     for (size_t m = 0; m < nMixtures_; ++m) {
@@ -443,21 +427,9 @@ void BatchIntFeatureScorer::fillScoreCacheTpl(EmissionIndex e, u32 featureIndex,
         s32        best     = 2147483647;
         for (size_t dns = startDns; dns < endDns; ++dns) {
             if (selector.value()) {
-                __m128i sum = _mm_setzero_si128();
-                for (int d = 0; d < paddedDimension_; d += BlockSize) {
-                    __m128i m, x;
-                    m = _mm_load_si128(reinterpret_cast<const __m128i*>(mean + d));
-                    // m = mean[d .. d+15]
-                    x = _mm_load_si128(reinterpret_cast<const __m128i*>(feature + d));
-                    // x = feature[d .. d+15]
-                    addDistance(x, m, sum);
-                }
-                {
-                    s32 tmp = horizontalAdd(sum);
-                    tmp += *dnsConst;
-                    if (tmp < best)
-                        best = tmp;
-                }
+                const s32 tmp = kernels_.u8Distance(mean, feature, paddedDimension_) + *dnsConst;
+                if (tmp < best)
+                    best = tmp;
             }
             mean += paddedDimension_;
             ++dnsConst;
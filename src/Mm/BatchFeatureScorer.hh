@@ -16,6 +16,7 @@
 #define _MM_BATCH_FEATURE_SCORER_HH
 
 #include <Mm/FeatureScorer.hh>
+#include <Mm/GaussianKernels.hh>
 #include <Mm/MixtureSet.hh>
 #include <Mm/SimdFeatureScorer.hh>
 
@@ -196,6 +197,10 @@ protected:
     * total buffer size.
     */
     s32 bufferSize_;
+    /**
+    * distance kernels for the instruction set of the processor
+    */
+    const GaussianKernels& kernels_;
 };
 
 /**
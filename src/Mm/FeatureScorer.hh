@@ -41,6 +41,17 @@ protected:
         virtual Score         score(EmissionIndex e, u32 modelIndex) {
             return 0.0;
         }
+        /**
+         * Whether scoreConcurrently() may be called from several threads at once.
+         * score() itself fills caches lazily and must never be called concurrently.
+         */
+        virtual bool supportsConcurrentScoring() const {
+            return false;
+        }
+        /** Same as score(), but without modifying the context scorer (requires supportsConcurrentScoring()) */
+        virtual Score scoreConcurrently(EmissionIndex e) const {
+            return score(e);
+        }
     };
     friend class ContextScorer;
 
@@ -213,6 +224,15 @@ public:
                 return cache_.set(e, scorer_->score(e));
             return cache_[e];
         }
+        virtual bool supportsConcurrentScoring() const {
+            return scorer_->supportsConcurrentScoring();
+        }
+        virtual Score scoreConcurrently(EmissionIndex e) const {
+            require_(0 <= e && e < nEmissions());
+            if (!cache_.isCalculated(e))
+                return scorer_->scoreConcurrently(e);
+            return cache_[e];
+        }
         void precache() const {
             if (precached_)
                 return;
@@ -0,0 +1,445 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "GaussianKernels.hh"
+
+#if (defined(PROC_intel) || defined(PROC_x86_64)) && !defined(DISABLE_SIMD)
+#define GAUSSIAN_KERNELS_SIMD
+#include <immintrin.h>
+#endif
+#include <cmath>
+#include <random>
+
+#include <Core/Allocator.hh>
+#include <Core/Application.hh>
+#include <Core/Statistics.hh>
+#include <Math/Random.hh>
+#include "CovarianceFeatureScorerElement.hh"
+#include "MixtureSet.hh"
+#include "Utilities.hh"
+
+using namespace Mm;
+
+namespace {
+
+// scalar reference implementation
+
+f32 floatDistanceScalar(const f32* mean, const f32* feature, u32 dimension) {
+    f32 sum = 0.0;
+    for (u32 d = 0; d < dimension; ++d) {
+        const f32 x = mean[d] - feature[d];
+        sum += x * x;
+    }
+    return sum;
+}
+
+s32 s16DistanceScalar(const s16* mean, const s16* feature, u32 dimension) {
+    s32 sum = 0;
+    for (u32 d = 0; d < dimension; ++d) {
+        const s32 x = s32(mean[d]) - s32(feature[d]);
+        sum += x * x;
+    }
+    return sum;
+}
+
+s32 u8DistanceScalar(const u8* mean, const u8* feature, u32 dimension) {
+    s32 sum = 0;
+    for (u32 d = 0; d < dimension; ++d) {
+        const s32 x = s32(mean[d]) - s32(feature[d]);
+        sum += x * x;
+    }
+    return sum;
+}
+
+#ifdef GAUSSIAN_KERNELS_SIMD
+
+// SSE2: 4 floats, 8 x s16, 16 x u8 per instruction
+
+inline f32 horizontalAdd(__m128 s) {
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(s);
+}
+
+inline s32 horizontalAdd(__m128i s) {
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+}
+
+/** sum += (|m - x|^2) of 16 u8 values, accumulated in 4 x s32 */
+inline __m128i addU8Distance(__m128i m, __m128i x, __m128i sum) {
+    const __m128i d = _mm_or_si128(_mm_subs_epu8(m, x), _mm_subs_epu8(x, m));
+    const __m128i l = _mm_unpacklo_epi8(d, _mm_setzero_si128());
+    const __m128i h = _mm_unpackhi_epi8(d, _mm_setzero_si128());
+    return _mm_add_epi32(sum, _mm_add_epi32(_mm_madd_epi16(l, l), _mm_madd_epi16(h, h)));
+}
+
+f32 floatDistanceSse2(const f32* mean, const f32* feature, u32 dimension) {
+    __m128 s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps();
+    for (u32 d = 0; d < dimension; d += 8) {
+        const __m128 x1 = _mm_sub_ps(_mm_loadu_ps(mean + d), _mm_loadu_ps(feature + d));
+        const __m128 x2 = _mm_sub_ps(_mm_loadu_ps(mean + d + 4), _mm_loadu_ps(feature + d + 4));
+        s1              = _mm_add_ps(s1, _mm_mul_ps(x1, x1));
+        s2              = _mm_add_ps(s2, _mm_mul_ps(x2, x2));
+    }
+    return horizontalAdd(_mm_add_ps(s1, s2));
+}
+
+s32 s16DistanceSse2(const s16* mean, const s16* feature, u32 dimension) {
+    __m128i sum = _mm_setzero_si128();
+    for (u32 d = 0; d < dimension; d += 8) {
+        const __m128i x = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mean + d)),
+                                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(feature + d)));
+        sum             = _mm_add_epi32(sum, _mm_madd_epi16(x, x));
+    }
+    return horizontalAdd(sum);
+}
+
+s32 u8DistanceSse2(const u8* mean, const u8* feature, u32 dimension) {
+    __m128i sum = _mm_setzero_si128();
+    for (u32 d = 0; d < dimension; d += 16) {
+        sum = addU8Distance(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mean + d)),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(feature + d)),
+                            sum);
+    }
+    return horizontalAdd(sum);
+}
+
+// AVX2: 8 floats, 16 x s16, 32 x u8 per instruction
+
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+TARGET_AVX2 inline f32 horizontalAddAvx2(__m256 s) {
+    __m128 r = _mm_add_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1));
+    r        = _mm_add_ps(r, _mm_movehl_ps(r, r));
+    r        = _mm_add_ss(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(r);
+}
+
+TARGET_AVX2 inline s32 horizontalAddAvx2(__m256i s) {
+    __m128i r = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+    r         = _mm_add_epi32(r, _mm_shuffle_epi32(r, _MM_SHUFFLE(1, 0, 3, 2)));
+    r         = _mm_add_epi32(r, _mm_shuffle_epi32(r, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(r);
+}
+
+TARGET_AVX2 f32 floatDistanceAvx2(const f32* mean, const f32* feature, u32 dimension) {
+    __m256 s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps();
+    u32    d  = 0;
+    for (; d + 16 <= dimension; d += 16) {
+        const __m256 x1 = _mm256_sub_ps(_mm256_loadu_ps(mean + d), _mm256_loadu_ps(feature + d));
+        const __m256 x2 = _mm256_sub_ps(_mm256_loadu_ps(mean + d + 8), _mm256_loadu_ps(feature + d + 8));
+        s1              = _mm256_fmadd_ps(x1, x1, s1);
+        s2              = _mm256_fmadd_ps(x2, x2, s2);
+    }
+    if (d < dimension) {
+        const __m256 x = _mm256_sub_ps(_mm256_loadu_ps(mean + d), _mm256_loadu_ps(feature + d));
+        s1             = _mm256_fmadd_ps(x, x, s1);
+    }
+    return horizontalAddAvx2(_mm256_add_ps(s1, s2));
+}
+
+TARGET_AVX2 s32 s16DistanceAvx2(const s16* mean, const s16* feature, u32 dimension) {
+    __m256i sum = _mm256_setzero_si256();
+    u32     d   = 0;
+    for (; d + 16 <= dimension; d += 16) {
+        const __m256i x = _mm256_sub_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(mean + d)),
+                                           _mm256_loadu_si256(reinterpret_cast<const __m256i*>(feature + d)));
+        sum             = _mm256_add_epi32(sum, _mm256_madd_epi16(x, x));
+    }
+    if (d < dimension) {
+        const __m128i x = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mean + d)),
+                                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(feature + d)));
+        return horizontalAddAvx2(sum) + horizontalAdd(_mm_madd_epi16(x, x));
+    }
+    return horizontalAddAvx2(sum);
+}
+
+TARGET_AVX2 s32 u8DistanceAvx2(const u8* mean, const u8* feature, u32 dimension) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i       sum  = zero;
+    u32           d    = 0;
+    for (; d + 32 <= dimension; d += 32) {
+        const __m256i m  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mean + d));
+        const __m256i x  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(feature + d));
+        const __m256i ad = _mm256_or_si256(_mm256_subs_epu8(m, x), _mm256_subs_epu8(x, m));
+        const __m256i l  = _mm256_unpacklo_epi8(ad, zero);
+        const __m256i h  = _mm256_unpackhi_epi8(ad, zero);
+        sum              = _mm256_add_epi32(sum, _mm256_add_epi32(_mm256_madd_epi16(l, l), _mm256_madd_epi16(h, h)));
+    }
+    if (d < dimension) {
+        const __m128i m  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mean + d));
+        const __m128i x  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(feature + d));
+        const __m256i ad = _mm256_cvtepu8_epi16(_mm_or_si128(_mm_subs_epu8(m, x), _mm_subs_epu8(x, m)));
+        sum              = _mm256_add_epi32(sum, _mm256_madd_epi16(ad, ad));
+    }
+    return horizontalAddAvx2(sum);
+}
+
+#undef TARGET_AVX2
+
+// AVX-512: 16 floats, 32 x s16, 64 x u8 per instruction, the remainder is
+// handled with masked loads
+
+#define TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+TARGET_AVX512 f32 floatDistanceAvx512(const f32* mean, const f32* feature, u32 dimension) {
+    __m512 sum = _mm512_setzero_ps();
+    for (u32 d = 0; d < dimension; d += 16) {
+        const __mmask16 k = (dimension - d >= 16) ? __mmask16(0xffff) : __mmask16((1u << (dimension - d)) - 1);
+        const __m512    x = _mm512_sub_ps(_mm512_maskz_loadu_ps(k, mean + d), _mm512_maskz_loadu_ps(k, feature + d));
+        sum               = _mm512_fmadd_ps(x, x, sum);
+    }
+    return _mm512_reduce_add_ps(sum);
+}
+
+TARGET_AVX512 s32 s16DistanceAvx512(const s16* mean, const s16* feature, u32 dimension) {
+    __m512i sum = _mm512_setzero_si512();
+    for (u32 d = 0; d < dimension; d += 32) {
+        const __mmask32 k = (dimension - d >= 32) ? __mmask32(0xffffffffu) : __mmask32((1u << (dimension - d)) - 1);
+        const __m512i   x = _mm512_sub_epi16(_mm512_maskz_loadu_epi16(k, mean + d), _mm512_maskz_loadu_epi16(k, feature + d));
+        sum               = _mm512_add_epi32(sum, _mm512_madd_epi16(x, x));
+    }
+    return _mm512_reduce_add_epi32(sum);
+}
+
+TARGET_AVX512 s32 u8DistanceAvx512(const u8* mean, const u8* feature, u32 dimension) {
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i       sum  = zero;
+    for (u32 d = 0; d < dimension; d += 64) {
+        const __mmask64 k  = (dimension - d >= 64) ? ~__mmask64(0) : __mmask64((u64(1) << (dimension - d)) - 1);
+        const __m512i   m  = _mm512_maskz_loadu_epi8(k, mean + d);
+        const __m512i   x  = _mm512_maskz_loadu_epi8(k, feature + d);
+        const __m512i   ad = _mm512_or_si512(_mm512_subs_epu8(m, x), _mm512_subs_epu8(x, m));
+        const __m512i   l  = _mm512_unpacklo_epi8(ad, zero);
+        const __m512i   h  = _mm512_unpackhi_epi8(ad, zero);
+        sum                = _mm512_add_epi32(sum, _mm512_add_epi32(_mm512_madd_epi16(l, l), _mm512_madd_epi16(h, h)));
+    }
+    return _mm512_reduce_add_epi32(sum);
+}
+
+#undef TARGET_AVX512
+
+const GaussianKernels kernelTable[] = {
+        {GaussianKernels::scalar, &floatDistanceScalar, &s16DistanceScalar, &u8DistanceScalar},
+        {GaussianKernels::scalar, &floatDistanceScalar, &s16DistanceScalar, &u8DistanceScalar},
+        {GaussianKernels::sse2, &floatDistanceSse2, &s16DistanceSse2, &u8DistanceSse2},
+        {GaussianKernels::avx2, &floatDistanceAvx2, &s16DistanceAvx2, &u8DistanceAvx2},
+        {GaussianKernels::avx512, &floatDistanceAvx512, &s16DistanceAvx512, &u8DistanceAvx512}};
+
+#else  // GAUSSIAN_KERNELS_SIMD
+
+// other processors: scalar kernels only, see isSupported()
+const GaussianKernels kernelTable[] = {
+        {GaussianKernels::scalar, &floatDistanceScalar, &s16DistanceScalar, &u8DistanceScalar},
+        {GaussianKernels::scalar, &floatDistanceScalar, &s16DistanceScalar, &u8DistanceScalar}};
+
+#endif  // GAUSSIAN_KERNELS_SIMD
+
+}  // namespace
+
+const Core::Choice GaussianKernels::choiceInstructionSet(
+        "auto", autoDetect,
+        "scalar", scalar,
+        "sse2", sse2,
+        "avx2", avx2,
+        "avx512", avx512,
+        Core::Choice::endMark());
+
+const Core::ParameterChoice GaussianKernels::paramInstructionSet(
+        "instruction-set", &choiceInstructionSet,
+        "instruction set of the distance kernels, auto: best supported by the processor", autoDetect);
+
+bool GaussianKernels::isSupported(InstructionSet instructionSet) {
+#ifndef GAUSSIAN_KERNELS_SIMD
+    return instructionSet == scalar;
+#else
+    __builtin_cpu_init();
+    switch (instructionSet) {
+        case scalar:
+        case sse2:
+            return true;
+        case avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case avx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        default:
+            return false;
+    }
+#endif
+}
+
+GaussianKernels::InstructionSet GaussianKernels::bestSupported() {
+    static const InstructionSet best = isSupported(avx512) ? avx512 : (isSupported(avx2) ? avx2 : (isSupported(sse2) ? sse2 : scalar));
+    return best;
+}
+
+const char* GaussianKernels::name(InstructionSet instructionSet) {
+    return choiceInstructionSet[instructionSet].c_str();
+}
+
+const GaussianKernels& GaussianKernels::kernels(InstructionSet instructionSet) {
+    require(instructionSet != autoDetect);
+    require(isSupported(instructionSet));
+    return kernelTable[instructionSet];
+}
+
+const GaussianKernels& GaussianKernels::choose(const Core::Configuration& c) {
+    InstructionSet instructionSet = InstructionSet(paramInstructionSet(c));
+    if (instructionSet == autoDetect) {
+        instructionSet = bestSupported();
+    }
+    else if (!isSupported(instructionSet)) {
+        Core::Application::us()->warning("instruction set %s is not supported by this processor, using %s",
+                                         name(instructionSet), name(bestSupported()));
+        instructionSet = bestSupported();
+    }
+    return kernels(instructionSet);
+}
+
+// ================================================================
+
+const Core::ParameterInt GaussianKernelBenchmark::paramFrames(
+        "frames", "number of frames scored per instruction set", 100, 1);
+
+GaussianKernelBenchmark::GaussianKernelBenchmark(const Core::Configuration& c)
+        : Core::Component(c), nFrames_(paramFrames(c)) {}
+
+namespace {
+
+/** Prepared means and frames of one type, each vector padded to the given dimension. */
+template<typename T>
+struct BenchmarkData {
+    u32 paddedDimension;
+    T*  means;
+    T*  frames;
+    BenchmarkData(u32 dimension, u32 blockSize, u32 nDensities, u32 nFrames)
+            : paddedDimension(((dimension + blockSize - 1) / blockSize) * blockSize), means(0), frames(0) {
+        Core::allocateAlignedVector<T>(&means, size_t(nDensities) * paddedDimension, T(0), 64);
+        Core::allocateAlignedVector<T>(&frames, size_t(nFrames) * paddedDimension, T(0), 64);
+    }
+    ~BenchmarkData() {
+        ::free(means);
+        ::free(frames);
+    }
+};
+
+/** Minimum distance over all densities for each frame, returns the elapsed time. */
+template<typename T, typename S>
+f32 scoreFrames(S (*distance)(const T*, const T*, u32), const BenchmarkData<T>& data,
+                u32 nDensities, u32 nFrames, std::vector<S>& result) {
+    result.resize(nFrames);
+    Core::Timer timer;
+    timer.start();
+    for (u32 t = 0; t < nFrames; ++t) {
+        const T* frame = data.frames + size_t(t) * data.paddedDimension;
+        const T* mean  = data.means;
+        S        best  = Core::Type<S>::max;
+        for (u32 dns = 0; dns < nDensities; ++dns, mean += data.paddedDimension)
+            best = std::min(best, distance(mean, frame, data.paddedDimension));
+        result[t] = best;
+    }
+    timer.stop();
+    return timer.elapsed();
+}
+
+}  // namespace
+
+void GaussianKernelBenchmark::run(const MixtureSet& mixtureSet) {
+    const u32 dimension  = mixtureSet.dimension();
+    const u32 nDensities = mixtureSet.nDensities();
+    log("benchmarking gaussian kernels on %d densities of dimension %d, %d frames", nDensities, dimension, nFrames_);
+
+    // means divided by the standard deviation, frames around randomly chosen means
+    std::vector<f32>                            means(size_t(nDensities) * dimension);
+    std::vector<f32>                            frames(size_t(nFrames_) * dimension);
+    std::vector<CovarianceFeatureScorerElement> covariances(mixtureSet.nCovariances());
+    for (u32 c = 0; c < covariances.size(); ++c)
+        covariances[c] = *mixtureSet.covariance(c);
+    f32 maxAbs = 0.0;
+    for (u32 dns = 0; dns < nDensities; ++dns) {
+        const GaussDensity&              density = *mixtureSet.density(dns);
+        const Mean&                      mean    = *mixtureSet.mean(density.meanIndex());
+        const std::vector<VarianceType>& scale   = covariances[density.covarianceIndex()].inverseSquareRootDiagonal();
+        for (u32 d = 0; d < dimension; ++d) {
+            means[size_t(dns) * dimension + d] = mean[d] * scale[d];
+            maxAbs                             = std::max(maxAbs, std::abs(means[size_t(dns) * dimension + d]));
+        }
+    }
+    std::uniform_int_distribution<u32> chooseDensity(0, nDensities - 1);
+    std::normal_distribution<f32>      noise(0.0, 0.5);
+    for (u32 t = 0; t < nFrames_; ++t) {
+        const f32* mean = &means[size_t(chooseDensity(Math::randomEngine)) * dimension];
+        for (u32 d = 0; d < dimension; ++d)
+            frames[size_t(t) * dimension + d] = mean[d] + noise(Math::randomEngine);
+    }
+
+    // same quantization as in BatchIntFeatureScorer resp. with the full s16 range
+    // such that the sum of squared differences does not overflow
+    const f32          u8Scale  = 255.0 / (1.25 * 2 * maxAbs);
+    const f32          s16Scale = std::min(32767.0, std::sqrt(2147483647.0 / dimension) / 2) / (1.25 * maxAbs);
+    BenchmarkData<f32> floatData(dimension, 8, nDensities, nFrames_);
+    BenchmarkData<s16> s16Data(dimension, 8, nDensities, nFrames_);
+    BenchmarkData<u8>  u8Data(dimension, 16, nDensities, nFrames_);
+    quantize<f32, u8>  quantizeU8;
+    for (u32 i = 0; i < nDensities + nFrames_; ++i) {
+        const bool isMean = i < nDensities;
+        const u32  n      = isMean ? i : i - nDensities;
+        const f32* src    = isMean ? &means[size_t(n) * dimension] : &frames[size_t(n) * dimension];
+        f32*       f      = (isMean ? floatData.means : floatData.frames) + size_t(n) * floatData.paddedDimension;
+        s16*       s      = (isMean ? s16Data.means : s16Data.frames) + size_t(n) * s16Data.paddedDimension;
+        u8*        u      = (isMean ? u8Data.means : u8Data.frames) + size_t(n) * u8Data.paddedDimension;
+        for (u32 d = 0; d < dimension; ++d) {
+            f[d] = src[d];
+            s[d] = s16(std::max(-32767.0f, std::min(32767.0f, std::round(src[d] * s16Scale))));
+            u[d] = quantizeU8(src[d] * u8Scale);
+        }
+    }
+
+    std::vector<f32> floatReference, floatResult;
+    std::vector<s32> s16Reference, s16Result, u8Reference, u8Result;
+    for (s32 isa = GaussianKernels::scalar; isa <= GaussianKernels::avx512; ++isa) {
+        const GaussianKernels::InstructionSet instructionSet = GaussianKernels::InstructionSet(isa);
+        if (!GaussianKernels::isSupported(instructionSet)) {
+            log("instruction set %s not supported", GaussianKernels::name(instructionSet));
+            continue;
+        }
+        const GaussianKernels& kernels = GaussianKernels::kernels(instructionSet);
+
+        const f32 floatTime = scoreFrames(kernels.floatDistance, floatData, nDensities, nFrames_, floatResult);
+        const f32 s16Time   = scoreFrames(kernels.s16Distance, s16Data, nDensities, nFrames_, s16Result);
+        const f32 u8Time    = scoreFrames(kernels.u8Distance, u8Data, nDensities, nFrames_, u8Result);
+        if (instructionSet == GaussianKernels::scalar) {
+            floatReference = floatResult;
+            s16Reference   = s16Result;
+            u8Reference    = u8Result;
+        }
+        f32 maxFloatDeviation = 0.0;
+        for (u32 t = 0; t < nFrames_; ++t)
+            maxFloatDeviation = std::max(maxFloatDeviation, std::abs(floatResult[t] - floatReference[t]) / std::max(floatReference[t], 1.0f));
+
+        const f64 nDistances = f64(nDensities) * nFrames_;
+        log("%-6s f32: %8.3fs %10.1f Mdistances/s (max. relative deviation %g)",
+            GaussianKernels::name(instructionSet), floatTime, nDistances / floatTime / 1e6, maxFloatDeviation);
+        log("%-6s s16: %8.3fs %10.1f Mdistances/s%s",
+            GaussianKernels::name(instructionSet), s16Time, nDistances / s16Time / 1e6,
+            (s16Result == s16Reference) ? "" : " (DIFFERS FROM SCALAR REFERENCE)");
+        log("%-6s u8:  %8.3fs %10.1f Mdistances/s%s",
+            GaussianKernels::name(instructionSet), u8Time, nDistances / u8Time / 1e6,
+            (u8Result == u8Reference) ? "" : " (DIFFERS FROM SCALAR REFERENCE)");
+        if ((s16Result != s16Reference) || (u8Result != u8Reference))
+            error("results of instruction set %s differ from the scalar reference", GaussianKernels::name(instructionSet));
+    }
+}
@@ -0,0 +1,106 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _MM_GAUSSIAN_KERNELS_HH
+#define _MM_GAUSSIAN_KERNELS_HH
+
+#include <Core/Component.hh>
+#include <Core/Parameter.hh>
+#include <Core/Types.hh>
+
+namespace Mm {
+
+class MixtureSet;
+
+/**
+ * Distance kernels of the Gaussian feature scorers.
+ *
+ * The kernels compute the squared Euclidean distance of a mean and a
+ * feature vector, both already multiplied by the inverse standard
+ * deviation.  There are variants for float vectors and for vectors
+ * quantized to 16 bit (s16) and 8 bit (u8).
+ *
+ * Implementations for several instruction sets are compiled into the
+ * same object file using function target attributes, i.e. without global
+ * compiler flags.  The best instruction set supported by the processor
+ * is determined at run time (CPUID); the parameter instruction-set
+ * overrides this choice, e.g. for benchmarks.  The scalar kernels are
+ * the reference implementation and the only ones available on
+ * processors other than x86 (PROC_intel, PROC_x86_64).
+ *
+ * Requirements on the vectors: dimension is a multiple of 8 (f32, s16)
+ * resp. 16 (u8) and the padding components are zero in both vectors.
+ * No alignment is required.  For s16 vectors the differences of the
+ * components must be representable as s16 and the sum of squares as s32.
+ */
+class GaussianKernels {
+public:
+    enum InstructionSet {
+        autoDetect,
+        scalar,
+        sse2,
+        avx2,
+        avx512
+    };
+    static const Core::Choice          choiceInstructionSet;
+    static const Core::ParameterChoice paramInstructionSet;
+
+    typedef f32 (*FloatDistance)(const f32* mean, const f32* feature, u32 dimension);
+    typedef s32 (*S16Distance)(const s16* mean, const s16* feature, u32 dimension);
+    typedef s32 (*U8Distance)(const u8* mean, const u8* feature, u32 dimension);
+
+    InstructionSet instructionSet;
+    FloatDistance  floatDistance;
+    S16Distance    s16Distance;
+    U8Distance     u8Distance;
+
+    static bool           isSupported(InstructionSet);
+    static InstructionSet bestSupported();
+    static const char*    name(InstructionSet);
+
+    /** Kernels for the given instruction set, which has to be supported. */
+    static const GaussianKernels& kernels(InstructionSet);
+
+    /**
+     * Kernels for the instruction set chosen in the configuration.
+     * Falls back to the best supported instruction set if the chosen one
+     * is not supported by the processor.
+     */
+    static const GaussianKernels& choose(const Core::Configuration& c);
+};
+
+/**
+ * Measures the throughput of the distance kernels of all supported
+ * instruction sets on a mixture set.
+ *
+ * The means of all densities are prepared like in the batch feature
+ * scorers (divided by the standard deviation, padded, quantized) and for
+ * each frame the minimum distance over all densities is computed.  The
+ * frames are means of randomly chosen densities with added noise.
+ */
+class GaussianKernelBenchmark : public Core::Component {
+public:
+    static const Core::ParameterInt paramFrames;
+
+    GaussianKernelBenchmark(const Core::Configuration& c);
+
+    void run(const MixtureSet& mixtureSet);
+
+private:
+    u32 nFrames_;
+};
+
+}  // namespace Mm
+
+#endif  // _MM_GAUSSIAN_KERNELS_HH
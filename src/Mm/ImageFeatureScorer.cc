@@ -0,0 +1,118 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "ImageFeatureScorer.hh"
+#include <cmath>
+
+using namespace Mm;
+
+// ImageGaussDiagonalMaximumFeatureScorer::Context
+//////////////////////////////////////////////////
+
+ImageGaussDiagonalMaximumFeatureScorer::Context::Context(const FeatureVector&                          featureVector,
+                                                         const ImageGaussDiagonalMaximumFeatureScorer* featureScorer,
+                                                         size_t                                        cacheSize)
+        : CachedAssigningContextScorer(featureScorer, cacheSize) {
+    const MixtureSetImage& image = *featureScorer->image_;
+    require(featureVector.size() == image.dimension());
+
+    const u32 dimension = image.dimension(), paddedDimension = image.paddedDimension();
+    if (image.precision() == MixtureSetImage::int8)
+        quantizedFeatures_.assign(size_t(image.nCovariances()) * paddedDimension, 0);
+    else
+        features_.assign(size_t(image.nCovariances()) * paddedDimension, 0);
+    if (image.precision() == MixtureSetImage::float16)
+        mean_.assign(paddedDimension, 0);
+
+    for (CovarianceIndex c = 0; c < image.nCovariances(); ++c) {
+        const f32* isd = image.inverseSquareRootDiagonal(c);
+        if (image.precision() == MixtureSetImage::int8) {
+            const f32 scale = image.quantizationScale();
+            u8*       x     = &quantizedFeatures_[size_t(c) * paddedDimension];
+            for (u32 i = 0; i < dimension; ++i)
+                x[i] = u8(std::min(255.0f, std::max(0.0f, std::round(featureVector[i] * isd[i] * scale) + 128)));
+        }
+        else {
+            f32* x = &features_[size_t(c) * paddedDimension];
+            for (u32 i = 0; i < dimension; ++i)
+                x[i] = featureVector[i] * isd[i];
+        }
+    }
+}
+
+// ImageGaussDiagonalMaximumFeatureScorer
+/////////////////////////////////////////
+
+const Core::ParameterFloat ImageGaussDiagonalMaximumFeatureScorer::paramMixtureWeightScale(
+        "mixture-weight-scale", "scaling of the logarithmized mixture weights", 1.0,
+        Core::Type<Score>::epsilon);
+
+const Core::ParameterFloat ImageGaussDiagonalMaximumFeatureScorer::paramGaussianScale(
+        "gaussian-scale", "scaling of the logarithmized gaussian probability", 1.0,
+        Core::Type<Score>::epsilon);
+
+ImageGaussDiagonalMaximumFeatureScorer::ImageGaussDiagonalMaximumFeatureScorer(
+        const Core::Configuration& c, Core::Ref<const MixtureSetImage> image)
+        : Core::Component(c),
+          Precursor(c),
+          image_(image),
+          kernels_(GaussianKernels::choose(c)),
+          mixtureWeightScale_(paramMixtureWeightScale(c)),
+          gaussianScale_(paramGaussianScale(c)),
+          quantizedDistanceScale_(gaussianScale_ / (image->quantizationScale() * image->quantizationScale())) {
+    log("using %s kernels on %s mixture set image \"%s\" (%d mixtures, %d densities)",
+        GaussianKernels::name(kernels_.instructionSet),
+        MixtureSetImage::choicePrecision[image_->precision()].c_str(),
+        image_->filename().c_str(), image_->nMixtures(), image_->nDensities());
+}
+
+AssigningFeatureScorer::ScoreAndBestDensity ImageGaussDiagonalMaximumFeatureScorer::calculateScoreAndDensity(
+        const CachedAssigningContextScorer* cs, MixtureIndex mixtureIndex) const {
+    const Context*         c     = required_cast(const Context*, cs);
+    const MixtureSetImage& image = *image_;
+    const u32              pd    = image.paddedDimension();
+    const DensityIndex     begin = image.mixtureBegin(mixtureIndex), end = image.mixtureBegin(mixtureIndex + 1);
+
+    Score  bestScore   = Core::Type<Score>::max;
+    size_t bestDensity = Core::Type<size_t>::max;
+    for (DensityIndex d = begin; d < end; ++d) {
+        const CovarianceIndex cov = image.covarianceIndex(d);
+        Score                 distance;
+        switch (image.precision()) {
+            case MixtureSetImage::float32:
+                distance = gaussianScale_ * kernels_.floatDistance(
+                                                    static_cast<const f32*>(image.mean(d)), &c->features_[size_t(cov) * pd], pd);
+                break;
+            case MixtureSetImage::float16: {
+                const u16* mean = static_cast<const u16*>(image.mean(d));
+                for (u32 i = 0; i < pd; ++i)
+                    c->mean_[i] = MixtureSetImage::halfToFloat(mean[i]);
+                distance = gaussianScale_ * kernels_.floatDistance(&c->mean_[0], &c->features_[size_t(cov) * pd], pd);
+            } break;
+            default:
+                distance = quantizedDistanceScale_ * kernels_.u8Distance(
+                                                             static_cast<const u8*>(image.mean(d)), &c->quantizedFeatures_[size_t(cov) * pd], pd);
+        }
+        Score score = mixtureWeightScale_ * image.minus2LogWeight(d) +
+                      gaussianScale_ * image.logNormalizationFactor(cov) + distance;
+        if (bestScore > score) {
+            bestScore   = score;
+            bestDensity = d - begin;
+        }
+    }
+    ScoreAndBestDensity result;
+    result.score       = 0.5 * bestScore;
+    result.bestDensity = bestDensity;
+    return result;
+}
@@ -0,0 +1,80 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _MM_IMAGE_FEATURE_SCORER_HH
+#define _MM_IMAGE_FEATURE_SCORER_HH
+
+#include "AssigningFeatureScorer.hh"
+#include "GaussianKernels.hh"
+#include "MixtureSetImage.hh"
+
+namespace Mm {
+
+/** Feature-scorer for Gauss densities with diagonal covariance matrices
+ *  scoring directly on a mapped MixtureSetImage with maximum approximation.
+ *
+ *  The scorer keeps no copy of the model, all image scorers of a process
+ *  using the same image file share one mapping.  For each feature vector the feature is multiplied by the
+ *  inverse standard deviation of each covariance (and quantized for 8 bit
+ *  images); the distances are computed by the GaussianKernels, f16 means
+ *  are converted to f32 before.
+ */
+class ImageGaussDiagonalMaximumFeatureScorer : public CachedAssigningFeatureScorer {
+    typedef CachedAssigningFeatureScorer Precursor;
+
+protected:
+    class Context : public CachedAssigningContextScorer {
+        friend class ImageGaussDiagonalMaximumFeatureScorer;
+
+        /** prepared feature vector per covariance, f32 or u8 */
+        std::vector<f32>         features_;
+        std::vector<u8>          quantizedFeatures_;
+        mutable std::vector<f32> mean_;
+
+        Context(const FeatureVector&                          featureVector,
+                const ImageGaussDiagonalMaximumFeatureScorer* featureScorer,
+                size_t                                        cacheSize);
+    };
+    friend class Context;
+
+    static const Core::ParameterFloat paramMixtureWeightScale;
+    static const Core::ParameterFloat paramGaussianScale;
+
+    Core::Ref<const MixtureSetImage> image_;
+    const GaussianKernels&           kernels_;
+    Score                            mixtureWeightScale_;
+    Score                            gaussianScale_;
+    /** gaussianScale_ / (2 * quantization scale ^ 2) */
+    Score quantizedDistanceScale_;
+
+    virtual ScoreAndBestDensity calculateScoreAndDensity(const CachedAssigningContextScorer* cs, MixtureIndex mixtureIndex) const;
+
+public:
+    ImageGaussDiagonalMaximumFeatureScorer(const Core::Configuration& c, Core::Ref<const MixtureSetImage> image);
+    virtual ~ImageGaussDiagonalMaximumFeatureScorer() {}
+
+    virtual AssigningScorer getAssigningScorer(const FeatureVector& featureVector) const {
+        return AssigningScorer(new Context(featureVector, this, nMixtures()));
+    }
+    virtual MixtureIndex nMixtures() const {
+        return image_->nMixtures();
+    }
+    virtual ComponentIndex dimension() const {
+        return image_->dimension();
+    }
+};
+
+}  // namespace Mm
+
+#endif  // _MM_IMAGE_FEATURE_SCORER_HH
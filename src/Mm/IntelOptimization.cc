@@ -15,26 +15,13 @@
 #if (defined(PROC_intel) || defined(PROC_x86_64))
 
 #include "IntelOptimization.hh"
-#include <Core/Application.hh>
 
 using namespace Mm;
 
 FeatureScorerIntelOptimization::FeatureScorerIntelOptimization(
         const Core::Configuration& c, ComponentIndex dimension)
-        : Precursor(c)
-#if !defined(DISABLE_SIMD)
-          ,
-          l2norm_(c, dimension)
-#if !defined(ENABLE_SSE2)
-          ,
-          reset_(c)
-#endif
-#endif
-{
-#if defined(DISABLE_SIMD)
-    Core::Application::us()->warning("SIMD is not supported (in Valgrind executables)");
-#endif
-}
+        : Precursor(c),
+          kernels_(GaussianKernels::choose(c)) {}
 
 void FeatureScorerIntelOptimization::createDensityElement(Score                                 scaledMinus2LogWeight,
                                                           const Mean&                           mean,
@@ -66,52 +53,4 @@ void FeatureScorerIntelOptimization::multiplyAndQuantize(const std::vector<Featu
     std::fill(ri, r.end(), 0);
 }
 
-#if defined(DISABLE_SIMD)
-
-int FeatureScorerIntelOptimization::distance(const PreparedFeatureVector& mean, const PreparedFeatureVector& featureVector) const {
-    int            df, score = 0;
-    ComponentIndex cmp       = 0;
-    ComponentIndex dimension = featureVector.size();
-    switch ((dimension - 1) % 8) {
-        while (cmp < dimension) {
-            case 7:
-                df = (mean[cmp] - featureVector[cmp]);
-                score += df * df;
-                ++cmp;
-            case 6:
-                df = (mean[cmp] - featureVector[cmp]);
-                score += df * df;
-                ++cmp;
-            case 5:
-                df = (mean[cmp] - featureVector[cmp]);
-                score += df * df;
-                ++cmp;
-            case 4:
-                df = (mean[cmp] - featureVector[cmp]);
-                score += df * df;
-                ++cmp;
-            case 3:
-                df = (mean[cmp] - featureVector[cmp]);
-                score += df * df;
-                ++cmp;
-            case 2:
-                df = (mean[cmp] - featureVector[cmp]);
-                score += df * df;
-                ++cmp;
-            case 1:
-                df = (mean[cmp] - featureVector[cmp]);
-                score += df * df;
-                ++cmp;
-            case 0:
-                df = (mean[cmp] - featureVector[cmp]);
-                score += df * df;
-                ++cmp;
-        }
-    }
-    verify_(cmp == dimension);
-    return score;
-}
-
-#endif  // DISABLE_SIMD
-
 #endif  // PROC_intel
@@ -16,11 +16,9 @@
 #define _MM_INTEL_OPTIMAZATION_HH
 
 #if (defined(PROC_intel) || defined(PROC_x86_64))
-#include "IntelCodeGenerator.hh"
-#include "SSE2CodeGenerator.hh"
-
 #include "CovarianceFeatureScorerElement.hh"
 #include "GaussDensity.hh"
+#include "GaussianKernels.hh"
 #include "MixtureFeatureScorerElement.hh"
 #include "Utilities.hh"
 
@@ -37,18 +35,8 @@ public:
     typedef std::vector<QuantizedType>                          PreparedFeatureVector;
 
 private:
-#if !defined(DISABLE_SIMD)
-#if defined(ENABLE_SSE2)
-    SSE2L2NormCodeGenerator l2norm_;
-    enum {BlockSize = 16};
-#else
-    IntelMMXL2NormCodeGenerator l2norm_;
-    IntelMMXResetCodeGenerator  reset_;
-    enum {BlockSize = 8};
-#endif  // ENABLE_SSE2
-#else
-    enum { BlockSize = 8 };
-#endif  // DISABLE_SIMD
+    enum { BlockSize = 16 };
+    const GaussianKernels& kernels_;
 
 private:
     /** @return is @param vectorSize rounded up to the next integer divisible by BlockSize. */
@@ -68,31 +56,16 @@ public:
                                      const CovarianceFeatureScorerElement& covarianceScorerElement,
                                      MixtureElement::Density&              result);
 
-    int distanceNoMmx(const PreparedFeatureVector& mean,
-                      const PreparedFeatureVector& featureVector) const;
-
-#if defined(DISABLE_SIMD)
-    int  distance(const PreparedFeatureVector& mean,
-                  const PreparedFeatureVector& featureVector) const;
-    void resetFloatingPointCalculation() const {}
-#else
-    /**
-     * When this function is used the processor is set to optimized integer mode.
-     * Before using floating point operations resetFloatingPointCalculation HAS to be called.
-     */
+    /** Squared distance of the quantized vectors, see GaussianKernels. */
     int distance(const PreparedFeatureVector& mean,
                  const PreparedFeatureVector& featureVector) const {
-        return l2norm_.run(&mean[0], &featureVector[0]);
+        return kernels_.u8Distance(&mean[0], &featureVector[0], mean.size());
     }
-#if defined(ENABLE_SSE2)
     void resetFloatingPointCalculation() const {}
-#else
-    void resetFloatingPointCalculation() const {
-        reset_.run();
-    }
-#endif  // ENABLE_SSE2
 
-#endif  // DISABLE_SIMD
+    const GaussianKernels& kernels() const {
+        return kernels_;
+    }
 };
 
 }  // namespace Mm
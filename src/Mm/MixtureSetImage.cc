@@ -0,0 +1,419 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "MixtureSetImage.hh"
+#include <Core/Application.hh>
+#include <Core/Directory.hh>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CovarianceFeatureScorerElement.hh"
+#include "Module.hh"
+
+using namespace Mm;
+
+namespace {
+
+u64 fnv(u64 hash, const void* data, size_t size) {
+    const u8* p = reinterpret_cast<const u8*>(data);
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ p[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+const u64 fnvOffsetBasis = 0xcbf29ce484222325ull;
+
+}  // namespace
+
+/**
+ * Image file layout:
+ * header, mixture begin indices (u32), covariance index (u32) and
+ * -2 * log(weight) (f32) of each entry, log normalization factor (f32) and
+ * inverse standard deviation (f32 * paddedDimension) of each covariance,
+ * means; each array starts at a multiple of 64 bytes.
+ */
+struct MixtureSetImage::Header {
+    static const u32 currentVersion = 1;
+
+    char magic[8];
+    u32  version;
+    u32  precision;
+    u32  dimension, paddedDimension;
+    u32  nMixtures, nDensities, nCovariances;
+    f32  quantizationScale;
+    u64  checksum;
+    u64  covarianceIndexOffset, weightsOffset, normalizationOffset, diagonalsOffset, meansOffset, end;
+
+    static u64 align(u64 offset) {
+        return (offset + 63) & ~u64(63);
+    }
+    static const char* magicString() {
+        return "MMIMAGE";
+    }
+    static size_t meanSize(Precision precision, u32 paddedDimension) {
+        switch (precision) {
+            case float32: return paddedDimension * sizeof(f32);
+            case float16: return paddedDimension * sizeof(u16);
+            case int8: return paddedDimension * sizeof(u8);
+        }
+        return 0;
+    }
+    void layout() {
+        covarianceIndexOffset = align(sizeof(Header) + (u64(nMixtures) + 1) * sizeof(u32));
+        weightsOffset         = align(covarianceIndexOffset + u64(nDensities) * sizeof(u32));
+        normalizationOffset   = align(weightsOffset + u64(nDensities) * sizeof(f32));
+        diagonalsOffset       = align(normalizationOffset + u64(nCovariances) * sizeof(f32));
+        meansOffset           = align(diagonalsOffset + u64(nCovariances) * paddedDimension * sizeof(f32));
+        end                   = meansOffset + u64(nDensities) * meanSize(Precision(precision), paddedDimension);
+    }
+};
+
+const Core::Choice MixtureSetImage::choicePrecision(
+        "float32", float32,
+        "float16", float16,
+        "int8", int8,
+        Core::Choice::endMark());
+
+MixtureSetImage::MixtureSetImage()
+        : mapping_(0),
+          mappingSize_(0),
+          precision_(float32),
+          paddedDimension_(0),
+          nMixtures_(0),
+          nDensities_(0),
+          nCovariances_(0),
+          checksum_(0),
+          quantizationScale_(1),
+          mixtureBegin_(0),
+          covarianceIndex_(0),
+          minus2LogWeights_(0),
+          logNormalizationFactors_(0),
+          inverseSquareRootDiagonals_(0),
+          means_(0),
+          meanSize_(0) {}
+
+MixtureSetImage::~MixtureSetImage() {
+    if (mapping_)
+        munmap(mapping_, mappingSize_);
+}
+
+u16 MixtureSetImage::floatToHalf(f32 f) {
+    u32 x;
+    memcpy(&x, &f, sizeof(x));
+    const u32 sign     = (x >> 16) & 0x8000;
+    const u32 exponent = (x >> 23) & 0xff;
+    u32       mantissa = x & 0x7fffff;
+    if (exponent == 0xff)  // inf, nan
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    const s32 e = s32(exponent) - 127 + 15;
+    if (e >= 31)
+        return sign | 0x7c00;
+    if (e <= 0) {  // subnormal, rounded to nearest even
+        if (e < -10)
+            return sign;
+        mantissa |= 0x800000;
+        const u32 shift = 14 - e, half = 1u << (shift - 1);
+        u32       h = mantissa >> shift, rest = mantissa & ((1u << shift) - 1);
+        if (rest > half || (rest == half && (h & 1)))
+            ++h;
+        return sign | h;
+    }
+    u32       h    = (u32(e) << 10) | (mantissa >> 13);
+    const u32 rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+        ++h;  // a carry into the exponent is correct, including overflow to inf
+    return sign | h;
+}
+
+f32 MixtureSetImage::halfToFloat(u16 h) {
+    const u32 sign     = u32(h & 0x8000) << 16;
+    const u32 exponent = (h >> 10) & 0x1f;
+    const u32 mantissa = h & 0x3ff;
+    u32       x;
+    if (exponent == 0) {
+        const f32 f = mantissa * (1.0f / 16777216.0f);  // 2^-24
+        return sign ? -f : f;
+    }
+    else if (exponent == 31)
+        x = sign | 0x7f800000 | (mantissa << 13);
+    else
+        x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    f32 f;
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+bool MixtureSetImage::write(const MixtureSet& mixtureSet, Precision precision, u64 checksum, const std::string& filename) {
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, Header::magicString(), sizeof(header.magic));
+    header.version         = Header::currentVersion;
+    header.precision       = precision;
+    header.dimension       = mixtureSet.dimension();
+    header.paddedDimension = ((header.dimension + 15) / 16) * 16;
+    header.nMixtures       = mixtureSet.nMixtures();
+    header.nCovariances    = mixtureSet.nCovariances();
+    header.checksum        = checksum;
+
+    std::vector<u32> mixtureBegin(header.nMixtures + 1, 0);
+    for (MixtureIndex m = 0; m < header.nMixtures; ++m)
+        mixtureBegin[m + 1] = mixtureBegin[m] + mixtureSet.mixture(m)->nDensities();
+    header.nDensities = mixtureBegin.back();
+
+    std::vector<CovarianceFeatureScorerElement> covariances(header.nCovariances);
+    for (CovarianceIndex c = 0; c < header.nCovariances; ++c) {
+        if (!dynamic_cast<const DiagonalCovariance*>(mixtureSet.covariance(c)))
+            return false;
+        covariances[c] = *mixtureSet.covariance(c);
+    }
+
+    // the entries in mixture order; normalized means are computed when written
+    std::vector<CovarianceIndex> covarianceIndex;
+    std::vector<f32>             minus2LogWeights;
+    std::vector<MeanIndex>       meanIndex;
+    covarianceIndex.reserve(header.nDensities);
+    minus2LogWeights.reserve(header.nDensities);
+    meanIndex.reserve(header.nDensities);
+    for (MixtureIndex m = 0; m < header.nMixtures; ++m) {
+        const Mixture* mixture = mixtureSet.mixture(m);
+        for (DensityIndex dns = 0; dns < mixture->nDensities(); ++dns) {
+            const GaussDensity* density = mixtureSet.density(mixture->densityIndex(dns));
+            covarianceIndex.push_back(density->covarianceIndex());
+            minus2LogWeights.push_back(-2 * mixture->logWeight(dns));
+            meanIndex.push_back(density->meanIndex());
+        }
+    }
+
+    std::vector<f32> normalized(header.paddedDimension, 0);
+    auto             normalize = [&](DensityIndex d) {
+        const Mean&                      mean = *mixtureSet.mean(meanIndex[d]);
+        const std::vector<VarianceType>& isd  = covariances[covarianceIndex[d]].inverseSquareRootDiagonal();
+        for (u32 i = 0; i < header.dimension; ++i)
+            normalized[i] = mean[i] * isd[i];
+    };
+    // same interval as SimdGaussDiagonalMaximumFeatureScorer, leaves a reserve of 25% for the features
+    header.quantizationScale = 1;
+    if (precision == int8) {
+        f32 maxAbs = 0;
+        for (DensityIndex d = 0; d < header.nDensities; ++d) {
+            normalize(d);
+            for (u32 i = 0; i < header.dimension; ++i)
+                maxAbs = std::max(maxAbs, std::abs(normalized[i]));
+        }
+        header.quantizationScale = maxAbs > 0 ? 255.0 / (2.5 * maxAbs) : 1;
+    }
+    header.layout();
+
+    std::ofstream o(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!o)
+        return false;
+    const char zeros[64] = {0};
+    o.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    o.write(reinterpret_cast<const char*>(&mixtureBegin[0]), mixtureBegin.size() * sizeof(u32));
+    o.write(zeros, header.covarianceIndexOffset - u64(o.tellp()));
+    o.write(reinterpret_cast<const char*>(covarianceIndex.data()), covarianceIndex.size() * sizeof(u32));
+    o.write(zeros, header.weightsOffset - u64(o.tellp()));
+    o.write(reinterpret_cast<const char*>(minus2LogWeights.data()), minus2LogWeights.size() * sizeof(f32));
+    o.write(zeros, header.normalizationOffset - u64(o.tellp()));
+    for (CovarianceIndex c = 0; c < header.nCovariances; ++c) {
+        f32 logNormalizationFactor = covariances[c].logNormalizationFactor();
+        o.write(reinterpret_cast<const char*>(&logNormalizationFactor), sizeof(f32));
+    }
+    o.write(zeros, header.diagonalsOffset - u64(o.tellp()));
+    std::vector<f32> diagonal(header.paddedDimension, 0);
+    for (CovarianceIndex c = 0; c < header.nCovariances; ++c) {
+        std::copy(covariances[c].inverseSquareRootDiagonal().begin(), covariances[c].inverseSquareRootDiagonal().end(), diagonal.begin());
+        o.write(reinterpret_cast<const char*>(&diagonal[0]), diagonal.size() * sizeof(f32));
+    }
+    o.write(zeros, header.meansOffset - u64(o.tellp()));
+    std::vector<u16> half(header.paddedDimension, 0);
+    std::vector<u8>  quantized(header.paddedDimension, 0);
+    for (DensityIndex d = 0; d < header.nDensities; ++d) {
+        normalize(d);
+        switch (precision) {
+            case float32:
+                o.write(reinterpret_cast<const char*>(&normalized[0]), normalized.size() * sizeof(f32));
+                break;
+            case float16:
+                for (u32 i = 0; i < header.dimension; ++i)
+                    half[i] = floatToHalf(normalized[i]);
+                o.write(reinterpret_cast<const char*>(&half[0]), half.size() * sizeof(u16));
+                break;
+            case int8:
+                for (u32 i = 0; i < header.dimension; ++i)
+                    quantized[i] = u8(std::min(255.0f, std::max(0.0f, std::round(normalized[i] * header.quantizationScale) + 128)));
+                o.write(reinterpret_cast<const char*>(&quantized[0]), quantized.size());
+                break;
+        }
+    }
+    o.close();
+    return o.good();
+}
+
+Core::Ref<MixtureSetImage> MixtureSetImage::map(const std::string& filename) {
+    // all images mapped by this process, by device and inode of the file;
+    // weak references, an image is unmapped when its last user releases it
+    static std::map<std::pair<dev_t, ino_t>, Core::WeakRef<MixtureSetImage>> images;
+    static std::mutex                                                         mutex;
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return Core::Ref<MixtureSetImage>();
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (size_t(st.st_size) < sizeof(Header))) {
+        ::close(fd);
+        return Core::Ref<MixtureSetImage>();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::pair<dev_t, ino_t> id(st.st_dev, st.st_ino);
+    for (auto i = images.begin(); i != images.end();) {
+        if (!i->second)
+            i = images.erase(i);
+        else
+            ++i;
+    }
+    auto i = images.find(id);
+    if (i != images.end()) {
+        ::close(fd);
+        return Core::Ref<MixtureSetImage>(i->second);
+    }
+    char* mapping = (char*)mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return Core::Ref<MixtureSetImage>();
+
+    Header header;
+    memcpy(&header, mapping, sizeof(header));
+    Header expected = header;
+    expected.layout();
+    if ((memcmp(header.magic, Header::magicString(), sizeof(header.magic)) != 0) ||
+        (header.version != Header::currentVersion) || (header.precision > int8) ||
+        (header.paddedDimension % 16 != 0) || (header.paddedDimension < header.dimension) ||
+        (header.covarianceIndexOffset != expected.covarianceIndexOffset) || (header.weightsOffset != expected.weightsOffset) ||
+        (header.normalizationOffset != expected.normalizationOffset) || (header.diagonalsOffset != expected.diagonalsOffset) ||
+        (header.meansOffset != expected.meansOffset) || (header.end != expected.end) ||
+        (header.end > u64(st.st_size))) {
+        munmap(mapping, st.st_size);
+        return Core::Ref<MixtureSetImage>();
+    }
+    MixtureSetImage* image             = new MixtureSetImage();
+    image->mapping_                    = mapping;
+    image->mappingSize_                = st.st_size;
+    image->filename_                   = filename;
+    image->dimension_                  = header.dimension;
+    image->precision_                  = Precision(header.precision);
+    image->paddedDimension_            = header.paddedDimension;
+    image->nMixtures_                  = header.nMixtures;
+    image->nDensities_                 = header.nDensities;
+    image->nCovariances_               = header.nCovariances;
+    image->checksum_                   = header.checksum;
+    image->quantizationScale_          = header.quantizationScale;
+    image->mixtureBegin_               = reinterpret_cast<const u32*>(mapping + sizeof(header));
+    image->covarianceIndex_            = reinterpret_cast<const u32*>(mapping + header.covarianceIndexOffset);
+    image->minus2LogWeights_           = reinterpret_cast<const f32*>(mapping + header.weightsOffset);
+    image->logNormalizationFactors_    = reinterpret_cast<const f32*>(mapping + header.normalizationOffset);
+    image->inverseSquareRootDiagonals_ = reinterpret_cast<const f32*>(mapping + header.diagonalsOffset);
+    image->means_                      = reinterpret_cast<const u8*>(mapping + header.meansOffset);
+    image->meanSize_                   = Header::meanSize(image->precision_, header.paddedDimension);
+    Core::Ref<MixtureSetImage> result(image);
+    images[id] = result;
+    return result;
+}
+
+u64 MixtureSetImage::fileChecksum(const std::string& filename) {
+    std::ifstream i(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!i)
+        return 0;
+    u64               hash = fnvOffsetBasis;
+    std::vector<char> buffer(1 << 20);
+    while (i) {
+        i.read(&buffer[0], buffer.size());
+        hash = fnv(hash, &buffer[0], i.gcount());
+    }
+    return hash;
+}
+
+// ================================================================================
+
+const Core::ParameterChoice MixtureSetImageLoader::paramPrecision(
+        "image-precision", &MixtureSetImage::choicePrecision,
+        "precision of the means in the mixture set image", MixtureSetImage::float32);
+
+const Core::ParameterString MixtureSetImageLoader::paramCacheDirectory(
+        "image-cache-directory",
+        "directory of the cached mixture set images, default: directory of the mixture set file",
+        "");
+
+Core::Ref<AbstractMixtureSet> MixtureSetImageLoader::load(
+        const std::string& filename, const Core::Configuration& c) const {
+    Core::Application* app = Core::Application::us();
+    if (filename.empty())
+        return Core::Ref<AbstractMixtureSet>();
+    if (Core::filenameExtension(filename) == ".mimage") {
+        Core::Ref<MixtureSetImage> image = MixtureSetImage::map(filename);
+        if (!image)
+            app->error("failed to map mixture set image \"%s\"", filename.c_str());
+        return image;
+    }
+
+    // key of the cached image: mixture set file and all settings which change the image
+    MixtureSetImage::Precision precision = MixtureSetImage::Precision(paramPrecision(c));
+    u32                        offset    = Module_::paramReducedMixtureSetDimensionOffset(c);
+    u32                        dimension = Module_::paramReducedMixtureSetDimension(c);
+    u64                        checksum  = MixtureSetImage::fileChecksum(filename);
+    if (!checksum) {
+        app->error("failed to read mixture set file \"%s\"", filename.c_str());
+        return Core::Ref<AbstractMixtureSet>();
+    }
+    checksum = fnv(checksum, &precision, sizeof(precision));
+    checksum = fnv(checksum, &offset, sizeof(offset));
+    checksum = fnv(checksum, &dimension, sizeof(dimension));
+
+    std::string directory = paramCacheDirectory(c);
+    if (directory.empty())
+        directory = Core::directoryName(filename);
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)checksum);
+    const std::string imageFilename = Core::joinPaths(directory, Core::baseName(filename) + "." + key + ".mimage");
+
+    Core::Ref<MixtureSetImage> image = MixtureSetImage::map(imageFilename);
+    if (image && image->checksum() == checksum) {
+        app->log("mapped mixture set image \"%s\"", imageFilename.c_str());
+        return image;
+    }
+
+    Core::Ref<MixtureSet> mixtureSet = Module::instance().readMixtureSet(filename, c);
+    if (!mixtureSet)
+        return Core::Ref<AbstractMixtureSet>();
+    // written under a temporary name, concurrent processes never map a partial image
+    std::string temporary = imageFilename + "." + Core::form("%d", getpid());
+    if (!MixtureSetImage::write(*mixtureSet, precision, checksum, temporary) ||
+        rename(temporary.c_str(), imageFilename.c_str()) != 0) {
+        unlink(temporary.c_str());
+        app->error("failed to write mixture set image \"%s\"", imageFilename.c_str());
+        return Core::Ref<AbstractMixtureSet>();
+    }
+    app->log("mixture set image written to \"%s\"", imageFilename.c_str());
+    mixtureSet.reset();
+    image = MixtureSetImage::map(imageFilename);
+    if (!image)
+        app->error("failed to map mixture set image \"%s\"", imageFilename.c_str());
+    return image;
+}
@@ -0,0 +1,165 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _MM_MIXTURE_SET_IMAGE_HH
+#define _MM_MIXTURE_SET_IMAGE_HH
+
+#include <Core/Choice.hh>
+#include <Core/Parameter.hh>
+#include "MixtureSet.hh"
+#include "MixtureSetLoader.hh"
+
+namespace Mm {
+
+/**
+ * Flat, read-only image of a mixture set of Gauss densities with diagonal
+ * covariances, the model of the image-diagonal-maximum feature scorer
+ * (ImageGaussDiagonalMaximumFeatureScorer).  The other feature scorers
+ * load a MixtureSet and keep their own layout.
+ *
+ * The densities of mixture m are the entries [mixtureBegin(m),
+ * mixtureBegin(m + 1)), densities used by several mixtures are stored for
+ * each of them.  For each entry the image holds -2 * log(weight), the
+ * covariance index and the mean multiplied by the inverse standard
+ * deviation of the covariance; for each covariance the inverse standard
+ * deviation and the log normalization factor (see
+ * CovarianceFeatureScorerElement).  Vectors are padded with zeros to a
+ * multiple of 16 components as required by the GaussianKernels.  Means
+ * are stored as f32, as f16 or quantized to 8 bit (u8, v * scale + 128).
+ *
+ * Each array starts at a multiple of 64 bytes.  Images are mapped
+ * read-only and shared: as long as an image of a file is in use, map()
+ * returns it for all requests of the process, and all processes mapping
+ * the same file share its pages.  The tables of AbstractMixtureSet are not
+ * used.
+ */
+class MixtureSetImage : public AbstractMixtureSet {
+public:
+    enum Precision {
+        float32,
+        float16,
+        int8
+    };
+    static const Core::Choice choicePrecision;
+
+private:
+    struct Header;
+    char*       mapping_;
+    size_t      mappingSize_;
+    std::string filename_;
+
+    Precision  precision_;
+    u32        paddedDimension_;
+    u32        nMixtures_, nDensities_, nCovariances_;
+    u64        checksum_;
+    f32        quantizationScale_;
+    const u32* mixtureBegin_;
+    const u32* covarianceIndex_;
+    const f32* minus2LogWeights_;
+    const f32* logNormalizationFactors_;
+    const f32* inverseSquareRootDiagonals_;
+    const u8*  means_;
+    size_t     meanSize_;
+
+    MixtureSetImage();
+
+public:
+    virtual ~MixtureSetImage();
+
+    /**
+     * Write the image of a mixture set with diagonal covariances.
+     * @param checksum identifies the source of the image, see checksum()
+     */
+    static bool write(const MixtureSet& mixtureSet, Precision precision, u64 checksum, const std::string& filename);
+    /** Map an image file, returns the image of the file if it is still in use. */
+    static Core::Ref<MixtureSetImage> map(const std::string& filename);
+    /** FNV-1a hash of the content of a file, 0 if the file cannot be read. */
+    static u64 fileChecksum(const std::string& filename);
+
+    static u16 floatToHalf(f32 f);
+    static f32 halfToFloat(u16 h);
+
+    const std::string& filename() const {
+        return filename_;
+    }
+    Precision precision() const {
+        return precision_;
+    }
+    u64 checksum() const {
+        return checksum_;
+    }
+    /** Components of the stored vectors, a multiple of 16. */
+    u32 paddedDimension() const {
+        return paddedDimension_;
+    }
+    /** scale of the 8 bit quantization of the means */
+    f32 quantizationScale() const {
+        return quantizationScale_;
+    }
+    MixtureIndex nMixtures() const {
+        return nMixtures_;
+    }
+    DensityIndex nDensities() const {
+        return nDensities_;
+    }
+    CovarianceIndex nCovariances() const {
+        return nCovariances_;
+    }
+    DensityIndex mixtureBegin(MixtureIndex m) const {
+        return mixtureBegin_[m];
+    }
+    CovarianceIndex covarianceIndex(DensityIndex d) const {
+        return covarianceIndex_[d];
+    }
+    f32 minus2LogWeight(DensityIndex d) const {
+        return minus2LogWeights_[d];
+    }
+    f32 logNormalizationFactor(CovarianceIndex c) const {
+        return logNormalizationFactors_[c];
+    }
+    const f32* inverseSquareRootDiagonal(CovarianceIndex c) const {
+        return inverseSquareRootDiagonals_ + size_t(c) * paddedDimension_;
+    }
+    /** normalized mean, f32, u16 (f16) or u8 according to precision() */
+    const void* mean(DensityIndex d) const {
+        return means_ + size_t(d) * meanSize_;
+    }
+
+    size_t getMemoryUsed() const {
+        return mappingSize_;
+    }
+};
+
+/**
+ * Loads the mixture set image for a mixture set file, used by the
+ * image-diagonal-maximum feature scorer only.
+ *
+ * Image files (extension .mimage) are mapped directly.  For all other
+ * files the image is a cache artifact: it is named after the mixture set
+ * file and the checksum of the file content and the settings that
+ * influence the image (precision, reduced dimension).  If no valid image
+ * exists, the mixture set is read, the image is written and then mapped.
+ */
+struct MixtureSetImageLoader : public AbstractMixtureSetLoader {
+    static const Core::ParameterChoice paramPrecision;
+    static const Core::ParameterString paramCacheDirectory;
+
+    virtual Core::Ref<AbstractMixtureSet> load(const std::string&         filename,
+                                               const Core::Configuration& c) const;
+    virtual ~MixtureSetImageLoader() {}
+};
+
+}  // namespace Mm
+
+#endif  // _MM_MIXTURE_SET_IMAGE_HH
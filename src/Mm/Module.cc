@@ -18,8 +18,10 @@
 #include <Modules.hh>
 #include "FeatureScorerFactory.hh"
 #include "GaussDiagonalMaximumFeatureScorer.hh"
+#include "ImageFeatureScorer.hh"
 #include "MixtureSet.hh"
 #include "MixtureSetBuilder.hh"
+#include "MixtureSetImage.hh"
 #include "MixtureSetLoader.hh"
 #include "MixtureSetReader.hh"
 #include "SimdFeatureScorer.hh"
@@ -87,6 +89,9 @@ Module_::Module_()
     featureScorerFactory_->registerFeatureScorer<
             SimdGaussDiagonalMaximumFeatureScorer, MixtureSet, AbstractMixtureSetLoader>(
             simdDiagonalMaximum, "SIMD-diagonal-maximum");
+    featureScorerFactory_->registerFeatureScorer<
+            ImageGaussDiagonalMaximumFeatureScorer, MixtureSetImage, MixtureSetImageLoader>(
+            imageDiagonalMaximum, "image-diagonal-maximum");
 
 #ifdef MODULE_MM_BATCH
     featureScorerFactory_->registerFeatureScorer<
@@ -66,6 +66,7 @@ public:
         statePosterior,
         passThrough,
         hybridPassThrough,
+        imageDiagonalMaximum,
         invalidFeatureScorer /* add all valid feature scorers in Mm before this line */
     };
     // static const Core::Choice choiceFeatureScorerType;
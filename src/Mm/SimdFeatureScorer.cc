@@ -34,6 +34,13 @@ SimdGaussDiagonalMaximumFeatureScorer::Context::Context(const FeatureVector&
     }
 }
 
+Score SimdGaussDiagonalMaximumFeatureScorer::Context::scoreConcurrently(EmissionIndex e) const {
+    require_(0 <= e && e < nEmissions());
+    if (cache_.isCalculated(e))
+        return cache_[e].score;
+    return static_cast<const SimdGaussDiagonalMaximumFeatureScorer*>(featureScorer_)->calculateScoreAndDensity(this, e).score;
+}
+
 std::vector<SimdGaussDiagonalMaximumFeatureScorer::PreparedFeatureVector>
         SimdGaussDiagonalMaximumFeatureScorer::multiplyAndQuantize(const Mm::FeatureVector& featureVector) const {
     require(featureVector.size() == dimension());
@@ -57,7 +64,8 @@ std::vector<SimdGaussDiagonalMaximumFeatureScorer::PreparedFeatureVector>
 SimdGaussDiagonalMaximumFeatureScorer::SimdGaussDiagonalMaximumFeatureScorer(const Core::Configuration& c, Core::Ref<const MixtureSet> mixtureSet)
         : Core::Component(c),
           Precursor(c),
-          optimization_(select("code"), mixtureSet->dimension()) {
+          optimization_(c, mixtureSet->dimension()) {
+    log("using %s kernels", GaussianKernels::name(optimization_.kernels().instructionSet));
     init(*mixtureSet);
 }
 
@@ -145,15 +153,8 @@ AssigningFeatureScorer::ScoreAndBestDensity
 }
 
 /**
- * correctness:
- * Do not use floating point operations after optimization_.distance(),
- * but before calling optimization_.resetFloatingPointCalculation(), because
- * this may result in incorrect behaviour.
- *
- * efficiency:
- * For the sake of some processor types which can not switch quickly
- * from optimized integer modus to floating point modus,
- * use INTEGER OPERATIONS ONLY in this function!
+ * The distances are computed by the kernels of the instruction set chosen
+ * at startup (see GaussianKernels), use integer operations only here.
  */
 std::pair<int, DensityIndex> SimdGaussDiagonalMaximumFeatureScorer::quantizedScore(const MixtureElement&                     mixture,
                                                                                    const std::vector<PreparedFeatureVector>& featuresPerCovariance) const {
@@ -69,6 +69,13 @@ public:
         Context(const FeatureVector&                         featureVector,
                 const SimdGaussDiagonalMaximumFeatureScorer* featureScorer,
                 size_t                                       cacheSize);
+
+    public:
+        /** The quantized distance computation only reads the prepared feature vectors */
+        virtual bool supportsConcurrentScoring() const {
+            return true;
+        }
+        virtual Score scoreConcurrently(EmissionIndex e) const;
     };
 
     /**
@@ -20,6 +20,7 @@
 #include <Fsa/Determinize.hh>
 #include <Fsa/Project.hh>
 #include <Fsa/RemoveEpsilons.hh>
+#include <Fsa/Static.hh>
 #include <Math/Utilities.hh>
 #include <Speech/Types.hh>
 
@@ -139,13 +140,68 @@ static void make_single_final_state(std::vector<Fsa::StateId>& states, std::vect
 
 namespace Nn {
 
+AllophoneStateFsaExporter::~AllophoneStateFsaExporter() {
+    waitForPrefetch();
+}
+
 AllophoneStateFsaExporter::ExportedAutomaton AllophoneStateFsaExporter::exportFsaForOrthography(std::string const& orthography) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Fsa::ConstAutomatonRef      cached = cache_->find(orthography);
+    if (cached) {
+        return fromCachedAutomaton(cached);
+    }
+    ExportedAutomaton result = buildFsaForOrthography(orthography);
+    cache_->insert(orthography, toCachedAutomaton(result));
+    return result;
+}
+
+std::vector<AllophoneStateFsaExporter::ExportedAutomaton> AllophoneStateFsaExporter::exportFsasForOrthographies(std::vector<std::string> const& orthographies) {
+    waitForPrefetch();
+    std::vector<ExportedAutomaton> result;
+    result.reserve(orthographies.size());
+    for (std::string const& orthography : orthographies) {
+        auto it = prefetched_.find(orthography);
+        if (it != prefetched_.end()) {
+            result.push_back(it->second);
+        }
+        else {
+            result.push_back(exportFsaForOrthography(orthography));
+        }
+    }
+    prefetched_.clear();
+    return result;
+}
+
+void AllophoneStateFsaExporter::prefetch(std::vector<std::string> const& orthographies) {
+    waitForPrefetch();
+    prefetched_.clear();
+    prefetch_thread_ = std::thread([this, orthographies]() {
+        for (std::string const& orthography : orthographies) {
+            if (prefetched_.find(orthography) == prefetched_.end()) {
+                prefetched_[orthography] = exportFsaForOrthography(orthography);
+            }
+        }
+    });
+}
+
+void AllophoneStateFsaExporter::waitForPrefetch() {
+    if (prefetch_thread_.joinable()) {
+        prefetch_thread_.join();
+    }
+}
+
+AllophoneStateFsaExporter::ExportedAutomaton AllophoneStateFsaExporter::buildFsaForOrthography(std::string const& orthography) const {
     Core::Ref<Am::AcousticModel>   am    = mc_.acousticModel();
     Speech::AllophoneStateGraphRef graph = allophone_state_graph_builder_->build(orthography);
     graph                                = Fsa::projectInput(graph);
     graph                                = Fsa::removeDisambiguationSymbols(graph);
     graph                                = Fsa::removeEpsilons(graph);
     graph                                = Fsa::normalize(graph);
+    return exportGraph(graph, [&am](Fsa::LabelId label) { return am->emissionIndex(label); });
+}
+
+AllophoneStateFsaExporter::ExportedAutomaton AllophoneStateFsaExporter::exportGraph(
+        Fsa::ConstAutomatonRef graph, std::function<Am::AcousticModel::EmissionIndex(Fsa::LabelId)> const& emissionIndex) {
     // TODO: use Fsa::topologicalSort here, remove toposort below, cleanup
     Core::Ref<Fsa::StaticAutomaton> automaton = Fsa::staticCopy(graph);
     require_eq(automaton->initialStateId(), 0);
@@ -162,7 +218,7 @@ AllophoneStateFsaExporter::ExportedAutomaton AllophoneStateFsaExporter::exportFs
                 verify(automaton->hasState(a->target_));
                 if (Speech::Score(a->weight_) >= Core::Type<Speech::Score>::max)
                     continue;
-                edges.push_back(Edge(s, a->target_, am->emissionIndex(a->input_), Speech::Score(a->weight_)));
+                edges.push_back(Edge(s, a->target_, emissionIndex(a->input_), Speech::Score(a->weight_)));
             }
             if (state->isFinal()) {
                 final_states.push_back(std::make_pair(s, Speech::Score(state->weight())));
@@ -173,12 +229,16 @@ AllophoneStateFsaExporter::ExportedAutomaton AllophoneStateFsaExporter::exportFs
     toposort(states, final_states, edges);
     filter_edges(edges);
     make_single_final_state(states, final_states, edges);
+    // the edges to the new final state are appended, restore the order of cached automata
+    std::stable_sort(edges.begin(), edges.end(), &cmp_edges);
 
     ExportedAutomaton result;
-    result.num_states = states.size();
-    result.num_edges  = edges.size();
-    result.edges      = std::vector<u32>(edges.size() * 3ul);
-    result.weights    = std::vector<f32>(edges.size());
+    result.num_states  = states.size();
+    result.num_edges   = edges.size();
+    result.edges       = std::vector<u32>(edges.size() * 3ul);
+    result.weights     = std::vector<f32>(edges.size());
+    result.start_state = states.front();
+    result.end_state   = final_states.front().first;
 
     for (size_t e = 0ul; e < edges.size(); e++) {
         result.edges[e]                    = edges[e].from;
@@ -190,4 +250,53 @@ AllophoneStateFsaExporter::ExportedAutomaton AllophoneStateFsaExporter::exportFs
     return result;
 }
 
+Fsa::ConstAutomatonRef AllophoneStateFsaExporter::toCachedAutomaton(ExportedAutomaton const& exported) {
+    Fsa::StaticAutomaton* f = new Fsa::StaticAutomaton(Fsa::TypeAcceptor);
+    f->setSemiring(Fsa::LogSemiring);
+    for (Fsa::StateId s = 0u; s < exported.num_states; s++) {
+        f->setState(new Fsa::State(s));
+    }
+    f->setInitialStateId(exported.start_state);
+    f->setStateFinal(f->fastState(exported.end_state));
+    for (size_t e = 0ul; e < exported.num_edges; e++) {
+        f->fastState(exported.edges[e])->newArc(exported.edges[e + exported.num_edges],
+                                                Fsa::Weight(exported.weights[e]),
+                                                static_cast<Fsa::LabelId>(exported.edges[e + 2 * exported.num_edges]));
+    }
+    return Fsa::ConstAutomatonRef(f);
+}
+
+AllophoneStateFsaExporter::ExportedAutomaton AllophoneStateFsaExporter::fromCachedAutomaton(Fsa::ConstAutomatonRef automaton) {
+    Core::Ref<const Fsa::StaticAutomaton> f = Fsa::staticCopy(automaton);
+    std::vector<Edge>                     edges;
+    size_t                                num_states = f->maxStateId() + 1ul;
+    Fsa::StateId                          end_state  = 0u;
+    for (Fsa::StateId s = 0u; s < num_states; s++) {
+        verify(f->hasState(s));
+        Fsa::State const* state = f->fastState(s);
+        if (state->isFinal())
+            end_state = s;
+        for (Fsa::State::const_iterator a = state->begin(); a != state->end(); ++a) {
+            edges.push_back(Edge(s, a->target(), static_cast<Am::AcousticModel::EmissionIndex>(a->input()), f32(a->weight())));
+        }
+    }
+    // the arcs of each state are in the order of the exported edges
+    std::stable_sort(edges.begin(), edges.end(), &cmp_edges);
+
+    ExportedAutomaton result;
+    result.num_states  = num_states;
+    result.num_edges   = edges.size();
+    result.start_state = f->initialStateId();
+    result.end_state   = end_state;
+    result.edges.resize(edges.size() * 3ul);
+    result.weights.resize(edges.size());
+    for (size_t e = 0ul; e < edges.size(); e++) {
+        result.edges[e]                    = edges[e].from;
+        result.edges[e + edges.size()]     = edges[e].to;
+        result.edges[e + 2 * edges.size()] = edges[e].emission_idx;
+        result.weights[e]                  = edges[e].weight;
+    }
+    return result;
+}
+
 }  // namespace Nn
@@ -16,11 +16,26 @@
 #define NN_ALIGNMENTFSAEXPORTER_HH
 
 #include <Core/Component.hh>
+#include <Core/Dependency.hh>
 #include <Speech/AllophoneStateGraphBuilder.hh>
+#include <Speech/FsaCache.hh>
 #include <Speech/ModelCombination.hh>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace Nn {
 
+/**
+ * Exports allophone state automata as edge lists, e.g. for full-sum training.
+ *
+ * Exported automata are optionally stored in a persistent Speech::FsaCache
+ * (selection "fsa-cache") keyed by orthography; the cache is invalidated
+ * when the model dependencies change.  A batch of orthographies can be
+ * exported in advance on a background thread, see prefetch().
+ * All exports are serialized, so the exporter may be used from several threads.
+ */
 class AllophoneStateFsaExporter : Core::Component {
 public:
     typedef Core::Component Precursor;
@@ -30,6 +45,8 @@ public:
         size_t           num_edges;
         std::vector<u32> edges;  // contains from,to,emissionIdx, thus num_edges == edges.size() / 3 == weights.size()
         std::vector<f32> weights;
+        Fsa::StateId     start_state;
+        Fsa::StateId     end_state;
     };
 
     AllophoneStateFsaExporter(Core::Configuration const& config)
@@ -44,14 +61,55 @@ public:
                                                        mc_.lexicon(),
                                                        mc_.acousticModel(),
                                                        false));
+        cache_.reset(new Speech::FsaCache(select("fsa-cache"), Fsa::storeStates));
+        Core::DependencySet dependencies;
+        mc_.getDependencies(dependencies);
+        cache_->setDependencies(dependencies);
     };
-    ~AllophoneStateFsaExporter() {}
+    ~AllophoneStateFsaExporter();
 
     ExportedAutomaton exportFsaForOrthography(std::string const& orthography) const;
 
+    /**
+     * Export the automata of all orthographies, automata which have been
+     * prefetched are taken over without exporting them again.
+     */
+    std::vector<ExportedAutomaton> exportFsasForOrthographies(std::vector<std::string> const& orthographies);
+
+    /**
+     * Start exporting the automata of the orthographies on a background thread;
+     * the results are used by the next call of exportFsasForOrthographies(),
+     * which waits for the thread.  Unused results are discarded by that call.
+     */
+    void prefetch(std::vector<std::string> const& orthographies);
+
+    /**
+     * Edge list of an allophone state graph, whose input labels are mapped
+     * to emission indices by emissionIndex.  The edges are sorted by
+     * distance, target and source state.
+     */
+    static ExportedAutomaton exportGraph(Fsa::ConstAutomatonRef                                                graph,
+                                         std::function<Am::AcousticModel::EmissionIndex(Fsa::LabelId)> const& emissionIndex);
+
+    /**
+     * Conversion to and from the automata stored in the cache, i.e. acceptors
+     * over emission indices; fromCachedAutomaton(toCachedAutomaton(a)) equals
+     * a for all results of exportGraph().
+     */
+    static Fsa::ConstAutomatonRef toCachedAutomaton(ExportedAutomaton const& exported);
+    static ExportedAutomaton      fromCachedAutomaton(Fsa::ConstAutomatonRef automaton);
+
 private:
     Speech::ModelCombination                      mc_;
     Core::Ref<Speech::AllophoneStateGraphBuilder> allophone_state_graph_builder_;
+    std::unique_ptr<Speech::FsaCache>             cache_;
+
+    mutable std::mutex                                 mutex_;
+    std::thread                                        prefetch_thread_;
+    std::unordered_map<std::string, ExportedAutomaton> prefetched_;
+
+    ExportedAutomaton buildFsaForOrthography(std::string const& orthography) const;
+    void              waitForPrefetch();
 };
 
 }  // namespace Nn
@@ -150,25 +150,97 @@ template<typename T>
 void BufferedAlignedFeatureProcessor<T>::generateMiniBatch(std::vector<NnMatrix>& miniBatch,
                                                            Math::CudaVector<u32>& miniBatchAlignment,
                                                            std::vector<f64>&      miniBatchAlignmentWeights,
+                                                           NnVector&              weights,
                                                            u32                    batchSize) {
-    // resize mini batch alignment
+    resizeMiniBatchAlignment(miniBatchAlignment, miniBatchAlignmentWeights, weights, batchSize);
+    fillMiniBatchAlignment(miniBatchAlignment, miniBatchAlignmentWeights, weights, PrecursorBuffer::nProcessedFeatures_, batchSize);
+    PrecursorBuffer::generateMiniBatch(miniBatch, batchSize);
+}
+
+/**	Resize the mini-batch alignment and the frame weights, left in host mode.
+ *
+ *	May allocate GPU memory, therefore only called from the main thread.
+ */
+template<typename T>
+void BufferedAlignedFeatureProcessor<T>::resizeMiniBatchAlignment(Math::CudaVector<u32>& miniBatchAlignment,
+                                                                  std::vector<f64>&      miniBatchAlignmentWeights,
+                                                                  NnVector&              weights,
+                                                                  u32                    batchSize) {
     miniBatchAlignment.resize(batchSize, 0, true);
-    // fill mini batch alignment
     miniBatchAlignment.finishComputation(false);
-
     if (weightedAlignment_)
         miniBatchAlignmentWeights.resize(batchSize, 0);
+    weights.resize(batchSize, 0, true);
+    weights.finishComputation(false);
+}
 
+/**	Fill the alignment and the frame weights of the buffered features
+ *	firstFeature, ..., firstFeature + batchSize - 1 (in shuffled order, if shuffling).
+ */
+template<typename T>
+void BufferedAlignedFeatureProcessor<T>::fillMiniBatchAlignment(Math::CudaVector<u32>& miniBatchAlignment,
+                                                                std::vector<f64>&      miniBatchAlignmentWeights,
+                                                                NnVector&              weights,
+                                                                u32                    firstFeature,
+                                                                u32                    batchSize) {
     for (u32 i = 0; i < batchSize; i++) {
-        u32 alignmentIndex = PrecursorBuffer::nProcessedFeatures_ + i;
+        u32 alignmentIndex = firstFeature + i;
         if (PrecursorBuffer::shuffle_) {
             alignmentIndex = PrecursorBuffer::shuffledIndices_.at(alignmentIndex);
         }
         miniBatchAlignment.at(i) = alignmentBuffer_.at(alignmentIndex);
-        if (weightedAlignment_)
+        // weight vectors according to class membership
+        weights.at(i) = classWeights_.at(miniBatchAlignment.at(i));
+        // additionally weight vectors according to alignment weights
+        if (weightedAlignment_) {
             miniBatchAlignmentWeights.at(i) = alignmentWeightsBuffer_.at(alignmentIndex);
+            weights.at(i) *= miniBatchAlignmentWeights.at(i);
+        }
     }
-    PrecursorBuffer::generateMiniBatch(miniBatch, batchSize);
+}
+
+template<typename T>
+void BufferedAlignedFeatureProcessor<T>::trainMiniBatchWithAlignment(std::vector<NnMatrix>& miniBatch,
+                                                                     Math::CudaVector<u32>& miniBatchAlignment,
+                                                                     NnVector&              weights,
+                                                                     u32                    batchSize) {
+    // initialize trainer (trainer checks if initialization is needed)
+    if (!PrecursorBuffer::trainer_->isInitialized())
+        initTrainer(miniBatch);
+    // process mini batch
+    PrecursorBuffer::trainer_->processBatch_feedInput(miniBatch, &weights, PrecursorBuffer::getCurSegment());
+    PrecursorBuffer::trainer_->processBatch_finishWithAlignment(miniBatchAlignment);
+    PrecursorBuffer::nProcessedMiniBatches_++;
+    PrecursorBuffer::nProcessedFeatures_ += batchSize;
+}
+
+template<typename T>
+void BufferedAlignedFeatureProcessor<T>::resizePrefetchSlot(u32 slot, u32 batchSize) {
+    PrecursorBuffer::resizePrefetchSlot(slot, batchSize);
+    const u32 ringSize = PrecursorBuffer::prefetchRing_.size();
+    prefetchAlignments_.resize(ringSize);
+    prefetchAlignmentWeights_.resize(ringSize);
+    prefetchWeights_.resize(ringSize);
+    resizeMiniBatchAlignment(prefetchAlignments_.at(slot), prefetchAlignmentWeights_.at(slot), prefetchWeights_.at(slot), batchSize);
+}
+
+template<typename T>
+void BufferedAlignedFeatureProcessor<T>::fillPrefetchSlot(u32 slot, u32 firstFeature, u32 batchSize) {
+    fillMiniBatchAlignment(prefetchAlignments_[slot], prefetchAlignmentWeights_[slot], prefetchWeights_[slot], firstFeature, batchSize);
+    PrecursorBuffer::fillPrefetchSlot(slot, firstFeature, batchSize);
+}
+
+template<typename T>
+void BufferedAlignedFeatureProcessor<T>::trainPrefetchSlot(u32 slot, u32 batchSize) {
+    std::vector<NnMatrix>& miniBatch = PrecursorBuffer::prefetchRing_.at(slot);
+    trainMiniBatchWithAlignment(miniBatch, prefetchAlignments_.at(slot), prefetchWeights_.at(slot), batchSize);
+    if (PrecursorBuffer::trainer_->measuresTime())
+        PrecursorBuffer::trainer_->logBatchTimes();
+    // release the slot to the producer
+    for (u32 stream = 0; stream < miniBatch.size(); stream++)
+        miniBatch.at(stream).finishComputation(false);
+    prefetchAlignments_.at(slot).finishComputation(false);
+    prefetchWeights_.at(slot).finishComputation(false);
 }
 
 template<typename T>
@@ -200,35 +272,16 @@ void BufferedAlignedFeatureProcessor<T>::processBuffer() {
     Math::CudaVector<u32> miniBatchAlignment;
     std::vector<f64>      miniBatchAlignmentWeights;
     NnVector              weights;
+    if (PrecursorBuffer::prefetchBatches_ > 0 && PrecursorBuffer::nProcessedFeatures_ + 2 * PrecursorBuffer::batchSize_ <= PrecursorBuffer::nBufferedFeatures_)
+        PrecursorBuffer::processPrefetchedMiniBatches();
     while (PrecursorBuffer::nProcessedFeatures_ + PrecursorBuffer::batchSize_ <= PrecursorBuffer::nBufferedFeatures_) {
         log("Process mini-batch ") << PrecursorBuffer::nProcessedMiniBatches_ + 1 << " with " << PrecursorBuffer::batchSize_
                                    << " features";
         f64 timeMinibatch = 0, timeGenerateMiniBatch = 0;
         TIMER_START(startBatch);
-        generateMiniBatch(miniBatch, miniBatchAlignment, miniBatchAlignmentWeights, PrecursorBuffer::batchSize_);
-        // determine weights for the mini batch features
-        weights.resize(miniBatchAlignment.size(), 0, true);
-        weights.finishComputation(false);
-        // weight vectors according to class membership
-        for (u32 index = 0; index < weights.size(); index++) {
-            weights.at(index) = classWeights_.at(miniBatchAlignment.at(index));
-        }
-        // additionally weight vectors according to alignment weights
-        if (weightedAlignment_) {
-            for (u32 index = 0; index < weights.size(); index++) {
-                weights.at(index) *= miniBatchAlignmentWeights.at(index);
-            }
-        }
+        generateMiniBatch(miniBatch, miniBatchAlignment, miniBatchAlignmentWeights, weights, PrecursorBuffer::batchSize_);
         TIMER_GPU_STOP(startBatch, end, measureTime, timeGenerateMiniBatch)
-        // initialize trainer (trainer checks if initialization is needed)
-        if (!PrecursorBuffer::trainer_->isInitialized())
-            initTrainer(miniBatch);
-
-        // process mini batch
-        PrecursorBuffer::trainer_->processBatch_feedInput(miniBatch, &weights, PrecursorBuffer::getCurSegment());
-        PrecursorBuffer::trainer_->processBatch_finishWithAlignment(miniBatchAlignment);
-        PrecursorBuffer::nProcessedMiniBatches_++;
-        PrecursorBuffer::nProcessedFeatures_ += PrecursorBuffer::batchSize_;
+        trainMiniBatchWithAlignment(miniBatch, miniBatchAlignment, weights, PrecursorBuffer::batchSize_);
         TIMER_GPU_STOP(startBatch, endBatch, measureTime, timeMinibatch)
         if (measureTime) {
             log("time for generating mini-batch: ") << timeGenerateMiniBatch;
@@ -242,30 +295,9 @@ void BufferedAlignedFeatureProcessor<T>::processBuffer() {
     u32 nRemainingFeatures = this->nBufferedFeatures_ - this->nProcessedFeatures_;
     if (this->processRemainingFeatures_ && nRemainingFeatures > 0) {
         log("Process mini-batch ") << this->nProcessedMiniBatches_ + 1 << " with " << nRemainingFeatures << " features.";
-        generateMiniBatch(miniBatch, miniBatchAlignment, miniBatchAlignmentWeights, nRemainingFeatures);
-        // determine weights for the mini batch features
-        weights.resize(miniBatchAlignment.size(), 0, true);
-        weights.finishComputation(false);
-        // weight vectors according to class membership
-        for (u32 index = 0; index < weights.size(); index++) {
-            weights.at(index) = classWeights_.at(miniBatchAlignment.at(index));
-        }
-        // additionally weight vectors according to alignment weights
-        if (weightedAlignment_) {
-            for (u32 index = 0; index < weights.size(); index++) {
-                weights.at(index) *= miniBatchAlignmentWeights.at(index);
-            }
-        }
-
+        generateMiniBatch(miniBatch, miniBatchAlignment, miniBatchAlignmentWeights, weights, nRemainingFeatures);
         this->trainer_->setBatchSize(nRemainingFeatures);
-        // initialize trainer
-        if (!this->trainer_->isInitialized())
-            initTrainer(miniBatch);
-        // process mini batch
-        PrecursorBuffer::trainer_->processBatch_feedInput(miniBatch, &weights, PrecursorBuffer::getCurSegment());
-        PrecursorBuffer::trainer_->processBatch_finishWithAlignment(miniBatchAlignment);
-        this->nProcessedMiniBatches_++;
-        this->nProcessedFeatures_ += nRemainingFeatures;
+        trainMiniBatchWithAlignment(miniBatch, miniBatchAlignment, weights, nRemainingFeatures);
         // reset to old batch size
         this->trainer_->setBatchSize(this->batchSize_);
     }
@@ -38,6 +38,8 @@ namespace Nn {
  *	The class combines the "BufferedFeatureExtractor" and the "AlignedFeatureProcessor"
  *	and provides the buffered processing of the features and alignment .
  *	This should be used by Speech::AligningFeatureExtractor.
+ *	With prefetch-batches > 0, the alignment and the frame weights of a mini-batch
+ *	are generated on the producer thread together with its features.
  */
 template<class T>
 class BufferedAlignedFeatureProcessor : protected BufferedFeatureExtractor<T>, public Speech::AlignedFeatureProcessor {
@@ -65,6 +67,11 @@ protected:
     std::vector<Mm::Weight> alignmentWeightsBuffer_;  // buffer for weights from the alignment
     bool                    weightedAlignment_;
 
+    // alignment, alignment weights and frame weights of the prefetch ring slots
+    std::vector<Math::CudaVector<u32>> prefetchAlignments_;
+    std::vector<std::vector<f64>>      prefetchAlignmentWeights_;
+    std::vector<NnVector>              prefetchWeights_;
+
 public:
     BufferedAlignedFeatureProcessor(const Core::Configuration& config, bool loadFromFile = true);
     virtual ~BufferedAlignedFeatureProcessor();
@@ -76,7 +83,10 @@ protected:
     virtual void initBuffer(Core::Ref<const Speech::Feature> f);
     virtual void resetBuffer();
     virtual void processBuffer();
-    virtual void generateMiniBatch(std::vector<NnMatrix>& miniBatch, Math::CudaVector<u32>& miniBatchAlignment, std::vector<f64>& miniBatchAlignmentWeights, u32 batchSize);
+    virtual void generateMiniBatch(std::vector<NnMatrix>& miniBatch, Math::CudaVector<u32>& miniBatchAlignment, std::vector<f64>& miniBatchAlignmentWeights, NnVector& weights, u32 batchSize);
+    virtual void resizePrefetchSlot(u32 slot, u32 batchSize);
+    virtual void fillPrefetchSlot(u32 slot, u32 firstFeature, u32 batchSize);
+    virtual void trainPrefetchSlot(u32 slot, u32 batchSize);
     virtual void processAlignedFeature(Core::Ref<const Speech::Feature> f, Am::AllophoneStateIndex e);
     virtual void processAlignedFeature(Core::Ref<const Speech::Feature> f, Am::AllophoneStateIndex e, Mm::Weight w);
 
@@ -90,6 +100,10 @@ public:
 
 protected:
     Mm::EmissionIndex classIndex(Am::AllophoneStateIndex e) const;
+    // fillMiniBatchAlignment() only reads the buffer and may run on the producer thread
+    void resizeMiniBatchAlignment(Math::CudaVector<u32>& miniBatchAlignment, std::vector<f64>& miniBatchAlignmentWeights, NnVector& weights, u32 batchSize);
+    void fillMiniBatchAlignment(Math::CudaVector<u32>& miniBatchAlignment, std::vector<f64>& miniBatchAlignmentWeights, NnVector& weights, u32 firstFeature, u32 batchSize);
+    void trainMiniBatchWithAlignment(std::vector<NnMatrix>& miniBatch, Math::CudaVector<u32>& miniBatchAlignment, NnVector& weights, u32 batchSize);
 
 public:
     virtual NeuralNetworkTrainer<T>* createTrainer(const Core::Configuration& config);
@@ -13,6 +13,8 @@
  *  limitations under the License.
  */
 #include <BufferedFeatureExtractor.hh>
+#include <Core/Utility.hh>
+#include <Math/CudaWrapper.hh>
 #include <Math/Random.hh>
 #include <Speech/DataSource.hh>
 
@@ -58,6 +60,10 @@ template<typename T>
 const Core::ParameterInt BufferedFeatureExtractor<T>::paramSlidingWindowSizeDerivatives(
         "window-size-derivatives", "Size of sliding window for derivatives (first + first component of second)", 0);
 
+template<typename T>
+const Core::ParameterInt BufferedFeatureExtractor<T>::paramPrefetchBatches(
+        "prefetch-batches", "Number of mini-batches generated in advance on a separate thread, 0 to disable", 0, 0);
+
 template<typename T>
 BufferedFeatureExtractor<T>::BufferedFeatureExtractor(const Core::Configuration& config, bool loadFromFile)
         : Core::Component(config),
@@ -80,12 +86,22 @@ BufferedFeatureExtractor<T>::BufferedFeatureExtractor(const Core::Configuration&
           shuffledIndices_(0),
           processRemainingFeatures_(false),
           needInit_(true),
+          prefetchBatches_(paramPrefetchBatches(config)),
+          prefetchRing_(),
+          nPrefetchedMiniBatches_(0),
+          nReleasedMiniBatches_(0),
+          dataTime_(0),
+          computeTime_(0),
           nProcessedMiniBatches_(0),
           totalNumberOfProcessedMiniBatches_(0),
           trainer_(0) {
     if (regressionWindowSize_ % 2 != 1) {
         this->error("regression window size must be an odd number but is ") << regressionWindowSize_;
     }
+    if (bufferType_ == utterance && prefetchBatches_ > 0) {
+        this->warning("prefetch-batches is ignored with an utterance buffer, each utterance is a single mini-batch");
+        prefetchBatches_ = 0;
+    }
     logProperties();
     if (shuffle_) {
         s32 seed = paramShuffleBufferSeed(config);
@@ -101,6 +117,8 @@ BufferedFeatureExtractor<T>::BufferedFeatureExtractor(const Core::Configuration&
 
 template<typename T>
 BufferedFeatureExtractor<T>::~BufferedFeatureExtractor() {
+    if (prefetchThread_.joinable())
+        prefetchThread_.join();
     if (trainer_)
         delete trainer_;
 }
@@ -203,6 +221,8 @@ void BufferedFeatureExtractor<T>::resetBuffer() {
     // used for indexing in buffer
     nProcessedFeatures_    = 0;
     nProcessedMiniBatches_ = 0;
+    dataTime_              = 0;
+    computeTime_           = 0;
 }
 
 /**	Update the feature buffer at index.
@@ -366,18 +386,37 @@ void BufferedFeatureExtractor<T>::computeSecondDerivative(u32 streamIndex, u32 i
 
 template<typename T>
 void BufferedFeatureExtractor<T>::generateMiniBatch(std::vector<NnMatrix>& miniBatch, u32 batchSize) {
+    resizeMiniBatch(miniBatch, batchSize);
+    fillMiniBatch(miniBatch, nProcessedFeatures_, batchSize);
+}
+
+/**	Resize the mini-batch to the number of input streams and the windowed feature dimensions.
+ *
+ *	May allocate GPU memory, therefore only called from the main thread.
+ *	The mini-batch is left in host mode, ready to be filled.
+ */
+template<typename T>
+void BufferedFeatureExtractor<T>::resizeMiniBatch(std::vector<NnMatrix>& miniBatch, u32 batchSize) {
     // resize mini batch to number of input streams
     miniBatch.resize(featureBuffer_.size());
     // resize each stream to correct size
     for (u32 streamIndex = 0; streamIndex < miniBatch.size(); streamIndex++) {
         u32 featureDim = slidingWindowSize_ * featureBuffer_.at(streamIndex).nRows() + slidingWindowSizeDerivatives_ * (featureBuffer_.at(streamIndex).nRows() + 1);
         miniBatch.at(streamIndex).resize(featureDim, batchSize);
+        miniBatch.at(streamIndex).finishComputation(false);
     }
-    // fill mini batch
+}
+
+/**	Fill the columns of a resized mini-batch with the buffered features
+ *	firstFeature, ..., firstFeature + batchSize - 1 (in shuffled order, if shuffling).
+ *
+ *	Only reads the buffer and writes the host memory of the mini-batch.
+ */
+template<typename T>
+void BufferedFeatureExtractor<T>::fillMiniBatch(std::vector<NnMatrix>& miniBatch, u32 firstFeature, u32 batchSize) {
     for (u32 streamIndex = 0; streamIndex < miniBatch.size(); streamIndex++) {
-        miniBatch.at(streamIndex).finishComputation(false);
         for (u32 column = 0; column < batchSize; column++) {
-            u32 featureIndex = nProcessedFeatures_ + column;
+            u32 featureIndex = firstFeature + column;
             if (shuffle_) {
                 verify_lt(featureIndex, shuffledIndices_.size());
                 featureIndex = shuffledIndices_.at(featureIndex);
@@ -422,26 +461,135 @@ void BufferedFeatureExtractor<T>::prepareProcessBuffer() {
     }
 }
 
+template<typename T>
+void BufferedFeatureExtractor<T>::trainMiniBatch(std::vector<NnMatrix>& miniBatch, u32 batchSize) {
+    // initialize trainer
+    if (!trainer_->isInitialized()) {
+        std::vector<u32> streamSizes;
+        for (u32 stream = 0; stream < miniBatch.size(); stream++)
+            streamSizes.push_back(miniBatch.at(stream).nRows());
+        trainer_->initializeTrainer(batchSize, streamSizes);
+    }
+    // process mini batch
+    trainer_->processBatch_feedInput(miniBatch, NULL, getCurSegment());
+    trainer_->processBatch_finish();
+    nProcessedMiniBatches_++;
+    nProcessedFeatures_ += batchSize;
+}
+
+template<typename T>
+void BufferedFeatureExtractor<T>::logMiniBatchTimes(f64 dataTime, f64 computeTime) const {
+    if (trainer_->measuresTime())
+        log("mini-batch ") << nProcessedMiniBatches_ << ": data wait " << dataTime << "s, compute " << computeTime << "s";
+}
+
+/**	Producer thread: generate nMiniBatches full mini-batches, starting at buffer position firstFeature.
+ *
+ *	Mini-batch i is written to ring slot i % ring size, as soon as the trainer
+ *	has released the mini-batch previously stored there.
+ */
+template<typename T>
+void BufferedFeatureExtractor<T>::prefetchMiniBatches(u32 firstFeature, u32 nMiniBatches) {
+    const u32 ringSize = prefetchRing_.size();
+    for (u32 i = 0; i < nMiniBatches; i++) {
+        {
+            std::unique_lock<std::mutex> lock(prefetchMutex_);
+            prefetchCondition_.wait(lock, [this, i, ringSize]() { return i < nReleasedMiniBatches_ + ringSize; });
+        }
+        fillPrefetchSlot(i % ringSize, firstFeature + i * batchSize_, batchSize_);
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex_);
+            nPrefetchedMiniBatches_ = i + 1;
+        }
+        prefetchCondition_.notify_all();
+    }
+}
+
+/**	Process all full mini-batches of the buffer, while the next
+ *	prefetch-batches mini-batches are generated on the producer thread.
+ *
+ *	The buffer (features, derivatives, shuffled indices) must not be
+ *	changed until all mini-batches are processed.
+ */
+template<typename T>
+void BufferedFeatureExtractor<T>::processPrefetchedMiniBatches() {
+    const u32 nMiniBatches = (nBufferedFeatures_ - nProcessedFeatures_) / batchSize_;
+    timeval   start, end;
+
+    // GPU memory is allocated on the main thread only
+    prefetchRing_.resize(prefetchBatches_ + 1);
+    for (u32 slot = 0; slot < prefetchRing_.size(); slot++)
+        resizePrefetchSlot(slot, batchSize_);
+
+    nPrefetchedMiniBatches_ = 0;
+    nReleasedMiniBatches_   = 0;
+    prefetchThread_         = std::thread(&BufferedFeatureExtractor<T>::prefetchMiniBatches, this, nProcessedFeatures_, nMiniBatches);
+
+    for (u32 i = 0; i < nMiniBatches; i++) {
+        f64 dataTime = 0, computeTime = 0;
+        TIMER_START(start);
+        {
+            std::unique_lock<std::mutex> lock(prefetchMutex_);
+            prefetchCondition_.wait(lock, [this, i]() { return i < nPrefetchedMiniBatches_; });
+        }
+        TIMER_STOP(start, end, dataTime);
+        log("Process mini-batch ") << nProcessedMiniBatches_ + 1 << " with " << batchSize_ << " features.";
+        TIMER_START(start);
+        trainPrefetchSlot(i % prefetchRing_.size(), batchSize_);
+        TIMER_GPU_STOP(start, end, trainer_->measuresTime(), computeTime);
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex_);
+            nReleasedMiniBatches_ = i + 1;
+        }
+        prefetchCondition_.notify_all();
+        dataTime_ += dataTime;
+        computeTime_ += computeTime;
+        logMiniBatchTimes(dataTime, computeTime);
+    }
+    prefetchThread_.join();
+}
+
+template<typename T>
+void BufferedFeatureExtractor<T>::resizePrefetchSlot(u32 slot, u32 batchSize) {
+    resizeMiniBatch(prefetchRing_.at(slot), batchSize);
+}
+
+template<typename T>
+void BufferedFeatureExtractor<T>::fillPrefetchSlot(u32 slot, u32 firstFeature, u32 batchSize) {
+    fillMiniBatch(prefetchRing_[slot], firstFeature, batchSize);
+}
+
+/**	Train on the mini-batch of a ring slot and release the slot to the producer,
+ *	i.e. leave it in host mode again.
+ */
+template<typename T>
+void BufferedFeatureExtractor<T>::trainPrefetchSlot(u32 slot, u32 batchSize) {
+    std::vector<NnMatrix>& miniBatch = prefetchRing_.at(slot);
+    trainMiniBatch(miniBatch, batchSize);
+    for (u32 stream = 0; stream < miniBatch.size(); stream++)
+        miniBatch.at(stream).finishComputation(false);
+}
+
 template<typename T>
 void BufferedFeatureExtractor<T>::processBuffer() {
     prepareProcessBuffer();
     std::vector<NnMatrix> miniBatch;
+    timeval               start, end;
 
+    if (prefetchBatches_ > 0 && nProcessedFeatures_ + 2 * batchSize_ <= nBufferedFeatures_)
+        processPrefetchedMiniBatches();
     while (nProcessedFeatures_ + batchSize_ <= nBufferedFeatures_) {
+        f64 dataTime = 0, computeTime = 0;
+        TIMER_START(start);
         generateMiniBatch(miniBatch, batchSize_);
+        TIMER_STOP(start, end, dataTime);
         log("Process mini-batch ") << nProcessedMiniBatches_ + 1 << " with " << miniBatch.at(0).nColumns() << " features.";
-        // initialize trainer
-        if (!trainer_->isInitialized()) {
-            std::vector<u32> streamSizes;
-            for (u32 stream = 0; stream < miniBatch.size(); stream++)
-                streamSizes.push_back(miniBatch.at(stream).nRows());
-            trainer_->initializeTrainer(batchSize_, streamSizes);
-        }
-        // process mini batch
-        trainer_->processBatch_feedInput(miniBatch, NULL, getCurSegment());
-        trainer_->processBatch_finish();
-        nProcessedMiniBatches_++;
-        nProcessedFeatures_ += batchSize_;
+        TIMER_START(start);
+        trainMiniBatch(miniBatch, batchSize_);
+        TIMER_GPU_STOP(start, end, trainer_->measuresTime(), computeTime);
+        dataTime_ += dataTime;
+        computeTime_ += computeTime;
+        logMiniBatchTimes(dataTime, computeTime);
     }
     // process the remaining feature with a smaller mini batch
     // only done for algorithms where the mini batch size is not critical
@@ -450,18 +598,7 @@ void BufferedFeatureExtractor<T>::processBuffer() {
         generateMiniBatch(miniBatch, nRemainingFeatures);
         log("Process mini-batch ") << nProcessedMiniBatches_ + 1 << " with " << miniBatch.at(0).nColumns() << " features.";
         trainer_->setBatchSize(nRemainingFeatures);
-        // initialize trainer
-        if (!trainer_->isInitialized()) {
-            std::vector<u32> streamSizes;
-            for (u32 stream = 0; stream < miniBatch.size(); stream++)
-                streamSizes.push_back(miniBatch.at(stream).nRows());
-            trainer_->initializeTrainer(nRemainingFeatures, streamSizes);
-        }
-        // process mini batch
-        trainer_->processBatch_feedInput(miniBatch, NULL, getCurSegment());
-        trainer_->processBatch_finish();
-        nProcessedMiniBatches_++;
-        nProcessedFeatures_ += nRemainingFeatures;
+        trainMiniBatch(miniBatch, nRemainingFeatures);
         // reset to old batch size
         trainer_->setBatchSize(batchSize_);
     }
@@ -472,6 +609,8 @@ template<typename T>
 void BufferedFeatureExtractor<T>::finalizeProcessBuffer() {
     log("Processed ") << nProcessedFeatures_ << " features. " << (nBufferedFeatures_ - nProcessedFeatures_)
                       << " remain unprocessed.";
+    if (nProcessedMiniBatches_ > 0)
+        log("Time for mini-batches of this buffer: data wait ") << dataTime_ << "s, compute " << computeTime_ << "s";
     totalNumberOfProcessedMiniBatches_ += nProcessedMiniBatches_;
     // reset the buffer
     resetBuffer();
@@ -563,6 +702,8 @@ void BufferedFeatureExtractor<T>::logProperties() const {
     this->log("regression window size for computation of derivative features is ") << regressionWindowSize_;
     this->log("sliding window size for computation of windowed features is ") << slidingWindowSize_;
     this->log("sliding window size for computation of windowed derivative features is ") << slidingWindowSizeDerivatives_;
+    if (prefetchBatches_ > 0)
+        this->log("generating ") << prefetchBatches_ << " mini-batches in advance";
     if (shuffle_)
         this->log("shuffling buffer");
     else
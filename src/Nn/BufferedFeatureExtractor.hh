@@ -20,7 +20,10 @@
 #include <Speech/CorpusVisitor.hh>
 #include <Speech/DataExtractor.hh>  // non supervised training (only features)
 #include <Speech/Feature.hh>        // speech feature types
+#include <condition_variable>
+#include <mutex>
 #include <random>
+#include <thread>
 
 #include "NeuralNetworkLayer.hh"
 #include "NeuralNetworkTrainer.hh"
@@ -33,6 +36,12 @@ namespace Nn {
  *	Samples/features are collected in a buffer before they are processed.
  *	Shuffling the data is possible.
  *
+ *	With prefetch-batches > 0, the mini-batches of a buffer are generated on a
+ *	producer thread into a ring of prefetch-batches + 1 preallocated mini-batches,
+ *	while the trainer processes the current one (see processPrefetchedMiniBatches()).
+ *	Subclasses which buffer more than the features (e.g. an alignment) extend the
+ *	ring slots via resizePrefetchSlot(), fillPrefetchSlot() and trainPrefetchSlot().
+ *	Prefetching is disabled for utterance buffers, which are a single mini-batch.
  */
 template<class T>
 class BufferedFeatureExtractor : public Speech::FeatureExtractor {
@@ -59,6 +68,7 @@ protected:
     static const Core::ParameterInt    paramRegressionWindowSize;
     static const Core::ParameterInt    paramSlidingWindowSize;
     static const Core::ParameterInt    paramSlidingWindowSizeDerivatives;
+    static const Core::ParameterInt    paramPrefetchBatches;
 
     const BufferType bufferType_; /** Type of the buffer (single, batch, sequence)*/
     const u32        regressionWindowSize_;
@@ -86,6 +96,16 @@ protected:
 
     bool needInit_; /** Flag to check for buffer initialization */
 
+    u32                                prefetchBatches_; /** Number of mini-batches generated in advance, 0: no prefetching */
+    std::vector<std::vector<NnMatrix>> prefetchRing_;    /** Preallocated mini-batches filled by the producer thread */
+    std::thread                        prefetchThread_;
+    std::mutex                         prefetchMutex_;
+    std::condition_variable            prefetchCondition_;
+    u32                                nPrefetchedMiniBatches_; /** Mini-batches of the current buffer generated by the producer */
+    u32                                nReleasedMiniBatches_;   /** Mini-batches of the current buffer returned to the ring */
+    f64                                dataTime_;    /** Time spent generating or waiting for mini-batches since resetBuffer */
+    f64                                computeTime_; /** Time spent in the trainer since resetBuffer */
+
 protected:
     u32                      nProcessedMiniBatches_;             /** number of processed mini-batches, reset at resetBuffer */
     u32                      totalNumberOfProcessedMiniBatches_; /** not reset until corpus completely processed */
@@ -149,6 +169,17 @@ public:
     virtual void generateMiniBatch(std::vector<NnMatrix>& miniBatch, u32 batchSize);
     virtual void initShuffle(); /** Initialize the shuffling */
 protected:
+    // mini-batch generation, fillMiniBatch() only reads the buffer and may run on the producer thread
+    void resizeMiniBatch(std::vector<NnMatrix>& miniBatch, u32 batchSize);
+    void fillMiniBatch(std::vector<NnMatrix>& miniBatch, u32 firstFeature, u32 batchSize);
+    void trainMiniBatch(std::vector<NnMatrix>& miniBatch, u32 batchSize);
+    void processPrefetchedMiniBatches();
+    // ring slots of processPrefetchedMiniBatches(), fillPrefetchSlot() runs on the producer thread
+    virtual void resizePrefetchSlot(u32 slot, u32 batchSize);
+    virtual void fillPrefetchSlot(u32 slot, u32 firstFeature, u32 batchSize);
+    virtual void trainPrefetchSlot(u32 slot, u32 batchSize);
+    void prefetchMiniBatches(u32 firstFeature, u32 nMiniBatches);
+    void logMiniBatchTimes(f64 dataTime, f64 computeTime) const;
     // internal methods for feature computation
     void setWindowedFeature(u32 streamIndex, u32 indexInBuffer, u32 indexInMiniBatch, NnMatrix& miniBatch);
     void setWindowedFeatureDerivatives(u32 streamIndex, u32 indexInBuffer, u32 indexInMiniBatch, NnMatrix& miniBatch);
@@ -27,6 +27,7 @@
 #endif
 #include "BatchFeatureScorer.hh"
 #include "FeatureScorer.hh"
+#include "MultiStreamFeatureScorer.hh"
 #include "NeuralNetworkForwardNode.hh"
 #include "TrainerFeatureScorer.hh"
 #endif
@@ -54,6 +55,8 @@ Module_::Module_()
             nnBatchFeatureScorer, "nn-batch-feature-scorer");
     Mm::Module::instance().featureScorerFactory()->registerFeatureScorer<TrainerFeatureScorer, Mm::MixtureSet, Mm::AbstractMixtureSetLoader>(
             nnTrainerFeatureScorer, "nn-trainer-feature-scorer");
+    Mm::Module::instance().featureScorerFactory()->registerFeatureScorer<MultiStreamFeatureScorer, Mm::MixtureSet, Mm::AbstractMixtureSetLoader>(
+            nnMultiStream, "nn-multi-stream");
 #endif
 #ifdef MODULE_NN_SEQUENCE_TRAINING
     Mm::Module::instance().featureScorerFactory()->registerFeatureScorer<CachedNeuralNetworkFeatureScorer, Mm::MixtureSet, Mm::AbstractMixtureSetLoader>(
@@ -42,6 +42,7 @@ public:
         nnCached               = FeatureScorerTypeOffset + 4,
         nnTrainerFeatureScorer = FeatureScorerTypeOffset + 5,
         pythonFeatureScorer    = FeatureScorerTypeOffset + 6,
+        nnMultiStream          = FeatureScorerTypeOffset + 7,
     };
 
     /** Set of file format class.
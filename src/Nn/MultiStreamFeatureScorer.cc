@@ -0,0 +1,183 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "MultiStreamFeatureScorer.hh"
+
+#include <Math/Module.hh>
+#include "LinearAndActivationLayer.hh"
+
+using namespace Nn;
+
+const Core::ParameterInt MultiStreamFeatureScorer::paramMaxBatchSize(
+        "max-batch-size", "maximum number of frames (of different streams) forwarded together", 64, 1);
+
+const Core::ParameterFloat MultiStreamFeatureScorer::paramMaxLatency(
+        "max-latency", "maximum time in milliseconds a frame waits for frames of other streams", 5.0, 0.0);
+
+MultiStreamFeatureScorer::MultiStreamFeatureScorer(const Core::Configuration& c, Core::Ref<const Mm::MixtureSet> mixtureSet)
+        : Core::Component(c),
+          Precursor(c),
+          maxBatchSize_(paramMaxBatchSize(c)),
+          maxLatency_(s64(paramMaxLatency(c) * 1000)),
+          prior_(c),
+          labelWrapper_(0),
+          nClasses_(0),
+          inputDimension_(0),
+          network_(c),
+          nBatches_(0),
+          nFrames_(0),
+          nDeadlineBatches_(0) {
+    init(mixtureSet);
+}
+
+MultiStreamFeatureScorer::~MultiStreamFeatureScorer() {
+    logStatistics();
+    delete labelWrapper_;
+}
+
+void MultiStreamFeatureScorer::init(Core::Ref<const Mm::MixtureSet> mixtureSet) {
+    log("initialize nn-multi-stream feature scorer with maximum batch size %d", maxBatchSize_);
+    nClasses_ = mixtureSet->nMixtures();
+
+    labelWrapper_ = new ClassLabelWrapper(select("class-labels"), nClasses_);
+    if (!labelWrapper_->isOneToOneMapping())
+        error("no one-to-one correspondence between network outputs and classes!");
+    outputIndex_.resize(nClasses_, -1);
+    for (u32 c = 0; c < nClasses_; ++c) {
+        if (labelWrapper_->isClassToAccumulate(c))
+            outputIndex_[c] = labelWrapper_->getOutputIndexFromClassIndex(c);
+    }
+
+    // the activations are allocated for the largest batch
+    network_.initializeNetwork(maxBatchSize_);
+    require_eq(network_.getTopLayer().getOutputDimension(), labelWrapper_->nClassesToAccumulate());
+    LinearAndSoftmaxLayer<f32>* topLayer = dynamic_cast<LinearAndSoftmaxLayer<f32>*>(&network_.getTopLayer());
+    if (!topLayer)
+        criticalError("output layer must be of type 'linear+softmax'");
+    if (network_.isRecurrent())
+        criticalError("recurrent networks keep state per stream and are not supported by the multi-stream feature scorer");
+    topLayer->setEvaluateSoftmax(false);
+    if (network_.getLayer(0).nInputActivations() != 1)
+        criticalError("Multiple input streams not implemented in MultiStreamFeatureScorer.");
+    inputDimension_ = network_.getLayer(0).getInputDimension(0);
+
+    if (prior_.fileName() != "")
+        prior_.read();
+    else
+        prior_.setFromMixtureSet(mixtureSet, *labelWrapper_);
+    network_.finishComputation();
+    topLayer->removeLogPriorFromBias(prior_);
+    network_.initComputation();
+
+    f32 l1norm = network_.l1norm();
+    if (std::isinf(l1norm) || Math::isnan(l1norm))
+        warning("l1 norm of all network weights is: ") << l1norm;
+    else
+        log("l1 norm of all network weights is: ") << l1norm;
+}
+
+MultiStreamFeatureScorer::BatchRef MultiStreamFeatureScorer::closeOpenBatch() const {
+    BatchRef batch = openBatch_;
+    openBatch_.reset();
+    batch->isClosed = true;
+    ++nBatches_;
+    nFrames_ += batch->features.size();
+    return batch;
+}
+
+void MultiStreamFeatureScorer::compute(Batch& batch) const {
+    std::unique_lock<std::mutex> lock(networkMutex_);
+    const u32                    nFrames = batch.features.size();
+
+    buffer_.resize(inputDimension_, nFrames);
+    for (u32 t = 0; t < nFrames; ++t) {
+        const Mm::FeatureVector& f = *batch.features[t];
+        for (u32 i = 0; i < inputDimension_; ++i)
+            buffer_.at(i, t) = f[i];
+    }
+    network_.initComputation();
+    buffer_.initComputation();
+    network_.forward(buffer_);
+    NnMatrix& output = network_.getTopLayerOutput();
+    output.finishComputation();
+    buffer_.finishComputation(false);
+
+    for (u32 t = 0; t < nFrames; ++t) {
+        std::vector<Mm::Score>& scores = batch.results[t]->scores;
+        for (u32 c = 0; c < nClasses_; ++c)
+            scores[c] = (outputIndex_[c] >= 0) ? -output.at(outputIndex_[c], t) : Core::Type<Mm::Score>::max;
+    }
+    lock.unlock();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch.isDone = true;
+    }
+    batchDone_.notify_all();
+}
+
+Mm::FeatureScorer::Scorer MultiStreamFeatureScorer::getScorer(const Mm::FeatureVector& f) const {
+    require_eq(f.size(), inputDimension_);
+    ContextScorer* result = new ContextScorer(nClasses_);
+    Scorer         scorer(result);
+
+    BatchRef batch;  // batch to be computed by this thread
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        activeStreams_.insert(std::this_thread::get_id());
+        if (!openBatch_) {
+            openBatch_.reset(new Batch());
+            openBatch_->deadline = std::chrono::steady_clock::now() + maxLatency_;
+        }
+        BatchRef own = openBatch_;
+        own->features.push_back(&f);
+        own->results.push_back(result);
+        if (own->features.size() >= maxBatchSize_ || own->features.size() >= activeStreams_.size()) {
+            batch = closeOpenBatch();
+        }
+        else {
+            while (!own->isDone) {
+                if (own->isClosed) {
+                    batchDone_.wait(lock);
+                }
+                else if (batchDone_.wait_until(lock, own->deadline) == std::cv_status::timeout && !own->isClosed) {
+                    ++nDeadlineBatches_;
+                    batch = closeOpenBatch();
+                    break;
+                }
+            }
+        }
+    }
+    if (batch)
+        compute(*batch);
+    return scorer;
+}
+
+void MultiStreamFeatureScorer::finalize() const {
+    BatchRef batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        activeStreams_.erase(std::this_thread::get_id());
+        // the remaining streams may all be waiting
+        if (openBatch_ && openBatch_->features.size() >= activeStreams_.size())
+            batch = closeOpenBatch();
+    }
+    if (batch)
+        compute(*batch);
+}
+
+void MultiStreamFeatureScorer::logStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    log("multi-stream scoring: %zu frames in %zu batches (%.2f frames per batch), %zu batches forwarded at the latency deadline",
+        size_t(nFrames_), size_t(nBatches_), nBatches_ > 0 ? f64(nFrames_) / nBatches_ : 0.0, size_t(nDeadlineBatches_));
+}
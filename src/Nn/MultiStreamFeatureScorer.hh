@@ -0,0 +1,146 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _NN_MULTI_STREAM_FEATURE_SCORER_HH
+#define _NN_MULTI_STREAM_FEATURE_SCORER_HH
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <Mm/Feature.hh>
+#include <Mm/FeatureScorer.hh>
+#include <Mm/Types.hh>
+
+#include "ClassLabelWrapper.hh"
+#include "NeuralNetwork.hh"
+#include "Prior.hh"
+#include "Types.hh"
+
+namespace Nn {
+
+/*
+ * Neural network feature scorer for many concurrently decoded streams
+ *
+ * The frames of all threads calling getScorer() are gathered into one
+ * minibatch and forwarded together, thus the matrix multiplications are
+ * efficient even though each stream requests the scores of a single frame.
+ * Each calling thread is one stream; getScorer() blocks until the batch
+ * containing its frame is computed.
+ *
+ * A batch is forwarded as soon as
+ *  - it contains max-batch-size frames, or
+ *  - every active stream waits for it, or
+ *  - the oldest frame waited for max-latency milliseconds.
+ * A stream becomes active with its first frame and inactive with
+ * finalize(), which should be called at the end of each segment.
+ *
+ * Limitations as in BatchFeatureScorer: only linear+softmax output layer
+ * and no recurrent networks.
+ */
+class MultiStreamFeatureScorer : public Mm::FeatureScorer {
+    typedef Mm::FeatureScorer Precursor;
+
+public:
+    static const Core::ParameterInt   paramMaxBatchSize;
+    static const Core::ParameterFloat paramMaxLatency;
+
+protected:
+    typedef Types<f32>::NnMatrix NnMatrix;
+
+    class ContextScorer : public FeatureScorer::ContextScorer {
+    public:
+        std::vector<Mm::Score> scores;
+
+        ContextScorer(u32 nEmissions)
+                : scores(nEmissions) {}
+        virtual ~ContextScorer() {}
+        virtual Mm::EmissionIndex nEmissions() const {
+            return scores.size();
+        }
+        virtual Mm::Score score(Mm::EmissionIndex e) const {
+            return scores[e];
+        }
+    };
+
+    struct Batch {
+        std::vector<const Mm::FeatureVector*> features;
+        std::vector<ContextScorer*>           results;
+        std::chrono::steady_clock::time_point deadline;
+        bool                                  isClosed;
+        bool                                  isDone;
+        Batch()
+                : isClosed(false), isDone(false) {}
+    };
+    typedef std::shared_ptr<Batch> BatchRef;
+
+    const u32                       maxBatchSize_;
+    const std::chrono::microseconds maxLatency_;
+    Prior<f32>                      prior_;
+    ClassLabelWrapper*              labelWrapper_;
+    u32                             nClasses_;
+    u32                             inputDimension_;
+    /** output index of each class, -1 if the class is not scored by the network */
+    std::vector<s32> outputIndex_;
+
+    mutable std::mutex                mutex_;
+    mutable std::condition_variable   batchDone_;
+    mutable BatchRef                  openBatch_;
+    mutable std::set<std::thread::id> activeStreams_;
+
+    /** network and input buffer, used by one batch at a time */
+    mutable std::mutex         networkMutex_;
+    mutable NeuralNetwork<f32> network_;
+    mutable NnMatrix           buffer_;
+
+    mutable u64 nBatches_, nFrames_, nDeadlineBatches_;
+
+    void     init(Core::Ref<const Mm::MixtureSet> mixtureSet);
+    BatchRef closeOpenBatch() const;
+
+    /** Forwards the batch and wakes up its streams */
+    void compute(Batch& batch) const;
+
+public:
+    MultiStreamFeatureScorer(const Core::Configuration& c, Core::Ref<const Mm::MixtureSet> mixtureSet);
+    virtual ~MultiStreamFeatureScorer();
+
+    virtual Mm::EmissionIndex nMixtures() const {
+        return nClasses_;
+    }
+    virtual void getFeatureDescription(Mm::FeatureDescription& description) const {
+        description.mainStream().setValue(Mm::FeatureDescription::nameDimension, inputDimension_);
+    }
+
+    virtual FeatureScorer::Scorer getScorer(Core::Ref<const Mm::Feature> f) const {
+        return getScorer(*f->mainStream());
+    }
+    /** Blocks until the scores of @param f are computed. */
+    virtual FeatureScorer::Scorer getScorer(const Mm::FeatureVector& f) const;
+
+    /** The stream of the calling thread becomes inactive. */
+    virtual void finalize() const;
+
+    u32 maxBatchSize() const {
+        return maxBatchSize_;
+    }
+    void logStatistics() const;
+};
+
+}  // namespace Nn
+
+#endif  // _NN_MULTI_STREAM_FEATURE_SCORER_HH
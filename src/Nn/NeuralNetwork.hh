@@ -174,6 +174,9 @@ public:
     bool isInitialized() const {
         return !needInit_;
     }
+    bool isRecurrent() const {
+        return isRecurrent_;
+    }
 
 protected:
     // set input activations for forwarding
@@ -581,6 +581,101 @@ struct PythonControl::Internal : public Core::Component {
         return result;
     }
 
+    bool _getOrthographies(PyObject* segmentNamesPy, const char* cmd, std::vector<std::string>& orthographies) {
+        PyObject* seq = PySequence_Fast(segmentNamesPy, "segment names must be a sequence");
+        if (!seq)
+            return false;
+        Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+        orthographies.reserve(n);
+        for (Py_ssize_t i = 0; i < n; ++i) {
+            const char* segment_name = PyString_AsString(PySequence_Fast_GET_ITEM(seq, i));
+            if (!segment_name) {
+                Py_DECREF(seq);
+                return false;
+            }
+            auto iter = segmentToOrthMap_->find(std::string(segment_name));
+            if (iter == segmentToOrthMap_->end()) {
+                PyErr_Format(PyExc_KeyError, "PythonControl %s: unknown segment name '%s'", cmd, segment_name);
+                Py_DECREF(seq);
+                return false;
+            }
+            orthographies.push_back(iter->second);
+        }
+        Py_DECREF(seq);
+        return true;
+    }
+
+    /*
+     * Exports the automata of a batch of segments as one concatenated automaton.
+     * Returns (edges, weights, start_end_states):
+     * edges is a (4, num_edges) array of from, to, emission index and batch index,
+     * state ids are shifted such that the states of all segments are disjoint,
+     * start_end_states is a (2, num_segments) array of the start and end states.
+     * Optionally, prefetch_segment_names are exported on a background thread for the next call.
+     */
+    PyObject* exportAllophoneStateFsaBySegNames(PyObject* args, PyObject* kws) {
+        static const char* kwlist[] = {
+                "command",
+                "segment_names",
+                "prefetch_segment_names",
+                NULL};
+        const char* _cmd                 = NULL;
+        PyObject*   segmentNamesPy       = NULL;  // borrowed
+        PyObject*   prefetchSegmentNames = NULL;  // borrowed
+
+        if (!PyArg_ParseTupleAndKeywords(args, kws, "sO|O:callback", (char**)kwlist, &_cmd, &segmentNamesPy, &prefetchSegmentNames))
+            return NULL;
+
+        _initSegmentToOrthMap();
+        _initAllophoneStateFsaExporter();
+
+        const char*              cmd = "export_allophone_state_fsa_by_segment_names";
+        std::vector<std::string> orthographies, prefetchOrthographies;
+        if (!_getOrthographies(segmentNamesPy, cmd, orthographies))
+            return NULL;
+        if (prefetchSegmentNames && prefetchSegmentNames != Py_None && !_getOrthographies(prefetchSegmentNames, cmd, prefetchOrthographies))
+            return NULL;
+
+        std::vector<AllophoneStateFsaExporter::ExportedAutomaton> automata;
+        {
+            // exporting does not need the GIL
+            Python::ScopedAllowThreads allowThreads;
+            automata = allophoneStateFsaExporter_->exportFsasForOrthographies(orthographies);
+            if (!prefetchOrthographies.empty())
+                allophoneStateFsaExporter_->prefetch(prefetchOrthographies);
+        }
+
+        size_t numEdges = 0;
+        for (const AllophoneStateFsaExporter::ExportedAutomaton& automaton : automata)
+            numEdges += automaton.num_edges;
+        std::vector<u32> edges(4 * numEdges), startEndStates(2 * automata.size());
+        std::vector<f32> weights(numEdges);
+        u32              stateOffset = 0, edgeOffset = 0;
+        for (u32 b = 0; b < automata.size(); ++b) {
+            const AllophoneStateFsaExporter::ExportedAutomaton& automaton = automata[b];
+            for (size_t e = 0; e < automaton.num_edges; ++e) {
+                edges[edgeOffset + e]                = stateOffset + automaton.edges[e];
+                edges[numEdges + edgeOffset + e]     = stateOffset + automaton.edges[automaton.num_edges + e];
+                edges[2 * numEdges + edgeOffset + e] = automaton.edges[2 * automaton.num_edges + e];
+                edges[3 * numEdges + edgeOffset + e] = b;
+            }
+            std::copy(automaton.weights.begin(), automaton.weights.end(), weights.begin() + edgeOffset);
+            startEndStates[b]                  = stateOffset + automaton.start_state;
+            startEndStates[automata.size() + b] = stateOffset + automaton.end_state;
+            stateOffset += automaton.num_states;
+            edgeOffset += automaton.num_edges;
+        }
+
+        Python::ObjRef edgesPy, weightsPy, startEndStatesPy;
+        if (!Python::stdVec2numpyNoCopy(getPythonCriticalErrorFunc(), edgesPy.obj, edges, 4))
+            return NULL;
+        if (!Python::stdVec2numpyNoCopy(getPythonCriticalErrorFunc(), weightsPy.obj, weights))
+            return NULL;
+        if (!Python::stdVec2numpyNoCopy(getPythonCriticalErrorFunc(), startEndStatesPy.obj, startEndStates, 2))
+            return NULL;
+        return Py_BuildValue("(OOO)", edgesPy.obj, weightsPy.obj, startEndStatesPy.obj);
+    }
+
     PyObject* getOrthographyBySegmentName(PyObject* args, PyObject* kws) {
         static const char* kwlist[] = {
                 "command",
@@ -872,6 +967,8 @@ struct PythonControl::Internal : public Core::Component {
             return exportAllophoneStateFsaByOrthography(args, kws);
         if (cmd_s == "export_allophone_state_fsa_by_segment_name")
             return exportAllophoneStateFsaBySegName(args, kws);
+        if (cmd_s == "export_allophone_state_fsa_by_segment_names")
+            return exportAllophoneStateFsaBySegNames(args, kws);
         if (cmd_s == "get_orthography_by_segment_name")
             return getOrthographyBySegmentName(args, kws);
         if (cmd_s == "get_alignment_from_cache")
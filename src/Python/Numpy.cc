@@ -384,6 +384,41 @@ bool stdVec2numpy(CriticalErrorFunc criticalErrorFunc, PyObject*& nparr, const s
     return true;
 }
 
+template<typename T>
+static void deleteStdVecCapsule(PyObject* capsule) {
+    delete static_cast<std::vector<T>*>(PyCapsule_GetPointer(capsule, NULL));
+}
+
+template<typename T>
+bool stdVec2numpyNoCopy(CriticalErrorFunc criticalErrorFunc, PyObject*& nparr, std::vector<T>& stdvec, size_t nRows) {
+    Py_CLEAR(nparr);
+    require(nRows > 0 && stdvec.size() % nRows == 0);
+
+    std::vector<T>* data = new std::vector<T>();
+    data->swap(stdvec);
+    npy_intp dims[] = {(npy_intp)nRows, (npy_intp)(data->size() / nRows)};
+    if (nRows == 1)
+        dims[0] = (npy_intp)data->size();
+    nparr = PyArray_SimpleNewFromData(nRows == 1 ? 1 : 2, dims, NumpyType<T>::type(), data->data());
+    if (!nparr) {
+        delete data;
+        criticalErrorFunc() << "failed to create Numpy array";
+        return false;
+    }
+
+    // the capsule owns the data and is released together with the array
+    PyObject* capsule = PyCapsule_New(data, NULL, &deleteStdVecCapsule<T>);
+    if (!capsule || PyArray_SetBaseObject((PyArrayObject*)nparr, capsule) != 0) {
+        if (!capsule)
+            delete data;
+        Py_CLEAR(nparr);
+        criticalErrorFunc() << "failed to set base object of Numpy array";
+        return false;
+    }
+
+    return true;
+}
+
 // explicit template instantiation
 template bool numpy2nnMatrix<f32>(CriticalErrorFunc, PyObject*, Math::CudaMatrix<f32>&);
 template bool numpy2nnMatrix<f64>(CriticalErrorFunc, PyObject*, Math::CudaMatrix<f64>&);
@@ -403,5 +438,7 @@ template bool nnVec2numpy<u32>(CriticalErrorFunc, PyObject*&, const Math::CudaVe
 template bool stdVec2numpy<f32>(CriticalErrorFunc, PyObject*&, const std::vector<f32>&);
 template bool stdVec2numpy<f64>(CriticalErrorFunc, PyObject*&, const std::vector<f64>&);
 template bool stdVec2numpy<u32>(CriticalErrorFunc, PyObject*&, const std::vector<u32>&);
+template bool stdVec2numpyNoCopy<f32>(CriticalErrorFunc, PyObject*&, std::vector<f32>&, size_t);
+template bool stdVec2numpyNoCopy<u32>(CriticalErrorFunc, PyObject*&, std::vector<u32>&, size_t);
 
 }  // namespace Python
@@ -56,6 +56,11 @@ bool nnVec2numpy(CriticalErrorFunc criticalErrorFunc, PyObject*& nparr, const Ma
 template<typename T>
 bool stdVec2numpy(CriticalErrorFunc criticalErrorFunc, PyObject*& nparr, const std::vector<T>& stdvec);
 
+// Takes over the data of stdvec without copying it; stdvec is empty afterwards.
+// If nRows > 1, the array has the shape (nRows, stdvec.size() / nRows) in C order.
+template<typename T>
+bool stdVec2numpyNoCopy(CriticalErrorFunc criticalErrorFunc, PyObject*& nparr, std::vector<T>& stdvec, size_t nRows = 1);
+
 }  // namespace Python
 
 #endif  // NUMPY_HH
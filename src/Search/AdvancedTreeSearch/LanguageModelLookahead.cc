@@ -14,6 +14,7 @@
  */
 // $Id$
 
+#include <chrono>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -280,6 +281,15 @@ const Core::ParameterString LanguageModelLookahead::paramCacheArchive(
         "cache archive in which the look-ahead should be cached",
         "global-cache");
 
+const Core::ParameterBool LanguageModelLookahead::paramVectorizedPropagation(
+        "vectorized-propagation",
+        "propagate dense look-ahead tables level by level with SIMD instructions (same result as the sequential propagation)",
+        true);
+const Core::ParameterInt LanguageModelLookahead::paramBenchmarkTables(
+        "benchmark-tables",
+        "if > 0, measure the propagation throughput with this number of tables after building the look-ahead",
+        0, 0);
+
 static const int predictionArraySize = 100;
 
 // If this is enabled, then the maximization can also consider the backing-off. That is more correct,
@@ -306,6 +316,37 @@ LanguageModelLookahead::LanguageModelLookahead(
           statisticsChannel_(config, "statistics") {
     acousticModel_ = acousticModel;
 
+    initializeParameters();
+
+    buildLookaheadStructure(tree, rootNode, exits);
+
+    if (paramBenchmarkTables(config) > 0)
+        benchmarkPropagation(paramBenchmarkTables(config));
+}
+
+LanguageModelLookahead::LanguageModelLookahead(
+        Core::Configuration const&               c,
+        Lm::Score                                wpScale,
+        Core::Ref<const Lm::ScaledLanguageModel> lm,
+        LanguageModelLookahead const&            structure)
+        : Core::Component(c),
+          wpScale_(wpScale),
+          maxDepth_(0),
+          lm_(lm),
+          tree_(structure.tree_),
+          sparseNodesPrediction_(predictionArraySize, isqrt(lm_->lexicon()->nLemmas()) + 1),
+          batchRequest_(0),
+          nTables_(0),
+          nFreeTables_(0),
+          statisticsChannel_(config, "statistics") {
+    acousticModel_ = structure.acousticModel_;
+
+    initializeParameters();
+
+    shareLookaheadStructure(structure);
+}
+
+void LanguageModelLookahead::initializeParameters() {
     log() << "using pronunciation scale " << wpScale_;
 
     verify(approximatelyEqual(scaledLogAdd(-std::log(0.1), -std::log(0.2), 1.0, 1.0), -std::log(0.3)));
@@ -358,7 +399,6 @@ LanguageModelLookahead::LanguageModelLookahead(
     else
         log("look-ahead history limit is %d (usually means %d-gram look-ahead)",
             historyLimit_, historyLimit_ + 1);
-    buildLookaheadStructure(tree, rootNode, exits);
 }
 
 LanguageModelLookahead::~LanguageModelLookahead() {
@@ -1551,6 +1591,8 @@ void LanguageModelLookahead::buildLookaheadStructure(HMMStateNetwork const& tree
     verify(maxDepth_ != 0);
     waitingLookaheadNodesByDepth_.resize(maxDepth_ + 1);
 
+    buildPropagation();
+
     log("table size (%d entries): %zd bytes", nEntries_,
         sizeof(ContextLookahead) + nEntries_ * sizeof(Score));
 
@@ -1559,6 +1601,45 @@ void LanguageModelLookahead::buildLookaheadStructure(HMMStateNetwork const& tree
         draw(dc);
 }
 
+namespace {
+template<class T>
+Core::ConstantVector<T> constantView(Core::ConstantVector<T> const& v) {
+    return Core::ConstantVector<T>(v.data(), v.size());
+}
+}  // namespace
+
+void LanguageModelLookahead::shareLookaheadStructure(LanguageModelLookahead const& structure) {
+    log("using the look-ahead structure of ") << structure.fullName();
+    verify(structure.nEntries_ != 0 && structure.maxDepth_ != 0);
+
+    invalidFirstNodeForTokenIndex_ = structure.invalidFirstNodeForTokenIndex_;
+    nEntries_                      = structure.nEntries_;
+    maxDepth_                      = structure.maxDepth_;
+
+    ends_              = structure.ends_;
+    endOffsets_        = constantView(structure.endOffsets_);
+    successors_        = constantView(structure.successors_);
+    parents_           = constantView(structure.parents_);
+    nodes_             = constantView(structure.nodes_);
+    nodeForToken_      = constantView(structure.nodeForToken_);
+    firstNodeForToken_ = constantView(structure.firstNodeForToken_);
+    nodeId_            = constantView(structure.nodeId_);
+    hashForState_      = constantView(structure.hashForState_);
+    hashForNode_       = constantView(structure.hashForNode_);
+
+    buildBatchRequest();
+
+    waitingLookaheadNodesByDepth_.resize(maxDepth_ + 1);
+
+    // the layout only depends on the structure
+    if (paramVectorizedPropagation(config) && !logSemiringFactor_) {
+        if (structure.propagation_)
+            propagation_ = structure.propagation_;
+        else
+            buildPropagation();
+    }
+}
+
 void LanguageModelLookahead::draw(std::ostream& os) const {
     os << "digraph \"" << fullName() << "\" {" << std::endl
        << "ranksep = 1.5" << std::endl
@@ -1586,7 +1667,79 @@ void LanguageModelLookahead::draw(std::ostream& os) const {
 // ===========================================================================
 // dynamic data and caching
 
-void LanguageModelLookahead::computeScores(Lm::History const& history, std::vector<Score>& scores) const {
+void LanguageModelLookahead::buildPropagation() {
+    propagation_.reset();
+    if (!paramVectorizedPropagation(config) || logSemiringFactor_)
+        return;
+
+    std::vector<u32> firstSuccessor(nEntries_ + 1), successors(successors_.begin(), successors_.end());
+    for (u32 n = 0; n <= nEntries_; ++n)
+        firstSuccessor[n] = nodes_[n].firstSuccessor;
+    LookaheadPropagation* propagation = new LookaheadPropagation();
+    propagation->build(nEntries_, firstSuccessor, successors);
+    propagation_.reset(propagation);
+    log("look-ahead propagation: %d levels, %d chunks of %d nodes, %zd bytes, %s",
+        propagation->nLevels(), propagation->nChunks(), (int)LookaheadPropagation::ChunkSize,
+        propagation->getMemoryUsed(), propagation->isVectorized() ? "avx2" : "scalar");
+}
+
+void LanguageModelLookahead::benchmarkPropagation(u32 nTables) const {
+    std::vector<Score> initial;
+    initializeScores(lm_->startHistory(), initial);
+
+    std::vector<std::vector<Score>> reference(nTables, initial);
+    std::vector<std::vector<Score>> tables(nTables, initial);
+    std::vector<Score*>             pointers(nTables);
+    for (u32 t = 0; t < nTables; ++t)
+        pointers[t] = &tables[t][0];
+
+    typedef std::chrono::steady_clock Clock;
+    auto                              tablesPerSecond = [nTables](Clock::time_point start) {
+        return nTables / std::chrono::duration<f64>(Clock::now() - start).count();
+    };
+    auto reset = [&]() {
+        for (u32 t = 0; t < nTables; ++t)
+            std::copy(initial.begin(), initial.end(), tables[t].begin());
+    };
+    auto check = [&]() {
+        for (u32 t = 0; t < nTables; ++t)
+            verify(memcmp(&tables[t][0], &reference[t][0], nEntries_ * sizeof(Score)) == 0);
+    };
+
+    Clock::time_point start = Clock::now();
+    for (u32 t = 0; t < nTables; ++t)
+        propagateScoresSequential(reference[t]);
+    f64 sequential = tablesPerSecond(start);
+
+    LookaheadPropagation propagation;
+    std::vector<u32>     firstSuccessor(nEntries_ + 1), successors(successors_.begin(), successors_.end());
+    for (u32 n = 0; n <= nEntries_; ++n)
+        firstSuccessor[n] = nodes_[n].firstSuccessor;
+    propagation.build(nEntries_, firstSuccessor, successors);
+    propagation.setVectorized(false);
+
+    start = Clock::now();
+    for (u32 t = 0; t < nTables; ++t)
+        propagation.propagate(pointers[t]);
+    f64 levelOrdered = tablesPerSecond(start);
+    check();
+
+    f64 vectorized = 0;
+    propagation.setVectorized(true);
+    if (propagation.isVectorized()) {
+        reset();
+        start = Clock::now();
+        for (u32 t = 0; t < nTables; ++t)
+            propagation.propagate(pointers[t]);
+        vectorized = tablesPerSecond(start);
+        check();
+    }
+
+    log("look-ahead propagation benchmark (%d tables of %d nodes), tables per second: sequential %.1f, level-ordered %.1f, avx2 %.1f",
+        nTables, nEntries_, sequential, levelOrdered, vectorized);
+}
+
+void LanguageModelLookahead::initializeScores(Lm::History const& history, std::vector<Score>& scores) const {
     if (scores.size() == nEntries_) {
         std::fill(scores.begin(), scores.end(), Core::Type<Score>::max);
     }
@@ -1596,7 +1749,17 @@ void LanguageModelLookahead::computeScores(Lm::History const& history, std::vect
     }
 
     lm_->getBatch(history, batchRequest_, scores);
+}
+
+void LanguageModelLookahead::computeScores(Lm::History const& history, std::vector<Score>& scores) const {
+    initializeScores(history, scores);
+    if (propagation_)
+        propagation_->propagate(&scores[0]);
+    else
+        propagateScoresSequential(scores);
+}
 
+void LanguageModelLookahead::propagateScoresSequential(std::vector<Score>& scores) const {
     std::vector<Score>::iterator score = scores.begin();
 
     if (logSemiringFactor_) {
@@ -2018,15 +2181,7 @@ void LanguageModelLookahead::fill(ContextLookaheadReference lookahead, bool spar
     if (lookahead->isFilled_)
         return;  ///@todo If another thread is filling this table, wait
 
-    if (sparse) {
-        //Only really use sparse look-ahead if the history is not empty
-        Lm::BackingOffLm const* lm = dynamic_cast<Lm::BackingOffLm const*>(lm_->unscaled().get());
-        verify(lm);  // Sparse look-ahead is only supported with a backing-off LM
-        if (lm->historyLenght(lookahead->history_) == 0)
-            sparse = false;
-    }
-
-    if (not sparse or not((approx && computeScoresSparse<true>(*t)) || (!approx && computeScoresSparse<false>(*t)))) {
+    if (not sparse or not fillSparse(*t, approx)) {
         t->sparseScores_.clear();
         t->approxSparseScores_.clear();
         computeScores(t->history_, t->scores_);
@@ -2035,6 +2190,15 @@ void LanguageModelLookahead::fill(ContextLookaheadReference lookahead, bool spar
     t->isFilled_ = true;
 }
 
+bool LanguageModelLookahead::fillSparse(ContextLookahead& lookahead, bool approx) const {
+    //Only really use sparse look-ahead if the history is not empty
+    Lm::BackingOffLm const* lm = dynamic_cast<Lm::BackingOffLm const*>(lm_->unscaled().get());
+    verify(lm);  // Sparse look-ahead is only supported with a backing-off LM
+    if (lm->historyLenght(lookahead.history_) == 0)
+        return false;
+    return approx ? computeScoresSparse<true>(lookahead) : computeScoresSparse<false>(lookahead);
+}
+
 void LanguageModelLookahead::fillZero(ContextLookaheadReference lookahead) {
     ContextLookahead* t = const_cast<ContextLookahead*>(lookahead.get());
 
@@ -19,6 +19,7 @@
 
 #include <iostream>
 #include <list>
+#include <memory>
 
 #include <Core/Component.hh>
 #include <Core/Hash.hh>
@@ -28,6 +29,7 @@
 #include <Search/StateTree.hh>
 
 #include "LinearPrediction.hh"
+#include "LookaheadPropagation.hh"
 #include "PersistentStateTree.hh"
 #include "TreeStructure.hh"
 
@@ -109,9 +111,16 @@ private:
     void buildBatchRequest();
     void buildHash();
     void buildLookaheadStructure(Search::HMMStateNetwork const& tree, Search::StateId rootNode, std::vector<Search::PersistentStateTree::Exit> const& exits);
+    void shareLookaheadStructure(LanguageModelLookahead const& structure);
+    void initializeParameters();
 
-    const Lm::CompiledBatchRequest* batchRequest_;
-    void                            computeScores(Lm::History const&, std::vector<Score>&) const;
+    const Lm::CompiledBatchRequest*             batchRequest_;
+    std::shared_ptr<const LookaheadPropagation> propagation_;  // shared with sharing instances, 0: sequential propagation
+    void                                        buildPropagation();
+    void                                        initializeScores(Lm::History const&, std::vector<Score>&) const;
+    void                                        propagateScoresSequential(std::vector<Score>&) const;
+    void                                        computeScores(Lm::History const&, std::vector<Score>&) const;
+    void                                        benchmarkPropagation(u32 nTables) const;
 
 public:
     class ContextLookahead;
@@ -120,6 +129,8 @@ private:
     // Returns whether the scores were actually computed
     template<bool approx>
     bool computeScoresSparse(ContextLookahead& lookahead) const;
+    // Returns whether the table was filled sparse
+    bool fillSparse(ContextLookahead& lookahead, bool approx) const;
     friend class ContextLookahead;
     u32                                                                           cacheSizeHighMark_, cacheSizeLowMark_;
     typedef std::list<ContextLookahead*>                                          List;
@@ -162,6 +173,8 @@ public:
     static const Core::ParameterInt    paramCollisionHashSize;
     static const Core::ParameterFloat  paramMaxCollisionDeviation;
     static const Core::ParameterString paramCacheArchive;
+    static const Core::ParameterBool   paramVectorizedPropagation;
+    static const Core::ParameterInt    paramBenchmarkTables;
 
     LanguageModelLookahead(Core::Configuration const&,
                            Lm::Score wpScale,
@@ -171,6 +184,15 @@ public:
                            std::vector<Search::PersistentStateTree::Exit> const& exits,
                            Core::Ref<const Am::AcousticModel>);
 
+    /**
+     * Look-ahead on the static structure of @p structure, which is shared, not copied:
+     * @p structure must outlive this object.  Tables and caches are separate.
+     * */
+    LanguageModelLookahead(Core::Configuration const&,
+                           Lm::Score wpScale,
+                           Core::Ref<const Lm::ScaledLanguageModel>,
+                           LanguageModelLookahead const& structure);
+
     ~LanguageModelLookahead();
 
     void draw(std::ostream&) const;
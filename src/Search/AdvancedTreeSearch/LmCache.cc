@@ -0,0 +1,108 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "LmCache.hh"
+
+#include <map>
+#include <mutex>
+
+using namespace Search;
+
+LmCache::LmCache(u32 capacity)
+        : mask_(0),
+          generation_(1) {
+    u32 size = 1;
+    while (size < capacity)
+        size <<= 1;
+    std::vector<Slot>(size).swap(slots_);
+    mask_ = size - 1;
+}
+
+bool LmCache::find(const Key& key, Lm::Score& score, Counts& counts) {
+    const u32 generation = generation_.load(std::memory_order_relaxed);
+    const size_t hash    = key.hash();
+    for (u32 i = 0; i < ProbeLength; ++i) {
+        Slot&     slot(slots_[(hash + i) & mask_]);
+        const u32 sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+            continue;  // being written
+        if (slot.generation.load(std::memory_order_relaxed) == 0)
+            break;  // slots are never emptied, so the key can not be further down the window
+        const bool      matches = slot.matches(key);
+        const Lm::Score s       = slot.score.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+            continue;
+        if (matches) {
+            if (slot.generation.load(std::memory_order_relaxed) != generation)
+                slot.generation.store(generation, std::memory_order_relaxed);
+            score = s;
+            ++counts.hits;
+            return true;
+        }
+    }
+    ++counts.misses;
+    return false;
+}
+
+void LmCache::insert(const Key& key, Lm::Score score, Counts& counts) {
+    const u32    generation = generation_.load(std::memory_order_relaxed);
+    const size_t hash       = key.hash();
+
+    // Prefer an empty slot or the slot holding the key, otherwise replace the oldest entry
+    Slot* victim    = 0;
+    u32   victimAge = 0;
+    for (u32 i = 0; i < ProbeLength; ++i) {
+        Slot&     slot(slots_[(hash + i) & mask_]);
+        const u32 slotGeneration = slot.generation.load(std::memory_order_relaxed);
+        if (slotGeneration == 0 || slot.matches(key)) {
+            victim = &slot;
+            break;
+        }
+        const u32 age = generation - slotGeneration;
+        if (!victim || age > victimAge) {
+            victim    = &slot;
+            victimAge = age;
+        }
+    }
+
+    u32 sequence = victim->sequence.load(std::memory_order_relaxed);
+    if ((sequence & 1) || !victim->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire))
+        return;  // another thread is writing this slot
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (victim->generation.load(std::memory_order_relaxed) != 0 && !victim->matches(key))
+        ++counts.evictions;
+    victim->pron.store(key.pron, std::memory_order_relaxed);
+    victim->history.store(uintptr_t(key.history), std::memory_order_relaxed);
+    victim->historyHash.store(key.historyHash, std::memory_order_relaxed);
+    victim->score.store(score, std::memory_order_relaxed);
+    victim->generation.store(generation, std::memory_order_relaxed);
+
+    victim->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::shared_ptr<LmCache> LmCache::shared(const void* owner, Lm::Score wpScale, u32 capacity) {
+    static std::mutex                                                            mutex;
+    static std::map<std::pair<const void*, Lm::Score>, std::weak_ptr<LmCache>> caches;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<LmCache>&     entry(caches[std::make_pair(owner, wpScale)]);
+    std::shared_ptr<LmCache>    cache = entry.lock();
+    if (!cache) {
+        cache = std::make_shared<LmCache>(capacity);
+        entry = cache;
+    }
+    return cache;
+}
@@ -15,8 +15,12 @@
 #ifndef LMCACHE_HH
 #define LMCACHE_HH
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <Bliss/Lexicon.hh>
 #include <Lm/LanguageModel.hh>
-// #include "LinearMiniHash.hh"
 
 template<class Key>
 struct StandardValueHash {
@@ -32,81 +36,102 @@ struct StandardValueHash {
 };
 
 namespace Search {
-struct LmCacheKey {
-    LmCacheKey(Lm::HistoryHandle h, Bliss::LemmaPronunciation::Id _pron)
-            : history(h),
-              pron(_pron),
-              hash_(StandardValueHash<Bliss::LemmaPronunciation::Id>()(pron) + (((size_t)history) * 311) + ((size_t)history) / sizeof(void*)) {
-    }
+/**
+ * Fixed-capacity cache of LM scores keyed by (history, pronunciation), which
+ * can be used concurrently by several searches in one process.
+ *
+ * Open addressing with a short linear probe window.  Every slot carries a
+ * sequence counter which is odd while the slot is written: readers never
+ * block and treat a slot changing under them as a miss, writers claim a slot
+ * with a single compare-and-swap and drop the insertion if it is contended.
+ *
+ * Entries are aged by generation: a hit refreshes the generation of the
+ * entry, and an insertion into a full probe window replaces the entry with
+ * the oldest generation.
+ *
+ * Histories are identified by handle and hash key, so a handle which is
+ * recycled for a different history is not mistaken for the released one
+ * unless the hash keys collide as well.
+ */
+class LmCache {
+public:
+    struct Key {
+        Lm::HistoryHandle             history;
+        Lm::HistoryHash               historyHash;
+        Bliss::LemmaPronunciation::Id pron;
+
+        Key(const Lm::History& h, Bliss::LemmaPronunciation::Id _pron)
+                : history(h.handle()),
+                  historyHash(h.hashKey()),
+                  pron(_pron) {
+        }
 
-    size_t hash() const {
-        return hash_;
-    }
+        size_t hash() const {
+            size_t h = (size_t(historyHash) + size_t(history) / sizeof(void*)) * 311 + StandardValueHash<u32>()(pron);
+            return h ^ (h >> 17);
+        }
+    };
 
-    bool operator==(const LmCacheKey& rhs) const {
-        return pron == rhs.pron && history == rhs.history;
-    }
+    /// Counters of one user of the cache
+    struct Counts {
+        u32 hits, misses, evictions;
 
-    const Lm::HistoryHandle             history;
-    const Bliss::LemmaPronunciation::Id pron;
-    const size_t                        hash_;
-};
+        Counts()
+                : hits(0), misses(0), evictions(0) {
+        }
+        void clear() {
+            hits = misses = evictions = 0;
+        }
+    };
 
-struct LmCacheHash {
-    size_t operator()(const LmCacheKey& key) const {
-        return key.hash();
-    }
-};
+    /// @param capacity number of entries, rounded up to a power of two
+    LmCache(u32 capacity);
 
-struct LmCacheEqual {
-    bool operator()(const LmCacheKey& key1, const LmCacheKey& key2) const {
-        return key1 == key2;
-    }
-};
+    ///@return true if the key is cached, and in that case its score
+    bool find(const Key& key, Lm::Score& score, Counts& counts);
 
-struct LmCacheItem {
-    Lm::Score score;
+    void insert(const Key& key, Lm::Score score, Counts& counts);
 
-    inline LmCacheItem(Lm::Score s)
-            : score(s) {
+    /// Starts a new generation. Entries which are not used afterwards are replaced first.
+    void advanceGeneration() {
+        generation_.fetch_add(1, std::memory_order_relaxed);
     }
-};
 
-class LmCache {
-    ///@todo Make sure that the handles of the cached histories are kept alive
-public:
-    ///Should be called regularly to clean up the cache
-    ///All items that were not requested since the last call to clean()
-    ///will be removed.
-    ///@return the count of items remaining in the cache
-    u32 clean() {
-        oldCache_.swap(newCache_);
-        newCache_.clear();
-        return oldCache_.size();
+    u32 capacity() const {
+        return slots_.size();
     }
 
-    ///@return Core::Type<Lm::Score>::max if the item needs to be calculated
-    LmCacheItem& retrieve(const LmCacheKey& key) {
-        Hash::iterator it = newCache_.find(key);
-        if (it != newCache_.end())
-            return (*it).second;
-
-        it = oldCache_.find(key);
+    /// Returns the cache shared by all users with the same owner (the scaled LM) and word penalty scale.
+    /// It is created by the first request with the given capacity and released together with its last user.
+    static std::shared_ptr<LmCache> shared(const void* owner, Lm::Score wpScale, u32 capacity);
 
-        LmCacheItem item = LmCacheItem(Core::Type<Lm::Score>::max);
-
-        if (it != oldCache_.end()) {
-            item = (*it).second;
-            oldCache_.erase(it);
+private:
+    enum {
+        ProbeLength = 8
+    };
+
+    struct Slot {
+        std::atomic<u32>                           sequence;
+        std::atomic<u32>                           generation;  // zero for empty slots
+        std::atomic<Bliss::LemmaPronunciation::Id> pron;
+        std::atomic<Lm::Score>                     score;
+        std::atomic<uintptr_t>                     history;
+        std::atomic<Lm::HistoryHash>               historyHash;
+
+        Slot()
+                : sequence(0), generation(0), pron(0), score(0), history(0), historyHash(0) {
         }
 
-        return newCache_.insert(std::make_pair(key, item)).first->second;
-    }
+        bool matches(const Key& key) const {
+            return pron.load(std::memory_order_relaxed) == key.pron &&
+                   history.load(std::memory_order_relaxed) == uintptr_t(key.history) &&
+                   historyHash.load(std::memory_order_relaxed) == key.historyHash;
+        }
+    };
 
-private:
-    typedef std::unordered_map<LmCacheKey, LmCacheItem, LmCacheHash, LmCacheEqual> Hash;
-    Hash                                                                           oldCache_;
-    Hash                                                                           newCache_;
+    std::vector<Slot> slots_;
+    u32               mask_;
+    std::atomic<u32>  generation_;
 };
 }  // namespace Search
 
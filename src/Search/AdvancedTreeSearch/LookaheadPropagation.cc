@@ -0,0 +1,147 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "LookaheadPropagation.hh"
+
+#include <immintrin.h>
+#include <algorithm>
+
+#include <Core/Assertions.hh>
+
+using namespace AdvancedTreeSearch;
+
+namespace {
+
+struct FewerSuccessors {
+    const std::vector<u32>& firstSuccessor;
+    FewerSuccessors(const std::vector<u32>& f)
+            : firstSuccessor(f) {}
+    u32 nSuccessors(u32 n) const {
+        return firstSuccessor[n + 1] - firstSuccessor[n];
+    }
+    bool operator()(u32 a, u32 b) const {
+        return nSuccessors(a) < nSuccessors(b) || (nSuccessors(a) == nSuccessors(b) && a < b);
+    }
+};
+
+}  // namespace
+
+LookaheadPropagation::LookaheadPropagation()
+        : nNodes_(0), nLevels_(0), vectorized_(isAvx2Supported()) {}
+
+bool LookaheadPropagation::isAvx2Supported() {
+#if defined(DISABLE_SIMD)
+    return false;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+void LookaheadPropagation::setVectorized(bool vectorized) {
+    vectorized_ = vectorized && isAvx2Supported();
+}
+
+void LookaheadPropagation::build(u32 nNodes, const std::vector<u32>& firstSuccessor, const std::vector<u32>& successors) {
+    require(firstSuccessor.size() > nNodes);
+    nNodes_ = nNodes;
+
+    // level = length of the longest path to a leaf, successors have smaller ids
+    std::vector<u32> level(nNodes, 0);
+    nLevels_ = 0;
+    for (u32 n = 0; n < nNodes; ++n) {
+        for (u32 s = firstSuccessor[n]; s < firstSuccessor[n + 1]; ++s) {
+            verify(successors[s] < n);
+            level[n] = std::max(level[n], level[successors[s]] + 1);
+        }
+        nLevels_ = std::max(nLevels_, level[n] + 1);
+    }
+
+    std::vector<std::vector<u32>> nodesForLevel(nLevels_);
+    for (u32 n = 0; n < nNodes; ++n)
+        if (level[n] > 0)
+            nodesForLevel[level[n]].push_back(n);
+
+    chunkLength_.clear();
+    chunkOffset_.clear();
+    nodeIndex_.clear();
+    successorIndex_.clear();
+    FewerSuccessors fewerSuccessors(firstSuccessor);
+    for (u32 l = 1; l < nLevels_; ++l) {
+        std::vector<u32>& nodes = nodesForLevel[l];
+        std::sort(nodes.begin(), nodes.end(), fewerSuccessors);
+        for (u32 c = 0; c < nodes.size(); c += ChunkSize) {
+            // unused lanes repeat the last node of the chunk, which writes the same score twice
+            u32 chunk[ChunkSize];
+            for (u32 i = 0; i < ChunkSize; ++i)
+                chunk[i] = nodes[std::min<u32>(c + i, nodes.size() - 1)];
+            u32 length = 0;
+            for (u32 i = 0; i < ChunkSize; ++i)
+                length = std::max(length, fewerSuccessors.nSuccessors(chunk[i]));
+            chunkLength_.push_back(length);
+            chunkOffset_.push_back(successorIndex_.size());
+            nodeIndex_.insert(nodeIndex_.end(), chunk, chunk + ChunkSize);
+            for (u32 j = 0; j < length; ++j) {
+                // padding with the node itself does not change the minimum
+                for (u32 i = 0; i < ChunkSize; ++i)
+                    successorIndex_.push_back(j < fewerSuccessors.nSuccessors(chunk[i]) ? successors[firstSuccessor[chunk[i]] + j] : chunk[i]);
+            }
+        }
+    }
+}
+
+void LookaheadPropagation::propagate(Score* scores) const {
+    if (vectorized_)
+        propagateAvx2(scores);
+    else
+        propagateScalar(scores);
+}
+
+void LookaheadPropagation::propagateScalar(Score* scores) const {
+    for (u32 c = 0; c < chunkLength_.size(); ++c) {
+        const s32* nodes      = &nodeIndex_[c * ChunkSize];
+        const s32* successors = &successorIndex_[0] + chunkOffset_[c];
+        for (u32 i = 0; i < ChunkSize; ++i) {
+            Score minScore = scores[nodes[i]];
+            for (u32 j = 0; j < chunkLength_[c]; ++j) {
+                Score s = scores[successors[j * ChunkSize + i]];
+                if (minScore > s)
+                    minScore = s;
+            }
+            scores[nodes[i]] = minScore;
+        }
+    }
+}
+
+__attribute__((target("avx2"))) void LookaheadPropagation::propagateAvx2(Score* scores) const {
+    Score minScores[ChunkSize];
+    for (u32 c = 0; c < chunkLength_.size(); ++c) {
+        const s32* nodes      = &nodeIndex_[c * ChunkSize];
+        const s32* successors = &successorIndex_[0] + chunkOffset_[c];
+        __m256     minScore   = _mm256_i32gather_ps(scores, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(nodes)), sizeof(Score));
+        for (u32 j = 0; j < chunkLength_[c]; ++j) {
+            const __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(successors + j * ChunkSize));
+            // minps(a, b) is (a < b) ? a : b, the same as the sequential comparison
+            minScore = _mm256_min_ps(_mm256_i32gather_ps(scores, index, sizeof(Score)), minScore);
+        }
+        _mm256_storeu_ps(minScores, minScore);
+        for (u32 i = 0; i < ChunkSize; ++i)
+            scores[nodes[i]] = minScores[i];
+    }
+}
+
+size_t LookaheadPropagation::getMemoryUsed() const {
+    return sizeof(*this) + (chunkLength_.capacity() + chunkOffset_.capacity()) * sizeof(u32) +
+           (nodeIndex_.capacity() + successorIndex_.capacity()) * sizeof(s32);
+}
@@ -0,0 +1,90 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _SEARCH_LOOKAHEADPROPAGATION_HH
+#define _SEARCH_LOOKAHEADPROPAGATION_HH
+
+#include <vector>
+
+#include <Core/Types.hh>
+
+namespace AdvancedTreeSearch {
+
+/**
+ * Level-ordered layout of the compressed look-ahead tree for the
+ * minimum propagation of dense look-ahead tables.
+ *
+ * The score of a look-ahead node is the minimum of its own word-end
+ * score and the scores of its successors, which have smaller ids.
+ * Nodes whose successors are all on lower levels (level = longest path
+ * to a leaf) can be updated independently.  The inner nodes are grouped
+ * by level, sorted by their number of successors and cut into chunks of
+ * ChunkSize nodes.  The successor lists of a chunk are stored interleaved
+ * (successor j of all nodes of the chunk is contiguous) and padded with
+ * the node itself, so that one chunk is processed with one gather per
+ * successor position and an element-wise minimum.  Leaves are not
+ * touched at all.
+ *
+ * The minimum is accumulated per node in the original successor order
+ * with the same comparison as the sequential propagation, the result is
+ * therefore bit-identical.  The AVX2 kernel is selected at run time if
+ * supported by the processor.
+ */
+class LookaheadPropagation {
+public:
+    typedef f32 Score;
+    enum { ChunkSize = 8 };
+
+    LookaheadPropagation();
+
+    /**
+     * Builds the layout of nNodes nodes.  The successors of node n are
+     * successors[firstSuccessor[n] .. firstSuccessor[n + 1]), all < n.
+     */
+    void build(u32 nNodes, const std::vector<u32>& firstSuccessor, const std::vector<u32>& successors);
+
+    /** Use the AVX2 kernel if the processor supports it (the default). */
+    void setVectorized(bool vectorized);
+    bool isVectorized() const {
+        return vectorized_;
+    }
+    static bool isAvx2Supported();
+
+    /** Propagates the minimum to all nodes of the table scores[0 .. nNodes). */
+    void propagate(Score* scores) const;
+
+    u32 nLevels() const {
+        return nLevels_;
+    }
+    u32 nChunks() const {
+        return chunkLength_.size();
+    }
+    size_t getMemoryUsed() const;
+
+private:
+    u32              nNodes_;
+    u32              nLevels_;
+    bool             vectorized_;
+    std::vector<u32> chunkLength_;     // max. number of successors per chunk
+    std::vector<u32> chunkOffset_;     // first entry in successorIndex_ per chunk
+    std::vector<s32> nodeIndex_;       // ChunkSize nodes per chunk
+    std::vector<s32> successorIndex_;  // ChunkSize * chunkLength_ per chunk
+
+    void propagateScalar(Score* scores) const;
+    void propagateAvx2(Score* scores) const;
+};
+
+}  // namespace AdvancedTreeSearch
+
+#endif  // _SEARCH_LOOKAHEADPROPAGATION_HH
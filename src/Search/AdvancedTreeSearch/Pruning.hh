@@ -45,6 +45,9 @@ struct SearchSpace::AcousticPruning {
     inline bool prune(const StateHypothesis& hyp) const {
         return hyp.prospect > absoluteThreshold_;
     }
+    inline Score threshold() const {
+        return absoluteThreshold_;
+    }
     inline bool prune(const TraceManager &, const StateHypothesis& hyp) const {
         return prune(hyp);
     }
@@ -109,6 +112,9 @@ struct SearchSpace::PerInstanceAcousticPruning {
     inline bool prune(const StateHypothesis& hyp) const {
         return hyp.prospect > absoluteThreshold_ or hyp.prospect > instanceThreshold_;
     }
+    inline Score threshold() const {
+        return std::min(absoluteThreshold_, instanceThreshold_);
+    }
     inline bool prune(const TraceManager &, const StateHypothesis& hyp) const {
         return prune(hyp);
     }
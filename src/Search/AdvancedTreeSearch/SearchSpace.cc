@@ -15,13 +15,19 @@
 #include "SearchSpace.hh"
 
 #include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <random>
+#include <thread>
+#include <tuple>
 
 #include <Am/ClassicAcousticModel.hh>
 #include <Core/MappedArchive.hh>
 #include <Lm/BackingOff.hh>
 #include <Lm/Module.hh>
 #include <Mm/GaussDiagonalMaximumFeatureScorer.hh>
+#include <Modules.hh>
 
 #include "AcousticLookAhead.hh"
 #include "PersistentStateTree.hh"
@@ -288,6 +294,36 @@ const Core::ParameterInt paramInstanceDeletionLatency(
         "timeframes of inactivity before an instance is deleted",
         3, 0);
 
+const Core::ParameterInt paramSearchThreads(
+        "search-threads",
+        "number of threads used to expand, score and prune the state hypotheses of one timeframe. the result does not depend on the number of threads",
+        1, 1);
+
+const Core::ParameterInt paramSearchThreadsStateMinimum(
+        "search-threads-state-minimum",
+        "timeframes with less state hypotheses are processed by a single thread",
+        5000, 0);
+
+const Core::ParameterBool paramBenchmarkSearchThreads(
+        "benchmark-search-threads",
+        "repeat the parallel state expansion and emission scoring of every multi-threaded timeframe with 1 to search-threads threads, and collect the times in the search statistics",
+        false);
+
+const Core::ParameterInt paramLmCacheCapacity(
+        "lm-cache-capacity",
+        "number of entries of the LM score cache which complements the per-tree caches and outlives the trees, 0 disables it",
+        0, 0);
+
+const Core::ParameterBool paramShareLmCache(
+        "share-lm-cache",
+        "share the LM score cache with all searches in this process using the same language model and word penalty",
+        true);
+
+const Core::ParameterBool paramShareSearchNetwork(
+        "share-search-network",
+        "share the static search network and LM look-ahead structure with all searches in this process using the same models and configuration (not with acoustic look-ahead)",
+        true);
+
 const Core::ParameterString paramDumpDotGraph(
         "search-network-dump-dot-graph",
         "",
@@ -368,6 +404,18 @@ void truncate(const std::vector<From>& source, std::vector<To>& to) {
             to.push_back(*it);
     }
 }
+/// Searches sharing a static search network: component name, acoustic model, lexicon, look-ahead LM and pronunciation scale
+typedef std::tuple<std::string, const void*, const void*, const void*, Score> SharedAutomatonKey;
+
+std::mutex& sharedAutomataMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<SharedAutomatonKey, std::weak_ptr<StaticSearchAutomaton const>>& sharedAutomata() {
+    static std::map<SharedAutomatonKey, std::weak_ptr<StaticSearchAutomaton const>> automata;
+    return automata;
+}
 }  // namespace
 
 StaticSearchAutomaton::StaticSearchAutomaton(Core::Configuration config, Core::Ref<const Am::AcousticModel> acousticModel, Bliss::LexiconRef lexicon)
@@ -376,6 +424,8 @@ StaticSearchAutomaton::StaticSearchAutomaton(Core::Configuration config, Core::R
           minimized(paramBuildMinimizedTreeFromScratch(config)),
           network(config, acousticModel, lexicon),
           prefixFilter(nullptr),
+          isShared(false),
+          lmLookahead(nullptr),
           acousticModel_(acousticModel),
           lexicon_(lexicon) {
 }
@@ -384,6 +434,7 @@ StaticSearchAutomaton::~StaticSearchAutomaton() {
     if (prefixFilter) {
         delete prefixFilter;
     }
+    delete lmLookahead;
 }
 
 void StaticSearchAutomaton::buildNetwork() {
@@ -754,6 +805,75 @@ void StaticSearchAutomaton::buildBatches() {
 
 // ------------------------------- Search Space --------------------------------
 
+class SearchSpace::PartitionWorkers {
+public:
+    PartitionWorkers(u32 nWorkers)
+            : job_(nullptr), nPartitions_(0), generation_(0), pending_(0), stop_(false) {
+        for (u32 t = 0; t < nWorkers; ++t)
+            threads_.push_back(std::thread(&PartitionWorkers::work, this, t + 1));
+    }
+
+    ~PartitionWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (u32 t = 0; t < threads_.size(); ++t)
+            threads_[t].join();
+    }
+
+    /// Calls job(p) for p in [0, nPartitions), partition 0 in the calling thread, and returns when all calls have finished
+    void run(std::function<void(s32)> const& job, s32 nPartitions) {
+        verify(nPartitions <= (s32)threads_.size() + 1);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_         = &job;
+            nPartitions_ = nPartitions;
+            pending_     = threads_.size();
+            ++generation_;
+        }
+        start_.notify_all();
+        if (nPartitions > 0)
+            job(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [this] { return pending_ == 0; });
+        job_ = nullptr;
+    }
+
+private:
+    void work(s32 partition) {
+        u64 generation = 0;
+        while (true) {
+            std::function<void(s32)> const* job;
+            s32                             nPartitions;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_.wait(lock, [this, generation] { return stop_ || generation_ != generation; });
+                if (stop_)
+                    return;
+                generation  = generation_;
+                job         = job_;
+                nPartitions = nPartitions_;
+            }
+            if (partition < nPartitions)
+                (*job)(partition);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0)
+                finished_.notify_one();
+        }
+    }
+
+    std::vector<std::thread>        threads_;
+    std::mutex                      mutex_;
+    std::condition_variable         start_, finished_;
+    std::function<void(s32)> const* job_;
+    s32                             nPartitions_;
+    u64                             generation_;
+    u32                             pending_;
+    bool                            stop_;
+};
+
 SearchSpace::SearchSpace(const Core::Configuration&               config,
                          Core::Ref<const Am::AcousticModel>       acousticModel,
                          Bliss::LexiconRef                        lexicon,
@@ -770,7 +890,7 @@ SearchSpace::SearchSpace(const Core::Configuration&               config,
           recombinationLm_(),
           ssaLm_(dynamic_cast<Lm::SearchSpaceAwareLanguageModel const*>(lm_->unscaled().get())),
           lmLookahead_(0),
-          automaton_(new StaticSearchAutomaton(config, acousticModel, lexicon)),
+          automaton_(std::make_shared<StaticSearchAutomaton>(config, acousticModel, lexicon)),
           acousticLookAhead_(0),
           conditionPredecessorWord_(paramConditionPredecessorWord(config)),
           decodeMesh_(paramDecodeMesh(config)),
@@ -823,6 +943,10 @@ SearchSpace::SearchSpace(const Core::Configuration&               config,
           minWordEndScore_(Core::Type<Score>::max),
           stateHistogram_(paramAcousticPruningBins(config)),
           wordEndHistogram_(paramWordEndPruningBins(config)),
+          nThreads_(paramSearchThreads(config)),
+          threadsStateMinimum_(paramSearchThreadsStateMinimum(config)),
+          benchmarkThreads_(paramBenchmarkSearchThreads(config)),
+          emissionStamp_(0),
           hadWordEnd_(true),
           currentStatesAfterPruning("current states after pruning"),
           currentWordEndsAfterPruning("current word ends after pruning"),
@@ -874,6 +998,24 @@ SearchSpace::SearchSpace(const Core::Configuration&               config,
         sparseLookahead_ = false;
     }
 
+    if (nThreads_ > 1 && PathTrace::Enabled) {
+        warning() << "path tracing is not thread-safe, using a single thread";
+        nThreads_ = 1;
+    }
+    if (nThreads_ > 1) {
+        log() << "processing state hypotheses with up to " << nThreads_ << " threads";
+        partitionWorkers_.reset(new PartitionWorkers(nThreads_ - 1));
+    }
+
+    u32 lmCacheCapacity = paramLmCacheCapacity(config);
+    if (lmCacheCapacity) {
+        if (paramShareLmCache(config))
+            lmCache_ = LmCache::shared(lm_.get(), wpScale_, lmCacheCapacity);
+        else
+            lmCache_ = std::make_shared<LmCache>(lmCacheCapacity);
+        log() << "using " << (paramShareLmCache(config) ? "shared " : "") << "LM score cache with " << lmCache_->capacity() << " entries";
+    }
+
     statesOnDepth_.initialize(100, 100);
     statesOnInvertedDepth_.initialize(100, 100);
 }
@@ -899,7 +1041,6 @@ SearchSpace::~SearchSpace() {
         unigramLookAhead_.reset();
         delete lmLookahead_;
     }
-    delete automaton_;
 }
 
 void SearchSpace::initializePruning() {
@@ -969,30 +1110,51 @@ void SearchSpace::initialize() {
     getTransitionModels();
     initializePruning();
 
-    StaticSearchAutomaton* automaton = const_cast<StaticSearchAutomaton*>(automaton_);
+    // With share-search-network, the static network is built once per process for all searches with the
+    // same models and configuration; the lock is held until the network is complete.
+    std::unique_lock<std::mutex> sharedLock;
+    bool                         isBuilt = false;
+    if (paramShareSearchNetwork(config) && !AcousticLookAhead::isEnabled(config)) {
+        sharedLock = std::unique_lock<std::mutex>(sharedAutomataMutex());
+        std::weak_ptr<StaticSearchAutomaton const>& entry = sharedAutomata()[SharedAutomatonKey(fullName(), acousticModel_.get(), lexicon_.get(), lookaheadLm_.get(), wpScale_)];
+        std::shared_ptr<StaticSearchAutomaton const> shared = entry.lock();
+        if (shared) {
+            automaton_ = shared;
+            isBuilt    = true;
+            log() << "using the search network shared with other searches";
+        }
+        else {
+            entry = automaton_;
+            const_cast<StaticSearchAutomaton*>(automaton_.get())->isShared = true;
+        }
+    }
+
+    StaticSearchAutomaton* automaton = const_cast<StaticSearchAutomaton*>(automaton_.get());
 
     PersistentStateTree& net = automaton->network;
-    automaton->buildNetwork();
+    if (!isBuilt) {
+        automaton->buildNetwork();
 
-    automaton->buildDepths();
-    log() << "depth of root-state: " << automaton->stateDepths[net.rootState] << " hmm-length " << automaton->hmmLength;
-    if (automaton->stateDepths[net.rootState] == 0 && automaton->minimized) {
-        log() << "tail minimization was not used, root-state has depth 0";
-        automaton->minimized = false;
-    }
+        automaton->buildDepths();
+        log() << "depth of root-state: " << automaton->stateDepths[net.rootState] << " hmm-length " << automaton->hmmLength;
+        if (automaton->stateDepths[net.rootState] == 0 && automaton->minimized) {
+            log() << "tail minimization was not used, root-state has depth 0";
+            automaton->minimized = false;
+        }
 
-    if (!(automaton->stateDepths[net.rootState] == (automaton->minimized ? automaton->hmmLength : 0)) &&
-        !(automaton->stateDepths[net.rootState] == (automaton->minimized ? automaton->hmmLength + 1 : 1))) {
-        error() << "bad state depths! root-state has depth " << automaton->stateDepths[net.rootState] << ", should be " << (automaton->minimized ? automaton->hmmLength : 0);
-    }
+        if (!(automaton->stateDepths[net.rootState] == (automaton->minimized ? automaton->hmmLength : 0)) &&
+            !(automaton->stateDepths[net.rootState] == (automaton->minimized ? automaton->hmmLength + 1 : 1))) {
+            error() << "bad state depths! root-state has depth " << automaton->stateDepths[net.rootState] << ", should be " << (automaton->minimized ? automaton->hmmLength : 0);
+        }
 
-    automaton->buildLabelDistances();
+        automaton->buildLabelDistances();
 
-    // The filter must be created _before_ the outputs are cut off the search network
-    automaton->prefixFilter = new PrefixFilter(net, lexicon_, config);
-    if (!automaton->prefixFilter->haveFilter()) {
-        delete automaton->prefixFilter;
-        automaton->prefixFilter = nullptr;
+        // The filter must be created _before_ the outputs are cut off the search network
+        automaton->prefixFilter = new PrefixFilter(net, lexicon_, config);
+        if (!automaton->prefixFilter->haveFilter()) {
+            delete automaton->prefixFilter;
+            automaton->prefixFilter = nullptr;
+        }
     }
 
     acousticLookAhead_ = new AdvancedTreeSearch::AcousticLookAhead(config, net.getChecksum());
@@ -1003,9 +1165,14 @@ void SearchSpace::initialize() {
 
     // Initialization of the search network cuts away the outputs from the network
     // and puts them into the outputBatches_ data structures instead.
-    automaton->buildBatches();
+    if (!isBuilt)
+        automaton->buildBatches();
 
     stateHypothesisRecombinationArray.resize(net.structure.stateCount());
+
+    threadBuffers_.resize(nThreads_ > 1 ? nThreads_ : 0);
+    for (u32 t = 0; t < threadBuffers_.size(); ++t)
+        threadBuffers_[t].recombination.resize(net.structure.stateCount());
 }
 
 void SearchSpace::initializeLanguageModel() {
@@ -1013,16 +1180,33 @@ void SearchSpace::initializeLanguageModel() {
 
     unigramHistory_ = lookaheadLm_->reducedHistory(lookaheadLm_->startHistory(), 0);
 
-    StaticSearchAutomaton* automaton = const_cast<StaticSearchAutomaton*>(automaton_);
+    StaticSearchAutomaton* automaton = const_cast<StaticSearchAutomaton*>(automaton_.get());
 
     if (paramEnableLmLookahead(config)) {
-        lmLookahead_ = new AdvancedTreeSearch::LanguageModelLookahead(Core::Configuration(config, "lm-lookahead"),
-                                                                      wpScale_,
-                                                                      lookaheadLm_,
-                                                                      net.structure,
-                                                                      net.rootState,
-                                                                      net.exits,
-                                                                      acousticModel_);
+        if (automaton->isShared) {
+            // The look-ahead structure is built from the network outputs, thus only once before they are removed
+            if (!automaton->lmLookahead)
+                automaton->lmLookahead = new AdvancedTreeSearch::LanguageModelLookahead(Core::Configuration(config, "lm-lookahead"),
+                                                                                        wpScale_,
+                                                                                        lookaheadLm_,
+                                                                                        net.structure,
+                                                                                        net.rootState,
+                                                                                        net.exits,
+                                                                                        acousticModel_);
+            lmLookahead_ = new AdvancedTreeSearch::LanguageModelLookahead(Core::Configuration(config, "lm-lookahead"),
+                                                                          wpScale_,
+                                                                          lookaheadLm_,
+                                                                          *automaton->lmLookahead);
+        }
+        else {
+            lmLookahead_ = new AdvancedTreeSearch::LanguageModelLookahead(Core::Configuration(config, "lm-lookahead"),
+                                                                          wpScale_,
+                                                                          lookaheadLm_,
+                                                                          net.structure,
+                                                                          net.rootState,
+                                                                          net.exits,
+                                                                          acousticModel_);
+        }
 
         std::set<AdvancedTreeSearch::LanguageModelLookahead::LookaheadId> rootStates;
 
@@ -1049,16 +1233,19 @@ void SearchSpace::initializeLanguageModel() {
         else
             lmLookahead_->fill(unigramLookAhead_);
 
-        automaton->lookAheadIds.resize(net.structure.stateCount(), std::make_pair(0u, 0u));
-        automaton->lookAheadIdAndHash.resize(net.structure.stateCount(), std::make_pair(0u, 0u));
-        for (StateId state = 1; state < net.structure.stateCount(); ++state) {
-            if (acousticLookAhead_->isEnabled()) {
-                automaton->lookAheadIds[state]       = std::make_pair<uint, uint>(lmLookahead_->lookaheadId(state), acousticLookAhead_->getLookaheadId(state));
-                automaton->lookAheadIdAndHash[state] = std::make_pair<uint, uint>(lmLookahead_->lookaheadHash(state), acousticLookAhead_->getLookaheadId(state));
-            }
-            else {
-                automaton->lookAheadIds[state]       = std::make_pair<uint, uint>(lmLookahead_->lookaheadId(state), 0);
-                automaton->lookAheadIdAndHash[state] = std::make_pair<uint, uint>(lmLookahead_->lookaheadHash(state), 0);
+        // already filled, if the network is shared
+        if (automaton->lookAheadIds.empty()) {
+            automaton->lookAheadIds.resize(net.structure.stateCount(), std::make_pair(0u, 0u));
+            automaton->lookAheadIdAndHash.resize(net.structure.stateCount(), std::make_pair(0u, 0u));
+            for (StateId state = 1; state < net.structure.stateCount(); ++state) {
+                if (acousticLookAhead_->isEnabled()) {
+                    automaton->lookAheadIds[state]       = std::make_pair<uint, uint>(lmLookahead_->lookaheadId(state), acousticLookAhead_->getLookaheadId(state));
+                    automaton->lookAheadIdAndHash[state] = std::make_pair<uint, uint>(lmLookahead_->lookaheadHash(state), acousticLookAhead_->getLookaheadId(state));
+                }
+                else {
+                    automaton->lookAheadIds[state]       = std::make_pair<uint, uint>(lmLookahead_->lookaheadId(state), 0);
+                    automaton->lookAheadIdAndHash[state] = std::make_pair<uint, uint>(lmLookahead_->lookaheadHash(state), 0);
+                }
             }
         }
     }
@@ -1131,14 +1318,14 @@ inline bool SearchSpace::eventuallyDeactivateTree(Instance* at, bool increaseIna
     }
 }
 
-void SearchSpace::activateOrUpdateStateHypothesisLoop(const Search::StateHypothesis& hyp, Score score) {
-    StateHypothesisIndex& recombination = stateHypothesisRecombinationArray[hyp.state];  // Look-up at node index, contains positions in newStateHypotheses.
-    StateHypothesis&      sh(newStateHypotheses.data()[recombination]);                  //We may be referencing a not allocated position, so we use data()
-    // Check if present in current tree (starting at currentTreeFirstNewStateHypothesis).
-    if (recombination < currentTreeFirstNewStateHypothesis || recombination >= newStateHypotheses.size() || sh.state != hyp.state) {
-        recombination = newStateHypotheses.size();
-        addNewStateHypothesis(hyp);
-        newStateHypotheses.back().score = score;
+void SearchSpace::activateOrUpdateStateHypothesisLoop(StateExpansionTarget& target, const Search::StateHypothesis& hyp, Score score) {
+    StateHypothesisIndex& recombination = target.recombination[hyp.state];  // Look-up at node index, contains positions in target.hypotheses.
+    StateHypothesis&      sh(target.hypotheses.data()[recombination]);  //We may be referencing a not allocated position, so we use data()
+    // Check if present in current tree (starting at target.firstHypothesis).
+    if (recombination < target.firstHypothesis || recombination >= target.hypotheses.size() || sh.state != hyp.state) {
+        recombination = target.hypotheses.size();
+        addNewStateHypothesis(target, hyp);
+        target.hypotheses.back().score = score;
     }
     else {
         //Update existing hypothesis
@@ -1149,15 +1336,15 @@ void SearchSpace::activateOrUpdateStateHypothesisLoop(const Search::StateHypothe
     }
 }
 
-void SearchSpace::activateOrUpdateStateHypothesisTransition(const Search::StateHypothesis& hyp, Score score, StateId successorState) {
-    StateHypothesisIndex& recombination = stateHypothesisRecombinationArray[successorState];
-    StateHypothesis&      sh(newStateHypotheses.data()[recombination]);  //We may be referencing a not allocated position, so we use data()
-    // Check if present in current tree (starting at currentTreeFirstNewStateHypothesis).
-    if (recombination < currentTreeFirstNewStateHypothesis || recombination >= newStateHypotheses.size() || sh.state != successorState) {
-        recombination = newStateHypotheses.size();
-        addNewStateHypothesis(hyp);
-        newStateHypotheses.back().score = score;
-        newStateHypotheses.back().state = successorState;
+void SearchSpace::activateOrUpdateStateHypothesisTransition(StateExpansionTarget& target, const Search::StateHypothesis& hyp, Score score, StateId successorState) {
+    StateHypothesisIndex& recombination = target.recombination[successorState];
+    StateHypothesis&      sh(target.hypotheses.data()[recombination]);  //We may be referencing a not allocated position, so we use data()
+    // Check if present in current tree (starting at target.firstHypothesis).
+    if (recombination < target.firstHypothesis || recombination >= target.hypotheses.size() || sh.state != successorState) {
+        recombination = target.hypotheses.size();
+        addNewStateHypothesis(target, hyp);
+        target.hypotheses.back().score = score;
+        target.hypotheses.back().state = successorState;
     }
     else {
         //Update existing hypothesis
@@ -1168,13 +1355,13 @@ void SearchSpace::activateOrUpdateStateHypothesisTransition(const Search::StateH
     }
 }
 
-void SearchSpace::activateOrUpdateStateHypothesisDirectly(const Search::StateHypothesis& hyp) {
-    StateHypothesisIndex& recombination = stateHypothesisRecombinationArray[hyp.state];
-    StateHypothesis&      sh(newStateHypotheses.data()[recombination]);  //We may be referencing a not allocated position, so we use data()
+void SearchSpace::activateOrUpdateStateHypothesisDirectly(StateExpansionTarget& target, const Search::StateHypothesis& hyp) {
+    StateHypothesisIndex& recombination = target.recombination[hyp.state];
+    StateHypothesis&      sh(target.hypotheses.data()[recombination]);  //We may be referencing a not allocated position, so we use data()
 
-    if (recombination < currentTreeFirstNewStateHypothesis || recombination >= newStateHypotheses.size() || sh.state != hyp.state) {
-        recombination = newStateHypotheses.size();
-        addNewStateHypothesis(hyp);
+    if (recombination < target.firstHypothesis || recombination >= target.hypotheses.size() || sh.state != hyp.state) {
+        recombination = target.hypotheses.size();
+        addNewStateHypothesis(target, hyp);
     }
     else {
         //Update existing hypothesis
@@ -1186,7 +1373,7 @@ void SearchSpace::activateOrUpdateStateHypothesisDirectly(const Search::StateHyp
 }
 
 template<bool expandForward, bool expandSkip>
-void SearchSpace::expandStateSlow(const Search::StateHypothesis& hyp) {
+void SearchSpace::expandStateSlow(StateExpansionTarget& target, const Search::StateHypothesis& hyp) {
     PersistentStateTree const& net                             = network();
     std::vector<int> const&    secondOrderEdgeSuccessorBatches = automaton_->secondOrderEdgeSuccessorBatches;
     HMMState const&            state                           = net.structure.state(hyp.state);
@@ -1205,7 +1392,7 @@ void SearchSpace::expandStateSlow(const Search::StateHypothesis& hyp) {
 
         // Use the second-order structure to do the skips directly
         for (int a = secondStart; a < secondEnd; ++a)
-            activateOrUpdateStateHypothesisTransition(hyp, skipScore, a);
+            activateOrUpdateStateHypothesisTransition(target, hyp, skipScore, a);
     }
 
     Score forwardScore = hyp.score + tdp[Am::StateTransitionModel::forward];
@@ -1216,7 +1403,7 @@ void SearchSpace::expandStateSlow(const Search::StateHypothesis& hyp) {
             //Fast iteration
             for (StateId successor = successors.first; successor != successors.second; ++successor) {
                 if (expandForward)
-                    activateOrUpdateStateHypothesisTransition(hyp, forwardScore, successor);  // Already covered by expandState?
+                    activateOrUpdateStateHypothesisTransition(target, hyp, forwardScore, successor);  // Already covered by expandState?
 
                 if (expandSkip && doSkip)  // TODO: only doSkip is sufficient
                 {                          // Second order expansion (successors of successor).
@@ -1224,11 +1411,11 @@ void SearchSpace::expandStateSlow(const Search::StateHypothesis& hyp) {
                     if (skipSuccessors.first != -1) {
                         //Fast iteration
                         for (StateId skipSuccessor = skipSuccessors.first; skipSuccessor != skipSuccessors.second; ++skipSuccessor)
-                            activateOrUpdateStateHypothesisTransition(hyp, skipScore, skipSuccessor);
+                            activateOrUpdateStateHypothesisTransition(target, hyp, skipScore, skipSuccessor);
                     }
                     else {
                         for (HMMStateNetwork::SuccessorIterator skipSuccessorIt = net.structure.successors(successor); skipSuccessorIt; ++skipSuccessorIt)
-                            activateOrUpdateStateHypothesisTransition(hyp, skipScore, *skipSuccessorIt);
+                            activateOrUpdateStateHypothesisTransition(target, hyp, skipScore, *skipSuccessorIt);
                     }
                 }
             }
@@ -1238,12 +1425,12 @@ void SearchSpace::expandStateSlow(const Search::StateHypothesis& hyp) {
                 StateId successor = *successorIt;
 
                 if (expandForward)
-                    activateOrUpdateStateHypothesisTransition(hyp, forwardScore, successor);
+                    activateOrUpdateStateHypothesisTransition(target, hyp, forwardScore, successor);
 
                 if (expandSkip && doSkip)  // TODO: only doSkip is sufficient
                 {
                     for (HMMStateNetwork::SuccessorIterator skipSuccessorIt = net.structure.successors(successor); skipSuccessorIt; ++skipSuccessorIt)
-                        activateOrUpdateStateHypothesisTransition(hyp, skipScore, *skipSuccessorIt);
+                        activateOrUpdateStateHypothesisTransition(target, hyp, skipScore, *skipSuccessorIt);
                 }
             }
         }
@@ -1260,7 +1447,7 @@ void SearchSpace::expandStateSlow(const Search::StateHypothesis& hyp) {
 // The hypotheses are in the transitstate, which is part of WordEndHypothesis, which was created in pruneEarlyWordEnds.
 // Due to recombineWordEnds(), there is only one hypothesis in each transit state per history (instance).
 template<bool allowSkip>
-inline void SearchSpace::expandState(const Search::StateHypothesis& hyp) {
+inline void SearchSpace::expandState(StateExpansionTarget& target, const Search::StateHypothesis& hyp) {
     // This is the 'fast' state-expansion step, that should work in 99.9% of the expansions
     // Labels were already removed from the network before starting, so they can be ignored
     PersistentStateTree const&      net                             = network();
@@ -1272,7 +1459,7 @@ inline void SearchSpace::expandState(const Search::StateHypothesis& hyp) {
     Score loopScore = hyp.score + tdp[Am::StateTransitionModel::loop];
 
     if (loopScore < Core::Type<Score>::max)
-        activateOrUpdateStateHypothesisLoop(hyp, loopScore);
+        activateOrUpdateStateHypothesisLoop(target, hyp, loopScore);
 
     // forward transition
     if ((state.successors & SingleSuccessorBatchMask) == SingleSuccessorBatchMask) {
@@ -1283,7 +1470,7 @@ inline void SearchSpace::expandState(const Search::StateHypothesis& hyp) {
         Score forwardScore = hyp.score + tdp[Am::StateTransitionModel::forward];
 
         if (forwardScore < Core::Type<Score>::max)
-            activateOrUpdateStateHypothesisTransition(hyp, forwardScore, forwardSuccessor);
+            activateOrUpdateStateHypothesisTransition(target, hyp, forwardScore, forwardSuccessor);
     }
     else {
         // There are multiple successors
@@ -1291,7 +1478,7 @@ inline void SearchSpace::expandState(const Search::StateHypothesis& hyp) {
 
         if (successors.first == -1) {
             // The successor structure has irregular linked-list form, use the slow non-optimized expansion
-            expandStateSlow<true, allowSkip>(hyp);
+            expandStateSlow<true, allowSkip>(target, hyp);
             return;
         }
 
@@ -1299,7 +1486,7 @@ inline void SearchSpace::expandState(const Search::StateHypothesis& hyp) {
 
         if (forwardScore < Core::Type<Score>::max)
             for (int successor = successors.first; successor < successors.second; ++successor)
-                activateOrUpdateStateHypothesisTransition(hyp, forwardScore, successor);
+                activateOrUpdateStateHypothesisTransition(target, hyp, forwardScore, successor);
     }
 
     if (allowSkip) {
@@ -1311,21 +1498,116 @@ inline void SearchSpace::expandState(const Search::StateHypothesis& hyp) {
 
             if (skipScore < Core::Type<Score>::max)
                 for (StateId successor2 = secondStart; successor2 < secondEnd; ++successor2)
-                    activateOrUpdateStateHypothesisTransition(hyp, skipScore, successor2);
+                    activateOrUpdateStateHypothesisTransition(target, hyp, skipScore, successor2);
         }
         else if (secondStart == 0) {
             //The secondOrderEdgeSuccessorBatches_ structure can not hold the successors, so use slow expansion to expand the second-order followers
-            expandStateSlow<false, true>(hyp);
+            expandStateSlow<false, true>(target, hyp);
         }
     }
 }
 
+void SearchSpace::expandInstance(const Instance& instance, u32 oldStart, u32 oldEnd, StateExpansionTarget& target) {
+    // Expand entry state hypotheses
+    if (allowSkips_) {
+        for (std::vector<StateHypothesis>::const_iterator sh = instance.rootStateHypotheses.begin();
+             sh != instance.rootStateHypotheses.end(); ++sh)
+            expandState<true>(target, *sh);
+    }
+    else {
+        for (std::vector<StateHypothesis>::const_iterator sh = instance.rootStateHypotheses.begin();
+             sh != instance.rootStateHypotheses.end(); ++sh)
+            expandState<false>(target, *sh);
+    }
+
+    // Expand old state hypotheses
+    if (allowSkips_) {
+        for (StateHypothesesList::const_iterator sh = stateHypotheses.begin() + oldStart;
+             sh != stateHypotheses.begin() + oldEnd; ++sh)
+            expandState<true>(target, *sh);
+    }
+    else {
+        for (StateHypothesesList::const_iterator sh = stateHypotheses.begin() + oldStart;
+             sh != stateHypotheses.begin() + oldEnd; ++sh)
+            expandState<false>(target, *sh);
+    }
+}
+
+bool SearchSpace::parallelize() const {
+    return nThreads_ > 1 && stateHypotheses.size() >= threadsStateMinimum_;
+}
+
+void SearchSpace::partitionInstances(u32 nThreads) {
+    u64 total = 0;
+    for (u32 i = 0; i < activeInstances.size(); ++i)
+        total += activeInstances[i]->states.size() + activeInstances[i]->rootStateHypotheses.size() + 1;
+
+    partition_.clear();
+    partition_.push_back(0);
+    u64 accumulated = 0;
+    for (u32 i = 0; i + 1 < activeInstances.size(); ++i) {
+        accumulated += activeInstances[i]->states.size() + activeInstances[i]->rootStateHypotheses.size() + 1;
+        if (accumulated * nThreads >= total * partition_.size())
+            partition_.push_back(i + 1);
+    }
+    partition_.push_back(activeInstances.size());
+}
+
+void SearchSpace::forEachPartition(std::function<void(s32)> const& job) {
+    partitionWorkers_->run(job, partition_.size() - 1);
+}
+
+void SearchSpace::expandInstancesParallel() {
+    expandedInstanceEnds_.resize(activeInstances.size());
+
+    forEachPartition([this](s32 p) {
+        ThreadBuffer&        buffer(threadBuffers_[p]);
+        StateExpansionTarget target(buffer.hypotheses, buffer.recombination);
+        buffer.hypotheses.clear();
+        for (u32 i = partition_[p]; i < partition_[p + 1]; ++i) {
+            const Instance& instance(*activeInstances[i]);
+            target.firstHypothesis = buffer.hypotheses.size();
+            expandInstance(instance, instance.states.begin, instance.states.end, target);
+            expandedInstanceEnds_[i] = buffer.hypotheses.size();
+        }
+    });
+}
+
+void SearchSpace::benchmarkThreads() {
+    typedef std::chrono::steady_clock Clock;
+
+    // The expansion only writes into threadBuffers_ and expandedInstanceEnds_, so it can be repeated
+    for (u32 nThreads = 1; nThreads <= nThreads_; ++nThreads) {
+        partitionInstances(nThreads);
+        Clock::time_point start = Clock::now();
+        expandInstancesParallel();
+        std::ostringstream os;
+        os << "search-threads benchmark: expansion seconds with " << nThreads << " threads";
+        statistics->customStatistics(os.str()) += std::chrono::duration<f64>(Clock::now() - start).count();
+    }
+}
+
 void SearchSpace::expandHmm() {
     PerformanceCounter expandPerf(*statistics, "expand HMM");
 
     bestProspect_ = Core::Type<Score>::max;
     bestScore_    = Core::Type<Score>::max;
 
+    StateExpansionTarget target(newStateHypotheses, stateHypothesisRecombinationArray);
+
+    // Without early back-off, the root state hypotheses of an instance are not changed while processing the other instances,
+    // so the instances present at the beginning of the timeframe can be expanded concurrently into per-thread buffers.
+    // These are then concatenated in instance order, which gives exactly the serial result.
+    u32 nExpandedInstances = 0;
+    if (!earlyBackoff_ && parallelize()) {
+        if (benchmarkThreads_)
+            benchmarkThreads();
+        partitionInstances(nThreads_);
+        expandInstancesParallel();
+        nExpandedInstances = activeInstances.size();
+    }
+    u32 partition = 0;
+
     for (u32 treeIdx = 0; treeIdx < activeInstances.size(); ++treeIdx) {
         Instance& instance(*activeInstances[treeIdx]);  // All hypotheses in one context/tree.
 
@@ -1333,20 +1615,21 @@ void SearchSpace::expandHmm() {
 
         const u32 oldStart = instance.states.begin, oldEnd = instance.states.end;
 
-        instance.states.begin              = newStateHypotheses.size();
-        currentTreeFirstNewStateHypothesis = instance.states.begin;
-
-        // Expand entry state hypotheses
-
-        if (allowSkips_) {
-            for (std::vector<StateHypothesis>::const_iterator sh = instance.rootStateHypotheses.begin();
-                 sh != instance.rootStateHypotheses.end(); ++sh)
-                expandState<true>(*sh);
+        instance.states.begin  = newStateHypotheses.size();
+        target.firstHypothesis = instance.states.begin;
+
+        if (treeIdx < nExpandedInstances) {
+            // Take over the hypotheses expanded in parallel, and update the recombination array as the serial expansion would have done
+            if (treeIdx == partition_[partition + 1])
+                ++partition;
+            StateHypothesesList const& expanded(threadBuffers_[partition].hypotheses);
+            for (u32 h = (treeIdx == partition_[partition]) ? 0 : expandedInstanceEnds_[treeIdx - 1]; h < expandedInstanceEnds_[treeIdx]; ++h) {
+                stateHypothesisRecombinationArray[expanded[h].state] = newStateHypotheses.size();
+                addNewStateHypothesis(target, expanded[h]);
+            }
         }
         else {
-            for (std::vector<StateHypothesis>::const_iterator sh = instance.rootStateHypotheses.begin();
-                 sh != instance.rootStateHypotheses.end(); ++sh)
-                expandState<false>(*sh);
+            expandInstance(instance, oldStart, oldEnd, target);
         }
 
         if (earlyBackoff_ && instance.rootStateHypotheses.size()) {
@@ -1362,18 +1645,6 @@ void SearchSpace::expandHmm() {
 
         instance.rootStateHypotheses.clear();
 
-        // Expand old state hypotheses
-        if (allowSkips_) {
-            for (StateHypothesesList::const_iterator sh = stateHypotheses.begin() + oldStart;
-                 sh != stateHypotheses.begin() + oldEnd; ++sh)
-                expandState<true>(*sh);
-        }
-        else {
-            for (StateHypothesesList::const_iterator sh = stateHypotheses.begin() + oldStart;
-                 sh != stateHypotheses.begin() + oldEnd; ++sh)
-                expandState<false>(*sh);
-        }
-
         // List of state hypotheses that should be transferred into this tree.
         // Filled by applyLookaheadInTree(Internal) (see below in same method) if the sparseLookAhead fails.
         // The hypotheses are pushed to the backOffInstance.
@@ -1382,7 +1653,7 @@ void SearchSpace::expandHmm() {
             for (std::vector<StateHypothesisIndex>::const_iterator transferIt = instance.transfer.begin();
                  transferIt != instance.transfer.end();
                  ++transferIt)
-                activateOrUpdateStateHypothesisDirectly(newStateHypotheses[*transferIt]);
+                activateOrUpdateStateHypothesisDirectly(target, newStateHypotheses[*transferIt]);
 
             // Make sure we don't need to re-allocate at later timeframes
             instance.transfer.reserve(instance.transfer.capacity());
@@ -1667,7 +1938,10 @@ void SearchSpace::addAcousticScores() {
     bestProspect_ = Core::Type<Score>::max;
     bestScore_    = Core::Type<Score>::max;
 
-    {
+    if (parallelize()) {
+        addAcousticScoresParallel<Pruning>();
+    }
+    else {
         Pruning pruning(*this);
 
         for (auto instance : activeInstances) {
@@ -1678,6 +1952,115 @@ void SearchSpace::addAcousticScores() {
     verify(bestProspect_ != Core::Type<Score>::max || stateHypotheses.empty());
 }
 
+template<class Pruning>
+void SearchSpace::addAcousticScoresParallel() {
+    const Mm::CachedFeatureScorer::CachedContextScorerOverlay* scorerCache(dynamic_cast<const Mm::CachedFeatureScorer::CachedContextScorerOverlay*>(scorer_.get()));
+    // Context scorers fill their caches lazily, so score() must not be called concurrently. If not all scores are cached
+    // already, the emissions needed in this timeframe are collected in parallel, and each is scored once, concurrently
+    // if the scorer supports it and in the foreground otherwise.
+    const bool precached = scorerCache && scorerCache->precached();
+
+    partitionInstances(nThreads_);
+
+    if (!precached) {
+        const u32 nEmissions = scorer_->nEmissions();
+        if (emissionScores_.size() < nEmissions) {
+            emissionScores_.resize(nEmissions);
+            emissionStamps_.resize(nEmissions, 0);
+        }
+        ++emissionStamp_;
+
+        forEachPartition([this, nEmissions](s32 p) {
+            ThreadBuffer& buffer(threadBuffers_[p]);
+            if (buffer.emissionStamps.size() < nEmissions)
+                buffer.emissionStamps.resize(nEmissions, 0);
+            StateHypothesesList::const_iterator sh     = stateHypotheses.begin() + activeInstances[partition_[p]]->states.begin;
+            StateHypothesesList::const_iterator sh_end = stateHypotheses.begin() + activeInstances[partition_[p + 1] - 1]->states.end;
+            for (; sh != sh_end; ++sh) {
+                if (sh->prospect == F32_MAX)
+                    continue;
+                Mm::MixtureIndex mix = network().structure.state(sh->state).stateDesc.acousticModel;
+                verify_(mix != StateTree::invalidAcousticModel);
+                if (buffer.emissionStamps[mix] != emissionStamp_) {
+                    buffer.emissionStamps[mix] = emissionStamp_;
+                    buffer.emissions.push_back(mix);
+                }
+            }
+        });
+
+        scoreEmissions(scorer_->supportsConcurrentScoring());
+    }
+
+    instanceScores_.resize(activeInstances.size());
+
+    forEachPartition([this, scorerCache, precached](s32 p) {
+        for (u32 i = partition_[p]; i < partition_[p + 1]; ++i) {
+            Score                         minimum = Core::Type<Score>::max;
+            StateHypothesesList::iterator sh      = stateHypotheses.begin() + activeInstances[i]->states.begin;
+            StateHypothesesList::iterator sh_end  = stateHypotheses.begin() + activeInstances[i]->states.end;
+            for (; sh != sh_end; ++sh) {
+                if (sh->prospect == F32_MAX)
+                    continue;  //This state will be pruned
+
+                Mm::MixtureIndex mix = network().structure.state(sh->state).stateDesc.acousticModel;
+                Score            s   = precached ? scorerCache->Mm::CachedFeatureScorer::CachedContextScorerOverlay::score(mix) : emissionScores_[mix];
+
+                sh->score += s;
+                sh->prospect += s * acousticProspectFactor_;
+
+                if (sh->prospect < minimum)
+                    minimum = sh->prospect;
+            }
+            instanceScores_[i] = minimum;
+        }
+    });
+
+    // The pruning only records minima, so feeding it the per-instance minima in instance order has the same effect as the serial loop
+    Pruning pruning(*this);
+    for (u32 i = 0; i < activeInstances.size(); ++i) {
+        pruning.startInstance(activeInstances[i]->key);
+        pruning.prepare(StateHypothesis(0, 0, instanceScores_[i]));
+    }
+}
+
+void SearchSpace::scoreEmissions(bool concurrent) {
+    // Merge the emissions requested by the ranges, so that each is scored once
+    frameEmissions_.clear();
+    for (u32 p = 0; p < threadBuffers_.size(); ++p) {
+        std::vector<Mm::MixtureIndex>& emissions(threadBuffers_[p].emissions);
+        for (std::vector<Mm::MixtureIndex>::const_iterator mix = emissions.begin(); mix != emissions.end(); ++mix) {
+            if (emissionStamps_[*mix] != emissionStamp_) {
+                emissionStamps_[*mix] = emissionStamp_;
+                frameEmissions_.push_back(*mix);
+            }
+        }
+        emissions.clear();
+    }
+
+    if (!concurrent) {
+        for (u32 e = 0; e < frameEmissions_.size(); ++e)
+            emissionScores_[frameEmissions_[e]] = scorer_->score(frameEmissions_[e]);
+        return;
+    }
+
+    // The scores do not depend on the number of threads, so the benchmark simply overwrites them
+    typedef std::chrono::steady_clock Clock;
+    for (u32 nThreads = benchmarkThreads_ ? 1 : nThreads_; nThreads <= nThreads_; ++nThreads) {
+        const u64 nFrameEmissions = frameEmissions_.size();
+        auto      scoreRange      = [this, nFrameEmissions, nThreads](s32 p) {
+            for (u32 e = nFrameEmissions * p / nThreads; e < nFrameEmissions * (p + 1) / nThreads; ++e)
+                emissionScores_[frameEmissions_[e]] = scorer_->scoreConcurrently(frameEmissions_[e]);
+        };
+        Clock::time_point start = Clock::now();
+        partitionWorkers_->run(scoreRange, nThreads);
+        if (benchmarkThreads_) {
+            std::ostringstream os;
+            os << "search-threads benchmark: scoring seconds with " << nThreads << " threads";
+            statistics->customStatistics(os.str()) += std::chrono::duration<f64>(Clock::now() - start).count();
+        }
+    }
+}
+
 void SearchSpace::activateLmLookahead(Search::Instance& instance, bool compute) {
     if (instance.lookahead.get())
         return;
@@ -1873,6 +2256,63 @@ void SearchSpace::pruneStates(Pruning& pruning) {
     activeInstances.resize(instOut);
 }
 
+/// Threshold pruning, parallelized over instances if enabled.
+/// Pruning has to provide the effective threshold of the current instance through threshold().
+template<class Pruning>
+void SearchSpace::pruneStatesParallel(Pruning& pruning) {
+    if (!parallelize()) {
+        pruneStates(pruning);
+        return;
+    }
+
+    // Instance thresholds are determined in the foreground, as startInstance() may access the search space
+    instanceScores_.resize(activeInstances.size());
+    for (u32 i = 0; i < activeInstances.size(); ++i) {
+        pruning.startInstance(activeInstances[i]->key);
+        instanceScores_[i] = pruning.threshold();
+    }
+
+    partitionInstances(nThreads_);
+
+    // Compact each partition in place, then close the gaps between the partitions
+    StateHypothesesList::iterator hypBegin = stateHypotheses.begin();
+    forEachPartition([this, hypBegin](s32 p) {
+        StateHypothesesList::iterator hypIn, hypOut, instHypEnd;
+        hypIn = hypOut = hypBegin + activeInstances[partition_[p]]->states.begin;
+        for (u32 i = partition_[p]; i < partition_[p + 1]; ++i) {
+            Instance* at(activeInstances[i]);
+            verify_(hypIn == hypBegin + at->states.begin);
+            at->states.begin = hypOut - hypBegin;
+            for (instHypEnd = hypBegin + at->states.end; hypIn < instHypEnd; ++hypIn) {
+                if (!(hypIn->prospect > instanceScores_[i]))
+                    *(hypOut++) = *hypIn;
+            }
+            at->states.end = hypOut - hypBegin;
+        }
+    });
+
+    StateHypothesesList::iterator hypOut = hypBegin;
+    for (u32 p = 0; p + 1 < partition_.size(); ++p) {
+        const u32 first = activeInstances[partition_[p]]->states.begin, last = activeInstances[partition_[p + 1] - 1]->states.end;
+        const u32 shift = first - (hypOut - hypBegin);
+        hypOut          = std::copy(hypBegin + first, hypBegin + last, hypOut);
+        for (u32 i = partition_[p]; i < partition_[p + 1]; ++i) {
+            activeInstances[i]->states.begin -= shift;
+            activeInstances[i]->states.end -= shift;
+        }
+    }
+
+    u32 instOut = 0;
+    for (u32 instIn = 0; instIn < activeInstances.size(); ++instIn) {
+        Instance* at(activeInstances[instIn]);
+        if (!eventuallyDeactivateTree(at, true))
+            activeInstances[instOut++] = at;
+    }
+
+    stateHypotheses.erase(hypOut, stateHypotheses.end());
+
+    activeInstances.resize(instOut);
+}
 
 void SearchSpace::updateSsaLm() {
     if (!ssaLm_) {
@@ -1965,7 +2405,7 @@ void SearchSpace::pruneStatesEarly() {
     verify(bestProspect_ != Core::Type<Score>::max || stateHypotheses.empty());
 
     AcousticPruning pruning(*this, acousticPruning_);
-    pruneStates(pruning);
+    pruneStatesParallel(pruning);
 }
 
 void SearchSpace::pruneAndAddScores() {
@@ -1986,13 +2426,13 @@ void SearchSpace::pruneAndAddScores() {
         addAcousticScores<RecordMinimumPerInstance>();
         PerformanceCounter         perf(*statistics, "acoustic pruning");
         PerInstanceAcousticPruning pruning(*this);
-        pruneStates(pruning);
+        pruneStatesParallel(pruning);
     }
     else {
         addAcousticScores<RecordMinimum>();
         PerformanceCounter perf(*statistics, "acoustic pruning");
         AcousticPruning    pruning(*this);
-        pruneStates(pruning);
+        pruneStatesParallel(pruning);
     }
 
     {
@@ -2005,7 +2445,7 @@ void SearchSpace::pruneAndAddScores() {
             Score acuThreshold = quantileStateScore(bestProspect_, bestProspect_ + acousticPruning_, acousticPruningLimit_);
             statistics->acousticHistogramPruningThreshold += acuThreshold - bestProspect_;
             AcousticPruning pruning(*this, acuThreshold - bestProspect_);
-            pruneStates(pruning);
+            pruneStatesParallel(pruning);
 
             currentAcousticPruningSaturation += 1.0;
             statistics->customStatistics("acoustic pruning saturation") += 1.0;
@@ -2366,7 +2806,7 @@ void SearchSpace::hypothesizeEpsilonPronunciations(Score bestScore) {
                 std::unordered_map<InstanceKey, Instance*, InstanceKey::Hash>::iterator instIt = activeInstanceMap.find(InstanceKey(weh.recombinationHistory));
                 if (instIt != activeInstanceMap.end()) {
                     // Use the network's cache to extend the LM score
-                    static_cast<Instance&>(*instIt->second).addLmScore(weh, pronunciation->id(), lm_, lexicon_, wpScale_);
+                    static_cast<Instance&>(*instIt->second).addLmScore(weh, pronunciation->id(), lm_, lexicon_, wpScale_, lmCache_.get(), lmCacheCounts_);
                 }
                 else {
                     // Go on without a cache
@@ -2400,7 +2840,7 @@ void SearchSpace::hypothesizeEpsilonPronunciations(Score bestScore) {
             std::unordered_map<InstanceKey, Instance*, InstanceKey::Hash>::iterator instIt = activeInstanceMap.find(InstanceKey(weh.recombinationHistory));
             if (instIt != activeInstanceMap.end()) {
                 // Use the network's cache to extend the LM score
-                static_cast<Instance&>(*instIt->second).addLmScore(weh, pronunciation->id(), lm_, lexicon_, wpScale_);
+                static_cast<Instance&>(*instIt->second).addLmScore(weh, pronunciation->id(), lm_, lexicon_, wpScale_, lmCache_.get(), lmCacheCounts_);
             }
             else {
                 // Go on without a cache
@@ -3254,6 +3694,13 @@ void SearchSpace::recombineWordEndsInternal(bool shallCreateLattice) {
 void SearchSpace::doWordEndStatistics() {
     PersistentStateTree const& net = network();
 
+    if (lmCache_) {
+        statistics->customStatistics("lm cache hits") += lmCacheCounts_.hits;
+        statistics->customStatistics("lm cache misses") += lmCacheCounts_.misses;
+        statistics->customStatistics("lm cache evictions") += lmCacheCounts_.evictions;
+        lmCacheCounts_.clear();
+    }
+
     if (lmLookahead_)
         lmLookahead_->collectStatistics();
 
@@ -3322,6 +3769,9 @@ void SearchSpace::setCurrentTimeFrame(TimeframeIndex timeFrame, const Mm::Featur
     if (currentPruning_.get() && currentPruning_->haveTimeDependentPruning())
         setMasterBeam(currentPruning_->beamForTime(timeFrame) * lm_->scale());
 
+    if (lmCache_)
+        lmCache_->advanceGeneration();
+
     PerformanceCounter perf(*statistics, "initialize acoustic lookahead");
 
     acousticLookAhead_->startLookAhead(timeFrame_, true);
@@ -3596,7 +4046,7 @@ void SearchSpace::processOneWordEnd(Instance const& at, StateHypothesis const& h
                                hyp.pathTrace);
     weh.score.acoustic += exitPenalty;
     auto oldScore = weh.score;
-    at.addLmScore(weh, we->pronunciation, lm_, lexicon_, wpScale_);
+    at.addLmScore(weh, we->pronunciation, lm_, lexicon_, wpScale_, lmCache_.get(), lmCacheCounts_);
 
     if (weh.score < minWordEndScore_) {
         minWordEndScore_ = weh.score;
@@ -15,6 +15,8 @@
 #ifndef SEARCH_CONDITIONEDTREESEARCHSPACE_HH
 #define SEARCH_CONDITIONEDTREESEARCHSPACE_HH
 
+#include <functional>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -87,6 +89,11 @@ public:
     // is initialized in initialize() and used in filterStates->pruneStates.
     PrefixFilter* prefixFilter;
 
+    /// Set if the automaton is shared by several searches (see share-search-network):
+    /// the static LM look-ahead structure, on which each search builds its own look-ahead.
+    bool                                        isShared;
+    AdvancedTreeSearch::LanguageModelLookahead* lmLookahead;
+
     StaticSearchAutomaton(Core::Configuration config, Core::Ref<const Am::AcousticModel> acousticModel, Bliss::LexiconRef lexicon);
     ~StaticSearchAutomaton();
 
@@ -154,7 +161,7 @@ protected:
         return automaton_->network;
     }
 
-    StaticSearchAutomaton const* automaton_;
+    std::shared_ptr<StaticSearchAutomaton const> automaton_;
 
     Lm::History                                                           unigramHistory_;
     AdvancedTreeSearch::LanguageModelLookahead::ContextLookaheadReference unigramLookAhead_;
@@ -255,13 +262,40 @@ protected:
     KeyInstanceMap                                                        activeInstanceMap;
 
     /// Temporary search space helpers:
-    StateHypothesisIndex currentTreeFirstNewStateHypothesis;
-
     typedef std::unordered_set<WordEndHypothesisList::iterator, WordEndHypothesis::Hash, WordEndHypothesis::Equality> WordEndHypothesisRecombinationMap;
     WordEndHypothesisRecombinationMap                                                                                 wordEndHypothesisMap;  // Map used for recombining word end hypotheses
 
     std::vector<StateHypothesisIndex> stateHypothesisRecombinationArray;  // Array used to recombine state hypotheses
 
+    /// Intra-frame parallelization:
+    // State expansion, acoustic scoring and acoustic pruning are distributed over contiguous ranges of instances.
+    // The per-thread results are merged in instance order, so that the result is identical to the serial one.
+    struct ThreadBuffer {
+        StateHypothesesList               hypotheses;      // Expanded state hypotheses of one range of instances
+        std::vector<StateHypothesisIndex> recombination;   // Recombination array for these hypotheses
+        std::vector<Mm::MixtureIndex>     emissions;       // Emissions requested by the range in the current timeframe
+        std::vector<u32>                  emissionStamps;  // Stamp of the last request per emission
+    };
+
+    // Fork-join workers, one per additional thread
+    class PartitionWorkers;
+
+    u32                               nThreads_;
+    u32                               threadsStateMinimum_;
+    bool                              benchmarkThreads_;
+    std::unique_ptr<PartitionWorkers> partitionWorkers_;
+    std::vector<ThreadBuffer>         threadBuffers_;
+    std::vector<u32>                  partition_;             // Boundaries of the instance ranges, nRanges + 1 entries
+    std::vector<u32>                  expandedInstanceEnds_;  // End of each instance within the buffer of its range
+    std::vector<Score>                instanceScores_;        // Per-instance minimum or pruning threshold
+    std::vector<Score>                emissionScores_;
+    std::vector<u32>                  emissionStamps_;
+    std::vector<Mm::MixtureIndex>     frameEmissions_;  // Distinct emissions scored in the current timeframe
+    u32                               emissionStamp_;
+
+    std::shared_ptr<LmCache> lmCache_;  // Shared LM score cache, may be null
+    LmCache::Counts          lmCacheCounts_;
+
     ScoreDependentStatistic statesOnDepth_;
     ScoreDependentStatistic statesOnInvertedDepth_;
 
@@ -388,10 +422,26 @@ protected:
     void addAcousticScoresInternal(Instance const& instance, Pruning& pruning, u32 from, u32 to);
     template<class Pruning>
     void addAcousticScores();
+    template<class Pruning>
+    void addAcousticScoresParallel();
 
     // Prune states, ignoring and forgetting network-assignment
     template<class Pruning>
     void pruneStates(Pruning& pruning);
+    // Same as pruneStates, distributed over multiple threads if enabled (Pruning must provide threshold())
+    template<class Pruning>
+    void pruneStatesParallel(Pruning& pruning);
+
+    // Whether the current timeframe is processed with multiple threads
+    bool parallelize() const;
+    // Splits activeInstances into contiguous ranges of similar size, one per thread
+    void partitionInstances(u32 nThreads);
+    // Calls job(p) for every range p of partition_, concurrently in the foreground and the workers
+    void forEachPartition(std::function<void(s32)> const& job);
+    // Scores the distinct emissions gathered in threadBuffers_ into emissionScores_
+    void scoreEmissions(bool concurrent);
+    // Times the parallel state expansion of the current timeframe for every number of threads
+    void benchmarkThreads();
 
     void updateSsaLm();
 
@@ -418,13 +468,23 @@ protected:
 
     void applyLookaheadInInstance(Instance* network);
 
-    inline_ void addNewStateHypothesis(const StateHypothesis& hyp) {
-        newStateHypotheses.push_back(hyp);
+    // Destination of the expansion of one instance
+    struct StateExpansionTarget {
+        StateHypothesesList&               hypotheses;
+        std::vector<StateHypothesisIndex>& recombination;
+        StateHypothesisIndex               firstHypothesis;  // First hypothesis of the instance, earlier ones are not recombined with
+
+        StateExpansionTarget(StateHypothesesList& _hypotheses, std::vector<StateHypothesisIndex>& _recombination)
+                : hypotheses(_hypotheses), recombination(_recombination), firstHypothesis(0) {}
+    };
+
+    inline_ void addNewStateHypothesis(StateExpansionTarget& target, const StateHypothesis& hyp) {
+        target.hypotheses.push_back(hyp);
     }
 
-    inline_ void activateOrUpdateStateHypothesisLoop(const StateHypothesis& hyp, Score score);
-    inline_ void activateOrUpdateStateHypothesisTransition(const StateHypothesis& hyp, Score score, StateId successorState);
-    inline_ void activateOrUpdateStateHypothesisDirectly(const StateHypothesis& hyp);
+    inline_ void activateOrUpdateStateHypothesisLoop(StateExpansionTarget& target, const StateHypothesis& hyp, Score score);
+    inline_ void activateOrUpdateStateHypothesisTransition(StateExpansionTarget& target, const StateHypothesis& hyp, Score score, StateId successorState);
+    inline_ void activateOrUpdateStateHypothesisDirectly(StateExpansionTarget& target, const StateHypothesis& hyp);
 
     /// Checks whether network should be deactivated, and if so do it.
     /// Returns true iff network has been deactivated
@@ -433,9 +493,14 @@ protected:
     Instance* createTreeInstance(const InstanceKey& key);
 
     template<bool allowSkip>
-    inline_ void expandState(const Search::StateHypothesis& hyp);
+    inline_ void expandState(StateExpansionTarget& target, const Search::StateHypothesis& hyp);
     template<bool expandForward, bool expandSkip>
-    inline_ void expandStateSlow(const Search::StateHypothesis& hyp);
+    inline_ void expandStateSlow(StateExpansionTarget& target, const Search::StateHypothesis& hyp);
+
+    // Expands the root hypotheses and the given range of stateHypotheses of the instance
+    void expandInstance(const Instance& instance, u32 oldStart, u32 oldEnd, StateExpansionTarget& target);
+    // Expands all active instances into threadBuffers_
+    void expandInstancesParallel();
 
     /// ------------ Search algorithm helpers ---------------------------:
 
@@ -44,40 +44,59 @@ u32 Instance::backOffChainStates() const {
     return states;
 }
 
-void Instance::addLmScore(EarlyWordEndHypothesis&                         hyp,
-                          Bliss::LemmaPronunciation::Id                   pron,
-                          const Core::Ref<const Lm::ScaledLanguageModel>& lm,
-                          const Bliss::LexiconRef&                        lexicon,
-                          Score                                           wpScale) const {
-    SimpleLMCache::const_iterator it = lmCache.find(pron);
-    if (it == lmCache.end()) {
+namespace {
+template<class Hypothesis>
+inline void addCachedLmScore(Hypothesis&                                     hyp,
+                             Bliss::LemmaPronunciation::Id                   pron,
+                             const Core::Ref<const Lm::ScaledLanguageModel>& lm,
+                             const Bliss::LexiconRef&                        lexicon,
+                             Score                                           wpScale,
+                             const Lm::History&                              scoreHistory,
+                             Instance::SimpleLMCache&                        lmCache,
+                             LmCache*                                        sharedCache,
+                             LmCache::Counts&                                counts) {
+    Instance::SimpleLMCache::const_iterator it = lmCache.find(pron);
+    if (it != lmCache.end()) {
+        hyp.score.lm += (*it).second;
+        return;
+    }
+
+    Score lmScore = 0;
+    if (sharedCache && sharedCache->find(LmCache::Key(scoreHistory, pron), lmScore, counts)) {
+        hyp.score.lm += lmScore;
+    }
+    else {
+        // The score is added in place, so that the result does not depend on the cache
         Score oldLmScore = hyp.score.lm;
         if (pron != Bliss::LemmaPronunciation::invalidId) {
             Lm::addLemmaPronunciationScoreOmitExtension(lm, lexicon->lemmaPronunciation(pron), wpScale, lm->scale(), scoreHistory, hyp.score.lm);
         }
-        lmCache.insert(std::make_pair(pron, hyp.score.lm - oldLmScore));
-    }
-    else {
-        hyp.score.lm += (*it).second;
+        lmScore = hyp.score.lm - oldLmScore;
+        if (sharedCache)
+            sharedCache->insert(LmCache::Key(scoreHistory, pron), lmScore, counts);
     }
+    lmCache.insert(std::make_pair(pron, lmScore));
+}
+}  // namespace
+
+void Instance::addLmScore(EarlyWordEndHypothesis&                         hyp,
+                          Bliss::LemmaPronunciation::Id                   pron,
+                          const Core::Ref<const Lm::ScaledLanguageModel>& lm,
+                          const Bliss::LexiconRef&                        lexicon,
+                          Score                                           wpScale,
+                          LmCache*                                        sharedCache,
+                          LmCache::Counts&                                counts) const {
+    addCachedLmScore(hyp, pron, lm, lexicon, wpScale, scoreHistory, lmCache, sharedCache, counts);
 }
 
 void Instance::addLmScore(WordEndHypothesis&                              hyp,
                           Bliss::LemmaPronunciation::Id                   pron,
                           const Core::Ref<const Lm::ScaledLanguageModel>& lm,
                           const Bliss::LexiconRef&                        lexicon,
-                          Score                                           wpScale) const {
-    SimpleLMCache::const_iterator it = lmCache.find(pron);
-    if (it == lmCache.end()) {
-        Score oldLmScore = hyp.score.lm;
-        if (pron != Bliss::LemmaPronunciation::invalidId) {
-            Lm::addLemmaPronunciationScoreOmitExtension(lm, lexicon->lemmaPronunciation(pron), wpScale, lm->scale(), scoreHistory, hyp.score.lm);
-        }
-        lmCache.insert(std::make_pair(pron, hyp.score.lm - oldLmScore));
-    }
-    else {
-        hyp.score.lm += (*it).second;
-    }
+                          Score                                           wpScale,
+                          LmCache*                                        sharedCache,
+                          LmCache::Counts&                                counts) const {
+    addCachedLmScore(hyp, pron, lm, lexicon, wpScale, scoreHistory, lmCache, sharedCache, counts);
 }
 
 int WordEndHypothesis::meshHistoryPhones = 1;
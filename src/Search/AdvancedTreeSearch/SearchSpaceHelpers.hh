@@ -18,6 +18,7 @@
 #include <Core/Types.hh>
 
 #include "LanguageModelLookahead.hh"
+#include "LmCache.hh"
 #include "TraceManager.hh"
 #include "TreeStructure.hh"
 
@@ -174,19 +175,23 @@ struct Instance {
     /// Returns the total number of states in this back-off chain (eg. in this tree, its back-off parents, and its back-off trees)
     u32 backOffChainStates() const;
 
-    /// Adds the LM score to the early word end hypothesis, using the tree-wise cache
+    /// Adds the LM score to the early word end hypothesis, using the tree-wise cache and the shared cache (if any)
     void addLmScore(EarlyWordEndHypothesis&                         hyp,
                     Bliss::LemmaPronunciation::Id                   pron,
                     const Core::Ref<const Lm::ScaledLanguageModel>& lm,
                     const Bliss::LexiconRef&                        lexicon,
-                    Score                                           wpScale) const;
+                    Score                                           wpScale,
+                    LmCache*                                        sharedCache,
+                    LmCache::Counts&                                counts) const;
 
-    /// Adds the LM score to the word end hypothesis, using the tree-wise cache
+    /// Adds the LM score to the word end hypothesis, using the tree-wise cache and the shared cache (if any)
     void addLmScore(WordEndHypothesis&                              hyp,
                     Bliss::LemmaPronunciation::Id                   pron,
                     const Core::Ref<const Lm::ScaledLanguageModel>& lm,
                     const Bliss::LexiconRef&                        lexicon,
-                    Score                                           wpScale) const;
+                    Score                                           wpScale,
+                    LmCache*                                        sharedCache,
+                    LmCache::Counts&                                counts) const;
 
     /// Back-off tree of this tree
     Instance* backOffInstance;
@@ -14,6 +14,7 @@
  */
 #include "Aligner.hh"
 #include <Am/ClassicAcousticModel.hh>
+#include <Core/ThreadPool.hh>
 #include <Fsa/Arithmetic.hh>
 #include <Fsa/Basic.hh>
 #include <Fsa/Best.hh>
@@ -27,6 +28,7 @@
 #include <Search/Types.hh>
 #include <Speech/AllophoneStateGraphBuilder.hh>
 #include <algorithm>
+#include <functional>
 #include <queue>
 
 using namespace Search;
@@ -38,6 +40,16 @@ static const Core::ParameterBool paramLogVariability(
         "",
         false);
 
+static const Core::ParameterInt paramThreads(
+        "threads",
+        "number of threads used to expand the state hypotheses of one timeframe. the result does not depend on the number of threads",
+        1, 1);
+
+static const Core::ParameterInt paramThreadsStateMinimum(
+        "threads-state-minimum",
+        "timeframes with less state hypotheses are expanded by a single thread",
+        1000, 0);
+
 class Aligner::SearchSpace : public Core::Component {
 private:
     typedef Fsa::StaticAutomaton Model;
@@ -70,6 +82,74 @@ private:
     mutable Fsa::StaticAutomaton*        traceback_;
     Core::Ref<Fsa::StaticAutomaton>      tracebackRef_;
 
+    /*
+     * Parallel expansion: the successor states of the previous timeframe
+     * are collected per range of source hypotheses, then each new state
+     * hypothesis is computed from the incoming arcs of its state.
+     */
+    struct IncomingArc {
+        StateId                          source;
+        u32                              arc; /**< index of the arc in the source state */
+        Am::AcousticModel::EmissionIndex emission;
+    };
+    struct Predecessor {
+        StateHypothesisIndex             shi;
+        u32                              arc;
+        Am::AcousticModel::EmissionIndex emission;
+        bool                             operator<(const Predecessor& p) const {
+            return shi < p.shi || (shi == p.shi && arc < p.arc);
+        }
+    };
+    struct ThreadBuffer {
+        std::vector<u32>                              stateStamps, emissionStamps;
+        std::vector<StateId>                          targets;
+        std::vector<Am::AcousticModel::EmissionIndex> emissions;
+        std::vector<Predecessor>                      predecessors;
+    };
+    /*
+     * Fork-join over the partitions of a timeframe, see forEachPartition().
+     */
+    struct PartitionTask {
+        const std::function<void(s32)>* job;
+        s32                             partition;
+    };
+    class PartitionMapper {
+    public:
+        PartitionMapper* clone() const {
+            return new PartitionMapper();
+        }
+        void map(const PartitionTask& task) {
+            (*task.job)(task.partition);
+        }
+        void reset() {}
+    };
+    typedef Core::ThreadPool<PartitionTask, PartitionMapper> ThreadPool;
+
+    u32         nThreads_;
+    u32         threadsStateMinimum_;
+    ThreadPool* threadPool_;
+    /*
+     * Emission index of each arc of the model, the arcs of state s start
+     * at arcBegin_[s].  The acoustic model caches its emission indices
+     * lazily, therefore it is not called by the threads.
+     */
+    std::vector<u32>                              arcBegin_;
+    std::vector<Am::AcousticModel::EmissionIndex> arcEmissions_;
+    std::vector<u32>                              incomingBegin_;
+    std::vector<IncomingArc>                      incoming_;
+    std::vector<StateHypothesisIndex>             sourceHypothesis_;
+    std::vector<ThreadBuffer>                     threadBuffers_;
+    std::vector<StateId>                          targets_;
+    std::vector<Fsa::State*>                      targetTracebackStates_;
+    std::vector<u32>                              targetStamps_, emissionStamps_;
+    std::vector<Score>                            emissionScores_;
+    u32                                           stamp_;
+
+    void                   buildIncomingArcs(Core::Ref<const Am::AcousticModel> acousticModel);
+    bool                   useThreads(StateHypothesisIndex nSources) const;
+    void                   forEachPartition(s32 nPartitions, const std::function<void(s32)>& job);
+    void                   expandParallel(Core::Ref<const Am::AcousticModel> acousticModel,
+                                          Mm::FeatureScorer::Scorer&         emissionScores);
     void                   activateOrUpdateStateHypothesisViterbi(StateId, Score, Trace, Am::AllophoneStateIndex);
     void                   activateOrUpdateStateHypothesisBaumWelch(StateId, Score, Trace, Am::AllophoneStateIndex, Fsa::Weight);
     void                   deleteStateHypothesisViterbi(StateHypothesisIndex shi);
@@ -79,8 +159,9 @@ private:
 
 public:
     SearchSpace(const Core::Configuration&);
+    ~SearchSpace();
     void           setViterbi(bool viterbi);
-    void           setModel(Fsa::ConstAutomatonRef);
+    void           setModel(Fsa::ConstAutomatonRef, Core::Ref<const Am::AcousticModel>);
     void           clear();
     void           addStartupHypothesis();
     TimeframeIndex time() const {
@@ -102,7 +183,31 @@ public:
 };
 
 Aligner::SearchSpace::SearchSpace(const Core::Configuration& c)
-        : Core::Component(c), viterbi_(true), logVariability_(paramLogVariability(c)), time_(0), traceback_(new Fsa::StaticAutomaton), tracebackRef_(Core::ref(traceback_)) {}
+        : Core::Component(c),
+          viterbi_(true),
+          logVariability_(paramLogVariability(c)),
+          time_(0),
+          traceback_(new Fsa::StaticAutomaton),
+          tracebackRef_(Core::ref(traceback_)),
+          nThreads_(paramThreads(c)),
+          threadsStateMinimum_(paramThreadsStateMinimum(c)),
+          threadPool_(0),
+          stamp_(0) {
+    if (nThreads_ > 1 && logVariability_) {
+        warning() << "log-variability is only supported by the serial expansion, using a single thread";
+        nThreads_ = 1;
+    }
+    if (nThreads_ > 1) {
+        log() << "expanding state hypotheses with up to " << nThreads_ << " threads";
+        threadBuffers_.resize(nThreads_);
+        threadPool_ = new ThreadPool();
+        threadPool_->init(nThreads_);
+    }
+}
+
+Aligner::SearchSpace::~SearchSpace() {
+    delete threadPool_;
+}
 
 void Aligner::SearchSpace::setViterbi(bool viterbi) {
     viterbi_ = viterbi;
@@ -112,12 +217,53 @@ void Aligner::SearchSpace::setViterbi(bool viterbi) {
     // (E.g. Speech/PhonemeSequenceAlignmentGenerator.)
 }
 
-void Aligner::SearchSpace::setModel(Fsa::ConstAutomatonRef m) {
+void Aligner::SearchSpace::setModel(Fsa::ConstAutomatonRef m, Core::Ref<const Am::AcousticModel> acousticModel) {
     require(m);
     model_ = Core::ref((const Model*)(Fsa::staticCopy(m).get()));
+    if (nThreads_ > 1)
+        buildIncomingArcs(acousticModel);
     clear();
 }
 
+void Aligner::SearchSpace::buildIncomingArcs(Core::Ref<const Am::AcousticModel> acousticModel) {
+    const u32 nStates = model_->size();
+    arcBegin_.assign(nStates + 1, 0);
+    incomingBegin_.assign(nStates + 1, 0);
+    for (StateId s = 0; s < nStates; ++s) {
+        const Fsa::State* sp = model_->fastState(s);
+        if (!sp)
+            continue;
+        arcBegin_[s + 1] = sp->nArcs();
+        for (Fsa::State::const_iterator a = sp->begin(); a != sp->end(); ++a)
+            ++incomingBegin_[a->target_ + 1];
+    }
+    for (StateId s = 0; s < nStates; ++s) {
+        arcBegin_[s + 1] += arcBegin_[s];
+        incomingBegin_[s + 1] += incomingBegin_[s];
+    }
+    arcEmissions_.resize(arcBegin_[nStates]);
+    incoming_.resize(incomingBegin_[nStates]);
+    std::vector<u32> next(incomingBegin_.begin(), incomingBegin_.end() - 1);
+    for (StateId s = 0; s < nStates; ++s) {
+        const Fsa::State* sp = model_->fastState(s);
+        if (!sp)
+            continue;
+        for (u32 i = 0; i < sp->nArcs(); ++i) {
+            const Fsa::Arc* a = sp->getArc(i);
+            arcEmissions_[arcBegin_[s] + i] = acousticModel->emissionIndex(a->input_);
+            IncomingArc& in(incoming_[next[a->target_]++]);
+            in.source   = s;
+            in.arc      = i;
+            in.emission = arcEmissions_[arcBegin_[s] + i];
+        }
+    }
+    sourceHypothesis_.assign(nStates, 0);
+    targetStamps_.assign(nStates, 0);
+    for (u32 p = 0; p < threadBuffers_.size(); ++p)
+        threadBuffers_[p].stateStamps.assign(nStates, 0);
+    stamp_ = 0;
+}
+
 void Aligner::SearchSpace::clear() {
     stateHypotheses_.clear();
     stateHypotheses_.shrink_to_fit();
@@ -207,6 +353,10 @@ void Aligner::SearchSpace::expand(
         Core::Ref<const Am::AcousticModel> acousticModel,
         Mm::FeatureScorer::Scorer&         emissionScores) {
     require_(model_);
+    if (useThreads(StateHypothesisIndex(stateHypotheses_.size()) - firstHypCurrentFrame_)) {
+        expandParallel(acousticModel, emissionScores);
+        return;
+    }
     StateHypothesisIndex firstHypPreviousFrame = firstHypCurrentFrame_;
     firstHypCurrentFrame_                      = stateHypotheses_.size();
     Core::Statistics<f32> variability("emission score variability");
@@ -242,6 +392,186 @@ void Aligner::SearchSpace::expand(
     ++time_;
 }
 
+bool Aligner::SearchSpace::useThreads(StateHypothesisIndex nSources) const {
+    return nThreads_ > 1 && nSources > 1 && u32(nSources) >= threadsStateMinimum_;
+}
+
+void Aligner::SearchSpace::forEachPartition(s32 nPartitions, const std::function<void(s32)>& job) {
+    if (nPartitions == 1) {
+        job(0);
+        return;
+    }
+    for (s32 p = 0; p < nPartitions; ++p) {
+        PartitionTask task;
+        task.job       = &job;
+        task.partition = p;
+        threadPool_->submit(task);
+    }
+    threadPool_->wait();
+}
+
+/*
+ * Same result as the serial expansion for any number of threads:
+ * - new state hypotheses are created in the order in which the serial
+ *   expansion reaches their states first,
+ * - each new state hypothesis combines its predecessors in the order of
+ *   the serial expansion (source hypothesis, then arc), so ties in Viterbi
+ *   mode and the summation order in Baum-Welch mode are unchanged.
+ * Context scorers fill their caches lazily and are not thread-safe,
+ * therefore the distinct emissions of the timeframe are scored in the
+ * foreground.  The threads use the emission indices of the arcs computed
+ * in setModel() only.
+ */
+void Aligner::SearchSpace::expandParallel(
+        Core::Ref<const Am::AcousticModel> acousticModel,
+        Mm::FeatureScorer::Scorer&         emissionScores) {
+    const StateHypothesisIndex firstHypPreviousFrame = firstHypCurrentFrame_;
+    firstHypCurrentFrame_                            = stateHypotheses_.size();
+    const s32 nSources    = firstHypCurrentFrame_ - firstHypPreviousFrame;
+    const s32 nPartitions = std::min(s32(nThreads_), nSources);
+
+    const u32 nEmissions = acousticModel->nEmissions();
+    if (emissionScores_.size() < nEmissions) {
+        emissionScores_.resize(nEmissions);
+        emissionStamps_.resize(nEmissions, 0);
+    }
+    if (++stamp_ == 0) {
+        std::fill(targetStamps_.begin(), targetStamps_.end(), 0);
+        std::fill(emissionStamps_.begin(), emissionStamps_.end(), 0);
+        for (u32 p = 0; p < threadBuffers_.size(); ++p) {
+            std::fill(threadBuffers_[p].stateStamps.begin(), threadBuffers_[p].stateStamps.end(), 0);
+            std::fill(threadBuffers_[p].emissionStamps.begin(), threadBuffers_[p].emissionStamps.end(), 0);
+        }
+        stamp_ = 1;
+    }
+
+    // successor states and emissions of each range of source hypotheses in order of first occurrence
+    forEachPartition(nPartitions, [&](s32 p) {
+        ThreadBuffer& buffer(threadBuffers_[p]);
+        if (buffer.emissionStamps.size() < nEmissions)
+            buffer.emissionStamps.resize(nEmissions, 0);
+        buffer.targets.clear();
+        buffer.emissions.clear();
+        const StateHypothesisIndex begin = firstHypPreviousFrame + s64(nSources) * p / nPartitions;
+        const StateHypothesisIndex end   = firstHypPreviousFrame + s64(nSources) * (p + 1) / nPartitions;
+        for (StateHypothesisIndex shi = begin; shi < end; ++shi) {
+            const StateId state      = stateHypotheses_[shi].state;
+            sourceHypothesis_[state] = shi;
+
+            const Fsa::State*                       s = model_->fastState(state);
+            const Am::AcousticModel::EmissionIndex* e = arcEmissions_.data() + arcBegin_[state];
+            for (Fsa::State::const_iterator a = s->begin(); a != s->end(); ++a, ++e) {
+                if (buffer.stateStamps[a->target_] != stamp_) {
+                    buffer.stateStamps[a->target_] = stamp_;
+                    buffer.targets.push_back(a->target_);
+                }
+                if (buffer.emissionStamps[*e] != stamp_) {
+                    buffer.emissionStamps[*e] = stamp_;
+                    buffer.emissions.push_back(*e);
+                }
+            }
+        }
+    });
+
+    targets_.clear();
+    for (s32 p = 0; p < nPartitions; ++p) {
+        const ThreadBuffer& buffer(threadBuffers_[p]);
+        for (std::vector<StateId>::const_iterator t = buffer.targets.begin(); t != buffer.targets.end(); ++t) {
+            if (targetStamps_[*t] != stamp_) {
+                targetStamps_[*t] = stamp_;
+                targets_.push_back(*t);
+            }
+        }
+        for (std::vector<Am::AcousticModel::EmissionIndex>::const_iterator e = buffer.emissions.begin(); e != buffer.emissions.end(); ++e) {
+            if (emissionStamps_[*e] != stamp_) {
+                emissionStamps_[*e] = stamp_;
+                emissionScores_[*e] = emissionScores->score(*e);
+            }
+        }
+    }
+
+    // recombination of the predecessors of each new state hypothesis
+    const s32 nTargets = targets_.size();
+    stateHypotheses_.resize(firstHypCurrentFrame_ + nTargets, StateHypothesis(Fsa::InvalidStateId, 0.0, invalidTrace, 0));
+    if (!viterbi_)
+        targetTracebackStates_.resize(nTargets);
+    const s32 nTargetPartitions = std::max(1, std::min(nPartitions, nTargets));
+    // not reference counted by the threads
+    const Fsa::Semiring* semiring = traceback_->semiring().get();
+    forEachPartition(nTargetPartitions, [&](s32 p) {
+        std::vector<Predecessor>& predecessors(threadBuffers_[p].predecessors);
+        const s32                 begin = s64(nTargets) * p / nTargetPartitions;
+        const s32                 end   = s64(nTargets) * (p + 1) / nTargetPartitions;
+        for (s32 i = begin; i < end; ++i) {
+            const StateId target = targets_[i];
+            predecessors.clear();
+            for (u32 j = incomingBegin_[target]; j < incomingBegin_[target + 1]; ++j) {
+                const IncomingArc&         in(incoming_[j]);
+                const StateHypothesisIndex shi = sourceHypothesis_[in.source];
+                if (shi >= firstHypPreviousFrame && shi < firstHypCurrentFrame_ && stateHypotheses_[shi].state == in.source) {
+                    Predecessor pred;
+                    pred.shi      = shi;
+                    pred.arc      = in.arc;
+                    pred.emission = in.emission;
+                    predecessors.push_back(pred);
+                }
+            }
+            verify_(!predecessors.empty());
+            std::sort(predecessors.begin(), predecessors.end());
+
+            StateHypothesis& sh(stateHypotheses_[firstHypCurrentFrame_ + i]);
+            sh.state = target;
+            if (viterbi_) {
+                for (std::vector<Predecessor>::const_iterator pred = predecessors.begin(); pred != predecessors.end(); ++pred) {
+                    const Fsa::Arc* a               = model_->fastState(stateHypotheses_[pred->shi].state)->getArc(pred->arc);
+                    Score           emissionScore   = emissionScores_[pred->emission];
+                    Score           transitionScore = Score(a->weight_);
+                    Score           sco             = stateHypotheses_[pred->shi].score + transitionScore + emissionScore;
+                    if (pred == predecessors.begin() || sh.score >= sco) {
+                        sh.score    = sco;
+                        sh.trace    = pred->shi;
+                        sh.emission = a->input_;
+                    }
+                }
+            }
+            else {  // baum-welch
+                Fsa::State* toShs = new Fsa::State(firstHypCurrentFrame_ + i);
+                for (std::vector<Predecessor>::const_iterator pred = predecessors.begin(); pred != predecessors.end(); ++pred) {
+                    const Fsa::Arc* a               = model_->fastState(stateHypotheses_[pred->shi].state)->getArc(pred->arc);
+                    Score           emissionScore   = emissionScores_[pred->emission];
+                    Score           transitionScore = Score(a->weight_);
+                    Score           arcScore        = transitionScore + emissionScore;
+                    Score           potential       = stateHypotheses_[pred->shi].score + arcScore;
+                    if (pred == predecessors.begin())
+                        sh.score = potential;
+                    else
+                        sh.score = (Score)semiring->collect((Fsa::Weight)sh.score, (Fsa::Weight)potential);
+                    sh.trace    = pred->shi;
+                    sh.emission = a->input_;
+                    toShs->newArc(traceback_->fastState(pred->shi)->id(), (Fsa::Weight)arcScore, a->input_);
+                }
+                targetTracebackStates_[i] = toShs;
+            }
+        }
+    });
+
+    for (s32 i = 0; i < nTargets; ++i)
+        stateHypothesisForState_[targets_[i]] = firstHypCurrentFrame_ + i;
+    if (viterbi_) {
+        for (StateHypothesisIndex shi = firstHypCurrentFrame_; shi < (StateHypothesisIndex)stateHypotheses_.size(); ++shi)
+            ++stateHypotheses_[stateHypotheses_[shi].trace].nRefs;
+    }
+    else {
+        for (s32 i = 0; i < nTargets; ++i) {
+            Fsa::State* toShs = targetTracebackStates_[i];
+            traceback_->setState(toShs);
+            for (Fsa::State::const_iterator a = toShs->begin(); a != toShs->end(); ++a)
+                ++stateHypotheses_[a->target()].nRefs;
+        }
+    }
+    ++time_;
+}
+
 Score Aligner::SearchSpace::minimumScore() const {
     Score result = Core::Type<Score>::max;
     for (StateHypothesisList::const_iterator sh = stateHypotheses_.begin() + firstHypCurrentFrame_;
@@ -569,7 +899,7 @@ void Aligner::setModel(Fsa::ConstAutomatonRef             model,
     require(model->initialStateId() != Fsa::InvalidStateId);
     model_         = model;
     acousticModel_ = acousticModel;
-    ss_->setModel(model_);
+    ss_->setModel(model_, acousticModel_);
     ss_->addStartupHypothesis();
     nStateHypotheses_.clear();
     acousticPruningThreshold_ = maxAcousticPruningThreshold_;
@@ -17,7 +17,9 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <chrono>
 
+#include <Core/Dependency.hh>
 #include <Fsa/Stack.hh>
 #include <Search/Wfst/CompressedNetwork.hh>
 
@@ -135,9 +137,10 @@ public:
         network_->nStates_      = fsa_.nStates();
         network_->nArcs_        = fsa_.nArcs();
         network_->nEpsilonArcs_ = fsa_.nEpsilonArcs();
-        states_                 = static_cast<State*>(malloc(network_->nStates_ * sizeof(State)));
-        arcs_                   = static_cast<Arc*>(malloc(network_->nArcs_ * sizeof(Arc)));
-        epsilonArcs_            = static_cast<EpsilonArc*>(malloc(network_->nEpsilonArcs_ * sizeof(EpsilonArc)));
+        // zero initialized, so that padding bytes in the image are deterministic
+        states_      = static_cast<State*>(calloc(network_->nStates_, sizeof(State)));
+        arcs_        = static_cast<Arc*>(calloc(network_->nArcs_, sizeof(Arc)));
+        epsilonArcs_ = static_cast<EpsilonArc*>(calloc(network_->nEpsilonArcs_, sizeof(EpsilonArc)));
         curStates_ = curArcs_ = curEpsArcs_             = 0;
         typename Automaton::StateId             initial = fsa_.initialStateId();
         Fsa::Stack<typename Automaton::StateId> statesToExplore;
@@ -153,7 +156,7 @@ public:
         }
         verify(curStates_ == network_->nStates());
         verify(curArcs_ == network_->nArcs());
-        verify(curEpsArcs_ = network_->nEpsilonArcs());
+        verify(curEpsArcs_ == network_->nEpsilonArcs());
         network_->initialStateIndex_ = stateIndex_[initial];
     }
 };
@@ -169,6 +172,9 @@ struct CompressedNetwork::ImageHeader {
 
     char   magic[8];
     u32    version;
+    u32    byteOrder;
+    u32    layout;
+    u32    dependencyChecksum; /* 0 if built without dependencies */
     u32    initialStateIndex;
     u32    nStates;
     u32    nArcs;
@@ -180,10 +186,17 @@ struct CompressedNetwork::ImageHeader {
 
     static const char* magicWord;
     static const u32   formatVersion;
+    static const u32   byteOrderMark;
+
+    /** sizes of the stored structures */
+    static u32 currentLayout() {
+        return (sizeof(State) << 16) | (sizeof(Arc) << 8) | sizeof(EpsilonArc);
+    }
 };
 
 const char* CompressedNetwork::ImageHeader::magicWord     = "RWTH_NWF";
-const u32   CompressedNetwork::ImageHeader::formatVersion = 4;
+const u32   CompressedNetwork::ImageHeader::formatVersion = 5;
+const u32   CompressedNetwork::ImageHeader::byteOrderMark = 0x01020304;
 
 /******************************************************************************/
 
@@ -195,12 +208,15 @@ const Core::ParameterChoice CompressedNetwork::paramAutomatonType_(
         "automaton-type", &choiceAutomatonType, "type of network", AutomatonTypeFst);
 const Core::ParameterString CompressedNetwork::paramNetworkFile_(
         "network-file", "search network to load", "");
+const Core::ParameterBool CompressedNetwork::paramPrefetch_(
+        "prefetch", "read the whole network image into the page cache when mapping it", false);
 
 const CompressedNetwork::ArcIndex CompressedNetwork::InvalidArcIndex = Core::Type<CompressedNetwork::ArcIndex>::max;
 const Score                       CompressedNetwork::NonFinalWeight  = static_cast<Score>(0xffffffff);
+const u32                         CompressedNetwork::ImageAlignment  = 64;
 
 CompressedNetwork::CompressedNetwork(const Core::Configuration& c, bool loadNetwork)
-        : Core::Component(c), states_(0), arcs_(0), epsilonArcs_(0), mmap_(0), mmapSize_(0), loadNetwork_(loadNetwork) {
+        : Core::Component(c), states_(0), arcs_(0), epsilonArcs_(0), dependencyChecksum_(0), mmap_(0), mmapSize_(0), loadNetwork_(loadNetwork) {
 }
 
 CompressedNetwork::~CompressedNetwork() {
@@ -213,6 +229,15 @@ CompressedNetwork::~CompressedNetwork() {
         ::free(epsilonArcs_);
     }
 }
+void CompressedNetwork::setLexicon(Bliss::LexiconRef lexicon) {
+    dependencyChecksum_ = 0;
+    if (lexicon) {
+        Core::DependencySet dependencies;
+        dependencies.add("lexicon", lexicon->getDependency());
+        dependencyChecksum_ = dependencies.getChecksum();
+    }
+}
+
 bool CompressedNetwork::init() {
     std::string networkFile = paramNetworkFile_(config);
     if (loadNetwork_) {
@@ -265,15 +290,15 @@ bool CompressedNetwork::write(const std::string& file) const {
 
 namespace {
 template<class T>
-bool writeArray(int fd, u64& offset, T* data, size_t nElements) {
-    off_t   pos, pad;
+bool writeArray(int fd, u64& offset, T* data, size_t nElements, u32 alignment) {
+    off_t   pos;
     ssize_t nBytes;
     if ((pos = lseek(fd, 0, SEEK_CUR)) == (off_t)-1)
         return false;
-    pad = (pos + 7) % 8;
-    if ((pos = lseek(fd, pad, SEEK_CUR)) == (off_t)-1)
+    std::vector<char> pad((alignment - pos % alignment) % alignment, 0);
+    if (write(fd, pad.data(), pad.size()) != ssize_t(pad.size()))
         return false;
-    offset = pos;
+    offset = pos + pad.size();
     nBytes = sizeof(T) * nElements;
     if (write(fd, data, nBytes) != nBytes)
         return false;
@@ -287,26 +312,30 @@ u32 CompressedNetwork::writeData(int fd) const {
     ImageHeader header;
 
     // write header
+    memset(&header, 0, sizeof(ImageHeader));
     memcpy(header.magic, ImageHeader::magicWord, 8);
-    header.version           = ImageHeader::formatVersion;
-    header.initialStateIndex = initialStateIndex_;
-    header.nStates           = nStates();
-    header.nArcs             = nArcs();
-    header.nEpsilonArcs      = nEpsilonArcs();
-    header.statesOffset      = 0;
-    header.arcsOffset        = 0;
-    header.epsArcsOffset     = 0;
-    header.end               = 0;
-    nBytes                   = sizeof(ImageHeader);
+    header.version            = ImageHeader::formatVersion;
+    header.byteOrder          = ImageHeader::byteOrderMark;
+    header.layout             = ImageHeader::currentLayout();
+    header.dependencyChecksum = dependencyChecksum_;
+    header.initialStateIndex  = initialStateIndex_;
+    header.nStates            = nStates();
+    header.nArcs              = nArcs();
+    header.nEpsilonArcs       = nEpsilonArcs();
+    header.statesOffset       = 0;
+    header.arcsOffset         = 0;
+    header.epsArcsOffset      = 0;
+    header.end                = 0;
+    nBytes                    = sizeof(ImageHeader);
     if (::write(fd, &header, nBytes) != nBytes)
         return 1;
 
     // write arrays
-    if (!writeArray(fd, header.statesOffset, states_, nStates()))
+    if (!writeArray(fd, header.statesOffset, states_, nStates(), ImageAlignment))
         return 2;
-    if (!writeArray(fd, header.arcsOffset, arcs_, nArcs()))
+    if (!writeArray(fd, header.arcsOffset, arcs_, nArcs(), ImageAlignment))
         return 3;
-    if (!writeArray(fd, header.epsArcsOffset, epsilonArcs_, nArcs()))
+    if (!writeArray(fd, header.epsArcsOffset, epsilonArcs_, nEpsilonArcs(), ImageAlignment))
         return 4;
 
     // determine file size
@@ -329,12 +358,17 @@ bool CompressedNetwork::read(const std::string& file) {
         error("cannot open '%s' for reading", file.c_str());
         return false;
     }
-    bool r = readData(fd);
+    auto start = std::chrono::steady_clock::now();
+    bool r     = readData(fd);
+    close(fd);
+    auto end = std::chrono::steady_clock::now();
     if (!r) {
         error("cannot read network from '%s'", file.c_str());
     }
     else {
-        log("memory mapped '%s'", file.c_str());
+        log("memory mapped '%s' in %.1f ms: %d states, %d arcs, %d epsilon arcs",
+            file.c_str(), std::chrono::duration<double, std::milli>(end - start).count(),
+            nStates(), nArcs(), nEpsilonArcs());
     }
     return r;
 }
@@ -355,16 +389,39 @@ bool CompressedNetwork::readData(int fd) {
         warning("file format is in version %d, expected %d", header.version, ImageHeader::formatVersion);
         return false;
     }
+    if (header.byteOrder != ImageHeader::byteOrderMark || header.layout != ImageHeader::currentLayout()) {
+        warning("network image was written on an incompatible platform");
+        return false;
+    }
+    if (header.dependencyChecksum && dependencyChecksum_ && header.dependencyChecksum != dependencyChecksum_) {
+        warning("dependencies of the network image (checksum %u) do not equal the required dependencies (checksum %u)",
+                header.dependencyChecksum, dependencyChecksum_);
+        return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || header.end > u64(status.st_size) ||
+        header.statesOffset % ImageAlignment || header.arcsOffset % ImageAlignment || header.epsArcsOffset % ImageAlignment ||
+        header.statesOffset + u64(header.nStates) * sizeof(State) > header.end ||
+        header.arcsOffset + u64(header.nArcs) * sizeof(Arc) > header.end ||
+        header.epsArcsOffset + u64(header.nEpsilonArcs) * sizeof(EpsilonArc) > header.end) {
+        warning("network image is truncated or corrupt");
+        return false;
+    }
     nStates_           = header.nStates;
     nArcs_             = header.nArcs;
     nEpsilonArcs_      = header.nEpsilonArcs;
     initialStateIndex_ = header.initialStateIndex;
 
-    mmap_ = (char*)mmap(0, mmapSize_ = header.end, PROT_READ, MAP_SHARED, fd, 0);
-    if (mmap_ == MAP_FAILED) {
+    int flags = MAP_SHARED;
+    if (paramPrefetch_(config))
+        flags |= MAP_POPULATE;
+    void* m = mmap(0, header.end, PROT_READ, flags, fd, 0);
+    if (m == MAP_FAILED) {
         error("mmap failed");
         return false;
     }
+    mmap_        = static_cast<char*>(m);
+    mmapSize_    = header.end;
     states_      = reinterpret_cast<State*>(mmap_ + header.statesOffset);
     arcs_        = reinterpret_cast<Arc*>(mmap_ + header.arcsOffset);
     epsilonArcs_ = reinterpret_cast<EpsilonArc*>(mmap_ + header.epsArcsOffset);
@@ -32,6 +32,13 @@ namespace Wfst {
  * Limitations apply to the number of arcs per state (u16),
  * number of epsilon arcs per state (u8) and number of labels (u16).
  * Labels are stored in OpenFst format (Epsilon = 0)
+ *
+ * The image file contains the arrays of states, arcs and epsilon arcs in
+ * their in-memory layout, each aligned to ImageAlignment bytes.  The file
+ * is mapped read-only and shared, i.e. all processes using the same image
+ * share its physical pages.  The header stores the layout of the arrays
+ * and the checksum of the dependencies (lexicon) the network was built
+ * with; images of other dependencies or layouts are rejected.
  */
 class CompressedNetwork : public Core::Component {
 private:
@@ -39,6 +46,7 @@ private:
     static const Core::ParameterChoice paramAutomatonType_;
     static const Core::ParameterString paramNetworkFile_;
     static const Core::ParameterBool   paramRemoveEpsArcs_;
+    static const Core::ParameterBool   paramPrefetch_;
 
 public:
     typedef u32            ArcIndex;
@@ -83,11 +91,13 @@ public:
 private:
     static const ArcIndex InvalidArcIndex;
     static const Score    NonFinalWeight;
+    static const u32      ImageAlignment;
     States                states_;
     Arcs                  arcs_;
     EpsilonArcs           epsilonArcs_;
     StateIndex            initialStateIndex_;
     u32                   nStates_, nArcs_, nEpsilonArcs_;
+    u32                   dependencyChecksum_;  // 0 if no dependencies are set
 
 public:
     CompressedNetwork(const Core::Configuration&, bool loadNetwork = true);
@@ -96,7 +106,8 @@ public:
     bool build(const OpenFst::VectorFst* f, bool removeEpsArcs = false);
     bool write(const std::string& file) const;
     bool read(const std::string& file);
-    void setLexicon(Bliss::LexiconRef lexicon) {}
+    /** Adds the lexicon to the dependencies of the image; call before write() and read(). */
+    void setLexicon(Bliss::LexiconRef lexicon);
     bool init();
 
     u32 nArcs() const {
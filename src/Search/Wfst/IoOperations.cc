@@ -151,6 +151,7 @@ Operation::AutomatonRef WriteFsa::process() {
 
 Operation::AutomatonRef Compress::process() {
     CompressedNetwork network(config, false);
+    network.setLexicon(resources_.lexicon());
     if (!network.build(input_, false)) {
         FileOperation::error("cannot build compressed network");
     }
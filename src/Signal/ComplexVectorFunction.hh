@@ -190,7 +190,7 @@ public:
         if (!getData(0, in))
             return putData(0, in.get());
 
-        Flow::Vector<ResultType>* out = new Flow::Vector<ResultType>;
+        Flow::Vector<ResultType>* out = Flow::Vector<ResultType>::create();
         function_(*in, *out);
         out->setTimestamp(*in);
         return putData(0, out);
@@ -221,7 +221,7 @@ bool CosineTransformNode::work(Flow::PortId p) {
         criticalError("Input size (%zd) does not match the expected input size (%zd)",
                       in->size(), inputSize());
 
-    Flow::Vector<f32>* out = new Flow::Vector<f32>;
+    Flow::Vector<f32>* out = Flow::Vector<f32>::create();
     out->setTimestamp(*in);
     apply(*in, *out);
     return putData(0, out);
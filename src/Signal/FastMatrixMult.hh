@@ -120,7 +120,7 @@ bool FastMatrixMultiplicationNode<T>::work(Flow::PortId p) {
                 << ", expected " << nCols_;
 
     // create output object and reserve space
-    Flow::DataPtr<Flow::Vector<T>> out(new Flow::Vector<T>(nRows_));
+    Flow::DataPtr<Flow::Vector<T>> out(Flow::Vector<T>::create(nRows_));
     out->setTimestamp(*in);
 
     // apply matrix, use Blas matrix-vector multiplication routine
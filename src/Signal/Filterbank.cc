@@ -867,7 +867,7 @@ bool FilterBankNode::work(Flow::PortId p) {
         criticalError("Input size (%zd) does not match the expected input size (%d)",
                       in->size(), inputSize_);
     }
-    Flow::Vector<f32>* out = new Flow::Vector<f32>;
+    Flow::Vector<f32>* out = Flow::Vector<f32>::create();
     out->setTimestamp(*in);
     apply(*in, *out);
     return putData(0, out);
@@ -313,7 +313,7 @@ bool GammaToneNode::work(Flow::PortId p) {
         setWarpWarpingFactor(warpingValue);
     }
 
-    Flow::Vector<Flow::Vector<f32>>* out = new Flow::Vector<Flow::Vector<f32>>();
+    Flow::Vector<Flow::Vector<f32>>* out = Flow::Vector<Flow::Vector<f32>>::create();
 
     in.makePrivate();
     apply(*in, *out);
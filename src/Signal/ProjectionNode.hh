@@ -96,7 +96,7 @@ bool ProjectionNode<T>::work(Flow::PortId p) {
     if (!getData(0, in))
         return putData(0, in.get());
 
-    Flow::Vector<T>* out = new Flow::Vector<T>;
+    Flow::Vector<T>* out = Flow::Vector<T>::create();
 
     //loop over components
     u32 cmp = 0;
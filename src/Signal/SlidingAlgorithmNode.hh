@@ -58,7 +58,7 @@ public:
 template<class Algorithm>
 bool SlidingAlgorithmNode<Algorithm>::work(Flow::PortId p) {
     Flow::DataPtr<InputData>  in;
-    Flow::DataPtr<OutputData> out(new OutputData);
+    Flow::DataPtr<OutputData> out(OutputData::create());
 
     while (!Algorithm::get(*out)) {
         if (!getData(0, in)) {
@@ -80,7 +80,7 @@ bool SlidingAlgorithmNode<Algorithm>::flushAllAndPut(Flow::PortId p, const Input
     Flow::DataPtr<OutputData> out;
 
     do {
-        out = Flow::dataPtr(new OutputData());
+        out = Flow::dataPtr(OutputData::create());
         if (!Algorithm::flush(*out))
             break;
         if (!putData(0, out.get()))
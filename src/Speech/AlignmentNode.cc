@@ -400,7 +400,7 @@ AlignmentDumpNode::AlignmentDumpNode(const Core::Configuration& c)
 }
 
 AlignmentDumpNode::~AlignmentDumpNode() {
-    delete archive_;
+    Core::Archive::releaseShared(archive_);
     archive_ = 0;
 }
 
@@ -483,14 +483,14 @@ bool AlignmentDumpNode::open(Core::Archive::AccessMode _access) {
         (!Core::isValidPath(filename_) &&
          !(_access & Core::Archive::AccessModeWrite)))
         return false;
-    archive_ = Core::Archive::create(config, filename_, _access);
+    archive_ = Core::Archive::createShared(config, filename_, _access);
     return isOpen();
 }
 
 void AlignmentDumpNode::close() {
     if (!isOpen())
         return;
-    delete archive_;
+    Core::Archive::releaseShared(archive_);
     archive_ = 0;
 }
 
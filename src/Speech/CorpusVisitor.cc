@@ -18,6 +18,7 @@
 #include <Core/XmlStream.hh>
 #include <Flow/Network.hh>
 #include "CorpusProcessor.hh"
+#include "ProgressJournal.hh"
 
 using namespace Core;
 
@@ -143,7 +144,26 @@ void clearParameter(Bliss::SpeechSegment* speechSegment, ParameterAdaptor parame
 CorpusVisitor::CorpusVisitor(const Core::Configuration& c)
         : Core::Component(c),
           recordingIndex_(0),
-          segmentIndex_(0) {}
+          segmentIndex_(0),
+          journal_(ProgressJournal::acquire(select("progress-journal"))) {}
+
+CorpusVisitor::CorpusVisitor(const Core::Configuration& c, bool useProgressJournal)
+        : Core::Component(c),
+          recordingIndex_(0),
+          segmentIndex_(0),
+          journal_(useProgressJournal ? ProgressJournal::acquire(select("progress-journal")) : 0) {}
+
+CorpusVisitor::~CorpusVisitor() {
+    ProgressJournal::release(journal_);
+}
+
+bool CorpusVisitor::skipFinished(Bliss::Segment* segment) {
+    if (!journal_ || !journal_->isFinished(segment->fullName()))
+        return false;
+    journal_->skip(segment->fullName());
+    ++segmentIndex_;
+    return true;
+}
 
 void CorpusVisitor::enterCorpus(Bliss::Corpus* corpus) {
     Bliss::CorpusVisitor::enterCorpus(corpus);
@@ -179,6 +199,8 @@ void CorpusVisitor::leaveRecording(Bliss::Recording* recording) {
 }
 
 void CorpusVisitor::visitSegment(Bliss::Segment* segment) {
+    if (skipFinished(segment))
+        return;
     setParameter(segmentIndex_, segment, DataSourceParameterAdaptor(dataSources_));
     setParameter(segmentIndex_, segment, StringExpressionAdaptor(corpusKeys_));
 
@@ -188,10 +210,14 @@ void CorpusVisitor::visitSegment(Bliss::Segment* segment) {
         corpusProcessors_[i]->processSegment(segment);
     for (size_t i = 0; i < corpusProcessors_.size(); ++i)
         corpusProcessors_[i]->leaveSegment(segment);
+    if (journal_)
+        journal_->finish(segment->fullName());
     ++segmentIndex_;
 }
 
 void CorpusVisitor::visitSpeechSegment(Bliss::SpeechSegment* speechSegment) {
+    if (skipFinished(speechSegment))
+        return;
     setParameter(segmentIndex_, speechSegment, DataSourceParameterAdaptor(dataSources_));
     setParameter(segmentIndex_, speechSegment, StringExpressionAdaptor(corpusKeys_));
 
@@ -205,6 +231,8 @@ void CorpusVisitor::visitSpeechSegment(Bliss::SpeechSegment* speechSegment) {
 
     clearParameter(speechSegment, DataSourceParameterAdaptor(dataSources_));
     clearParameter(speechSegment, StringExpressionAdaptor(corpusKeys_));
+    if (journal_)
+        journal_->finish(speechSegment->fullName());
     ++segmentIndex_;
 }
 
@@ -255,4 +283,49 @@ void clearSegmentParametersOnDataSource(Core::Ref<DataSource> dataSource, Bliss:
         clearParameter(segment, SingleDataSourceParameterAdaptor(dataSource.get()));
 }
 
+class ParameterListAdaptor {
+    SegmentParameterList& parameters_;
+
+public:
+    ParameterListAdaptor(SegmentParameterList& parameters)
+            : parameters_(parameters) {}
+
+    void set(const std::string& name, const std::string& value) {
+        parameters_.push_back(std::make_pair(name, value));
+    }
+
+    void clear(const std::string& name) {
+        parameters_.push_back(std::make_pair(name, std::string()));
+    }
+};
+
+void getSegmentParameters(size_t recordingIndex, size_t segmentIndex, Bliss::Segment* segment, SegmentParameterList& parameters) {
+    verify(segment);
+    Bliss::Recording* recording = segment->recording();
+    require(recording);
+
+    setParameter(recordingIndex, recording, ParameterListAdaptor(parameters));
+    auto* speechSegment = dynamic_cast<Bliss::SpeechSegment*>(segment);
+    if (speechSegment)
+        setParameter(segmentIndex, speechSegment, ParameterListAdaptor(parameters));
+    else
+        setParameter(segmentIndex, segment, ParameterListAdaptor(parameters));
+}
+
+void getClearedSegmentParameters(Bliss::Segment* segment, SegmentParameterList& parameters) {
+    verify(segment);
+
+    auto* speechSegment = dynamic_cast<Bliss::SpeechSegment*>(segment);
+    if (speechSegment)
+        clearParameter(speechSegment, ParameterListAdaptor(parameters));
+    else
+        clearParameter(segment, ParameterListAdaptor(parameters));
+}
+
+void setParametersOnDataSource(Core::Ref<DataSource> dataSource, const SegmentParameterList& parameters) {
+    verify(dataSource.get());
+    for (SegmentParameterList::const_iterator p = parameters.begin(); p != parameters.end(); ++p)
+        dataSource->setParameter(p->first, p->second);
+}
+
 }  // namespace Speech
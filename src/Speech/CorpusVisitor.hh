@@ -24,6 +24,7 @@
 namespace Speech {
 
 class CorpusProcessor;
+class ProgressJournal;
 
 /**
  * CorpusVisitor traverses the corpus description
@@ -32,6 +33,9 @@ class CorpusProcessor;
  *  - CorpusProcessor
  *  - DataSource
  *  - CorpusKey
+ *
+ * If a progress journal is configured (selection progress-journal), the
+ * segments finished by a previous run are skipped, see ProgressJournal.
  */
 
 class CorpusVisitor : public Core::Component,
@@ -44,6 +48,10 @@ private:
     size_t recordingIndex_;
     size_t segmentIndex_;
 
+    ProgressJournal* journal_;
+
+    bool skipFinished(Bliss::Segment*);
+
 private:
     template<class Reference>
     void signOn(std::vector<Reference>& v, Reference r) {
@@ -56,6 +64,18 @@ private:
     }
 
 protected:
+    /** Without progress journal, e.g. if the caller journals the segments. */
+    CorpusVisitor(const Core::Configuration& c, bool useProgressJournal);
+
+    /** Sets the recording and segment index, if segments are visited out of corpus order. */
+    void setIndices(size_t recordingIndex, size_t segmentIndex) {
+        recordingIndex_ = recordingIndex;
+        segmentIndex_   = segmentIndex;
+    }
+    const std::vector<Core::Ref<DataSource>>& dataSources() const {
+        return dataSources_;
+    }
+
     virtual void enterCorpus(Bliss::Corpus*);
     virtual void leaveCorpus(Bliss::Corpus*);
     virtual void enterRecording(Bliss::Recording*);
@@ -66,7 +86,7 @@ protected:
 public:
     CorpusVisitor(const Core::Configuration& c);
 
-    virtual ~CorpusVisitor() {}
+    virtual ~CorpusVisitor();
 
     void signOn(CorpusProcessor* p) {
         signOn(corpusProcessors_, p);
@@ -89,6 +109,19 @@ public:
 void setSegmentParametersOnDataSource(Core::Ref<DataSource>, Bliss::Segment*);
 void clearSegmentParametersOnDataSource(Core::Ref<DataSource>, Bliss::Segment*);
 
+/**
+ * Corpus section parameters (name, value) as they are passed to DataSource objects.
+ * Allows to apply the parameters of a segment after the Bliss objects are gone,
+ * e.g. when segments are processed asynchronously.
+ */
+typedef std::vector<std::pair<std::string, std::string>> SegmentParameterList;
+
+/** Collects the recording and segment parameters CorpusVisitor sets for the given segment. */
+void getSegmentParameters(size_t recordingIndex, size_t segmentIndex, Bliss::Segment*, SegmentParameterList&);
+/** Collects the parameters CorpusVisitor clears after the given segment (with empty values). */
+void getClearedSegmentParameters(Bliss::Segment*, SegmentParameterList&);
+void setParametersOnDataSource(Core::Ref<DataSource>, const SegmentParameterList&);
+
 }  // namespace Speech
 
 #endif  // _SPEECH_CORPUS_VISITOR_HH
@@ -249,6 +249,36 @@ Cart::Score StateTyingDecisionTreeTrainer::LogLikelihoodGain::operator()(
     return gain;
 }
 
+size_t StateTyingDecisionTreeTrainer::LogLikelihoodGain::nStatistics(const Cart::Example& example) const {
+    require(example.values->rows() == 2);
+    return 2 * example.values->columns();
+}
+
+void StateTyingDecisionTreeTrainer::LogLikelihoodGain::statistics(const Cart::Example& example, f64* statistics) const {
+    std::copy(example.values->begin(), example.values->end(), statistics);
+}
+
+/*
+  same as logLikelihood(), but thread-safe
+*/
+Cart::Score StateTyingDecisionTreeTrainer::LogLikelihoodGain::score(f64 nObs, const f64* statistics, size_t nStatistics) const {
+    if (nObs <= 0.0)
+        return 0.0;
+    size_t     d              = nStatistics / 2;
+    const f64* itSum          = statistics;
+    const f64* itSumOfSquares = statistics + d;
+    f64        ll             = 0.0;
+    for (size_t i = 0; i < d; ++i, ++itSum, ++itSumOfSquares) {
+        f64 mu          = *itSum / nObs;
+        f64 sigmaSquare = *itSumOfSquares / nObs - mu * mu;
+        if (sigmaSquare < minSigmaSquare_)
+            sigmaSquare = minSigmaSquare_;
+        ll += ::log(sigmaSquare);
+    }
+    ll = (0.5 * nObs) * (d + d * ::log(PI + PI) + ll);
+    return ll;
+}
+
 StateTyingDecisionTreeTrainer::StateTyingDecisionTreeTrainer(const Core::Configuration& config)
         : Precursor(config) {
     setScorer(Cart::ConstScorerRef(new LogLikelihoodGain(select("log-likelihood-gain"))));
@@ -97,6 +97,11 @@ public:
                 const Cart::Score fatherLogLikelihood,
                 Cart::Score& leftChildLogLikelihood, Cart::Score& rightChildLogLikelihood) const;
         void operator()(const Cart::ExamplePtrRange& examples, Cart::Score& score) const;
+
+        // statistics are the sums followed by the sums of squares of an example
+        size_t      nStatistics(const Cart::Example& example) const;
+        void        statistics(const Cart::Example& example, f64* statistics) const;
+        Cart::Score score(f64 nObs, const f64* statistics, size_t nStatistics) const;
     };
 
 public:
@@ -13,6 +13,8 @@
  *  limitations under the License.
  */
 #include "MixtureSetTrainer.hh"
+#include <algorithm>
+#include <thread>
 #include <Mm/AbstractMixtureSetEstimator.hh>
 #include <Mm/MixtureSetSplitter.hh>
 #include <Mm/Module.hh>
@@ -36,6 +38,11 @@ const Core::ParameterBool MixtureSetTrainer::paramForceCovarianceTying(
         "set covariance tying independent of the mixture in 'old-mixture-set-file'",
         false);
 
+const Core::ParameterInt MixtureSetTrainer::paramCombinationThreads(
+        "combination-threads",
+        "number of threads reading and adding up the files to combine, 0: merge all files in a single pass",
+        0, 0);
+
 MixtureSetTrainer::MixtureSetTrainer(const Core::Configuration& configuration)
         : Core::Component(configuration),
           estimator_(0) {}
@@ -118,18 +125,23 @@ void MixtureSetTrainer::read() {
 bool MixtureSetTrainer::combine(const std::vector<std::string>& toCombine) {
     verify(!estimator_);
 
-    Core::BinaryInputStreams bis(toCombine);
-    if (!bis.areOpen()) {
-        error("Failed to open <mixture-set-files-to-combine> for reading.");
-        return false;
-    }
-
     const std::string newMixtureSetFilename = paramNewMixtureSetFilename(config);
     for (u32 n = 0; n < toCombine.size(); ++n) {
         if (newMixtureSetFilename == toCombine[n]) {
             error("<new-mixture-set-file> must be different from <mixture-set-files-to-combine>");
             return false;
         }
+    }
+    const u32 nThreads = std::min<size_t>(paramCombinationThreads(config), toCombine.size());
+    if (nThreads > 0)
+        return combine(toCombine, nThreads);
+
+    Core::BinaryInputStreams bis(toCombine);
+    if (!bis.areOpen()) {
+        error("Failed to open <mixture-set-files-to-combine> for reading.");
+        return false;
+    }
+    for (u32 n = 0; n < toCombine.size(); ++n) {
         log("Add \"%s\" ...", toCombine[n].c_str());
     }
     Core::BinaryOutputStream bos(newMixtureSetFilename);
@@ -147,6 +159,94 @@ bool MixtureSetTrainer::combine(const std::vector<std::string>& toCombine) {
     return result;
 }
 
+/**
+ * Each thread reads every nThreads-th file and adds it to its own estimator,
+ * at the end the estimators are reduced to one.  Only two estimators per
+ * thread are kept in memory at a time, independent of the number of files.
+ */
+bool MixtureSetTrainer::combine(const std::vector<std::string>& toCombine, u32 nThreads) {
+    require(nThreads > 0 && nThreads <= toCombine.size());
+
+    // estimators are created here, as they access the configuration
+    std::vector<Mm::AbstractMixtureSetEstimator*> shards(nThreads), buffers(nThreads);
+    for (u32 t = 0; t < nThreads; ++t) {
+        shards[t]  = createMixtureSetEstimator();
+        buffers[t] = createMixtureSetEstimator();
+    }
+    std::vector<s32>         failedFile(nThreads, -1);
+    std::vector<std::thread> threads;
+    for (u32 t = 0; t < nThreads; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            for (size_t n = t; n < toCombine.size(); n += nThreads) {
+                Mm::AbstractMixtureSetEstimator* estimator = (n == t) ? shards[t] : buffers[t];
+                Core::BinaryInputStream          bis(toCombine[n]);
+                if (bis)
+                    estimator->read(bis);
+                if (!bis || (estimator != shards[t] && !shards[t]->accumulate(*estimator))) {
+                    failedFile[t] = n;
+                    break;
+                }
+            }
+        }));
+    }
+    for (u32 t = 0; t < nThreads; ++t)
+        threads[t].join();
+
+    bool result = true;
+    for (u32 t = 0; t < nThreads; ++t) {
+        if (failedFile[t] >= 0) {
+            error("Failed to add \"%s\".", toCombine[failedFile[t]].c_str());
+            result = false;
+        }
+    }
+    if (result) {
+        log("Added %zd files using %d threads.", toCombine.size(), nThreads);
+        result = Mm::AbstractMixtureSetEstimator::reduce(shards);
+        if (!result)
+            error("Combination failed.");
+    }
+    if (result) {
+        const std::string filename = paramNewMixtureSetFilename(config);
+        result                     = Mm::Module::instance().writeMixtureSetEstimator(filename, *shards.front());
+        if (!result)
+            error("Failed to save mixture-set to \"%s\".", filename.c_str());
+    }
+    for (u32 t = 0; t < nThreads; ++t) {
+        delete shards[t];
+        delete buffers[t];
+    }
+    return result;
+}
+
+bool MixtureSetTrainer::combine(const std::vector<MixtureSetTrainer*>& trainers) {
+    std::vector<Mm::AbstractMixtureSetEstimator*> estimators;
+    if (estimator_)
+        estimators.push_back(estimator_);
+    for (size_t i = 0; i < trainers.size(); ++i) {
+        MixtureSetTrainer* trainer = trainers[i];
+        if (trainer == this || !trainer->estimator_)
+            continue;
+        if (!estimator_) {
+            // take over the estimator of a trainer which has seen data
+            std::swap(estimator_, trainer->estimator_);
+            std::swap(assigningFeatureScorer_, trainer->assigningFeatureScorer_);
+            estimators.push_back(estimator_);
+        }
+        else {
+            estimators.push_back(trainer->estimator_);
+        }
+    }
+    if (estimators.empty()) {
+        error("Cannot combine trainers: no statistics accumulated.");
+        return false;
+    }
+    if (!Mm::AbstractMixtureSetEstimator::reduce(estimators)) {
+        error("Combination failed: mixture set estimators differ in topology.");
+        return false;
+    }
+    return true;
+}
+
 bool MixtureSetTrainer::combinePartitions(const std::vector<std::string>& toCombine) {
     typedef Mm::AbstractMixtureSetEstimator::MixtureEstimators MixtureEstimators;
     typedef Mm::AbstractMixtureEstimator::DensityEstimators    DensityEstimators;
@@ -34,6 +34,7 @@ public:
     static const Core::ParameterString paramNewMixtureSetFilename;
     static const Core::ParameterBool   paramSplitFirst;
     static const Core::ParameterBool   paramForceCovarianceTying;
+    static const Core::ParameterInt    paramCombinationThreads;
 
 protected:
     Mm::AbstractMixtureSetEstimator*            estimator_;
@@ -54,6 +55,7 @@ protected:
     bool read(const std::string& filename, Mm::AbstractMixtureSetEstimator&);
     void read(const std::string& filename);
     void write(const std::string& filename) const;
+    bool combine(const std::vector<std::string>& toCombine, u32 nThreads);
 
     virtual const Core::Ref<Mm::MixtureSet> getMixtureSet(size_t nMixtures, size_t dimension);
 
@@ -75,6 +77,11 @@ public:
 
     virtual void read();
     bool         combine(const std::vector<std::string>& toCombine);
+    /**
+     * Adds the statistics accumulated by the other trainers, e.g. by the
+     * workers of a parallel corpus visitor, to this trainer.
+     */
+    bool combine(const std::vector<MixtureSetTrainer*>& trainers);
     bool         combinePartitions(const std::vector<std::string>& toCombine);
 
     void write() const {
@@ -0,0 +1,448 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "OnlineRecognizer.hh"
+#include <Am/AcousticModel.hh>
+#include <Bliss/CorpusDescription.hh>
+#include <Bliss/Lexicon.hh>
+#include <Mm/FeatureScorer.hh>
+#include <Mm/Types.hh>
+#include "Module.hh"
+
+using namespace Speech;
+
+// ===========================================================================
+// class StreamingDataSource
+
+const Core::ParameterString StreamingDataSource::paramInputPortName(
+        "input-port-name",
+        "network input receiving the audio stream, default: the first input",
+        "");
+const Core::ParameterFloat StreamingDataSource::paramSampleRate(
+        "sample-rate",
+        "sample rate of the audio stream",
+        16000, 1);
+
+StreamingDataSource::StreamingDataSource(const Core::Configuration& c)
+        : Core::Component(c),
+          Precursor(c),
+          inputPortId_(Flow::IllegalPortId),
+          sampleRate_(paramSampleRate(c)),
+          isEndOfStream_(true),
+          endTime_(0) {
+    std::string name(paramInputPortName(c));
+    if (name.empty()) {
+        if (nInputs() > 0)
+            inputPortId_ = 0;
+    }
+    else {
+        inputPortId_ = getInput(name);
+    }
+    if (inputPortId_ == Flow::IllegalPortId)
+        criticalError("Flow network does not have an input for the audio stream");
+    setProgressIndication(false);
+}
+
+StreamingDataSource::~StreamingDataSource() {}
+
+void StreamingDataSource::startStream() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        chunks_.clear();
+        ingestTimes_.clear();
+        isEndOfStream_ = false;
+        endTime_       = 0;
+    }
+    reset();
+    configure();
+    Core::Ref<Flow::Attributes> attributes(new Flow::Attributes());
+    attributes->set("sample-rate", sampleRate_);
+    attributes->set("sample-size", u32(sizeof(f32) * 8));
+    attributes->set("datatype", Flow::Vector<f32>::type()->name());
+    putAttributes(inputPortId_, attributes);
+}
+
+bool StreamingDataSource::putSamples(const f32* samples, u32 nSamples) {
+    Flow::DataPtr<Flow::Vector<f32>> chunk(Flow::Vector<f32>::create());
+    chunk->assign(samples, samples + nSamples);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (isEndOfStream_)
+        return false;
+    chunk->setStartTime(endTime_);
+    endTime_ += Flow::Time(nSamples) / sampleRate_;
+    chunk->setEndTime(endTime_);
+    chunks_.push_back(chunk);
+    ingestTimes_.push_back(std::make_pair(endTime_, Clock::now()));
+    chunkAvailable_.notify_one();
+    return true;
+}
+
+void StreamingDataSource::endOfStream() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    isEndOfStream_ = true;
+    chunkAvailable_.notify_one();
+}
+
+StreamingDataSource::Clock::time_point StreamingDataSource::ingestTime(Flow::Time t) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (ingestTimes_.size() > 1 && ingestTimes_.front().first < t)
+        ingestTimes_.pop_front();
+    return ingestTimes_.empty() ? Clock::now() : ingestTimes_.front().second;
+}
+
+bool StreamingDataSource::work(Flow::PortId in) {
+    if (in != inputPortId_)
+        return Precursor::work(in);
+    Flow::DataPtr<Flow::Vector<f32>> chunk;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        chunkAvailable_.wait(lock, [this] { return !chunks_.empty() || isEndOfStream_; });
+        if (!chunks_.empty()) {
+            chunk = chunks_.front();
+            chunks_.pop_front();
+        }
+    }
+    if (chunk)
+        return putData(in, chunk.get());
+    return putData(in, Flow::Data::eos());
+}
+
+// ===========================================================================
+// class OnlineRecognizer
+
+const Core::ParameterFloat OnlineRecognizer::paramPartialResultInterval(
+        "partial-result-interval",
+        "audio between partial results and endpoint checks (in seconds)",
+        0.1, 0.0);
+const Core::ParameterFloat OnlineRecognizer::paramEndpointSilence(
+        "endpoint-silence",
+        "audio after the last recognized word which ends the utterance (in seconds), 0 disables this endpoint",
+        0.8, 0.0);
+const Core::ParameterFloat OnlineRecognizer::paramNoSpeechTimeout(
+        "no-speech-timeout",
+        "utterances without any recognized word end after this duration (in seconds)",
+        Core::Type<f32>::max, 0.0);
+const Core::ParameterFloat OnlineRecognizer::paramMaxUtteranceDuration(
+        "max-utterance-duration",
+        "utterances end after this duration (in seconds)",
+        Core::Type<f32>::max, 0.0);
+const Core::ParameterBool OnlineRecognizer::paramNoDependencyCheck(
+        "no-dependency-check",
+        "do not check any dependencies",
+        false);
+
+OnlineRecognizer::OnlineRecognizer(const Core::Configuration& c, ResultListener* listener)
+        : Core::Component(c),
+          Precursor(c),
+          listener_(listener),
+          partialResultInterval_(paramPartialResultInterval(config)),
+          endpointSilence_(paramEndpointSilence(config)),
+          noSpeechTimeout_(paramNoSpeechTimeout(config)),
+          maxUtteranceDuration_(paramMaxUtteranceDuration(config)),
+          noDependencyCheck_(paramNoDependencyCheck(config)),
+          silence_(0),
+          isRunning_(false),
+          isEndpoint_(false),
+          nSearchedFrames_(0),
+          lastPartialResult_(0),
+          partialLatency_("partial result latency [ms]"),
+          finalLatency_("final result latency [ms]"),
+          statisticsChannel_(config, "statistics") {
+    require(listener_);
+    initializeRecognizer(Am::AcousticModel::complete);
+    if (recognizer_->lookAheadLength() > 0)
+        criticalError("cannot use a recognizer with acoustic look-ahead for online recognition");
+    silence_    = lexicon_->specialLemma("silence");
+    dataSource_ = Core::ref(new StreamingDataSource(select("feature-extraction")));
+    dataSource_->respondToDelayedErrors();
+}
+
+OnlineRecognizer::~OnlineRecognizer() {
+    if (isRunning_) {
+        finishUtterance();
+        waitForResult();
+    }
+}
+
+void OnlineRecognizer::signOn(CorpusVisitor& corpusVisitor) {
+    acousticModel_->signOn(corpusVisitor);
+}
+
+void OnlineRecognizer::startUtterance() {
+    require(!isRunning_);
+    recognizer_->resetStatistics();
+    recognizer_->restart();
+    acousticModel_->featureScorer()->reset();
+    featureTimes_.clear();
+    nSearchedFrames_   = 0;
+    lastPartialResult_ = 0;
+    stable_.clear();
+    isEndpoint_ = false;
+    dataSource_->startStream();
+    isRunning_ = true;
+    thread_    = std::thread(&OnlineRecognizer::recognize, this);
+}
+
+bool OnlineRecognizer::putSamples(const f32* samples, u32 nSamples) {
+    require(isRunning_);
+    if (isEndpoint_)
+        return false;
+    return dataSource_->putSamples(samples, nSamples);
+}
+
+void OnlineRecognizer::finishUtterance() {
+    require(isRunning_);
+    finishTime_ = Clock::now();
+    dataSource_->endOfStream();
+}
+
+void OnlineRecognizer::waitForResult() {
+    if (isRunning_) {
+        thread_.join();
+        isRunning_ = false;
+    }
+}
+
+void OnlineRecognizer::recognize() {
+    Core::Ref<Feature> feature;
+    bool               firstFeature = true;
+    while (!isEndpoint_ && dataSource_->getData(feature)) {
+        if (firstFeature) {
+            if (!noDependencyCheck_ && !acousticModel_->isCompatible(Mm::FeatureDescription(*this, *feature)))
+                acousticModel_->respondToDelayedErrors();
+            firstFeature = false;
+        }
+        feed(feature);
+        if (nSearchedFrames_ && audioTime() - lastPartialResult_ >= partialResultInterval_) {
+            lastPartialResult_ = audioTime();
+            partialResult();
+        }
+    }
+    // unblocks threaded feature extraction nodes waiting for audio after an endpoint
+    dataSource_->endOfStream();
+    flush();
+    finalResult();
+}
+
+void OnlineRecognizer::feed(Core::Ref<const Feature> f) {
+    Core::Ref<const Mm::ScaledFeatureScorer> scorer = acousticModel_->featureScorer();
+    if (scorer->isBuffered() && !scorer->bufferFilled()) {
+        scorer->addFeature(f);
+    }
+    else {
+        recognizer_->feed(scorer->getScorer(f));
+        ++nSearchedFrames_;
+    }
+    featureTimes_.push_back(f->timestamp());
+}
+
+void OnlineRecognizer::flush() {
+    Core::Ref<const Mm::ScaledFeatureScorer> scorer = acousticModel_->featureScorer();
+    if (scorer->isBuffered()) {
+        while (!scorer->bufferEmpty()) {
+            recognizer_->feed(scorer->flush());
+            ++nSearchedFrames_;
+        }
+    }
+}
+
+Flow::Time OnlineRecognizer::audioTime() const {
+    return nSearchedFrames_ ? featureTimes_[nSearchedFrames_ - 1].endTime() : 0;
+}
+
+f64 OnlineRecognizer::seconds(Clock::time_point since) {
+    return std::chrono::duration<f64>(Clock::now() - since).count();
+}
+
+void OnlineRecognizer::appendTraceback(Traceback& to, const Traceback& from) {
+    Traceback::const_iterator item = from.begin();
+    if (!to.empty())
+        while (item != from.end() && item->time <= to.back().time)
+            ++item;
+    to.insert(to.end(), item, from.end());
+}
+
+void OnlineRecognizer::partialResult() {
+    Traceback stable, best;
+    recognizer_->getPartialSentence(stable);
+    appendTraceback(stable_, stable);
+    recognizer_->getCurrentBestSentence(best);
+
+    Result result;
+    result.stable = stable_;
+    Traceback::const_iterator item = best.cbegin();
+    if (!stable_.empty())
+        while (item != best.cend() && item->time <= stable_.back().time)
+            ++item;
+    result.tentative.insert(result.tentative.end(), item, best.cend());
+
+    if (detectEndpoint(result.tentative)) {
+        isEndpoint_ = true;
+        return;
+    }
+    result.time    = audioTime();
+    result.latency = seconds(dataSource_->ingestTime(result.time));
+    partialLatency_ += u32(result.latency * 1000.0 + 0.5);
+    listener_->result(result);
+}
+
+bool OnlineRecognizer::detectEndpoint(const Traceback& tentative) const {
+    const Flow::Time time = audioTime();
+    if (time >= maxUtteranceDuration_)
+        return true;
+    const Search::SearchAlgorithm::TracebackItem* lastWord = 0;
+    for (Traceback::const_reverse_iterator item = tentative.rbegin(); !lastWord && item != tentative.rend(); ++item)
+        if (item->pronunciation && item->pronunciation->lemma() != silence_)
+            lastWord = &*item;
+    for (Traceback::const_reverse_iterator item = stable_.rbegin(); !lastWord && item != stable_.rend(); ++item)
+        if (item->pronunciation && item->pronunciation->lemma() != silence_)
+            lastWord = &*item;
+    if (!lastWord || lastWord->time == 0)
+        return time >= noSpeechTimeout_;
+    return endpointSilence_ > 0 && lastWord->time <= featureTimes_.size() &&
+           time - featureTimes_[lastWord->time - 1].endTime() >= endpointSilence_;
+}
+
+void OnlineRecognizer::finalResult() {
+    Traceback best;
+    recognizer_->getCurrentBestSentence(best);
+    appendTraceback(stable_, best);
+
+    Result result;
+    result.stable     = stable_;
+    result.isFinal    = true;
+    result.isEndpoint = isEndpoint_;
+    result.time       = audioTime();
+    result.latency    = seconds(isEndpoint_ ? dataSource_->ingestTime(result.time) : finishTime_);
+    finalLatency_ += u32(result.latency * 1000.0 + 0.5);
+    listener_->result(result);
+}
+
+void OnlineRecognizer::logStatistics() const {
+    recognizer_->logStatistics();
+}
+
+void OnlineRecognizer::logLatencyStatistics() {
+    if (statisticsChannel_.isOpen())
+        statisticsChannel_ << partialLatency_ << finalLatency_;
+}
+
+// ===========================================================================
+// class OnlineRecognitionSimulator
+
+const Core::ParameterFloat OnlineRecognitionSimulator::paramChunkDuration(
+        "chunk-duration",
+        "audio passed to the recognizer at once (in seconds)",
+        0.1, 0.0);
+const Core::ParameterBool OnlineRecognitionSimulator::paramRealTime(
+        "real-time",
+        "pass the chunks at the speed of a live audio stream",
+        true);
+
+OnlineRecognitionSimulator::OnlineRecognitionSimulator(const Core::Configuration& c)
+        : Core::Component(c),
+          Precursor(c),
+          recognizer_(0),
+          chunkDuration_(paramChunkDuration(config)),
+          realTime_(paramRealTime(config)),
+          partialResultsChannel_(config, "partial-results") {
+    audio_ = Core::ref(Module::instance().createDataSource(select("audio-input")));
+    audio_->respondToDelayedErrors();
+    recognizer_ = new OnlineRecognizer(select("online-recognizer"), this);
+}
+
+OnlineRecognitionSimulator::~OnlineRecognitionSimulator() {
+    delete recognizer_;
+}
+
+void OnlineRecognitionSimulator::signOn(CorpusVisitor& corpusVisitor) {
+    corpusVisitor.signOn(audio_);
+    recognizer_->signOn(corpusVisitor);
+    Precursor::signOn(corpusVisitor);
+}
+
+void OnlineRecognitionSimulator::result(const OnlineRecognizer::Result& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    results_.push_back(result);
+}
+
+void OnlineRecognitionSimulator::writeOrth(Core::XmlWriter& os, const Search::SearchAlgorithm::Traceback& traceback) const {
+    for (u32 i = 0; i < traceback.size(); ++i)
+        if (traceback[i].pronunciation)
+            os << traceback[i].pronunciation->lemma()->preferredOrthographicForm()
+               << Core::XmlBlank();
+}
+
+void OnlineRecognitionSimulator::processSpeechSegment(Bliss::SpeechSegment* segment) {
+    Core::XmlWriter& os(clog());
+    if (segment->orth().size()) {
+        os << Core::XmlOpen("orth") + Core::XmlAttribute("source", "reference")
+           << segment->orth()
+           << Core::XmlClose("orth");
+    }
+
+    std::vector<f32> samples;
+    audio_->initialize(segment);
+    Flow::DataPtr<Flow::Vector<f32>> in;
+    while (audio_->getData(in))
+        samples.insert(samples.end(), in->begin(), in->end());
+    audio_->finalize();
+
+    const Flow::Time sampleRate = recognizer_->sampleRate();
+    const u32        chunkSize  = std::max(u32(1), u32(chunkDuration_ * sampleRate + 0.5));
+    results_.clear();
+    recognizer_->startUtterance();
+    OnlineRecognizer::Clock::time_point start = OnlineRecognizer::Clock::now();
+    for (size_t pos = 0; pos < samples.size();) {
+        const u32 n = std::min(size_t(chunkSize), samples.size() - pos);
+        if (realTime_)
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<OnlineRecognizer::Clock::duration>(
+                                                          std::chrono::duration<f64>((pos + n) / sampleRate)));
+        if (!recognizer_->putSamples(&samples[pos], n))
+            break;
+        pos += n;
+    }
+    recognizer_->finishUtterance();
+    recognizer_->waitForResult();
+
+    verify(!results_.empty() && results_.back().isFinal);
+    if (partialResultsChannel_.isOpen()) {
+        for (u32 i = 0; i + 1 < results_.size(); ++i) {
+            const OnlineRecognizer::Result& r(results_[i]);
+            partialResultsChannel_ << Core::XmlOpen("partial-result") + Core::XmlAttribute("time", r.time) + Core::XmlAttribute("latency", r.latency)
+                                   << Core::XmlOpen("stable");
+            writeOrth(partialResultsChannel_, r.stable);
+            partialResultsChannel_ << Core::XmlClose("stable")
+                                   << Core::XmlOpen("tentative");
+            writeOrth(partialResultsChannel_, r.tentative);
+            partialResultsChannel_ << Core::XmlClose("tentative")
+                                   << Core::XmlClose("partial-result");
+        }
+    }
+    const OnlineRecognizer::Result& final(results_.back());
+    os << Core::XmlOpen("orth") + Core::XmlAttribute("source", "recognized");
+    writeOrth(os, final.stable);
+    os << Core::XmlClose("orth");
+    os << Core::XmlEmpty("online-result") + Core::XmlAttribute("endpoint", final.isEndpoint ? "true" : "false") +
+                    Core::XmlAttribute("time", final.time) + Core::XmlAttribute("latency", final.latency) +
+                    Core::XmlAttribute("partial-results", u32(results_.size() - 1));
+    recognizer_->logStatistics();
+    reportRealTime(Flow::Time(samples.size()) / sampleRate);
+}
+
+void OnlineRecognitionSimulator::leaveCorpus(Bliss::Corpus* corpus) {
+    if (!corpus->level())
+        recognizer_->logLatencyStatistics();
+    Precursor::leaveCorpus(corpus);
+}
@@ -0,0 +1,270 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _SPEECH_ONLINE_RECOGNIZER_HH
+#define _SPEECH_ONLINE_RECOGNIZER_HH
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <Core/Statistics.hh>
+#include <Flow/Vector.hh>
+#include "CorpusProcessor.hh"
+#include "DataSource.hh"
+#include "Recognizer.hh"
+
+namespace Speech {
+
+/**
+ * Feature extraction network with audio input from a stream.
+ *
+ * The network reads samples (Flow::Vector<f32>) from an input port
+ * (input-port-name, default: the first one).  Samples passed to
+ * putSamples() are queued.  When the network needs more input than has
+ * been queued, work() waits for the next chunk, so each feature is
+ * computed as soon as the audio it depends on has arrived.  After
+ * endOfStream() the network receives end-of-stream.
+ *
+ * putSamples() and endOfStream() may be called from any thread, the
+ * features are pulled by one consumer thread.
+ */
+class StreamingDataSource : public DataSource {
+    typedef DataSource Precursor;
+
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const Core::ParameterString paramInputPortName;
+    static const Core::ParameterFloat  paramSampleRate;
+
+private:
+    Flow::PortId inputPortId_;
+    Flow::Time   sampleRate_;
+
+    std::mutex                                     mutex_;
+    std::condition_variable                        chunkAvailable_;
+    std::deque<Flow::DataPtr<Flow::Vector<f32>>> chunks_;
+    bool                                           isEndOfStream_;
+    Flow::Time                                     endTime_;
+    /** end time and ingest time of the chunks, used to measure latencies */
+    std::deque<std::pair<Flow::Time, Clock::time_point>> ingestTimes_;
+
+public:
+    StreamingDataSource(const Core::Configuration&);
+    virtual ~StreamingDataSource();
+
+    /** Resets the network and starts a new stream at time zero. */
+    void startStream();
+    /** Queues a chunk of samples, @return is false after endOfStream(). */
+    bool putSamples(const f32* samples, u32 nSamples);
+    void endOfStream();
+    /**
+     * Time at which the chunk containing time @param t has been queued;
+     * the chunks up to this one are forgotten.
+     */
+    Clock::time_point ingestTime(Flow::Time t);
+    Flow::Time        sampleRate() const {
+        return sampleRate_;
+    }
+
+    /** Called if the input link is empty, waits for the next chunk. */
+    virtual bool work(Flow::PortId in);
+};
+
+/**
+ * Streaming (online) recognition of utterances delivered in audio chunks.
+ *
+ * Usage: startUtterance(), putSamples() while audio arrives (from any
+ * thread), finishUtterance() at the end of the audio, waitForResult().
+ * A recognition thread extracts features with a StreamingDataSource
+ * (selection feature-extraction) and feeds the search while the audio
+ * arrives.  Results are passed to the ResultListener in this thread:
+ *  - every partial-result-interval seconds of audio a partial result:
+ *    the words on which all active hypotheses agree (stable, they do not
+ *    change any more) followed by the rest of the current best sentence
+ *    (tentative),
+ *  - the final result at the end of the utterance.
+ *
+ * Endpointing: the utterance ends before finishUtterance() if the
+ * current best sentence ends with endpoint-silence seconds of audio
+ * after its last word (silence lemma excluded), if no word has been
+ * recognized within no-speech-timeout seconds, or after
+ * max-utterance-duration seconds.  Endpoints are checked together with
+ * the partial results.  Audio passed after the endpoint is ignored.
+ *
+ * Latency is measured from the time the audio covered by a result has
+ * been passed to putSamples() to the time the result is delivered; the
+ * final result latency is measured from the end of the utterance
+ * (finishUtterance() or the audio at the endpoint).  Both are collected
+ * in histograms (in milliseconds, channel statistics).
+ *
+ * Restrictions: as OfflineRecognizer, no recognizers with acoustic
+ * look-ahead.
+ */
+class OnlineRecognizer : public Recognizer {
+    typedef Recognizer Precursor;
+
+public:
+    typedef StreamingDataSource::Clock Clock;
+
+    static const Core::ParameterFloat paramPartialResultInterval;
+    static const Core::ParameterFloat paramEndpointSilence;
+    static const Core::ParameterFloat paramNoSpeechTimeout;
+    static const Core::ParameterFloat paramMaxUtteranceDuration;
+    static const Core::ParameterBool  paramNoDependencyCheck;
+
+    struct Result {
+        Traceback  stable;
+        Traceback  tentative;
+        bool       isFinal;
+        bool       isEndpoint;
+        /** end of the audio covered by the result (in seconds from the start of the utterance) */
+        Flow::Time time;
+        /** in seconds */
+        f64 latency;
+        Result()
+                : isFinal(false), isEndpoint(false), time(0), latency(0) {}
+    };
+
+    class ResultListener {
+    public:
+        virtual ~ResultListener() {}
+        virtual void result(const Result&) = 0;
+    };
+
+private:
+    Core::Ref<StreamingDataSource> dataSource_;
+    ResultListener*                listener_;
+    Flow::Time                     partialResultInterval_;
+    Flow::Time                     endpointSilence_;
+    Flow::Time                     noSpeechTimeout_;
+    Flow::Time                     maxUtteranceDuration_;
+    bool                           noDependencyCheck_;
+    const Bliss::Lemma*            silence_;
+
+    std::thread       thread_;
+    bool              isRunning_;
+    std::atomic<bool> isEndpoint_;
+    Clock::time_point finishTime_;
+
+    /** timestamps of the extracted features and number of features fed to the search */
+    std::vector<Flow::Timestamp> featureTimes_;
+    u32                          nSearchedFrames_;
+    Traceback                    stable_;
+    Flow::Time                   lastPartialResult_;
+
+    Core::HistogramStatistics partialLatency_;
+    Core::HistogramStatistics finalLatency_;
+    Core::XmlChannel          statisticsChannel_;
+
+    void       recognize();
+    void       feed(Core::Ref<const Feature>);
+    void       flush();
+    void       partialResult();
+    void       finalResult();
+    bool       detectEndpoint(const Traceback& tentative) const;
+    Flow::Time audioTime() const;
+    static f64 seconds(Clock::time_point since);
+    /** Appends the items of @param from which end after the last item of @param to. */
+    static void appendTraceback(Traceback& to, const Traceback& from);
+
+public:
+    OnlineRecognizer(const Core::Configuration&, ResultListener*);
+    virtual ~OnlineRecognizer();
+
+    void signOn(CorpusVisitor& corpusVisitor);
+
+    Core::Ref<const Bliss::Lexicon> lexicon() const {
+        return lexicon_;
+    }
+    Flow::Time sampleRate() const {
+        return dataSource_->sampleRate();
+    }
+
+    /** Restarts search and feature extraction and starts the recognition thread. */
+    void startUtterance();
+    /** @return is false if the utterance has ended (endpoint), the samples are ignored then. */
+    bool putSamples(const f32* samples, u32 nSamples);
+    /** End of the audio of the utterance. */
+    void finishUtterance();
+    /** Waits until the final result has been delivered. */
+    void waitForResult();
+    /** true after an endpoint has been detected in the current utterance */
+    bool isEndpoint() const {
+        return isEndpoint_;
+    }
+
+    /** Search statistics of the last utterance. */
+    void logStatistics() const;
+    /** Latency histograms of all utterances. */
+    void logLatencyStatistics();
+    const Core::HistogramStatistics& partialLatency() const {
+        return partialLatency_;
+    }
+    const Core::HistogramStatistics& finalLatency() const {
+        return finalLatency_;
+    }
+};
+
+/**
+ * Corpus driven simulation of streaming recognition.
+ *
+ * The audio of each speech segment is read by the network of the
+ * selection audio-input (output main-port-name) and passed in chunks of
+ * chunk-duration seconds to an OnlineRecognizer (selection
+ * online-recognizer).  With real-time, chunks are passed at the speed at
+ * which the audio would arrive from a microphone, so that the measured
+ * latencies correspond to those of a live stream.  The segment ends at
+ * the end of its audio or at a detected endpoint.
+ *
+ * Output (XML format) per segment: partial results (channel
+ * partial-results) and the final orthography as by OfflineRecognizer.
+ */
+class OnlineRecognitionSimulator : public CorpusProcessor,
+                                   public OnlineRecognizer::ResultListener {
+    typedef CorpusProcessor Precursor;
+
+public:
+    static const Core::ParameterFloat paramChunkDuration;
+    static const Core::ParameterBool  paramRealTime;
+
+private:
+    Core::Ref<DataSource>                 audio_;
+    OnlineRecognizer*                     recognizer_;
+    Flow::Time                            chunkDuration_;
+    bool                                  realTime_;
+    Core::XmlChannel                      partialResultsChannel_;
+    std::vector<OnlineRecognizer::Result> results_;
+    std::mutex                            mutex_;
+
+    void writeOrth(Core::XmlWriter&, const Search::SearchAlgorithm::Traceback&) const;
+
+public:
+    OnlineRecognitionSimulator(const Core::Configuration&);
+    virtual ~OnlineRecognitionSimulator();
+
+    virtual void signOn(CorpusVisitor& corpusVisitor);
+    virtual void processSpeechSegment(Bliss::SpeechSegment*);
+    virtual void leaveCorpus(Bliss::Corpus*);
+
+    virtual void result(const OnlineRecognizer::Result&);
+};
+
+}  // namespace Speech
+
+#endif  // _SPEECH_ONLINE_RECOGNIZER_HH
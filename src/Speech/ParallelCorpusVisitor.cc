@@ -0,0 +1,394 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "ParallelCorpusVisitor.hh"
+#include <algorithm>
+#include <deque>
+#include <Bliss/SegmentOrdering.hh>
+#include "CorpusProcessor.hh"
+#include "ProgressJournal.hh"
+
+using namespace Speech;
+
+// ===========================================================================
+// class ParallelCorpusVisitor::SegmentCollector
+
+/**
+ * Copies the selected segments (see Bliss::SegmentOrderingVisitor) and
+ * processes them when the traversal leaves the root corpus, i.e. while the
+ * root corpus still exists.
+ */
+class ParallelCorpusVisitor::SegmentCollector : public Bliss::SegmentOrderingVisitor {
+    typedef Bliss::SegmentOrderingVisitor Precursor;
+
+private:
+    ParallelCorpusVisitor* parent_;
+    size_t                 recordingIndex_;
+    size_t                 segmentIndex_;
+
+    typedef Core::StringHashMap<std::pair<size_t, size_t>> IndexMap;
+    IndexMap indices_;
+
+    void addIndices(Bliss::Segment* s) {
+        indices_[s->fullName()] = std::make_pair(recordingIndex_, segmentIndex_);
+        ++segmentIndex_;
+    }
+
+public:
+    SegmentCollector(ParallelCorpusVisitor* parent)
+            : parent_(parent), recordingIndex_(0), segmentIndex_(0) {}
+
+    virtual void enterCorpus(Bliss::Corpus* c) {
+        if (curCorpus_.empty())
+            recordingIndex_ = 0;
+        Precursor::enterCorpus(c);
+    }
+    virtual void enterRecording(Bliss::Recording* r) {
+        Precursor::enterRecording(r);
+        segmentIndex_ = 0;
+    }
+    virtual void leaveRecording(Bliss::Recording* r) {
+        Precursor::leaveRecording(r);
+        ++recordingIndex_;
+    }
+    virtual void visitSegment(Bliss::Segment* s) {
+        Precursor::visitSegment(s);
+        addIndices(s);
+    }
+    virtual void visitSpeechSegment(Bliss::SpeechSegment* s) {
+        Precursor::visitSpeechSegment(s);
+        addIndices(s);
+    }
+    virtual void leaveCorpus(Bliss::Corpus* c) {
+        if (curCorpus_.size() > 1) {
+            Precursor::leaveCorpus(c);
+            return;
+        }
+        curCorpus_.pop_back();
+
+        parent_->jobs_.clear();
+        for (std::vector<std::string>::const_iterator name = segmentList_.begin(); name != segmentList_.end(); ++name) {
+            Bliss::Segment* segment = getSegmentByName(*name);
+            verify(segment);
+            if (parent_->journal_ && parent_->journal_->isFinished(*name)) {
+                parent_->journal_->skip(*name);
+                continue;
+            }
+            IndexMap::const_iterator i = indices_.find(*name);
+            verify(i != indices_.end());
+            Job job;
+            job.segment        = segment;
+            job.recordingIndex = i->second.first;
+            job.segmentIndex   = i->second.second;
+            job.duration       = segment->end() - segment->start();
+            parent_->jobs_.push_back(job);
+        }
+        parent_->processSegments(c);
+        parent_->jobs_.clear();
+        segmentList_.clear();
+        indices_.clear();
+    }
+};
+
+// ===========================================================================
+// class ParallelCorpusVisitor::Worker
+
+class ParallelCorpusVisitor::Worker : public CorpusVisitor {
+    typedef CorpusVisitor Precursor;
+
+private:
+    ParallelCorpusVisitor*             parent_;
+    u32                                id_;
+    CorpusProcessor*                   processor_;
+    std::deque<size_t>                 queue_;
+    std::mutex                         queueMutex_;
+    std::vector<Bliss::CorpusSection*> path_;
+    Core::DeferredArchiveWrites        finalWrites_;
+    size_t                             nSegments_, nStolenSegments_;
+
+    void leaveSections(size_t depth);
+    void enterSections(const Job& job);
+
+public:
+    Worker(const Core::Configuration& c, ParallelCorpusVisitor* parent, u32 id, CorpusProcessor* processor);
+    virtual ~Worker();
+
+    CorpusProcessor* processor() const {
+        return processor_;
+    }
+
+    void push(size_t index);
+    bool popFront(size_t& index);
+    bool popBack(size_t& index);
+
+    /** Thread main function: processes segments until no job is left. */
+    void run(Bliss::Corpus* corpus);
+
+    void countStolenSegment() {
+        ++nStolenSegments_;
+    }
+    size_t nSegments() const {
+        return nSegments_;
+    }
+    size_t nStolenSegments() const {
+        return nStolenSegments_;
+    }
+    bool commitFinalWrites() {
+        return finalWrites_.commit();
+    }
+};
+
+ParallelCorpusVisitor::Worker::Worker(const Core::Configuration& c, ParallelCorpusVisitor* parent, u32 id, CorpusProcessor* processor)
+        : Precursor(c, false),
+          parent_(parent),
+          id_(id),
+          processor_(processor),
+          nSegments_(0),
+          nStolenSegments_(0) {
+    processor_->signOn(*this);
+    const std::vector<Core::Ref<DataSource>>& sources(dataSources());
+    for (size_t i = 0; i < sources.size(); ++i)
+        sources[i]->setProgressIndication(false);
+}
+
+ParallelCorpusVisitor::Worker::~Worker() {
+    delete processor_;
+}
+
+void ParallelCorpusVisitor::Worker::push(size_t index) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    queue_.push_back(index);
+}
+
+bool ParallelCorpusVisitor::Worker::popFront(size_t& index) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (queue_.empty())
+        return false;
+    index = queue_.front();
+    queue_.pop_front();
+    return true;
+}
+
+bool ParallelCorpusVisitor::Worker::popBack(size_t& index) {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (queue_.empty())
+        return false;
+    index = queue_.back();
+    queue_.pop_back();
+    return true;
+}
+
+void ParallelCorpusVisitor::Worker::leaveSections(size_t depth) {
+    while (path_.size() > depth) {
+        Bliss::CorpusSection* section = path_.back();
+        path_.pop_back();
+        Bliss::Recording* recording = dynamic_cast<Bliss::Recording*>(section);
+        if (recording)
+            leaveRecording(recording);
+        else
+            leaveCorpus(static_cast<Bliss::Corpus*>(section));
+    }
+}
+
+void ParallelCorpusVisitor::Worker::enterSections(const Job& job) {
+    std::vector<Bliss::CorpusSection*> path;
+    for (Bliss::CorpusSection* section = job.segment->recording(); section; section = section->parent())
+        path.push_back(section);
+    std::reverse(path.begin(), path.end());
+
+    size_t depth = 0;
+    while (depth < path.size() && depth < path_.size() && path[depth] == path_[depth])
+        ++depth;
+    leaveSections(depth);
+    for (; depth < path.size(); ++depth) {
+        if (depth + 1 == path.size()) {
+            setIndices(job.recordingIndex, job.segmentIndex);
+            enterRecording(job.segment->recording());
+        }
+        else
+            enterCorpus(static_cast<Bliss::Corpus*>(path[depth]));
+        path_.push_back(path[depth]);
+    }
+}
+
+void ParallelCorpusVisitor::Worker::run(Bliss::Corpus* corpus) {
+    path_.clear();
+    enterCorpus(corpus);
+    path_.push_back(corpus);
+
+    size_t index;
+    while (parent_->nextJob(id_, index)) {
+        const Job& job = parent_->jobs_[index];
+        parent_->results_[index]->activate();
+        enterSections(job);
+        setIndices(job.recordingIndex, job.segmentIndex);
+        job.segment->accept(this);
+        parent_->results_[index]->deactivate();
+        parent_->putResult(index);
+        ++nSegments_;
+    }
+
+    finalWrites_.activate();
+    leaveSections(0);
+    finalWrites_.deactivate();
+}
+
+// ===========================================================================
+// class ParallelCorpusVisitor
+
+const Core::ParameterInt ParallelCorpusVisitor::paramNumberOfThreads(
+        "threads",
+        "number of segments processed concurrently",
+        1, 1);
+const Core::ParameterInt ParallelCorpusVisitor::paramMaxPendingSegments(
+        "max-pending-segments",
+        "maximum number of segments processed ahead of the segment committed (0: 16 times the number of threads)",
+        0, 0);
+
+ParallelCorpusVisitor::ParallelCorpusVisitor(const Core::Configuration& c, const ProcessorFactory& createProcessor)
+        : Core::Component(c),
+          nextWindow_(0),
+          windowSize_(0),
+          maxPendingSegments_(paramMaxPendingSegments(c)),
+          nCommittedSegments_(0),
+          journal_(ProgressJournal::acquire(select("progress-journal"))) {
+    // the pipelines of all workers write to the same archives
+    Core::Archive::enableSharing();
+    const u32 nThreads = paramNumberOfThreads(config);
+    for (u32 t = 0; t < nThreads; ++t)
+        workers_.push_back(new Worker(config, this, t, createProcessor()));
+    if (maxPendingSegments_ == 0)
+        maxPendingSegments_ = 16 * nThreads;
+    // two windows are released ahead of the segment committed
+    windowSize_ = std::max<size_t>(maxPendingSegments_ / 2, 1);
+}
+
+ParallelCorpusVisitor::~ParallelCorpusVisitor() {
+    for (u32 t = 0; t < workers_.size(); ++t)
+        delete workers_[t];
+    ProgressJournal::release(journal_);
+    Core::Archive::disableSharing();
+}
+
+CorpusProcessor* ParallelCorpusVisitor::processor(u32 worker) const {
+    require(worker < workers_.size());
+    return workers_[worker]->processor();
+}
+
+void ParallelCorpusVisitor::accept(Bliss::CorpusDescription& corpus) {
+    SegmentCollector collector(this);
+    corpus.accept(&collector);
+}
+
+bool ParallelCorpusVisitor::canReleaseWindow() const {
+    return nextWindow_ < jobs_.size() && nextWindow_ + windowSize_ <= nCommittedSegments_ + maxPendingSegments_;
+}
+
+void ParallelCorpusVisitor::releaseWindow() {
+    const size_t        end = std::min(nextWindow_ + windowSize_, jobs_.size());
+    std::vector<size_t> window;
+    for (size_t i = nextWindow_; i < end; ++i)
+        window.push_back(i);
+    // longest first, stable to keep the schedule deterministic
+    std::stable_sort(window.begin(), window.end(), [this](size_t a, size_t b) {
+        return jobs_[a].duration > jobs_[b].duration;
+    });
+    for (size_t i = 0; i < window.size(); ++i)
+        workers_[i % workers_.size()]->push(window[i]);
+    nextWindow_ = end;
+}
+
+bool ParallelCorpusVisitor::nextJob(u32 worker, size_t& index) {
+    while (true) {
+        size_t released;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            released = nextWindow_;
+        }
+        if (workers_[worker]->popFront(index))
+            return true;
+        for (u32 t = 1; t < workers_.size(); ++t) {
+            if (workers_[(worker + t) % workers_.size()]->popBack(index)) {
+                workers_[worker]->countStolenSegment();
+                return true;
+            }
+        }
+        if (released >= jobs_.size())
+            return false;
+
+        // all queues are empty: release the next window, if not too far ahead of the commit
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobAvailable_.wait(lock, [this, released]() {
+            return nextWindow_ != released || canReleaseWindow();
+        });
+        if (nextWindow_ == released) {
+            releaseWindow();
+            jobAvailable_.notify_all();
+        }
+    }
+}
+
+void ParallelCorpusVisitor::putResult(size_t index) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isDone_[index] = true;
+    }
+    resultAvailable_.notify_all();
+}
+
+void ParallelCorpusVisitor::processSegments(Bliss::Corpus* corpus) {
+    log("processing %zd segments with %zd threads", jobs_.size(), workers_.size());
+
+    results_.resize(jobs_.size());
+    for (size_t i = 0; i < jobs_.size(); ++i)
+        results_[i] = new Core::DeferredArchiveWrites();
+    isDone_.assign(jobs_.size(), false);
+    nextWindow_ = nCommittedSegments_ = 0;
+
+    verify(threads_.empty());
+    for (u32 t = 0; t < workers_.size(); ++t)
+        threads_.push_back(std::thread(&Worker::run, workers_[t], corpus));
+
+    // commit phase: write the archive files in corpus order
+    for (size_t i = 0; i < jobs_.size(); ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            resultAvailable_.wait(lock, [this, i]() { return isDone_[i]; });
+        }
+        if (!results_[i]->commit())
+            error("failed to write archive files of segment '%s'", jobs_[i].segment->fullName().c_str());
+        else if (journal_)
+            journal_->finish(jobs_[i].segment->fullName());
+        delete results_[i];
+        results_[i] = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++nCommittedSegments_;
+        }
+        jobAvailable_.notify_all();
+    }
+
+    for (u32 t = 0; t < threads_.size(); ++t)
+        threads_[t].join();
+    threads_.clear();
+    results_.clear();
+    isDone_.clear();
+
+    for (u32 t = 0; t < workers_.size(); ++t) {
+        if (!workers_[t]->commitFinalWrites())
+            error("failed to write archive files of worker %d", t);
+        log("worker %d processed %zd segments, %zd of them stolen from other workers",
+            t, workers_[t]->nSegments(), workers_[t]->nStolenSegments());
+    }
+}
@@ -0,0 +1,119 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _SPEECH_PARALLEL_CORPUS_VISITOR_HH
+#define _SPEECH_PARALLEL_CORPUS_VISITOR_HH
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <Bliss/CorpusDescription.hh>
+#include <Core/Archive.hh>
+#include <Core/Component.hh>
+#include "CorpusVisitor.hh"
+
+namespace Speech {
+
+class CorpusProcessor;
+class ProgressJournal;
+
+/**
+ * Multi-threaded counterpart of CorpusVisitor.
+ *
+ * Several segments are processed concurrently.  Each worker thread owns a
+ * complete pipeline of corpus processors, created by the factory passed to
+ * the constructor, thus every worker has its own flow networks and data
+ * sources.
+ *
+ * Scheduling: the segments are released in windows of consecutive
+ * segments.  Within a window the longest segments are dealt out first,
+ * round robin to the queues of the workers.  Idle workers steal the
+ * shortest remaining segment from the queues of other workers.
+ *
+ * Commit: archive files written while a segment is processed (e.g. by
+ * flow caches, alignment or lattice archives) are deferred and written
+ * by the calling thread in corpus order.  Thus the archives are
+ * deterministic and equal to those written by CorpusVisitor.  At most
+ * max-pending-segments segments are processed ahead of the segment
+ * committed.
+ *
+ * Each pipeline sees the root corpus, and the sub-corpora and recordings
+ * of the segments it processes.  Statistics accumulated by the
+ * processors are per worker, see processor().  Log output of different
+ * workers may interleave.
+ *
+ * With a progress journal (selection progress-journal), finished
+ * segments are skipped and each segment is journaled once its archive
+ * files have been committed.
+ */
+class ParallelCorpusVisitor : public Core::Component {
+public:
+    static const Core::ParameterInt paramNumberOfThreads;
+    static const Core::ParameterInt paramMaxPendingSegments;
+
+    typedef std::function<CorpusProcessor*()> ProcessorFactory;
+
+private:
+    struct Job {
+        Bliss::Segment* segment;
+        size_t          recordingIndex;
+        size_t          segmentIndex;
+        Bliss::Time     duration;
+    };
+
+    class SegmentCollector;
+    class Worker;
+    friend class SegmentCollector;
+    friend class Worker;
+
+    std::vector<Worker*>     workers_;
+    std::vector<std::thread> threads_;
+
+    std::vector<Job>                          jobs_;
+    std::vector<Core::DeferredArchiveWrites*> results_;
+    std::vector<bool>                         isDone_;
+    size_t                                    nextWindow_;
+    size_t                                    windowSize_;
+    size_t                                    maxPendingSegments_;
+    size_t                                    nCommittedSegments_;
+    std::mutex                                mutex_;
+    std::condition_variable                   jobAvailable_;
+    std::condition_variable                   resultAvailable_;
+    ProgressJournal*                          journal_;
+
+    bool canReleaseWindow() const;
+    void releaseWindow();
+    bool nextJob(u32 worker, size_t& index);
+    void putResult(size_t index);
+    void processSegments(Bliss::Corpus* corpus);
+
+public:
+    ParallelCorpusVisitor(const Core::Configuration& c, const ProcessorFactory& createProcessor);
+    virtual ~ParallelCorpusVisitor();
+
+    /** Processes all selected segments of the corpus. */
+    void accept(Bliss::CorpusDescription& corpus);
+
+    u32 nWorkers() const {
+        return workers_.size();
+    }
+    /** Corpus processor of the given worker, e.g. for combining accumulated statistics. */
+    CorpusProcessor* processor(u32 worker) const;
+};
+
+}  // namespace Speech
+
+#endif  // _SPEECH_PARALLEL_CORPUS_VISITOR_HH
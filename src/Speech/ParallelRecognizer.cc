@@ -0,0 +1,423 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "ParallelRecognizer.hh"
+#include <Bliss/Evaluation.hh>
+#include <Core/Statistics.hh>
+#include <Lattice/LatticeAdaptor.hh>
+#include <Search/LatticeHandler.hh>
+#include <Search/Module.hh>
+#include <Speech/Module.hh>
+#include "Recognizer.hh"
+
+using namespace Speech;
+
+// ===========================================================================
+// class ParallelOfflineRecognizer::JobCollector
+
+/**
+ * Look-ahead pass over the corpus: collects the speech segments together with
+ * the data source parameters Speech::CorpusVisitor would set for them.
+ */
+class ParallelOfflineRecognizer::JobCollector : public Bliss::CorpusVisitor {
+private:
+    std::vector<Job>& jobs_;
+    size_t            recordingIndex_;
+    size_t            segmentIndex_;
+
+public:
+    JobCollector(std::vector<Job>& jobs)
+            : jobs_(jobs), recordingIndex_(0), segmentIndex_(0) {}
+
+    virtual void enterCorpus(Bliss::Corpus*) {
+        recordingIndex_ = 0;
+    }
+    virtual void enterRecording(Bliss::Recording*) {
+        segmentIndex_ = 0;
+    }
+    virtual void leaveRecording(Bliss::Recording*) {
+        ++recordingIndex_;
+    }
+    virtual void visitSegment(Bliss::Segment*) {
+        ++segmentIndex_;
+    }
+    virtual void visitSpeechSegment(Bliss::SpeechSegment* s) {
+        jobs_.push_back(Job());
+        Job& job = jobs_.back();
+        job.name = s->fullName();
+        getSegmentParameters(recordingIndex_, segmentIndex_, s, job.parameters);
+        getClearedSegmentParameters(s, job.clearedParameters);
+        ++segmentIndex_;
+    }
+};
+
+// ===========================================================================
+// class ParallelOfflineRecognizer::Worker
+
+class ParallelOfflineRecognizer::Worker {
+private:
+    ParallelOfflineRecognizer*               parent_;
+    Search::SearchAlgorithm*                 recognizer_;
+    Core::Ref<DataSource>                    dataSource_;
+    Core::Ref<const Mm::ScaledFeatureScorer> featureScorer_;
+    bool                                     isFeatureDescriptionChecked_;
+
+    void decode(const Job& job, Result& result);
+
+public:
+    Worker(ParallelOfflineRecognizer* parent, Search::SearchAlgorithm* recognizer, Core::Ref<DataSource> dataSource)
+            : parent_(parent),
+              recognizer_(recognizer),
+              dataSource_(dataSource),
+              featureScorer_(parent->acousticModel_->featureScorer()),
+              isFeatureDescriptionChecked_(false) {
+        dataSource_->setProgressIndication(false);
+    }
+    ~Worker() {
+        delete recognizer_;
+    }
+
+    /** Thread main function: decodes segments until no job is left. */
+    void run();
+
+    void logStatistics() const {
+        recognizer_->logStatistics();
+    }
+};
+
+void ParallelOfflineRecognizer::Worker::run() {
+    size_t index;
+    while (parent_->nextJob(index)) {
+        Result* result = new Result();
+        decode(parent_->jobs_[index], *result);
+        parent_->putResult(index, result);
+    }
+}
+
+void ParallelOfflineRecognizer::Worker::decode(const Job& job, Result& result) {
+    Core::Timer timer;
+    timer.start();
+
+    setParametersOnDataSource(dataSource_, job.parameters);
+    {
+        std::lock_guard<std::mutex> lock(parent_->modelMutex_);
+        recognizer_->restart();
+    }
+    // progress indication is disabled, thus the segment is not needed
+    dataSource_->initialize(0);
+
+    Core::Ref<Feature> feature;
+    while (dataSource_->getData(feature)) {
+        if (!isFeatureDescriptionChecked_ && !parent_->noDependencyCheck_) {
+            std::lock_guard<std::mutex> lock(parent_->modelMutex_);
+            if (!parent_->acousticModel_->isCompatible(Mm::FeatureDescription(*parent_, *feature)))
+                parent_->acousticModel_->respondToDelayedErrors();
+        }
+        isFeatureDescriptionChecked_ = true;
+        recognizer_->feed(featureScorer_->getScorer(feature));
+        if (parent_->tracebackChannel_.isOpen())
+            result.featureTimes.push_back(feature->timestamp());
+    }
+    // end of stream, e.g. for feature scorers batching the frames of several workers
+    featureScorer_->finalize();
+    dataSource_->finalize();
+    {
+        std::lock_guard<std::mutex> lock(parent_->modelMutex_);
+        recognizer_->getCurrentBestSentence(result.traceback);
+        result.lattice = recognizer_->getCurrentWordLattice();
+    }
+    setParametersOnDataSource(dataSource_, job.clearedParameters);
+
+    timer.stop();
+    result.realTime    = dataSource_->realTime();
+    result.elapsedTime = timer.elapsed();
+}
+
+// ===========================================================================
+// class ParallelOfflineRecognizer
+
+const Core::ParameterInt ParallelOfflineRecognizer::paramNumberOfThreads(
+        "threads",
+        "number of segments decoded concurrently",
+        1, 1);
+const Core::ParameterInt ParallelOfflineRecognizer::paramMaxPendingSegments(
+        "max-pending-segments",
+        "maximum number of segments decoded ahead of the segment written (0: four times the number of threads)",
+        0, 0);
+const Core::ParameterBool ParallelOfflineRecognizer::paramStoreLattices(
+        "store-lattices",
+        "store word lattices in archive",
+        false);
+const Core::ParameterBool ParallelOfflineRecognizer::paramStoreTracebacks(
+        "store-tracebacks",
+        "store recognition tracebacks in archive",
+        false);
+const Core::ParameterBool ParallelOfflineRecognizer::paramTimeConditionedLattice(
+        "time-conditioned-lattice",
+        "produce time-conditioned lattice (instead of LM conditioned lattice)",
+        false);
+const Core::ParameterString ParallelOfflineRecognizer::paramLayerName(
+        "layer-name",
+        "name to distinguish results of differently parameterized passes over same corpus",
+        "",
+        "Analog tool keeps the results of different layers apart");
+const Core::ParameterBool ParallelOfflineRecognizer::paramEvaluteResult(
+        "evaluate-result",
+        "evaluate recognition results",
+        true);
+const Core::ParameterBool ParallelOfflineRecognizer::paramNoDependencyCheck(
+        "no-dependency-check",
+        "do not check any dependencies",
+        false);
+
+ParallelOfflineRecognizer::ParallelOfflineRecognizer(const Core::Configuration& c)
+        : Core::Component(c),
+          firstResult_(0),
+          nextJob_(0),
+          maxPendingSegments_(paramMaxPendingSegments(c)),
+          terminate_(false),
+          shouldEvaluateResult_(paramEvaluteResult(c)),
+          shouldStoreLattice_(paramStoreLattices(c)),
+          timeConditionedLattice_(paramTimeConditionedLattice(c)),
+          noDependencyCheck_(paramNoDependencyCheck(c)),
+          layerName_(paramLayerName(c)),
+          evaluator_(0),
+          latticeHandler_(0),
+          tracebackArchiveWriter_(0),
+          tracebackChannel_(c, "traceback"),
+          channelTimer_(c, "real-time-factor"),
+          nCommittedSegments_(0) {
+    const u32                 nThreads   = paramNumberOfThreads(config);
+    const Search::SearchType  searchType = static_cast<Search::SearchType>(Recognizer::paramSearch(config));
+    std::vector<Search::SearchAlgorithm*> recognizers;
+    for (u32 t = 0; t < nThreads; ++t)
+        recognizers.push_back(Search::Module::instance().createRecognizer(searchType, select("recognizer")));
+
+    modelCombination_ = ModelCombinationRef(new ModelCombination(select("model-combination"), recognizers.front()->modelCombinationNeeded(), Am::AcousticModel::complete));
+    modelCombination_->load();
+    lexicon_       = modelCombination_->lexicon();
+    acousticModel_ = modelCombination_->acousticModel();
+
+    if (acousticModel_->featureScorer()->isBuffered())
+        criticalError("parallel recognition does not support buffered feature scorers");
+
+    for (u32 t = 0; t < nThreads; ++t) {
+        Search::SearchAlgorithm* recognizer = recognizers[t];
+        recognizer->setModelCombination(*modelCombination_);
+        recognizer->init();
+        if (recognizer->lookAheadLength() > 0)
+            criticalError("parallel recognition does not support acoustic look-ahead");
+        Core::Ref<DataSource> dataSource(Speech::Module::instance().createDataSource(select("feature-extraction")));
+        dataSource->respondToDelayedErrors();
+        workers_.push_back(new Worker(this, recognizer, dataSource));
+    }
+    if (maxPendingSegments_ == 0)
+        maxPendingSegments_ = 4 * workers_.size();
+
+    latticeHandler_ = Search::Module::instance().createLatticeHandler(select("lattice-archive"));
+    latticeHandler_->setLexicon(lexicon_);
+    if (paramStoreTracebacks(config)) {
+        log("opening traceback archive");
+        tracebackArchiveWriter_ = Lattice::Archive::openForWriting(select("traceback-archive"), lexicon_);
+        if (tracebackArchiveWriter_->hasFatalErrors()) {
+            delete tracebackArchiveWriter_;
+            tracebackArchiveWriter_ = 0;
+        }
+    }
+    evaluator_ = new Bliss::Evaluator(select("evaluation"), lexicon_);
+}
+
+ParallelOfflineRecognizer::~ParallelOfflineRecognizer() {
+    stopWorkers();
+    for (u32 t = 0; t < workers_.size(); ++t)
+        delete workers_[t];
+    for (std::deque<Result*>::iterator r = results_.begin(); r != results_.end(); ++r)
+        delete *r;
+    delete latticeHandler_;
+    delete tracebackArchiveWriter_;
+    delete evaluator_;
+}
+
+void ParallelOfflineRecognizer::recognize(Bliss::CorpusDescription& corpus) {
+    jobs_.clear();
+    JobCollector collector(jobs_);
+    corpus.acceptWithoutReporting(&collector);
+    log("decoding %zd segments with %zd threads", jobs_.size(), workers_.size());
+
+    nCommittedSegments_ = 0;
+    startWorkers();
+    corpus.accept(this);
+    stopWorkers();
+    if (nCommittedSegments_ != jobs_.size())
+        error("only %zd of %zd segments were processed", nCommittedSegments_, jobs_.size());
+
+    for (u32 t = 0; t < workers_.size(); ++t)
+        workers_[t]->logStatistics();
+}
+
+void ParallelOfflineRecognizer::startWorkers() {
+    verify(threads_.empty());
+    firstResult_ = nextJob_ = 0;
+    terminate_              = false;
+    for (u32 t = 0; t < workers_.size(); ++t)
+        threads_.push_back(std::thread(&Worker::run, workers_[t]));
+}
+
+void ParallelOfflineRecognizer::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        terminate_ = true;
+    }
+    jobAvailable_.notify_all();
+    for (u32 t = 0; t < threads_.size(); ++t)
+        threads_[t].join();
+    threads_.clear();
+}
+
+bool ParallelOfflineRecognizer::nextJob(size_t& index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobAvailable_.wait(lock, [this]() {
+        return terminate_ || nextJob_ >= jobs_.size() || nextJob_ < firstResult_ + maxPendingSegments_;
+    });
+    if (terminate_ || nextJob_ >= jobs_.size())
+        return false;
+    index = nextJob_++;
+    while (firstResult_ + results_.size() <= index)
+        results_.push_back(0);
+    return true;
+}
+
+void ParallelOfflineRecognizer::putResult(size_t index, Result* result) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        verify(index >= firstResult_ && index < firstResult_ + results_.size());
+        result->isReady                 = true;
+        results_[index - firstResult_] = result;
+    }
+    resultAvailable_.notify_all();
+}
+
+void ParallelOfflineRecognizer::visitSpeechSegment(Bliss::SpeechSegment* s) {
+    const size_t index = nCommittedSegments_;
+    if (index >= jobs_.size() || jobs_[index].name != s->fullName())
+        criticalError("segment '%s' was not selected in the look-ahead pass", s->fullName().c_str());
+
+    Result* result = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        resultAvailable_.wait(lock, [this]() {
+            return !results_.empty() && results_.front() && results_.front()->isReady;
+        });
+        verify(firstResult_ == index);
+        result = results_.front();
+        results_.pop_front();
+        ++firstResult_;
+    }
+    jobAvailable_.notify_all();
+
+    {
+        std::lock_guard<std::mutex> lock(modelMutex_);
+        // keep worker messages out of the segment's output block
+        Core::Component::MessageLock messageLock;
+        processResult(s, *result);
+        delete result;
+    }
+    ++nCommittedSegments_;
+}
+
+void ParallelOfflineRecognizer::processResult(Bliss::SpeechSegment* s, const Result& result) {
+    const Traceback& traceback = result.traceback;
+
+    Core::XmlWriter& os(clog());
+    if (!layerName_.empty())
+        os << Core::XmlOpen("layer") + Core::XmlAttribute("name", layerName_);
+    if (s->orth().size()) {
+        os << Core::XmlOpen("orth") + Core::XmlAttribute("source", "reference")
+           << s->orth()
+           << Core::XmlClose("orth");
+    }
+    os << Core::XmlOpen("traceback");
+    traceback.write(os, lexicon_->phonemeInventory());
+    os << Core::XmlClose("traceback");
+    os << Core::XmlOpen("orth") + Core::XmlAttribute("source", "recognized");
+    for (u32 i = 0; i < traceback.size(); ++i)
+        if (traceback[i].pronunciation)
+            os << traceback[i].pronunciation->lemma()->preferredOrthographicForm()
+               << Core::XmlBlank();
+    os << Core::XmlClose("orth");
+    if (tracebackChannel_.isOpen() && !traceback.empty())
+        logTraceback(traceback, result.featureTimes);
+
+    Core::Ref<const Search::LatticeAdaptor> lattice = result.lattice;
+    if (lattice && !lattice->empty()) {
+        if (timeConditionedLattice_) {
+            lattice = Core::ref(new Lattice::WordLatticeAdaptor(
+                    Lattice::timeConditionedWordLattice(lattice->wordLattice(latticeHandler_))));
+        }
+        if (shouldStoreLattice_) {
+            if (!lattice->write(s->fullName(), latticeHandler_))
+                error("cannot write lattice '%s'", s->fullName().c_str());
+        }
+    }
+    if (tracebackArchiveWriter_) {
+        tracebackArchiveWriter_->store(s->fullName(), traceback.wordLattice(lexicon_));
+    }
+
+    if (shouldEvaluateResult_) {
+        evaluator_->setReferenceTranscription(s->orth());
+        evaluator_->evaluate(
+                traceback.lemmaPronunciationAcceptor(lexicon_),
+                "single best");
+        if (lattice && !lattice->empty()) {
+            Lattice::ConstWordLatticeRef wl = lattice->wordLattice(latticeHandler_);
+            if (wl->nParts() > 0)
+                evaluator_->evaluate(wl->part(0), "lattice");
+        }
+    }
+    reportRealTime(result);
+    if (!layerName_.empty())
+        os << Core::XmlClose("layer");
+}
+
+void ParallelOfflineRecognizer::reportRealTime(const Result& result) {
+    if (channelTimer_.isOpen()) {
+        channelTimer_ << Core::XmlFull("real-time", result.realTime);
+        if (result.realTime > 0)
+            channelTimer_ << Core::XmlFull("real-time-factor", result.elapsedTime / result.realTime) + Core::XmlAttribute("reference", "elapsed time");
+    }
+}
+
+void ParallelOfflineRecognizer::logTraceback(const Traceback& traceback, const std::vector<Flow::Timestamp>& featureTimes) {
+    tracebackChannel_ << Core::XmlOpen("traceback") + Core::XmlAttribute("type", "xml");
+    u32                                  previousIndex = traceback.begin()->time;
+    Search::SearchAlgorithm::ScoreVector previousScore(0.0, 0.0);
+    for (Traceback::const_iterator tbi = traceback.begin(); tbi != traceback.end(); ++tbi) {
+        if (tbi->pronunciation) {
+            tracebackChannel_ << Core::XmlOpen("item") + Core::XmlAttribute("type", "pronunciation")
+                              << Core::XmlFull("orth", tbi->pronunciation->lemma()->preferredOrthographicForm())
+                              << Core::XmlFull("phon", tbi->pronunciation->pronunciation()->format(lexicon_->phonemeInventory()))
+                              << Core::XmlFull("score", f32(tbi->score.acoustic - previousScore.acoustic)) + Core::XmlAttribute("type", "acoustic")
+                              << Core::XmlFull("score", f32(tbi->score.lm - previousScore.lm)) + Core::XmlAttribute("type", "language");
+            if (previousIndex < tbi->time)
+                tracebackChannel_ << Core::XmlEmpty("samples") + Core::XmlAttribute("start", f32(featureTimes[previousIndex].startTime())) +
+                                             Core::XmlAttribute("end", f32(featureTimes[tbi->time - 1].endTime()))
+                                  << Core::XmlEmpty("features") + Core::XmlAttribute("start", previousIndex) +
+                                             Core::XmlAttribute("end", tbi->time - 1);
+            tracebackChannel_ << Core::XmlClose("item");
+        }
+        previousScore = tbi->score;
+        previousIndex = tbi->time;
+    }
+    tracebackChannel_ << Core::XmlClose("traceback");
+}
@@ -0,0 +1,156 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _SPEECH_PARALLEL_RECOGNIZER_HH
+#define _SPEECH_PARALLEL_RECOGNIZER_HH
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <Bliss/CorpusDescription.hh>
+#include <Core/Component.hh>
+#include <Lattice/Archive.hh>
+#include <Search/Search.hh>
+#include "CorpusVisitor.hh"
+#include "DataSource.hh"
+#include "ModelCombination.hh"
+
+namespace Bliss {
+class Evaluator;
+}
+
+namespace Search {
+class LatticeHandler;
+}
+
+namespace Speech {
+
+/**
+ * Multi-threaded corpus driven recognition.
+ *
+ * Several segments are decoded concurrently.  Each worker thread owns a
+ * search algorithm and a feature extraction network (DataSource), while
+ * lexicon, acoustic model and language model are loaded only once and are
+ * shared read-only by all workers.  The advanced tree search also shares
+ * its static search network and LM look-ahead structure between the
+ * workers (parameter share-search-network).
+ *
+ * The corpus is traversed twice: a look-ahead pass without progress
+ * reporting collects the segments and hands them to the workers.  The
+ * actual pass waits for the result of each segment and writes it, so that
+ * results and per-segment log output appear in corpus order and do not
+ * interleave.  Messages the workers log while decoding are serialized
+ * per message (see Core::Component::Message).  At most max-pending-segments segments are decoded ahead of
+ * the segment currently written.
+ *
+ * Restrictions: buffered feature scorers (e.g. batched NN scorers),
+ * acoustic look-ahead and segment dependent language models keep
+ * per-stream state in the shared models and are not supported.  Use the
+ * nn-multi-stream feature scorer to forward the frames of all workers in
+ * common minibatches.  Search
+ * restart, traceback and lattice construction may touch reference counts
+ * of the shared models and are therefore serialized.
+ *
+ * Output (XML format) per segment as in OfflineRecognizer, search
+ * statistics are accumulated and logged per worker at the end.
+ */
+class ParallelOfflineRecognizer : public Core::Component,
+                                  public Bliss::CorpusVisitor {
+public:
+    static const Core::ParameterInt    paramNumberOfThreads;
+    static const Core::ParameterInt    paramMaxPendingSegments;
+    static const Core::ParameterBool   paramStoreLattices;
+    static const Core::ParameterBool   paramStoreTracebacks;
+    static const Core::ParameterBool   paramTimeConditionedLattice;
+    static const Core::ParameterString paramLayerName;
+    static const Core::ParameterBool   paramEvaluteResult;
+    static const Core::ParameterBool   paramNoDependencyCheck;
+
+private:
+    typedef Search::SearchAlgorithm::Traceback Traceback;
+
+    /** Everything a worker needs to know about a segment, independent of the Bliss objects. */
+    struct Job {
+        std::string          name;
+        SegmentParameterList parameters;
+        SegmentParameterList clearedParameters;
+    };
+
+    struct Result {
+        bool                                    isReady;
+        Traceback                               traceback;
+        Core::Ref<const Search::LatticeAdaptor> lattice;
+        std::vector<Flow::Timestamp>            featureTimes;
+        Flow::Time                              realTime;
+        f32                                     elapsedTime;
+        Result()
+                : isReady(false), realTime(0), elapsedTime(0) {}
+    };
+
+    class JobCollector;
+    class Worker;
+    friend class Worker;
+
+    ModelCombinationRef          modelCombination_;
+    Bliss::LexiconRef            lexicon_;
+    Core::Ref<Am::AcousticModel> acousticModel_;
+    std::vector<Worker*>         workers_;
+    std::vector<std::thread>     threads_;
+
+    std::vector<Job> jobs_;
+    /** Results of segments [firstResult_, firstResult_ + results_.size()) */
+    std::deque<Result*>     results_;
+    size_t                  firstResult_;
+    size_t                  nextJob_;
+    size_t                  maxPendingSegments_;
+    bool                    terminate_;
+    std::mutex              mutex_;
+    std::condition_variable jobAvailable_;
+    std::condition_variable resultAvailable_;
+
+    /** Serializes operations which may change reference counts of the shared models */
+    std::mutex modelMutex_;
+
+    bool                    shouldEvaluateResult_, shouldStoreLattice_, timeConditionedLattice_, noDependencyCheck_;
+    std::string             layerName_;
+    Bliss::Evaluator*       evaluator_;
+    Search::LatticeHandler* latticeHandler_;
+    Lattice::ArchiveWriter* tracebackArchiveWriter_;
+    Core::XmlChannel        tracebackChannel_;
+    Core::XmlChannel        channelTimer_;
+    size_t                  nCommittedSegments_;
+
+    bool  nextJob(size_t& index);
+    void  putResult(size_t index, Result* result);
+    void  startWorkers();
+    void  stopWorkers();
+    void  processResult(Bliss::SpeechSegment* segment, const Result& result);
+    void  logTraceback(const Traceback& traceback, const std::vector<Flow::Timestamp>& featureTimes);
+    void  reportRealTime(const Result& result);
+
+public:
+    ParallelOfflineRecognizer(const Core::Configuration&);
+    virtual ~ParallelOfflineRecognizer();
+
+    /** Decodes all selected segments of the corpus. */
+    void recognize(Bliss::CorpusDescription& corpus);
+
+    virtual void visitSpeechSegment(Bliss::SpeechSegment*);
+};
+
+}  // namespace Speech
+
+#endif  // _SPEECH_PARALLEL_RECOGNIZER_HH
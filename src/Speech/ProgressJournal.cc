@@ -0,0 +1,182 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include "ProgressJournal.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
+
+#include <Core/Application.hh>
+#include <Core/Directory.hh>
+
+using namespace Speech;
+
+namespace {
+
+std::mutex       journalMutex;
+ProgressJournal* openJournal = 0;
+
+const std::string segmentTag = "segment ";
+const std::string fileTag    = "file ";
+
+}  // namespace
+
+const Core::ParameterString ProgressJournal::paramFile(
+        "file",
+        "progress journal: finished segments and the archive files written for them, empty for no journal",
+        "");
+const Core::ParameterBool ProgressJournal::paramResume(
+        "resume",
+        "skip the segments finished according to an existing journal, otherwise start a new journal",
+        true);
+
+ProgressJournal::ProgressJournal(const Core::Configuration& c)
+        : Core::Component(c),
+          filename_(paramFile(config)),
+          fd_(-1),
+          nUsers_(0),
+          nSkippedSegments_(0) {
+    bool resume = paramResume(config) && Core::isRegularFile(filename_);
+    if (resume && !read())
+        return;
+    Core::createDirectory(Core::directoryName(filename_));
+    fd_ = ::open(filename_.c_str(), O_WRONLY | O_CREAT | O_APPEND | (resume ? 0 : O_TRUNC), 0644);
+    if (fd_ == -1) {
+        error("failed to open progress journal \"%s\"", filename_.c_str());
+        return;
+    }
+    if (resume)
+        log("resuming from progress journal \"%s\": %zd segments finished, %zd files of an interrupted segment are replaced",
+            filename_.c_str(), finishedSegments_.size(), interruptedFiles_.size());
+    else
+        log("writing progress journal \"%s\"", filename_.c_str());
+    Core::Archive::setWriteListener(this);
+}
+
+ProgressJournal::~ProgressJournal() {
+    if (fd_ != -1) {
+        Core::Archive::setWriteListener(0);
+        ::close(fd_);
+    }
+    if (nSkippedSegments_)
+        log("%zd segments skipped, finished by a previous run", nSkippedSegments_);
+}
+
+ProgressJournal* ProgressJournal::acquire(const Core::Configuration& c) {
+    if (paramFile(c).empty())
+        return 0;
+    std::lock_guard<std::mutex> lock(journalMutex);
+    if (!openJournal) {
+        openJournal = new ProgressJournal(c);
+        if (openJournal->fd_ == -1) {
+            delete openJournal;
+            openJournal = 0;
+            return 0;
+        }
+    }
+    else if (openJournal->filename_ != paramFile(c)) {
+        Core::Application::us()->error("progress journal \"%s\" ignored, journal \"%s\" is already open",
+                                       paramFile(c).c_str(), openJournal->filename_.c_str());
+        return 0;
+    }
+    ++openJournal->nUsers_;
+    return openJournal;
+}
+
+void ProgressJournal::release(ProgressJournal* journal) {
+    if (!journal)
+        return;
+    std::lock_guard<std::mutex> lock(journalMutex);
+    verify(journal == openJournal && journal->nUsers_ > 0);
+    if (--journal->nUsers_ == 0) {
+        delete journal;
+        openJournal = 0;
+    }
+}
+
+std::string ProgressJournal::fileKey(const Core::Archive& archive, const std::string& name) {
+    return archive.path() + "\t" + name;
+}
+
+bool ProgressJournal::read() {
+    std::ifstream is(filename_.c_str());
+    if (!is) {
+        error("failed to read progress journal \"%s\"", filename_.c_str());
+        return false;
+    }
+    std::vector<std::string> pendingFiles;
+    std::string              line;
+    off_t                    size = 0;
+    while (std::getline(is, line)) {
+        // a line without newline has been cut off
+        if (is.eof())
+            break;
+        size += line.size() + 1;
+        if (line.compare(0, segmentTag.size(), segmentTag) == 0) {
+            finishedSegments_.insert(line.substr(segmentTag.size()));
+            pendingFiles.clear();
+        }
+        else if (line.compare(0, fileTag.size(), fileTag) == 0) {
+            pendingFiles.push_back(line.substr(fileTag.size()));
+        }
+        else {
+            warning("unknown line in progress journal \"%s\": %s", filename_.c_str(), line.c_str());
+        }
+    }
+    is.close();
+    // files written after the last finished segment belong to an interrupted segment
+    interruptedFiles_.insert(pendingFiles.begin(), pendingFiles.end());
+    // remove an incomplete last line
+    if (::truncate(filename_.c_str(), size) != 0) {
+        error("failed to truncate progress journal \"%s\"", filename_.c_str());
+        return false;
+    }
+    return true;
+}
+
+void ProgressJournal::append(const std::string& line, bool sync) {
+    std::string data = line + "\n";
+    size_t      done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd_, data.data() + done, data.size() - done);
+        if (n <= 0) {
+            error("failed to write progress journal \"%s\"", filename_.c_str());
+            return;
+        }
+        done += n;
+    }
+    if (sync && ::fsync(fd_) != 0)
+        warning("failed to sync progress journal \"%s\"", filename_.c_str());
+}
+
+void ProgressJournal::skip(const std::string& segmentName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++nSkippedSegments_;
+}
+
+void ProgressJournal::finish(const std::string& segmentName) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(segmentTag + segmentName, true);
+}
+
+bool ProgressJournal::replaceFile(const Core::Archive& archive, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return interruptedFiles_.find(fileKey(archive, name)) != interruptedFiles_.end();
+}
+
+void ProgressJournal::fileWritten(const Core::Archive& archive, const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(fileTag + fileKey(archive, name), false);
+}
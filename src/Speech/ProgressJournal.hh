@@ -0,0 +1,96 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#ifndef _SPEECH_PROGRESS_JOURNAL_HH
+#define _SPEECH_PROGRESS_JOURNAL_HH
+
+#include <mutex>
+#include <unordered_set>
+
+#include <Core/Archive.hh>
+#include <Core/Component.hh>
+#include <Core/Parameter.hh>
+
+namespace Speech {
+
+/**
+ * Journal of the progress of a corpus run, which allows to resume an
+ * interrupted run.
+ *
+ * The journal is a text file to which one line is appended for each
+ * archive file written ("file <archive>\t<name>") and for each segment
+ * finished ("segment <name>").  A segment is journaled after all archive
+ * files written for it; the archives are synced before a file is
+ * journaled and the journal is synced after each segment.
+ *
+ * On restart with the same journal, the finished segments are skipped.
+ * The archives are opened as usual, i.e. existing file archives are
+ * appended to (their file table is recovered by a scan if the run was
+ * killed).  Files written for a segment which was not finished are
+ * replaced when the segment is processed again.
+ *
+ * Only suited for corpus processors whose results are written per
+ * segment, e.g. recognition, alignment and lattice generation;
+ * statistics accumulated over the corpus miss the skipped segments.
+ * While a journal is open it is the write listener of all archives,
+ * therefore at most one journal can be open; CorpusVisitor and
+ * ParallelCorpusVisitor share it by acquire() and release().
+ */
+class ProgressJournal : public Core::Component,
+                        public Core::ArchiveWriteListener {
+public:
+    static const Core::ParameterString paramFile;
+    static const Core::ParameterBool   paramResume;
+
+private:
+    std::string                     filename_;
+    int                             fd_;
+    u32                             nUsers_;
+    std::mutex                      mutex_;
+    std::unordered_set<std::string> finishedSegments_;
+    std::unordered_set<std::string> interruptedFiles_;
+    size_t                          nSkippedSegments_;
+
+    static std::string fileKey(const Core::Archive& archive, const std::string& name);
+
+    bool read();
+    void append(const std::string& line, bool sync);
+
+    ProgressJournal(const Core::Configuration& c);
+    virtual ~ProgressJournal();
+
+public:
+    /**
+     * Opens the journal configured by parameter file, or returns the
+     * journal already open.  Returns 0 if no journal is configured.
+     */
+    static ProgressJournal* acquire(const Core::Configuration& c);
+    static void             release(ProgressJournal* journal);
+
+    /** True if the segment has been finished by a previous run. */
+    bool isFinished(const std::string& segmentName) const {
+        return finishedSegments_.find(segmentName) != finishedSegments_.end();
+    }
+    /** Counts a segment skipped because it is finished, see isFinished(). */
+    void skip(const std::string& segmentName);
+    /** Journals the segment, after all its archive files have been written. */
+    void finish(const std::string& segmentName);
+
+    virtual bool replaceFile(const Core::Archive& archive, const std::string& name);
+    virtual void fileWritten(const Core::Archive& archive, const std::string& name);
+};
+
+}  // namespace Speech
+
+#endif  // _SPEECH_PROGRESS_JOURNAL_HH
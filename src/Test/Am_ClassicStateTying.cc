@@ -0,0 +1,97 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/**
+ * Test cases for the compiled state tying table: the table has to agree
+ * with the state tying for all allophone states it defines and must not
+ * define the others.
+ */
+
+#include <Test/UnitTest.hh>
+
+#include <Am/ClassicStateTying.hh>
+#include <Test/File.hh>
+#include <Test/Lexicon.hh>
+#include <fstream>
+
+namespace {
+
+/** Gives access to the compiled table. */
+class CompiledLutStateTying : public Am::LutStateTying {
+public:
+    CompiledLutStateTying(const Core::Configuration& config, Am::ClassicStateModelRef stateModel)
+            : Core::Component(config),
+              Am::LutStateTying(config, stateModel) {}
+
+    using Am::ClassicStateTying::tableClassifyIndex;
+};
+
+Am::ClassicStateModelRef getStateModel(Bliss::LexiconRef lexicon) {
+    Core::Configuration                config;
+    Am::HmmTopologySetRef              hmmTopologies(new Am::HmmTopologySet(config, lexicon->phonemeInventory()->phoneme("si")->id()));
+    Am::ConstPhonologyRef              phonology(new Am::Phonology(config, lexicon->phonemeInventory()));
+    Am::ConstAllophoneAlphabetRef      allophones(new Am::AllophoneAlphabet(config, phonology, lexicon));
+    Am::ConstAllophoneStateAlphabetRef allophoneStates(new Am::AllophoneStateAlphabet(config, allophones, hmmTopologies));
+    return Am::ClassicStateModelRef(new Am::ClassicStateModel(phonology, allophones, allophoneStates, hmmTopologies));
+}
+
+}  // namespace
+
+TEST(Am, ClassicStateTying, CompiledTable) {
+    ::Test::Lexicon* lexicon = new ::Test::Lexicon();
+    lexicon->addPhoneme("si", false);
+    lexicon->addPhoneme("a");
+    lexicon->addPhoneme("b");
+    lexicon->addPhoneme("c");
+    lexicon->addLemma("[SILENCE]", "si", "silence");
+    lexicon->addLemma("A", "a");
+    lexicon->addLemma("AC", "a c");
+    lexicon->addLemma("BAC", "b a c");
+    Am::ClassicStateModelRef           stateModel = getStateModel(Bliss::LexiconRef(lexicon));
+    Am::ConstAllophoneStateAlphabetRef alphabet   = stateModel->getAllophoneStateAlphabet();
+
+    // every third allophone state is not in the lookup table
+    ::Test::Directory dir;
+    const std::string filename = ::Test::File(dir, "state-tying.lut").path();
+    std::vector<bool> defined;
+    std::ofstream     lut(filename.c_str());
+    for (auto it = alphabet->allophoneStates(); it.first != it.second; ++it.first) {
+        defined.push_back(defined.size() % 3 != 2);
+        if (defined.back())
+            lut << alphabet->symbol(it.first.id()) << " " << defined.size() % 7 << std::endl;
+    }
+    lut.close();
+    EXPECT_TRUE(defined.size() > 3);
+
+    Core::Configuration config;
+    config.set("*.file", filename);
+    config.set("*.compiled-table", "false");
+    Am::LutStateTying reference(config, stateModel);
+    EXPECT_TRUE(!reference.hasCompiledTable());
+    config.set("*.compiled-table", "true");
+    CompiledLutStateTying compiled(config, stateModel);
+    EXPECT_TRUE(compiled.hasCompiledTable());
+
+    size_t i = 0;
+    for (auto it = alphabet->allophoneStates(); it.first != it.second; ++it.first, ++i) {
+        const Am::AllophoneStateIndex index = it.first.id();
+        if (defined[i]) {
+            EXPECT_EQ(reference.classifyIndex(index), compiled.tableClassifyIndex(index));
+            EXPECT_EQ(reference.classify(it.first.allophoneState()), compiled.classifyIndex(index));
+        }
+        else {
+            EXPECT_EQ(Mm::invalidMixture, compiled.tableClassifyIndex(index));
+        }
+    }
+}
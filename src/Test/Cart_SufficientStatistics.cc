@@ -0,0 +1,191 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Test/UnitTest.hh>
+
+#include <Cart/Cluster.hh>
+#include <Cart/DecisionTree.hh>
+#include <Cart/DecisionTreeTrainer.hh>
+#include <Cart/Example.hh>
+#include <Core/CompressedStream.hh>
+#include <Test/File.hh>
+
+namespace {
+
+const char* trainingPlan =
+        "<decision-tree-training>"
+        "<properties-definition>"
+        "<key>left</key><value-map><value id=\"0\">a</value><value id=\"1\">b</value><value id=\"2\">c</value></value-map>"
+        "<key>right</key><value-map><value id=\"0\">a</value><value id=\"1\">b</value><value id=\"2\">c</value></value-map>"
+        "</properties-definition>"
+        "<max-leaves>100</max-leaves>"
+        "<step name=\"split\" action=\"split\">"
+        "<min-obs>1</min-obs>"
+        "<questions>"
+        "<question><key>left</key><value>a</value></question>"
+        "<question><key>left</key><value>b</value></question>"
+        "<question><key>left</key><values>a c</values></question>"
+        "<question><key>right</key><value>a</value></question>"
+        "<question><key>right</key><value>b</value></question>"
+        "<question><key>right</key><values>b c</values></question>"
+        "</questions>"
+        "</step>"
+        "</decision-tree-training>";
+
+/**
+ * Sum of squared errors of one-dimensional examples,
+ * rows of the examples are sum and sum of squares.
+ */
+class SquaredErrorScorer : public Cart::Scorer {
+public:
+    SquaredErrorScorer(const Core::Configuration& config)
+            : Cart::Scorer(config) {}
+
+    void write(std::ostream& os) const {
+        os << "squared-error\n";
+    }
+
+    Cart::Score score(const Cart::ExamplePtrRange& examples) const {
+        f64 statistics[2] = {0.0, 0.0}, nObs = 0.0;
+        for (Cart::ExamplePtrList::const_iterator it = examples.begin; it != examples.end; ++it) {
+            nObs += (*it)->nObs;
+            statistics[0] += (*it)->values->get(0);
+            statistics[1] += (*it)->values->get(1);
+        }
+        return score(nObs, statistics, 2);
+    }
+
+    Cart::Score operator()(const Cart::ExamplePtrRange& leftExamples, const Cart::ExamplePtrRange& rightExamples,
+                           const Cart::Score fatherScore,
+                           Cart::Score& leftChildScore, Cart::Score& rightChildScore) const {
+        leftChildScore  = score(leftExamples);
+        rightChildScore = score(rightExamples);
+        return fatherScore - (leftChildScore + rightChildScore);
+    }
+
+    size_t nStatistics(const Cart::Example& example) const {
+        return 2;
+    }
+    void statistics(const Cart::Example& example, f64* statistics) const {
+        statistics[0] = example.values->get(0);
+        statistics[1] = example.values->get(1);
+    }
+    Cart::Score score(f64 nObs, const f64* statistics, size_t nStatistics) const {
+        return (nObs > 0.0) ? statistics[1] - statistics[0] * statistics[0] / nObs : 0.0;
+    }
+};
+
+void addExamples(Cart::ExampleList& examples) {
+    const char* values[] = {"a", "b", "c"};
+    for (u32 l = 0; l < 3; ++l)
+        for (u32 r = 0; r < 3; ++r) {
+            std::vector<std::string> keys(1, "left"), exampleValues(1, values[l]);
+            keys.push_back("right");
+            exampleValues.push_back(values[r]);
+            f64            nObs    = 5 + l + 2 * r;
+            f64            mean    = 3.0 * l + 0.5 * r * r;
+            Cart::Example* example = new Cart::Example(new Cart::StoredProperties(examples.getMap(), keys, exampleValues), new Cart::FloatBox(2, 1));
+            example->nObs          = nObs;
+            example->values->set(0, nObs * mean);
+            example->values->set(1, nObs * (mean * mean + 1.0 + 0.1 * l));
+            examples.add(example);
+        }
+}
+
+std::vector<Cart::DecisionTree::ClassId> classify(const Core::Configuration& config, const Cart::ExampleList& examples, u32& nClusters) {
+    Cart::DecisionTreeTrainer trainer(config, Cart::PropertyMapRef(new Cart::PropertyMap), Cart::ConstScorerRef(new SquaredErrorScorer(config)));
+    EXPECT_TRUE(trainer.loadFromString(trainingPlan));
+    Cart::ExampleList trainingExamples(config, trainer.plan().map);
+    addExamples(trainingExamples);
+    Cart::DecisionTree tree(config);
+    Cart::ClusterList* clusters = trainer.train(&tree, trainingExamples);
+    EXPECT_TRUE(clusters);
+    nClusters = clusters->size();
+    std::vector<Cart::DecisionTree::ClassId> classes;
+    for (Cart::ExampleList::const_iterator it = trainingExamples.begin(); it != trainingExamples.end(); ++it)
+        classes.push_back(tree.classify(*(*it)->properties));
+    delete clusters;
+    return classes;
+}
+
+}  // namespace
+
+TEST(Cart, SufficientStatistics, SameTree) {
+    Core::Configuration config;
+    Cart::ExampleList   examples(config);
+    u32                 nClusters = 0, nStatisticsClusters = 0;
+
+    std::vector<Cart::DecisionTree::ClassId> classes = classify(config, examples, nClusters);
+    config.set("*.use-sufficient-statistics", "true");
+    config.set("*.cluster-parallel", "true");
+    std::vector<Cart::DecisionTree::ClassId> statisticsClasses = classify(config, examples, nStatisticsClusters);
+
+    EXPECT_TRUE(nClusters > 1);
+    EXPECT_EQ(nClusters, nStatisticsClusters);
+    EXPECT_EQ(classes.size(), statisticsClasses.size());
+    for (size_t i = 0; i < classes.size(); ++i)
+        EXPECT_EQ(classes[i], statisticsClasses[i]);
+}
+
+TEST(Cart, SufficientStatistics, BinaryExampleFile) {
+    Core::Configuration       config;
+    Cart::DecisionTreeTrainer trainer(config);
+    EXPECT_TRUE(trainer.loadFromString(trainingPlan));
+    Cart::ExampleList examples(config, trainer.plan().map);
+    addExamples(examples);
+
+    ::Test::Directory dir;
+    const std::string filename = ::Test::File(dir, "examples.bin").path();
+    EXPECT_TRUE(examples.writeBinary(filename));
+    EXPECT_TRUE(Cart::ExampleList::isBinaryFile(filename));
+
+    // map from file
+    Cart::ExampleList loaded(config);
+    EXPECT_TRUE(loaded.loadFromFile(filename));
+    // map of the training plan
+    Cart::ExampleList loadedWithMap(config, trainer.plan().map);
+    EXPECT_TRUE(loadedWithMap.loadFromFile(filename));
+
+    EXPECT_TRUE(loaded.map() == examples.map());
+    EXPECT_EQ(examples.size(), loaded.size());
+    EXPECT_EQ(examples.size(), loadedWithMap.size());
+    for (size_t i = 0; i < examples.size(); ++i) {
+        EXPECT_EQ(examples[i]->nObs, loaded[i]->nObs);
+        EXPECT_TRUE(*examples[i]->values == *loaded[i]->values);
+        EXPECT_TRUE(*examples[i]->properties == *loaded[i]->properties);
+        EXPECT_TRUE(*examples[i]->properties == *loadedWithMap[i]->properties);
+    }
+
+    // merge binary and xml files, examples with equal properties are accumulated
+    const std::string xmlFilename = ::Test::File(dir, "examples.xml").path();
+    {
+        Core::XmlOutputStream xml(new Core::CompressedOutputStream(xmlFilename));
+        examples.writeXml(xml);
+    }
+    EXPECT_TRUE(!Cart::ExampleList::isBinaryFile(xmlFilename));
+    std::vector<std::string> filenames;
+    filenames.push_back(filename);
+    filenames.push_back(xmlFilename);
+    filenames.push_back(filename);
+    Cart::ExampleList merged(config);
+    EXPECT_TRUE(merged.mergeFromFiles(filenames));
+    EXPECT_TRUE(merged.map() == examples.map());
+    EXPECT_EQ(examples.size(), merged.size());
+    for (size_t i = 0; i < examples.size(); ++i) {
+        EXPECT_TRUE(*examples[i]->properties == *merged[i]->properties);
+        EXPECT_EQ(3 * examples[i]->nObs, merged[i]->nObs);
+        for (u32 r = 0; r < 2; ++r)
+            EXPECT_DOUBLE_EQ(3 * examples[i]->values->get(r), merged[i]->values->get(r), 1e-4 * examples[i]->values->get(r));
+    }
+}
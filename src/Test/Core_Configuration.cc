@@ -0,0 +1,182 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Core/Application.hh>
+#include <Core/Configuration.hh>
+#include <Core/StringUtilities.hh>
+#include <Test/UnitTest.hh>
+#include <chrono>
+#include <map>
+#include <random>
+#include <sstream>
+
+using namespace Core;
+
+namespace {
+
+std::string lookup(const Configuration& config, const std::string& selection, const std::string& parameter) {
+    Configuration c(config);
+    c.setSelection(selection);
+    std::string value = "-";
+    c.get(parameter, value);
+    return value;
+}
+
+/** Straightforward matching: returns true if the resource name matches the path. */
+bool referenceMatch(const std::vector<std::string>& name, size_t i, const std::vector<std::string>& path, size_t j) {
+    if (i == name.size())
+        return j == path.size();
+    if (name[i] == "*") {
+        for (size_t k = j; k <= path.size(); ++k)
+            if (referenceMatch(name, i + 1, path, k))
+                return true;
+        return false;
+    }
+    return (j < path.size()) && (name[i] == path[j]) && referenceMatch(name, i + 1, path, j + 1);
+}
+
+/** Value of the most specific matching resource, the first resource name on ties. */
+std::string referenceLookup(const std::map<std::string, std::string>& resources, const std::string& parameter) {
+    std::vector<std::string> path     = split(parameter, ".");
+    s32                      specific = 0;
+    std::string              result   = "-";
+    for (std::map<std::string, std::string>::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+        std::vector<std::string> name = split(r->first, ".");
+        if (!referenceMatch(name, 0, path, 0))
+            continue;
+        s32 m = name.size() - std::count(name.begin(), name.end(), std::string("*"));
+        if (m > specific) {
+            specific = m;
+            result   = r->second;
+        }
+    }
+    return result;
+}
+
+const char* components[] = {"recognizer", "acoustic-model", "mixture-set", "feature-extraction",
+                            "lm", "search", "corpus", "channel", "flow", "alignment"};
+const u32   nComponents  = sizeof(components) / sizeof(components[0]);
+
+/** Random resource names of up to five components, a quarter of them wildcards. */
+void createSyntheticResources(std::mt19937& engine, u32 nResources, std::map<std::string, std::string>& resources) {
+    std::uniform_int_distribution<u32> component(0, nComponents - 1), depth(1, 5), wildcard(0, 3);
+    for (u32 i = 0; i < nResources; ++i) {
+        std::string name;
+        for (u32 d = 0, n = depth(engine); d < n; ++d) {
+            name += (wildcard(engine) == 0) ? std::string("*") : std::string(components[component(engine)]);
+            name += ".";
+        }
+        name += form("param-%d", i % 97);
+        resources[name] = form("%d", i);
+    }
+}
+
+std::string randomSelection(std::mt19937& engine) {
+    std::uniform_int_distribution<u32> component(0, nComponents - 1), depth(1, 5);
+    std::string                        selection = components[component(engine)];
+    for (u32 d = 1, n = depth(engine); d < n; ++d)
+        selection += std::string(".") + components[component(engine)];
+    return selection;
+}
+
+}  // namespace
+
+TEST(Core, Configuration, Match) {
+    Configuration config;
+    config.set("*.abc.foo", "cat");
+    config.set("*.xyz.foo", "dog");
+    config.set("foo.*.bar", "/tmp/$(foo).txt");
+    config.set("*.beam", "1");
+    config.set("a.*.beam", "2");
+    config.set("a.b.*.c.beam", "3");
+    config.set("*.d.*", "4");
+
+    EXPECT_EQ(lookup(config, "foo.abc", "bar"), std::string("/tmp/cat.txt"));
+    EXPECT_EQ(lookup(config, "foo.xyz", "bar"), std::string("/tmp/dog.txt"));
+    EXPECT_EQ(lookup(config, "x", "beam"), std::string("1"));
+    EXPECT_EQ(lookup(config, "a", "beam"), std::string("2"));
+    EXPECT_EQ(lookup(config, "a.x.y", "beam"), std::string("2"));
+    // wildcards match zero components
+    EXPECT_EQ(lookup(config, "a.b.c", "beam"), std::string("3"));
+    EXPECT_EQ(lookup(config, "a.b.x.y.c", "beam"), std::string("3"));
+    EXPECT_EQ(lookup(config, "x", "d"), std::string("4"));
+    EXPECT_EQ(lookup(config, "x.y", "z"), std::string("-"));
+
+    // replacing and adding resources invalidates previous lookups
+    config.set("a.*.beam", "5");
+    EXPECT_EQ(lookup(config, "a.x.y", "beam"), std::string("5"));
+    config.set("a.x.*.beam", "6");
+    EXPECT_EQ(lookup(config, "a.x.y", "beam"), std::string("6"));
+    EXPECT_EQ(lookup(config, "a.b.c", "beam"), std::string("3"));
+}
+
+TEST(Core, Configuration, SyntheticConfig) {
+    std::mt19937                       engine(42);
+    std::map<std::string, std::string> resources;
+    createSyntheticResources(engine, 3000, resources);
+    Configuration config;
+    for (std::map<std::string, std::string>::const_iterator r = resources.begin(); r != resources.end(); ++r)
+        config.set(r->first, r->second);
+
+    // ties are reported on std::cerr
+    std::ostringstream warnings;
+    std::streambuf*    cerr = std::cerr.rdbuf(warnings.rdbuf());
+    for (u32 i = 0; i < 2000; ++i) {
+        std::string selection = randomSelection(engine);
+        std::string parameter = form("param-%d", i % 97);
+        std::string expected  = referenceLookup(resources, selection + "." + parameter);
+        EXPECT_EQ(lookup(config, selection, parameter), expected);
+        // memoized lookup
+        EXPECT_EQ(lookup(config, selection, parameter), expected);
+    }
+    std::cerr.rdbuf(cerr);
+}
+
+/**
+ * Startup-like load: many wildcard resources and distinct parameter lookups.
+ * Reports the time of matching every resource per lookup, as done before the
+ * resource index, and of Configuration.
+ */
+TEST(Core, Configuration, Benchmark) {
+    typedef std::chrono::steady_clock  Clock;
+    std::mt19937                       engine(7);
+    std::map<std::string, std::string> resources;
+    createSyntheticResources(engine, 5000, resources);
+    std::vector<std::string> selections;
+    for (u32 i = 0; i < 1000; ++i)
+        selections.push_back(randomSelection(engine));
+
+    std::ostringstream warnings;
+    std::streambuf*    cerr = std::cerr.rdbuf(warnings.rdbuf());
+
+    Clock::time_point        start = Clock::now();
+    std::vector<std::string> expected;
+    for (u32 i = 0; i < selections.size(); ++i)
+        expected.push_back(referenceLookup(resources, selections[i] + "." + form("param-%d", i % 97)));
+    f64 exhaustive = std::chrono::duration<f64>(Clock::now() - start).count();
+
+    start = Clock::now();
+    Configuration config;
+    for (std::map<std::string, std::string>::const_iterator r = resources.begin(); r != resources.end(); ++r)
+        config.set(r->first, r->second);
+    std::vector<std::string> values;
+    for (u32 i = 0; i < selections.size(); ++i)
+        values.push_back(lookup(config, selections[i], form("param-%d", i % 97)));
+    f64 indexed = std::chrono::duration<f64>(Clock::now() - start).count();
+
+    std::cerr.rdbuf(cerr);
+    EXPECT_TRUE(values == expected);
+    Core::Application::us()->log("configuration of %zu resources, %zu lookups: matching all resources %.3fs, resource index %.3fs",
+                                 resources.size(), selections.size(), exhaustive, indexed);
+}
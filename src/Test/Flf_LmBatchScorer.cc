@@ -0,0 +1,202 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/**
+ * Test cases for the batched LM scoring of the Flf rescorers: scores and
+ * histories have to agree with Lm::addLemmaScore.
+ */
+
+#include <Test/UnitTest.hh>
+
+#include <Flf/LmBatchScorer.hh>
+#include <Lm/ArpaLm.hh>
+#include <Lm/ScaledLanguageModel.hh>
+#include <Test/File.hh>
+#include <Test/Lexicon.hh>
+#include <fstream>
+
+namespace {
+
+const char* arpaLm =
+        "\\data\\\n"
+        "ngram 1=5\n"
+        "ngram 2=6\n"
+        "\n"
+        "\\1-grams:\n"
+        "-1.0 </s>\n"
+        "-99 <s> -0.5\n"
+        "-0.7 a -0.3\n"
+        "-0.8 b -0.2\n"
+        "-0.9 c -0.4\n"
+        "\n"
+        "\\2-grams:\n"
+        "-0.2 <s> a\n"
+        "-0.1 a a\n"
+        "-0.4 a b\n"
+        "-0.3 b c\n"
+        "-0.6 b </s>\n"
+        "-0.5 c a\n"
+        "\n"
+        "\\end\\\n";
+
+class LmBatchScorerTest : public Test::Fixture {
+public:
+    void setUp();
+    void tearDown();
+
+protected:
+    ::Test::Directory*                 dir_;
+    ::Test::Lexicon*                   lexicon_;
+    Core::Ref<const Lm::LanguageModel> lm_;
+    std::vector<const Bliss::Lemma*>   lemmas_;
+    std::vector<Lm::History>           histories_;
+
+    /** Expects score and history of request id to be those of Lm::addLemmaScore. */
+    void expectLemmaScore(const Flf::LmBatchScorer& scorer, Flf::LmBatchScorer::RequestId id, const Lm::History& history, const Bliss::Lemma* lemma) const;
+};
+
+void LmBatchScorerTest::setUp() {
+    dir_     = new ::Test::Directory();
+    lexicon_ = new ::Test::Lexicon();
+    lexicon_->addPhoneme("a");
+    lexicon_->addPhoneme("b");
+    lexicon_->addPhoneme("c");
+    lexicon_->addLemma("<s>", "", "sentence-begin");
+    lexicon_->addLemma("</s>", "", "sentence-end");
+    lexicon_->addLemma("a", "a");
+    lexicon_->addLemma("b", "b");
+    lexicon_->addLemma("c", "c");
+    // lemma with the two syntactic tokens a b
+    Bliss::Lemma* ab = lexicon_->newLemma();
+    lexicon_->addPronunciation(ab, lexicon_->getPronunciation("a b"));
+    lexicon_->setOrthographicForms(ab, std::vector<std::string>(1, "ab"));
+    lexicon_->setDefaultLemmaName(ab);
+    lexicon_->setDefaultEvaluationToken(ab);
+    std::vector<std::string> tokens(1, "a");
+    tokens.push_back("b");
+    lexicon_->setSyntacticTokenSequence(ab, tokens);
+    Bliss::LexiconRef lexicon(lexicon_);
+
+    const std::string filename = ::Test::File(*dir_, "lm.arpa").path();
+    std::ofstream     os(filename.c_str());
+    os << arpaLm;
+    os.close();
+    Core::Configuration config;
+    config.set("*.file", filename);
+    Core::Ref<Lm::ArpaLm> lm(new Lm::ArpaLm(config, lexicon));
+    lm->init();
+    lm_ = lm;
+
+    const char* orths[] = {"a", "b", "c", "ab"};
+    for (u32 i = 0; i < 4; ++i)
+        lemmas_.push_back(lexicon->lemma(orths[i]));
+    histories_.push_back(lm_->startHistory());
+    histories_.push_back(lm_->extendedHistory(histories_[0], lemmas_[0]->syntacticTokenSequence()[0]));
+    histories_.push_back(lm_->extendedHistory(histories_[1], lemmas_[1]->syntacticTokenSequence()[0]));
+}
+
+void LmBatchScorerTest::tearDown() {
+    histories_.clear();
+    lemmas_.clear();
+    lm_.reset();
+    delete dir_;
+}
+
+void LmBatchScorerTest::expectLemmaScore(const Flf::LmBatchScorer& scorer, Flf::LmBatchScorer::RequestId id, const Lm::History& history, const Bliss::Lemma* lemma) const {
+    Lm::History h     = history;
+    Lm::Score   score = 0.0;
+    Lm::addLemmaScore(lm_, 1.0, lemma, 1.0, h, score);
+    EXPECT_DOUBLE_EQ(score, scorer.score(id), 1e-5);
+    EXPECT_TRUE(scorer.history(id) == h);
+}
+
+}  // namespace
+
+TEST_F(Flf, LmBatchScorerTest, Scores) {
+    Flf::LmBatchScorer                         scorer(lm_);
+    std::vector<Flf::LmBatchScorer::RequestId> ids;
+    for (u32 h = 0; h < histories_.size(); ++h)
+        for (u32 l = 0; l < lemmas_.size(); ++l)
+            ids.push_back(scorer.request(histories_[h], lemmas_[l]));
+    scorer.flush();
+    for (u32 h = 0, i = 0; h < histories_.size(); ++h)
+        for (u32 l = 0; l < lemmas_.size(); ++l, ++i)
+            expectLemmaScore(scorer, ids[i], histories_[h], lemmas_[l]);
+    // the second token of the multi-token lemma is scored in a second batch
+    EXPECT_EQ(u64(2), scorer.statistics().nBatches);
+    EXPECT_EQ(u64(histories_.size() * (lemmas_.size() + 1)), scorer.statistics().nQueries);
+}
+
+TEST_F(Flf, LmBatchScorerTest, Duplicates) {
+    Flf::LmBatchScorer            scorer(lm_);
+    Flf::LmBatchScorer::RequestId first  = scorer.request(histories_[1], lemmas_[3]);
+    Flf::LmBatchScorer::RequestId other  = scorer.request(histories_[1], lemmas_[2]);
+    Flf::LmBatchScorer::RequestId second = scorer.request(histories_[1], lemmas_[3]);
+    scorer.flush();
+    expectLemmaScore(scorer, first, histories_[1], lemmas_[3]);
+    expectLemmaScore(scorer, second, histories_[1], lemmas_[3]);
+    expectLemmaScore(scorer, other, histories_[1], lemmas_[2]);
+    // the duplicate request uses the result of the first one
+    EXPECT_EQ(u64(3), scorer.statistics().nRequests);
+    EXPECT_EQ(u64(3), scorer.statistics().nQueries);
+    EXPECT_EQ(u64(0), scorer.statistics().nCacheHits);
+}
+
+TEST_F(Flf, LmBatchScorerTest, CacheHits) {
+    Flf::LmBatchScorer scorer(lm_);
+    scorer.request(histories_[0], lemmas_[0]);
+    scorer.request(histories_[2], lemmas_[3]);
+    scorer.flush();
+    const u64 nQueries = scorer.statistics().nQueries;
+    const u64 nBatches = scorer.statistics().nBatches;
+
+    scorer.clearRequests();
+    Flf::LmBatchScorer::RequestId cached = scorer.request(histories_[2], lemmas_[3]);
+    Flf::LmBatchScorer::RequestId other  = scorer.request(histories_[0], lemmas_[0]);
+    EXPECT_EQ(u64(2), scorer.statistics().nCacheHits);
+    scorer.flush();
+    EXPECT_EQ(nQueries, scorer.statistics().nQueries);
+    EXPECT_EQ(nBatches, scorer.statistics().nBatches);
+    expectLemmaScore(scorer, cached, histories_[2], lemmas_[3]);
+    expectLemmaScore(scorer, other, histories_[0], lemmas_[0]);
+
+    scorer.clearCache();
+    scorer.clearRequests();
+    Flf::LmBatchScorer::RequestId uncached = scorer.request(histories_[2], lemmas_[3]);
+    scorer.flush();
+    EXPECT_EQ(u64(2), scorer.statistics().nCacheHits);
+    EXPECT_EQ(nQueries + 2, scorer.statistics().nQueries);
+    expectLemmaScore(scorer, uncached, histories_[2], lemmas_[3]);
+}
+
+TEST_F(Flf, LmBatchScorerTest, Eviction) {
+    // the cache is cleared when it would exceed two entries
+    Flf::LmBatchScorer scorer(lm_, 2);
+    scorer.request(histories_[0], lemmas_[0]);
+    scorer.request(histories_[0], lemmas_[1]);
+    scorer.flush();
+    scorer.clearRequests();
+    scorer.request(histories_[0], lemmas_[2]);
+    scorer.flush();
+    EXPECT_EQ(u64(0), scorer.statistics().nCacheHits);
+
+    scorer.clearRequests();
+    Flf::LmBatchScorer::RequestId evicted = scorer.request(histories_[0], lemmas_[0]);
+    EXPECT_EQ(u64(0), scorer.statistics().nCacheHits);
+    Flf::LmBatchScorer::RequestId kept = scorer.request(histories_[0], lemmas_[2]);
+    EXPECT_EQ(u64(1), scorer.statistics().nCacheHits);
+    scorer.flush();
+    expectLemmaScore(scorer, evicted, histories_[0], lemmas_[0]);
+    expectLemmaScore(scorer, kept, histories_[0], lemmas_[2]);
+}
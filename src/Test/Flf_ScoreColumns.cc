@@ -0,0 +1,190 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Test/UnitTest.hh>
+
+#include <Flf/Best.hh>
+#include <Flf/Copy.hh>
+#include <Flf/FlfCore/Basic.hh>
+#include <Flf/FlfCore/ScoreColumns.hh>
+#include <Flf/FlfCore/Traverse.hh>
+#include <Fsa/Static.hh>
+
+namespace {
+
+const Flf::Score Max = Flf::Semiring::Max;
+
+Flf::ScoresRef scores(Flf::ConstSemiringRef semiring, Flf::Score s0, Flf::Score s1, Flf::Score s2) {
+    Flf::ScoresRef a = semiring->create();
+    a->set(0, s0);
+    a->set(1, s1);
+    a->set(2, s2);
+    return a;
+}
+
+/**
+ * Acyclic acceptor with three dimensions, some scores are Max.
+ */
+Flf::ConstLatticeRef getColumnTestLattice() {
+    Fsa::StaticAlphabet* alphabet = new Fsa::StaticAlphabet();
+    alphabet->addIndexedSymbol("A", 0);
+    alphabet->addIndexedSymbol("B", 1);
+
+    Flf::ScoreList scales;
+    scales.push_back(1.0);
+    scales.push_back(0.5);
+    scales.push_back(0.0);
+    Flf::ConstSemiringRef semiring = Flf::Semiring::create(Fsa::SemiringTypeTropical, 3, scales);
+
+    Flf::StaticLattice* l = new Flf::StaticLattice(Fsa::TypeAcceptor);
+    l->setSemiring(semiring);
+    l->setInputAlphabet(Fsa::ConstAlphabetRef(alphabet));
+    Flf::State* s[4];
+    for (u32 i = 0; i < 4; ++i) {
+        s[i] = new Flf::State(i);
+        l->setState(s[i]);
+    }
+    l->setInitialStateId(0);
+    s[3]->setFinal(scores(semiring, 0.5, 1.0, Max));
+    s[0]->newArc(1, scores(semiring, 1.0, 2.0, 3.0), 0, 0);
+    s[0]->newArc(2, scores(semiring, 4.0, Max, 0.0), 1, 1);
+    s[1]->newArc(2, scores(semiring, 0.25, 0.5, 0.75), 0, 0);
+    s[1]->newArc(3, scores(semiring, 7.0, 1.0, Max), 1, 1);
+    s[2]->newArc(3, scores(semiring, 2.0, 3.0, 5.0), 0, 0);
+    return Flf::ConstLatticeRef(l);
+}
+
+/** Sums the arc targets and counts the final states of a lattice */
+class ArcCounter : public Flf::TraverseStateView {
+public:
+    u32 nArcs, nFinals, targetSum;
+
+protected:
+    virtual void exploreState(const Flf::StateView& s) {
+        if (s.isFinal())
+            ++nFinals;
+    }
+    virtual void exploreArc(const Flf::StateView& from, const Flf::Arc& a) {
+        ++nArcs;
+        targetSum += a.target();
+    }
+
+public:
+    ArcCounter(Flf::ConstLatticeRef l)
+            : Flf::TraverseStateView(l), nArcs(0), nFinals(0), targetSum(0) {
+        traverse();
+    }
+};
+
+void expectEqualScores(Flf::ConstSemiringRef semiring, const Flf::ScoresRef& a, const Flf::ScoresRef& b) {
+    for (Flf::ScoreId id = 0; id < semiring->size(); ++id)
+        EXPECT_EQ(a->get(id), b->get(id));
+}
+
+void expectEqualLattices(Flf::ConstLatticeRef l, Flf::ConstLatticeRef c) {
+    EXPECT_EQ(l->initialStateId(), c->initialStateId());
+    EXPECT_EQ(l->semiring()->size(), c->semiring()->size());
+    for (Fsa::StateId s = 0; s < 4; ++s) {
+        Flf::ConstStateRef sp = l->getState(s), cp = c->getState(s);
+        EXPECT_EQ(sp->tags(), cp->tags());
+        EXPECT_EQ(sp->nArcs(), cp->nArcs());
+        if (sp->isFinal())
+            expectEqualScores(l->semiring(), sp->weight(), cp->weight());
+        for (u32 i = 0; i < sp->nArcs(); ++i) {
+            EXPECT_EQ(sp->getArc(i)->target(), cp->getArc(i)->target());
+            EXPECT_EQ(sp->getArc(i)->input(), cp->getArc(i)->input());
+            expectEqualScores(l->semiring(), sp->getArc(i)->weight(), cp->getArc(i)->weight());
+        }
+    }
+}
+
+}  // namespace
+
+TEST(Flf, ScoreColumns, Project) {
+    Flf::ConstLatticeRef        l        = getColumnTestLattice();
+    Flf::ConstSemiringRef       semiring = l->semiring();
+    std::vector<Flf::ScoresRef> rows;
+    for (Fsa::StateId s = 0; s < 4; ++s) {
+        Flf::ConstStateRef sp = l->getState(s);
+        for (Flf::State::const_iterator a = sp->begin(); a != sp->end(); ++a)
+            rows.push_back(a->weight());
+    }
+    rows.push_back(l->getState(3)->weight());
+    Flf::ScoreColumns columns(semiring->size(), rows.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+        columns.setRow(i, rows[i]);
+
+    // the scales of the semiring mask the third dimension, the other scales do not
+    std::vector<Flf::ScoreList> scaleLists(3, Flf::ScoreList(semiring->size(), 0.0));
+    scaleLists[0]    = semiring->scales();
+    scaleLists[1][0] = 2.0;
+    scaleLists[2][0] = scaleLists[2][1] = scaleLists[2][2] = 1.0;
+    for (size_t i = 0; i < scaleLists.size(); ++i) {
+        Flf::ScoreList projected(rows.size());
+        columns.project(scaleLists[i], projected.data());
+        for (size_t row = 0; row < rows.size(); ++row)
+            EXPECT_EQ(rows[row]->project(scaleLists[i]), projected[row]);
+    }
+    EXPECT_EQ(Max, rows[1]->project(scaleLists[0]));
+    EXPECT_EQ(Max, rows[3]->project(scaleLists[2]));
+
+    Flf::ScoreColumnsRef result = columns.project(scaleLists, 4);
+    EXPECT_EQ(size_t(4), result->nDimensions());
+    for (size_t row = 0; row < rows.size(); ++row) {
+        for (Flf::ScoreId id = 0; id < scaleLists.size(); ++id)
+            EXPECT_EQ(rows[row]->project(scaleLists[id]), result->get(row, id));
+        EXPECT_EQ(Flf::Score(Flf::Semiring::One), result->get(row, 3));
+    }
+}
+
+TEST(Flf, ScoreColumns, ColumnCopy) {
+    Flf::ConstLatticeRef l = getColumnTestLattice();
+    Flf::ConstLatticeRef c = Flf::columnCopy(l);
+    EXPECT_TRUE(dynamic_cast<const Flf::ColumnLattice*>(c.get()));
+    expectEqualLattices(Flf::deepCopy(l), c);
+    // the materialized states are kept
+    EXPECT_TRUE(c->getState(1) == c->getState(1));
+
+    Flf::ProjectionMatrix mapping(2, Flf::ScoreList(3, 0.0));
+    mapping[0][0] = 1.0;
+    mapping[0][1] = 0.5;
+    mapping[1][2] = 2.0;
+    Flf::ConstSemiringRef target = Flf::Semiring::create(Fsa::SemiringTypeTropical, 2);
+    Flf::ConstLatticeRef  p      = Flf::projectSemiring(c, target, mapping);
+    EXPECT_TRUE(dynamic_cast<const Flf::ColumnLattice*>(p.get()));
+    expectEqualLattices(Flf::deepCopy(Flf::projectSemiring(l, target, mapping)), p);
+}
+
+TEST(Flf, ScoreColumns, CompactTraversal) {
+    Flf::ConstLatticeRef l = getColumnTestLattice();
+    Flf::ConstLatticeRef c = Flf::compactCopy(l);
+    EXPECT_TRUE(dynamic_cast<const Flf::CompactLattice*>(c.get()));
+    expectEqualLattices(l, c);
+
+    ArcCounter staticCount(l), compactCount(c);
+    EXPECT_EQ(staticCount.nArcs, 5u);
+    EXPECT_EQ(staticCount.nFinals, 1u);
+    EXPECT_EQ(compactCount.nArcs, staticCount.nArcs);
+    EXPECT_EQ(compactCount.nFinals, staticCount.nFinals);
+    EXPECT_EQ(compactCount.targetSum, staticCount.targetSum);
+
+    std::pair<Flf::ConstLatticeRef, Flf::Score> staticBest = Flf::bestProjection(l), compactBest = Flf::bestProjection(c);
+    EXPECT_EQ(staticBest.second, compactBest.second);
+    Flf::ConstStateRef sp = staticBest.first->getState(staticBest.first->initialStateId());
+    Flf::ConstStateRef cp = compactBest.first->getState(compactBest.first->initialStateId());
+    for (; sp->hasArcs() && cp->hasArcs();
+         sp = staticBest.first->getState(sp->begin()->target()), cp = compactBest.first->getState(cp->begin()->target()))
+        EXPECT_EQ(sp->begin()->input(), cp->begin()->input());
+    EXPECT_TRUE(sp->isFinal() && cp->isFinal());
+}
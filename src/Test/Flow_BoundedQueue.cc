@@ -0,0 +1,73 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/**
+ * Test cases for Flow::BoundedQueue
+ */
+
+#include <Flow/Queue.hh>
+#include <Test/UnitTest.hh>
+#include <thread>
+#include <vector>
+
+using namespace Flow;
+
+TEST(Flow, BoundedQueue, Order) {
+    const u32          nPackets = 10000;
+    std::vector<Data*> packets;
+    for (u32 i = 0; i < nPackets; ++i)
+        packets.push_back(new Data());
+
+    BoundedQueue queue;
+    queue.setCapacity(7);
+    EXPECT_EQ(queue.capacity(), size_t(8));
+    EXPECT_TRUE(queue.isEmpty());
+
+    std::thread producer([&]() {
+        for (u32 i = 0; i < nPackets; ++i)
+            queue.put(packets[i]);
+    });
+    bool inOrder = true;
+    for (u32 i = 0; i < nPackets; ++i)
+        inOrder = inOrder && (queue.get() == packets[i]);
+    producer.join();
+    EXPECT_TRUE(inOrder);
+    EXPECT_TRUE(queue.isEmpty());
+
+    for (u32 i = 0; i < nPackets; ++i)
+        delete packets[i];
+}
+
+TEST(Flow, BoundedQueue, Interrupt) {
+    Data         packet;
+    BoundedQueue queue;
+    queue.setCapacity(1);
+    EXPECT_TRUE(queue.put(&packet));
+
+    // producer blocks on the full queue until interrupted
+    bool        putResult = true;
+    std::thread producer([&]() { putResult = queue.put(&packet); });
+    queue.interrupt();
+    producer.join();
+    EXPECT_FALSE(putResult);
+
+    std::vector<Data*> removed;
+    queue.clear(removed);
+    EXPECT_EQ(removed.size(), size_t(1));
+    EXPECT_TRUE(queue.get() == 0);
+
+    queue.resume();
+    EXPECT_TRUE(queue.put(&packet));
+    EXPECT_TRUE(queue.get() == &packet);
+}
@@ -0,0 +1,167 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/**
+ * Test cases for recycling of Flow::Vector objects
+ */
+
+#include <Core/Application.hh>
+#include <Flow/Module.hh>
+#include <Flow/Network.hh>
+#include <Flow/Node.hh>
+#include <Flow/Vector.hh>
+#include <Test/UnitTest.hh>
+#include <thread>
+
+using namespace Flow;
+
+namespace {
+
+const u32 nFrames = 500;
+
+/** Sends nFrames vectors, then end-of-stream */
+class FrameSourceNode : public SourceNode {
+public:
+    FrameSourceNode(const Core::Configuration& c)
+            : Core::Component(c), SourceNode(c), frame_(0) {}
+
+    virtual bool configure() {
+        Core::Ref<Attributes> a(new Attributes());
+        a->set("datatype", Vector<f32>::type()->name());
+        return putOutputAttributes(0, a);
+    }
+    virtual bool work(PortId out) {
+        if (frame_ >= nFrames)
+            return putEos(out);
+        Vector<f32>* v = Vector<f32>::create(16);
+        (*v)[0]        = frame_;
+        v->setStartTime(frame_);
+        v->setEndTime(frame_ + 1);
+        ++frame_;
+        return putData(out, v);
+    }
+
+private:
+    u32 frame_;
+};
+
+/** Writes its output to a new vector, as most feature extraction nodes do */
+class CopyNode : public SleeveNode {
+public:
+    CopyNode(const Core::Configuration& c)
+            : Core::Component(c), SleeveNode(c) {}
+
+    virtual bool configure() {
+        Core::Ref<const Attributes> a = getInputAttributes(0);
+        if (!configureDatatype(a, Vector<f32>::type()))
+            return false;
+        return putOutputAttributes(0, a);
+    }
+    virtual bool work(PortId out) {
+        DataPtr<Vector<f32>> in;
+        if (!getData(0, in))
+            return putData(0, in.get());
+        Vector<f32>* v = Vector<f32>::create(2 * in->size());
+        for (u32 i = 0; i < in->size(); ++i)
+            (*v)[2 * i] = (*v)[2 * i + 1] = (*in)[i];
+        v->setTimestamp(*in);
+        return putData(0, v);
+    }
+};
+
+/** Runs source -> copy -> copy once, returns the number of frames received */
+u32 runPipeline() {
+    INIT_MODULE(Flow);
+    Core::Configuration config;
+    Network             network(Core::Configuration(config, "pipeline"), false);
+    network.addNode(new FrameSourceNode(Core::Configuration(config, "source")));
+    network.addNode(new CopyNode(Core::Configuration(config, "copy-1")));
+    network.addNode(new CopyNode(Core::Configuration(config, "copy-2")));
+    network.addLink("source", "", "copy-1", "");
+    network.addLink("copy-1", "", "copy-2", "");
+    network.addOutput("out");
+    network.addLink("copy-2", "", "network", "out");
+    PortId out = network.getOutput("out");
+    network.activateOutput(out);
+
+    u32                  n = 0;
+    DataPtr<Vector<f32>> v;
+    while (network.getData(out, v))
+        ++n;
+    return n;
+}
+
+}  // namespace
+
+TEST(Flow, DataPool, Recycle) {
+    // warm up the free list of this thread
+    DataPtr<Vector<f32>> v(Vector<f32>::create(64));
+    v.reset();
+
+    const Datatype::AllocationStatistics before = Vector<f32>::type()->allocationStatistics();
+    for (u32 frame = 0; frame < 1000; ++frame) {
+        DataPtr<Vector<f32>> out(Vector<f32>::create(64));
+        out->setStartTime(frame);
+        out->setEndTime(frame + 1);
+        (*out)[0] = 1.0;
+    }
+    const Datatype::AllocationStatistics after = Vector<f32>::type()->allocationStatistics();
+    EXPECT_EQ(after.nAllocations, before.nAllocations);
+    EXPECT_EQ(after.nDeallocations, before.nDeallocations);
+}
+
+TEST(Flow, DataPool, Reset) {
+    Vector<f32>* v = Vector<f32>::create(3);
+    (*v)[1]        = 2.0;
+    v->setStartTime(1.0);
+    v->setEndTime(2.0);
+    DataPtr<Vector<f32>> p(v);
+    p.reset();
+
+    // recycled object looks like a new one
+    DataPtr<Vector<f32>> q(Vector<f32>::create(3));
+    EXPECT_EQ(q->size(), size_t(3));
+    EXPECT_EQ((*q)[1], 0.0f);
+    EXPECT_EQ(q->startTime(), 0.0);
+    EXPECT_EQ(q->endTime(), 0.0);
+
+    // clone copies contents and timestamp
+    q->setEndTime(3.0);
+    (*q)[2] = 5.0;
+    DataPtr<Vector<f32>> c(dynamic_cast<Vector<f32>*>(q->clone()));
+    EXPECT_EQ(c->size(), size_t(3));
+    EXPECT_EQ((*c)[2], 5.0f);
+    EXPECT_EQ(c->endTime(), 3.0);
+    EXPECT_TRUE(c.get() != q.get());
+}
+
+TEST(Flow, DataPool, CrossThread) {
+    // objects released by another thread go to the free list of that thread
+    DataPtr<Vector<f32>> v(Vector<f32>::create(16));
+    std::thread          consumer([&v]() { v.reset(); });
+    consumer.join();
+    DataPtr<Vector<f32>> w(Vector<f32>::create(16));
+    EXPECT_EQ(w->size(), size_t(16));
+}
+
+TEST(Flow, DataPool, Pipeline) {
+    // the first run fills the free list, the second one only reuses objects
+    EXPECT_EQ(runPipeline(), nFrames);
+    const Datatype::AllocationStatistics before = Vector<f32>::type()->allocationStatistics();
+    EXPECT_EQ(runPipeline(), nFrames);
+    const Datatype::AllocationStatistics after = Vector<f32>::type()->allocationStatistics();
+    EXPECT_EQ(after.nAllocations, before.nAllocations);
+    EXPECT_EQ(after.nDeallocations, before.nDeallocations);
+    EXPECT_TRUE(after.nReuses - before.nReuses >= u64(3 * nFrames));
+}
@@ -0,0 +1,124 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/**
+ * Throughput of a Flow pipeline with and without threaded nodes
+ */
+
+#include <chrono>
+#include <cmath>
+#include <Core/Application.hh>
+#include <Flow/Module.hh>
+#include <Flow/Network.hh>
+#include <Flow/Node.hh>
+#include <Flow/Vector.hh>
+#include <Test/UnitTest.hh>
+
+namespace {
+
+const u32 nFrames     = 2000;
+const u32 dimension   = 64;
+const u32 nTransforms = 9;
+
+/** Sends nFrames vectors, then end-of-stream */
+class FrameSourceNode : public Flow::SourceNode {
+public:
+    FrameSourceNode(const Core::Configuration& c)
+            : Core::Component(c), Flow::SourceNode(c), frame_(0) {}
+
+    virtual bool configure() {
+        Core::Ref<Flow::Attributes> a(new Flow::Attributes());
+        a->set("datatype", Flow::Vector<f32>::type()->name());
+        return putOutputAttributes(0, a);
+    }
+    virtual bool work(Flow::PortId out) {
+        if (frame_ >= nFrames)
+            return putEos(out);
+        Flow::Vector<f32>* v = Flow::Vector<f32>::create(dimension);
+        for (u32 i = 0; i < dimension; ++i)
+            (*v)[i] = 0.001f * frame_ + 0.01f * i;
+        v->setStartTime(frame_);
+        v->setEndTime(frame_ + 1);
+        ++frame_;
+        return putData(out, v);
+    }
+
+private:
+    u32 frame_;
+};
+
+/** A feature transformation step of some cost */
+class TransformNode : public Flow::SleeveNode {
+public:
+    TransformNode(const Core::Configuration& c)
+            : Core::Component(c), Flow::SleeveNode(c) {}
+
+    virtual bool configure() {
+        Core::Ref<const Flow::Attributes> a = getInputAttributes(0);
+        if (!configureDatatype(a, Flow::Vector<f32>::type()))
+            return false;
+        return putOutputAttributes(0, a);
+    }
+    virtual bool work(Flow::PortId out) {
+        Flow::DataPtr<Flow::Vector<f32>> in;
+        if (!getData(0, in))
+            return putData(0, in.get());
+        in.makePrivate();
+        for (u32 r = 0; r < 20; ++r)
+            for (u32 i = 0; i < in->size(); ++i)
+                (*in)[i] = std::sin((*in)[i] + 0.5f);
+        return putData(0, in.get());
+    }
+};
+
+/** Runs the pipeline source -> 9 transformations once, returns the output and the seconds taken */
+f64 runPipeline(bool threaded, std::vector<f32>& output) {
+    INIT_MODULE(Flow);
+    Core::Configuration config;
+    Flow::Network       network(Core::Configuration(config, "pipeline"), false);
+    network.addNode(new FrameSourceNode(Core::Configuration(config, "source")));
+    std::string previous = "source";
+    for (u32 t = 0; t < nTransforms; ++t) {
+        std::string name = "transform-" + std::to_string(t);
+        TransformNode* node = new TransformNode(Core::Configuration(config, name));
+        // every other node gets its own thread, so that five threads share the work
+        node->setThreaded(threaded && t % 2 == 0);
+        network.addNode(node);
+        network.addLink(previous, "", name, "");
+        previous = name;
+    }
+    network.addOutput("out");
+    network.addLink(previous, "", "network", "out");
+    Flow::PortId out = network.getOutput("out");
+    network.activateOutput(out);
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point                 start = Clock::now();
+    Flow::DataPtr<Flow::Vector<f32>>  v;
+    while (network.getData(out, v))
+        output.insert(output.end(), v->begin(), v->end());
+    return std::chrono::duration<f64>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+TEST(Flow, ThreadedNetwork, Throughput) {
+    std::vector<f32> serialOutput, threadedOutput;
+    f64              serial   = runPipeline(false, serialOutput);
+    f64              threaded = runPipeline(true, threadedOutput);
+    EXPECT_EQ(serialOutput.size(), size_t(nFrames * dimension));
+    EXPECT_TRUE(serialOutput == threadedOutput);
+    Core::Application::us()->log("Flow pipeline of %u nodes, frames per second: unthreaded %.1f, threaded %.1f",
+                                 nTransforms + 1, nFrames / serial, nFrames / threaded);
+}
@@ -0,0 +1,142 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Test/UnitTest.hh>
+
+#include <Fsa/Automaton.hh>
+#include <Fsa/Best.hh>
+#include <Fsa/Compact.hh>
+#include <Fsa/Prune.hh>
+#include <Fsa/Rational.hh>
+#include <Fsa/Sssp.hh>
+#include <Fsa/Static.hh>
+#include <Test/File.hh>
+
+namespace {
+
+/**
+ * Cyclic acceptor with a deleted state (3) and a non-accessible state (5).
+ */
+Fsa::ConstAutomatonRef getCompactTestAutomaton() {
+    Fsa::StaticAlphabet* a = new Fsa::StaticAlphabet();
+    a->addIndexedSymbol("A", 0);
+    a->addIndexedSymbol("B", 1);
+
+    Fsa::StaticAutomaton* f = new Fsa::StaticAutomaton();
+    f->setSemiring(Fsa::TropicalSemiring);
+    f->setInputAlphabet(Fsa::ConstAlphabetRef(a));
+    f->setType(Fsa::TypeAcceptor);
+
+    Fsa::State* s[6];
+    for (u32 i = 0; i < 6; ++i)
+        s[i] = f->newState();
+    f->setInitialStateId(0);
+    f->setStateFinal(s[4], Fsa::Weight(0.5f));
+    s[0]->newArc(1, Fsa::Weight(1.0f), 0);
+    s[0]->newArc(2, Fsa::Weight(4.0f), 1);
+    s[1]->newArc(2, Fsa::Weight(1.0f), 0);
+    s[1]->newArc(4, Fsa::Weight(7.0f), 1);
+    s[2]->newArc(1, Fsa::Weight(0.5f), 1);
+    s[2]->newArc(4, Fsa::Weight(2.0f), 0);
+    s[5]->newArc(4, Fsa::Weight(0.0f), 0);
+    f->deleteState(3);
+    return Fsa::ConstAutomatonRef(f);
+}
+
+void expectEqualStates(Fsa::ConstAutomatonRef f, Fsa::ConstCompactAutomatonRef c) {
+    for (Fsa::StateId s = 0; s <= 5; ++s) {
+        Fsa::ConstStateRef sp   = f->getState(s);
+        Fsa::StateView     view = c->state(s);
+        if (s == 3 || s == 5) {
+            EXPECT_TRUE(!view.valid());
+            EXPECT_TRUE(!c->getState(s));
+            continue;
+        }
+        EXPECT_TRUE(view.valid());
+        EXPECT_EQ(sp->tags(), view.tags());
+        EXPECT_EQ(sp->nArcs(), view.nArcs());
+        Fsa::ConstStateRef cp = c->getState(s);
+        EXPECT_EQ(sp->nArcs(), cp->nArcs());
+        for (u32 i = 0; i < sp->nArcs(); ++i) {
+            EXPECT_EQ(sp->getArc(i)->target(), view.getArc(i)->target());
+            EXPECT_EQ(sp->getArc(i)->input(), view.getArc(i)->input());
+            EXPECT_EQ(f32(sp->getArc(i)->weight()), f32(view.getArc(i)->weight()));
+            EXPECT_EQ(sp->getArc(i)->target(), cp->getArc(i)->target());
+        }
+    }
+}
+
+}  // namespace
+
+TEST(Fsa, Compact, Copy) {
+    Fsa::ConstAutomatonRef        f = getCompactTestAutomaton();
+    Fsa::ConstCompactAutomatonRef c = Fsa::compactCopy(f);
+    EXPECT_EQ(Fsa::StateId(5), c->size());
+    EXPECT_EQ(u32(6), c->nArcs());
+    EXPECT_EQ(f->initialStateId(), c->initialStateId());
+    EXPECT_TRUE(c->hasProperty(Fsa::PropertyStorage));
+    expectEqualStates(f, c);
+    EXPECT_TRUE(Fsa::compactCopy(c) == c);
+}
+
+TEST(Fsa, Compact, Algorithms) {
+    Fsa::ConstAutomatonRef        f = getCompactTestAutomaton();
+    Fsa::ConstCompactAutomatonRef c = Fsa::compactCopy(f);
+
+    Fsa::StatePotentials fd = Fsa::sssp(f), cd = Fsa::sssp(c);
+    EXPECT_TRUE(cd.size() >= 5);
+    for (Fsa::StateId s = 0; s < 5; ++s)
+        if (s != 3)
+            EXPECT_EQ(f32(fd[s]), f32(cd[s]));
+
+    Fsa::StatePotentials fb = Fsa::sssp(Fsa::transpose(f)), cb = Fsa::sssp(Fsa::transpose(c));
+    for (Fsa::StateId s = 0; s < 5; ++s)
+        if (s != 3)
+            EXPECT_EQ(f32(fb[s]), f32(cb[s]));
+    EXPECT_EQ(f32(4.5f), f32(Fsa::bestscore(c)));
+    EXPECT_EQ(f32(Fsa::bestscore(f)), f32(Fsa::bestscore(c)));
+
+    // best path 0 -> 1 -> 2 -> 4
+    Fsa::ConstAutomatonRef best = Fsa::best(c);
+    Fsa::StateId           s    = best->initialStateId();
+    Fsa::StateId           path[] = {1, 2, 4};
+    for (u32 i = 0; i < 3; ++i) {
+        Fsa::ConstStateRef sp = best->getState(s);
+        EXPECT_EQ(u32(1), sp->nArcs());
+        s = sp->begin()->target();
+        EXPECT_EQ(path[i], s);
+    }
+    EXPECT_TRUE(best->getState(s)->isFinal());
+
+    Fsa::ConstAutomatonRef fp = Fsa::prunePosterior(f, Fsa::Weight(2.0f)), cp = Fsa::prunePosterior(c, Fsa::Weight(2.0f));
+    for (Fsa::StateId s = 0; s < 5; ++s)
+        if (s != 3)
+            EXPECT_EQ(fp->getState(s)->nArcs(), cp->getState(s)->nArcs());
+}
+
+TEST(Fsa, Compact, Image) {
+    Fsa::ConstAutomatonRef        f = getCompactTestAutomaton();
+    Fsa::ConstCompactAutomatonRef c = Fsa::compactCopy(f);
+    ::Test::Directory             dir;
+    std::string                   filename = ::Test::File(dir, "automaton.image").path();
+    EXPECT_TRUE(Fsa::writeCompact(c, filename));
+    Fsa::ConstCompactAutomatonRef m = Fsa::mapCompact(filename, f->semiring(), f->getInputAlphabet());
+    EXPECT_TRUE(m);
+    EXPECT_TRUE(m->isMapped());
+    EXPECT_EQ(c->size(), m->size());
+    EXPECT_EQ(c->type(), m->type());
+    EXPECT_EQ(c->initialStateId(), m->initialStateId());
+    expectEqualStates(f, m);
+    EXPECT_EQ(f32(Fsa::bestscore(f)), f32(Fsa::bestscore(m)));
+}
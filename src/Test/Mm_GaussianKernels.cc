@@ -0,0 +1,89 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/**
+ * Test cases for the distance kernels of the Gaussian feature scorers:
+ * all instruction sets supported by the processor are compared with the
+ * scalar reference.
+ */
+
+#include <Mm/GaussianKernels.hh>
+#include <Test/UnitTest.hh>
+#include <cmath>
+#include <random>
+
+using namespace Mm;
+
+namespace {
+
+/** Random vectors with an unaligned start and zero padding up to the given dimension. */
+template<typename T>
+std::vector<T> randomVector(std::mt19937& engine, u32 dimension, u32 paddedDimension, int min, int max) {
+    std::uniform_int_distribution<int> value(min, max);
+    std::vector<T>                     v(paddedDimension + 1, T(0));
+    for (u32 d = 0; d < dimension; ++d)
+        v[d + 1] = T(value(engine));
+    return v;
+}
+
+}  // namespace
+
+TEST(Mm, GaussianKernels, Scalar) {
+    const GaussianKernels& k = GaussianKernels::kernels(GaussianKernels::scalar);
+
+    u8 um[16] = {0, 255, 10, 20}, ux[16] = {255, 0, 20, 10};
+    EXPECT_EQ(k.u8Distance(um, ux, 16), s32(2 * 255 * 255 + 2 * 100));
+
+    s16 sm[8] = {-1000, 1000, 3}, sx[8] = {1000, -1000, 0};
+    EXPECT_EQ(k.s16Distance(sm, sx, 8), s32(2 * 2000 * 2000 + 9));
+
+    f32 fm[8] = {0.5, -1.5}, fx[8] = {1.5, 0.5};
+    EXPECT_DOUBLE_EQ(k.floatDistance(fm, fx, 8), 5.0, 1e-6);
+}
+
+TEST(Mm, GaussianKernels, Equivalence) {
+    const GaussianKernels& reference = GaussianKernels::kernels(GaussianKernels::scalar);
+    EXPECT_TRUE(GaussianKernels::isSupported(GaussianKernels::bestSupported()));
+
+    std::mt19937 engine(42);
+    for (s32 isa = GaussianKernels::sse2; isa <= GaussianKernels::avx512; ++isa) {
+        if (!GaussianKernels::isSupported(GaussianKernels::InstructionSet(isa)))
+            continue;
+        const GaussianKernels& k = GaussianKernels::kernels(GaussianKernels::InstructionSet(isa));
+        EXPECT_EQ(s32(k.instructionSet), isa);
+        // all remainders of the 128, 256 and 512 bit loops
+        for (u32 dimension = 1; dimension <= 130; ++dimension) {
+            const u32 u8Dimension = ((dimension + 15) / 16) * 16;
+            const u32 dimension8  = ((dimension + 7) / 8) * 8;
+            for (u32 n = 0; n < 4; ++n) {
+                std::vector<u8> um = randomVector<u8>(engine, dimension, u8Dimension, 0, 255);
+                std::vector<u8> ux = randomVector<u8>(engine, dimension, u8Dimension, 0, 255);
+                EXPECT_EQ(k.u8Distance(&um[1], &ux[1], u8Dimension),
+                          reference.u8Distance(&um[1], &ux[1], u8Dimension));
+
+                std::vector<s16> sm = randomVector<s16>(engine, dimension, dimension8, -2000, 2000);
+                std::vector<s16> sx = randomVector<s16>(engine, dimension, dimension8, -2000, 2000);
+                EXPECT_EQ(k.s16Distance(&sm[1], &sx[1], dimension8),
+                          reference.s16Distance(&sm[1], &sx[1], dimension8));
+
+                std::vector<f32> fm = randomVector<f32>(engine, dimension, dimension8, -100, 100);
+                std::vector<f32> fx = randomVector<f32>(engine, dimension, dimension8, -100, 100);
+                for (u32 d = 0; d < dimension; ++d)
+                    fm[d + 1] *= 0.01;
+                const f32 r = reference.floatDistance(&fm[1], &fx[1], dimension8);
+                EXPECT_DOUBLE_EQ(k.floatDistance(&fm[1], &fx[1], dimension8), r, 1e-5 * r);
+            }
+        }
+    }
+}
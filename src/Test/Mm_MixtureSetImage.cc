@@ -0,0 +1,124 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Mm/GaussDiagonalMaximumFeatureScorer.hh>
+#include <Mm/ImageFeatureScorer.hh>
+#include <Mm/MixtureSetImage.hh>
+#include <Test/File.hh>
+#include <Test/UnitTest.hh>
+#include <cmath>
+#include <random>
+
+using namespace Mm;
+
+namespace {
+
+/**
+ * Mixture set with two covariances and a dimension which is not a
+ * multiple of 16; density 1 and 4 are shared by two mixtures.
+ */
+Core::Ref<MixtureSet> getImageTestMixtureSet(std::mt19937& engine) {
+    const u32                           dimension = 20;
+    std::uniform_real_distribution<f32> value(-2, 2), variance(0.5, 2);
+    Core::Ref<MixtureSet>               mixtureSet(new MixtureSet(dimension));
+    for (u32 c = 0; c < 2; ++c) {
+        std::vector<VarianceType> diagonal(dimension);
+        for (u32 i = 0; i < dimension; ++i)
+            diagonal[i] = variance(engine);
+        mixtureSet->addCovariance(new DiagonalCovariance(diagonal));
+    }
+    for (u32 m = 0; m < 5; ++m) {
+        Mean* mean = new Mean(dimension);
+        for (u32 i = 0; i < dimension; ++i)
+            (*mean)[i] = value(engine);
+        mixtureSet->addMean(mean);
+        mixtureSet->addDensity(new GaussDensity(m, m % 2));
+    }
+    const u32 densities[3][3] = {{0, 1}, {2, 3, 4}, {1, 4}};
+    const u32 nDensities[3]   = {2, 3, 2};
+    for (u32 m = 0; m < 3; ++m) {
+        Mixture* mixture = new Mixture();
+        for (u32 d = 0; d < nDensities[m]; ++d)
+            mixture->addLogDensity(densities[m][d], std::log(1.0 / nDensities[m]));
+        mixtureSet->addMixture(mixture);
+    }
+    return mixtureSet;
+}
+
+}  // namespace
+
+TEST(Mm, MixtureSetImage, Half) {
+    const f32 exact[] = {0.0f, 1.0f, -1.5f, 0.25f, 65504.0f, -3.0517578125e-05f, 5.9604645e-08f};
+    for (u32 i = 0; i < sizeof(exact) / sizeof(exact[0]); ++i)
+        EXPECT_EQ(exact[i], MixtureSetImage::halfToFloat(MixtureSetImage::floatToHalf(exact[i])));
+    // ties are rounded to even
+    EXPECT_EQ(1.0f, MixtureSetImage::halfToFloat(MixtureSetImage::floatToHalf(1.0f + 1.0f / 2048)));
+    EXPECT_EQ(1.0f + 2.0f / 1024, MixtureSetImage::halfToFloat(MixtureSetImage::floatToHalf(1.0f + 3.0f / 2048)));
+    EXPECT_TRUE(std::isinf(MixtureSetImage::halfToFloat(MixtureSetImage::floatToHalf(1e6f))));
+    EXPECT_EQ(0.0f, MixtureSetImage::halfToFloat(MixtureSetImage::floatToHalf(1e-10f)));
+}
+
+TEST(Mm, MixtureSetImage, Scores) {
+    std::mt19937                      engine(7);
+    Core::Ref<MixtureSet>             mixtureSet = getImageTestMixtureSet(engine);
+    GaussDiagonalMaximumFeatureScorer reference(Core::Configuration(), mixtureSet);
+
+    const MixtureSetImage::Precision precisions[] = {MixtureSetImage::float32, MixtureSetImage::float16, MixtureSetImage::int8};
+    const f32                        tolerance[]  = {1e-4, 1e-2, 5e-2};
+    ::Test::Directory                dir;
+    for (u32 p = 0; p < 3; ++p) {
+        const std::string filename = ::Test::File(dir, Core::form("image-%d.mimage", p)).path();
+        EXPECT_TRUE(MixtureSetImage::write(*mixtureSet, precisions[p], 42, filename));
+        Core::Ref<const MixtureSetImage> image = MixtureSetImage::map(filename);
+        EXPECT_TRUE(image);
+        EXPECT_EQ(image->precision(), precisions[p]);
+        EXPECT_EQ(u64(42), image->checksum());
+        EXPECT_EQ(u32(20), image->dimension());
+        EXPECT_EQ(u32(32), image->paddedDimension());
+        EXPECT_EQ(MixtureIndex(3), image->nMixtures());
+        EXPECT_EQ(DensityIndex(7), image->nDensities());
+        EXPECT_EQ(DensityIndex(2), image->mixtureBegin(1));
+        EXPECT_EQ(CovarianceIndex(1), image->covarianceIndex(1));
+
+        ImageGaussDiagonalMaximumFeatureScorer scorer(Core::Configuration(), image);
+        EXPECT_EQ(MixtureIndex(3), scorer.nMixtures());
+        std::uniform_real_distribution<f32> value(-2, 2);
+        for (u32 n = 0; n < 20; ++n) {
+            FeatureVector feature(20);
+            for (u32 i = 0; i < feature.size(); ++i)
+                feature[i] = value(engine);
+            FeatureScorer::Scorer expected = reference.getScorer(feature), scores = scorer.getScorer(feature);
+            for (MixtureIndex m = 0; m < 3; ++m)
+                EXPECT_DOUBLE_EQ(scores->score(m), expected->score(m), tolerance[p] * (1 + std::abs(expected->score(m))));
+        }
+    }
+}
+
+TEST(Mm, MixtureSetImage, Shared) {
+    std::mt19937          engine(7);
+    Core::Ref<MixtureSet> mixtureSet = getImageTestMixtureSet(engine);
+    ::Test::Directory     dir;
+    const std::string     filename = ::Test::File(dir, "image.mimage").path();
+    EXPECT_TRUE(MixtureSetImage::write(*mixtureSet, MixtureSetImage::float32, 1, filename));
+    Core::Ref<const MixtureSetImage> image = MixtureSetImage::map(filename);
+    EXPECT_TRUE(image);
+    EXPECT_TRUE(MixtureSetImage::map(filename) == image);
+
+    // the image is unmapped with its last reference, the rewritten file is mapped again
+    image.reset();
+    EXPECT_TRUE(MixtureSetImage::write(*mixtureSet, MixtureSetImage::float32, 2, filename));
+    image = MixtureSetImage::map(filename);
+    EXPECT_TRUE(image);
+    EXPECT_EQ(u64(2), image->checksum());
+}
@@ -0,0 +1,80 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Test/UnitTest.hh>
+
+#include <Fsa/Static.hh>
+#include <Nn/AllophoneStateFsaExporter.hh>
+
+using Nn::AllophoneStateFsaExporter;
+
+namespace {
+
+/**
+ * HMM-like acceptor over emission indices with loops, a duplicate arc
+ * and two final states, i.e. the export adds a single final state.
+ */
+Fsa::ConstAutomatonRef getExporterTestGraph() {
+    Fsa::StaticAutomaton* f = new Fsa::StaticAutomaton(Fsa::TypeAcceptor);
+    f->setSemiring(Fsa::LogSemiring);
+    Fsa::State* s[5];
+    for (u32 i = 0; i < 5; ++i)
+        s[i] = f->newState();
+    f->setInitialStateId(0);
+    f->setStateFinal(s[3], Fsa::Weight(0.5f));
+    f->setStateFinal(s[4], Fsa::Weight(0.0f));
+    s[0]->newArc(0, Fsa::Weight(0.1f), 10);
+    s[0]->newArc(1, Fsa::Weight(0.2f), 11);
+    s[0]->newArc(2, Fsa::Weight(1.0f), 12);
+    s[1]->newArc(1, Fsa::Weight(0.1f), 11);
+    s[1]->newArc(2, Fsa::Weight(0.2f), 12);
+    s[1]->newArc(2, Fsa::Weight(0.3f), 12);
+    s[1]->newArc(3, Fsa::Weight(2.0f), 13);
+    s[2]->newArc(2, Fsa::Weight(0.1f), 12);
+    s[2]->newArc(3, Fsa::Weight(0.2f), 13);
+    s[2]->newArc(4, Fsa::Weight(0.7f), 14);
+    s[3]->newArc(3, Fsa::Weight(0.1f), 13);
+    s[3]->newArc(4, Fsa::Weight(0.2f), 14);
+    return Fsa::ConstAutomatonRef(f);
+}
+
+Am::AcousticModel::EmissionIndex identity(Fsa::LabelId label) {
+    return label;
+}
+
+}  // namespace
+
+TEST(Nn, AllophoneStateFsaExporter, CachedExport) {
+    AllophoneStateFsaExporter::ExportedAutomaton exported = AllophoneStateFsaExporter::exportGraph(getExporterTestGraph(), &identity);
+    EXPECT_EQ(exported.num_states, size_t(6));
+    EXPECT_EQ(exported.end_state, Fsa::StateId(5));
+    // the duplicate arc is merged
+    EXPECT_EQ(exported.num_edges, size_t(11 + 5));
+    EXPECT_EQ(exported.edges.size(), 3 * exported.num_edges);
+    EXPECT_EQ(exported.weights.size(), exported.num_edges);
+    for (size_t e = 1; e < exported.num_edges; ++e) {
+        u32 previous = exported.edges[e - 1 + exported.num_edges] - exported.edges[e - 1];
+        u32 current  = exported.edges[e + exported.num_edges] - exported.edges[e];
+        EXPECT_TRUE(previous <= current);
+    }
+
+    AllophoneStateFsaExporter::ExportedAutomaton cached = AllophoneStateFsaExporter::fromCachedAutomaton(
+            AllophoneStateFsaExporter::toCachedAutomaton(exported));
+    EXPECT_EQ(cached.num_states, exported.num_states);
+    EXPECT_EQ(cached.num_edges, exported.num_edges);
+    EXPECT_EQ(cached.start_state, exported.start_state);
+    EXPECT_EQ(cached.end_state, exported.end_state);
+    EXPECT_TRUE(cached.edges == exported.edges);
+    EXPECT_TRUE(cached.weights == exported.weights);
+}
@@ -14,6 +14,7 @@
  */
 #include <Mm/Types.hh>
 #include <Nn/BufferedAlignedFeatureProcessor.hh>
+#include <Nn/NeuralNetworkTrainer.hh>
 #include <Test/UnitTest.hh>
 
 class BufferedAlignedFeatureProcessor : public Nn::BufferedAlignedFeatureProcessor<f32> {
@@ -202,3 +203,100 @@ TEST_F(Test, TestBufferedAlignedFeatureProcessorWithWeights, buffer) {
         }
     }
 }
+
+// prefetched mini-batches with alignment
+
+struct AlignedMiniBatches {
+    std::vector<std::vector<f32>> features;
+    std::vector<std::vector<f32>> weights;
+    std::vector<std::vector<u32>> alignments;
+};
+
+class AlignedRecordingTrainer : public Nn::NeuralNetworkTrainer<f32> {
+public:
+    AlignedMiniBatches miniBatches;
+
+    AlignedRecordingTrainer(const Core::Configuration& config)
+            : Core::Component(config),
+              Nn::NeuralNetworkTrainer<f32>(config) {
+        needsNetwork_ = false;
+    }
+
+    virtual void processBatch_feedInput(std::vector<Nn::Types<f32>::NnMatrix>& features, Nn::Types<f32>::NnVector* weights, Bliss::Segment* segment) {
+        std::vector<f32> miniBatch, miniBatchWeights;
+        for (u32 column = 0; column < features.at(0).nColumns(); column++) {
+            for (u32 row = 0; row < features.at(0).nRows(); row++)
+                miniBatch.push_back(features.at(0).at(row, column));
+            miniBatchWeights.push_back(weights->at(column));
+        }
+        miniBatches.features.push_back(miniBatch);
+        miniBatches.weights.push_back(miniBatchWeights);
+    }
+
+    virtual void processBatch_finishWithAlignment(Math::CudaVector<u32>& alignment) {
+        std::vector<u32> miniBatchAlignment;
+        for (u32 i = 0; i < alignment.size(); i++)
+            miniBatchAlignment.push_back(alignment.at(i));
+        miniBatches.alignments.push_back(miniBatchAlignment);
+    }
+};
+
+class RecordingAlignedFeatureProcessor : public BufferedAlignedFeatureProcessor {
+public:
+    AlignedRecordingTrainer* recorder_;
+
+    RecordingAlignedFeatureProcessor(const Core::Configuration& config)
+            : Core::Component(config),
+              BufferedAlignedFeatureProcessor(config),
+              recorder_(0) {
+        acousticModelNeedInit_ = false;
+        classLabelWrapper_     = new Nn::ClassLabelWrapper(config, 10);
+        setClassWeights();
+    }
+
+    virtual Nn::NeuralNetworkTrainer<f32>* createTrainer(const Core::Configuration& config) {
+        recorder_ = new AlignedRecordingTrainer(config);
+        return recorder_;
+    }
+};
+
+class TestPrefetchedAlignedMiniBatches : public Test::ConfigurableFixture {
+public:
+    void setUp();
+    AlignedMiniBatches extract(u32 prefetchBatches);
+};
+
+void TestPrefetchedAlignedMiniBatches::setUp() {
+    setParameter("*.buffer-size", "12");
+    setParameter("*.buffer-type", "minibatch");
+    setParameter("*.batch-size", "3");
+    setParameter("*.shuffle", "true");
+    setParameter("*.shuffle-seed", "1");
+    setParameter("*.weighted-alignment", "true");
+    setParameter("*.on-error", "ignore");
+    setParameter("*.channel", "nil");
+}
+
+/** Feed one full buffer of 12 aligned features, i.e. 4 mini-batches, and return the mini-batches seen by the trainer */
+AlignedMiniBatches TestPrefetchedAlignedMiniBatches::extract(u32 prefetchBatches) {
+    setParameter("*.prefetch-batches", Core::form("%d", prefetchBatches));
+    RecordingAlignedFeatureProcessor processor(config);
+    for (u32 i = 0; i < 12; i++) {
+        Flow::Vector<Mm::FeatureType>* vector = new Flow::Vector<Mm::FeatureType>(2);
+        vector->at(0)                         = 2 * i + 1;
+        vector->at(1)                         = 2 * i + 2;
+        Flow::DataPtr<Flow::Vector<Mm::FeatureType>> dptr(vector);
+        processor.processAlignedFeature(Core::ref(new Speech::Feature(dptr)), i % 5, 1.0 / (i + 1));
+    }
+    verify(processor.recorder_);
+    return processor.recorder_->miniBatches;
+}
+
+TEST_F(Test, TestPrefetchedAlignedMiniBatches, shuffled) {
+    AlignedMiniBatches serial     = extract(0);
+    AlignedMiniBatches prefetched = extract(2);
+    EXPECT_EQ((size_t)4, serial.alignments.size());
+    EXPECT_TRUE(serial.features == prefetched.features);
+    EXPECT_TRUE(serial.weights == prefetched.weights);
+    EXPECT_TRUE(serial.alignments == prefetched.alignments);
+}
@@ -13,6 +13,7 @@
  *  limitations under the License.
  */
 #include <Nn/BufferedFeatureExtractor.hh>
+#include <Nn/NeuralNetworkTrainer.hh>
 #include <Nn/Types.hh>
 #include <Test/UnitTest.hh>
 
@@ -216,3 +217,87 @@ TEST_F(Test, TestBufferedFeatureExtractor, slidingWindow) {
     EXPECT_EQ(5.0f, minibatch.at(0).at(0, 2));
     EXPECT_EQ(6.0f, minibatch.at(0).at(1, 2));
 }
+
+// prefetched mini-batches
+
+class RecordingTrainer : public Nn::NeuralNetworkTrainer<f32> {
+public:
+    std::vector<std::vector<f32>> miniBatches;
+
+    RecordingTrainer(const Core::Configuration& config)
+            : Core::Component(config),
+              Nn::NeuralNetworkTrainer<f32>(config) {
+        needsNetwork_ = false;
+    }
+
+    virtual void processBatch_feedInput(std::vector<Nn::Types<f32>::NnMatrix>& features, Nn::Types<f32>::NnVector* weights, Bliss::Segment* segment) {
+        std::vector<f32> miniBatch;
+        for (u32 column = 0; column < features.at(0).nColumns(); column++)
+            for (u32 row = 0; row < features.at(0).nRows(); row++)
+                miniBatch.push_back(features.at(0).at(row, column));
+        miniBatches.push_back(miniBatch);
+    }
+};
+
+class RecordingFeatureExtractor : public BufferedFeatureExtractor {
+public:
+    RecordingTrainer* recorder_;
+
+    RecordingFeatureExtractor(const Core::Configuration& config)
+            : Core::Component(config),
+              BufferedFeatureExtractor(config),
+              recorder_(0) {}
+
+    virtual Nn::NeuralNetworkTrainer<f32>* createTrainer(const Core::Configuration& config) {
+        recorder_ = new RecordingTrainer(config);
+        return recorder_;
+    }
+};
+
+class TestPrefetchedMiniBatches : public Test::ConfigurableFixture {
+public:
+    void                          setUp();
+    std::vector<std::vector<f32>> extract(u32 prefetchBatches, bool shuffle);
+};
+
+void TestPrefetchedMiniBatches::setUp() {
+    setParameter("*.buffer-size", "12");
+    setParameter("*.buffer-type", "minibatch");
+    setParameter("*.batch-size", "3");
+    setParameter("*.window-size", "3");
+    setParameter("*.shuffle-seed", "1");
+    setParameter("*.on-error", "ignore");
+    setParameter("*.channel", "nil");
+}
+
+/** Feed one full buffer of 12 features, i.e. 4 mini-batches, and return the mini-batches seen by the trainer */
+std::vector<std::vector<f32>> TestPrefetchedMiniBatches::extract(u32 prefetchBatches, bool shuffle) {
+    setParameter("*.prefetch-batches", Core::form("%d", prefetchBatches));
+    setParameter("*.shuffle", shuffle ? "true" : "false");
+    RecordingFeatureExtractor extractor(config);
+    for (u32 i = 0; i < 12; i++) {
+        Flow::Vector<Mm::FeatureType>* vector = new Flow::Vector<Mm::FeatureType>(2);
+        vector->at(0)                         = 2 * i + 1;
+        vector->at(1)                         = 2 * i + 2;
+        Flow::DataPtr<Flow::Vector<Mm::FeatureType>> dptr(vector);
+        extractor.processFeature(Core::ref(new Speech::Feature(dptr)));
+    }
+    verify(extractor.recorder_);
+    return extractor.recorder_->miniBatches;
+}
+
+TEST_F(Test, TestPrefetchedMiniBatches, serial) {
+    std::vector<std::vector<f32>> serial     = extract(0, false);
+    std::vector<std::vector<f32>> prefetched = extract(2, false);
+    EXPECT_EQ((size_t)4, serial.size());
+    EXPECT_TRUE(serial == prefetched);
+}
+
+TEST_F(Test, TestPrefetchedMiniBatches, shuffled) {
+    std::vector<std::vector<f32>> serial     = extract(0, true);
+    std::vector<std::vector<f32>> prefetched = extract(2, true);
+    EXPECT_EQ((size_t)4, serial.size());
+    EXPECT_TRUE(serial == prefetched);
+    // shuffling is active
+    EXPECT_TRUE(serial != extract(0, false));
+}
@@ -0,0 +1,215 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/**
+ * Test cases for the multi-threaded expansion of the aligner: for any
+ * number of threads, the alignment has to be identical to the one of the
+ * serial expansion.
+ */
+
+#include <Test/UnitTest.hh>
+
+#include <Am/AcousticModel.hh>
+#include <Fsa/Static.hh>
+#include <Search/Aligner.hh>
+
+namespace {
+
+const u32 nLabels    = 12;
+const u32 nEmissions = 5;
+
+/** Acoustic model which only ties the allophone states to emissions. */
+class TyingAcousticModel : public Am::AcousticModel {
+public:
+    TyingAcousticModel(const Core::Configuration& c)
+            : Core::Component(c), Am::AcousticModel(c) {}
+
+    virtual void load(Mode mode) {}
+    virtual void getDependencies(Core::DependencySet&) const {}
+
+    virtual Core::Ref<Am::TransducerBuilder> createTransducerBuilder() const {
+        return Core::Ref<Am::TransducerBuilder>();
+    }
+
+    virtual Core::Ref<const Bliss::PhonemeInventory> phonemeInventory() const {
+        return Core::Ref<const Bliss::PhonemeInventory>();
+    }
+    virtual Core::Ref<const Am::AllophoneAlphabet> allophoneAlphabet() const {
+        return Core::Ref<const Am::AllophoneAlphabet>();
+    }
+    virtual Core::Ref<const Am::AllophoneStateAlphabet> allophoneStateAlphabet() const {
+        return Core::Ref<const Am::AllophoneStateAlphabet>();
+    }
+    virtual Core::Ref<const Am::Phonology> phonology() const {
+        return Core::Ref<const Am::Phonology>();
+    }
+    virtual Bliss::Phoneme::Id silence() const {
+        return Bliss::Phoneme::term;
+    }
+    virtual Am::AllophoneStateIndex silenceAllophoneStateIndex() const {
+        return 0;
+    }
+
+    virtual Core::Ref<Mm::AbstractMixtureSet> mixtureSet() {
+        return Core::Ref<Mm::AbstractMixtureSet>();
+    }
+
+    virtual Core::Ref<const Mm::ScaledFeatureScorer> featureScorer() {
+        return Core::Ref<const Mm::ScaledFeatureScorer>();
+    }
+    virtual Core::Ref<Mm::ScaledFeatureScorer> mutableFeatureScorer() {
+        return Core::Ref<Mm::ScaledFeatureScorer>();
+    }
+    virtual bool setFeatureScorer(Core::Ref<Mm::ScaledFeatureScorer>) {
+        return false;
+    }
+
+    virtual EmissionIndex emissionIndex(Am::AllophoneState) const {
+        return 0;
+    }
+    virtual EmissionIndex emissionIndex(Am::AllophoneStateIndex e) const {
+        return e % ::nEmissions;
+    }
+    virtual EmissionIndex nEmissions() const {
+        return ::nEmissions;
+    }
+
+    virtual StateTransitionIndex nStateTransitions() const {
+        return 0;
+    }
+    virtual const Am::StateTransitionModel* stateTransition(StateTransitionIndex) const {
+        return 0;
+    }
+    virtual StateTransitionIndex stateTransitionIndex(Am::AllophoneState, s8 subState) const {
+        return 0;
+    }
+    virtual StateTransitionIndex stateTransitionIndex(Am::AllophoneStateIndex, s8 subState) const {
+        return 0;
+    }
+
+    virtual Core::Ref<const Am::ClassicHmmTopologySet> hmmTopologySet() const {
+        return Core::Ref<const Am::ClassicHmmTopologySet>();
+    }
+    virtual const Am::ClassicHmmTopology* hmmTopology(Bliss::Phoneme::Id phoneme) const {
+        return 0;
+    }
+    virtual bool isAcrossWordModelEnabled() const {
+        return false;
+    }
+};
+
+/** Only provides access to the protected context scorer interface, never instantiated. */
+class FrameScorer : public Mm::FeatureScorer {
+    /** Deterministic emission scores of one timeframe, with many ties. */
+    class Context : public ContextScorer {
+        u32 time_;
+
+    public:
+        Context(u32 time)
+                : time_(time) {}
+        virtual Mm::EmissionIndex nEmissions() const {
+            return ::nEmissions;
+        }
+        virtual Mm::Score score(Mm::EmissionIndex e) const {
+            return 0.5 * ((7 * e + 13 * time_) % 11);
+        }
+    };
+
+public:
+    static Scorer create(u32 time) {
+        return Scorer(new Context(time));
+    }
+};
+
+/** Chain of HMM states with loop, forward and skip transitions. */
+Fsa::ConstAutomatonRef getAlignerTestModel(u32 nStates) {
+    Fsa::StaticAlphabet* alphabet = new Fsa::StaticAlphabet();
+    for (u32 l = 0; l < nLabels; ++l)
+        alphabet->addIndexedSymbol(Core::form("s%d", l), l);
+
+    Fsa::StaticAutomaton* f = new Fsa::StaticAutomaton();
+    f->setSemiring(Fsa::TropicalSemiring);
+    f->setInputAlphabet(Fsa::ConstAlphabetRef(alphabet));
+    f->setType(Fsa::TypeAcceptor);
+    for (u32 i = 0; i < nStates; ++i)
+        f->newState();
+    f->setInitialStateId(0);
+    f->setStateFinal(f->fastState(nStates - 1), Fsa::Weight(0.0f));
+    for (u32 i = 0; i < nStates; ++i) {
+        Fsa::State* s = f->fastState(i);
+        s->newArc(i, Fsa::Weight(0.25f * (i % 3)), i % nLabels);
+        if (i + 1 < nStates)
+            s->newArc(i + 1, Fsa::Weight(0.5f), (i + 1) % nLabels);
+        if (i + 2 < nStates)
+            s->newArc(i + 2, Fsa::Weight(1.5f), (i + 2) % nLabels);
+    }
+    return Fsa::ConstAutomatonRef(f);
+}
+
+Fsa::ConstAutomatonRef align(Core::Configuration config, const char* mode, u32 nThreads, Speech::Score& score) {
+    const u32 nStates = 200, nFrames = 300;
+    config.set("*.mode", mode);
+    config.set("*.search.threads", Core::form("%d", nThreads));
+    config.set("*.search.threads-state-minimum", "0");
+    Core::Ref<const Am::AcousticModel> acousticModel(new TyingAcousticModel(Core::Configuration(config, "acoustic-model")));
+    Search::Aligner                    aligner(Core::Configuration(config, "aligner"));
+    aligner.setModel(getAlignerTestModel(nStates), acousticModel);
+    for (u32 t = 0; t < nFrames; ++t)
+        aligner.feed(FrameScorer::create(t));
+    EXPECT_TRUE(aligner.reachedFinalState());
+    score = aligner.alignmentScore();
+    return Fsa::staticCopy(aligner.getAlignmentFsa());
+}
+
+void expectEqualAlignments(Fsa::ConstAutomatonRef serial, Fsa::ConstAutomatonRef parallel) {
+    EXPECT_EQ(serial->initialStateId(), parallel->initialStateId());
+    Core::Ref<const Fsa::StaticAutomaton> s = Core::ref((const Fsa::StaticAutomaton*)serial.get());
+    Core::Ref<const Fsa::StaticAutomaton> p = Core::ref((const Fsa::StaticAutomaton*)parallel.get());
+    EXPECT_EQ(s->size(), p->size());
+    for (Fsa::StateId id = 0; id < s->size(); ++id) {
+        const Fsa::State *ss = s->fastState(id), *ps = p->fastState(id);
+        EXPECT_EQ(!ss, !ps);
+        if (!ss)
+            continue;
+        EXPECT_EQ(ss->isFinal(), ps->isFinal());
+        EXPECT_EQ(ss->nArcs(), ps->nArcs());
+        for (u32 i = 0; i < ss->nArcs(); ++i) {
+            EXPECT_EQ(ss->getArc(i)->target(), ps->getArc(i)->target());
+            EXPECT_EQ(ss->getArc(i)->input(), ps->getArc(i)->input());
+            EXPECT_EQ(f32(ss->getArc(i)->weight()), f32(ps->getArc(i)->weight()));
+        }
+    }
+}
+
+void expectParallelEqualsSerial(const char* mode) {
+    Core::Configuration    config;
+    Speech::Score          serialScore;
+    Fsa::ConstAutomatonRef serial = align(config, mode, 1, serialScore);
+    for (u32 nThreads = 2; nThreads <= 4; ++nThreads) {
+        Speech::Score          parallelScore;
+        Fsa::ConstAutomatonRef parallel = align(config, mode, nThreads, parallelScore);
+        EXPECT_EQ(serialScore, parallelScore);
+        expectEqualAlignments(serial, parallel);
+    }
+}
+
+}  // namespace
+
+TEST(Search, Aligner, ParallelViterbi) {
+    expectParallelEqualsSerial("viterbi");
+}
+
+TEST(Search, Aligner, ParallelBaumWelch) {
+    expectParallelEqualsSerial("baum-welch");
+}
@@ -0,0 +1,128 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/**
+ * Test cases for the level-ordered propagation of dense LM look-ahead
+ * tables: scalar and AVX2 kernels are compared bit by bit with the
+ * sequential propagation of LanguageModelLookahead.
+ */
+
+#include <Search/AdvancedTreeSearch/LookaheadPropagation.hh>
+#include <Test/UnitTest.hh>
+#include <cstring>
+#include <random>
+
+using namespace AdvancedTreeSearch;
+
+namespace {
+
+typedef LookaheadPropagation::Score Score;
+
+/** Random DAG in which the successors of each node have smaller ids, like the compressed look-ahead tree. */
+struct RandomTree {
+    u32              nNodes;
+    std::vector<u32> firstSuccessor, successors;
+
+    RandomTree(std::mt19937& engine, u32 n)
+            : nNodes(n) {
+        std::uniform_int_distribution<u32> nSuccessors(0, 12);
+        for (u32 i = 0; i < nNodes; ++i) {
+            firstSuccessor.push_back(successors.size());
+            u32 k = (i == 0) ? 0 : nSuccessors(engine);
+            for (u32 j = 0; j < k; ++j)
+                successors.push_back(std::uniform_int_distribution<u32>(0, i - 1)(engine));
+        }
+        firstSuccessor.push_back(successors.size());
+    }
+
+    /** The sequential propagation of LanguageModelLookahead::computeScores. */
+    void propagate(std::vector<Score>& scores) const {
+        for (u32 n = 0; n < nNodes; ++n) {
+            Score minScore = scores[n];
+            for (u32 s = firstSuccessor[n]; s < firstSuccessor[n + 1]; ++s)
+                if (minScore > scores[successors[s]])
+                    minScore = scores[successors[s]];
+            scores[n] = minScore;
+        }
+    }
+};
+
+/** Word-end scores with ties, +0/-0 and nodes without words. */
+std::vector<Score> randomScores(std::mt19937& engine, u32 nNodes) {
+    std::uniform_int_distribution<int> value(-50, 50);
+    std::vector<Score>                 scores(nNodes);
+    for (u32 n = 0; n < nNodes; ++n) {
+        int v = value(engine);
+        if (v > 40)
+            scores[n] = Core::Type<Score>::max;
+        else if (v == 0)
+            scores[n] = (n % 2) ? -0.0f : 0.0f;
+        else
+            scores[n] = v * 0.25f;
+    }
+    return scores;
+}
+
+bool bitEqual(const std::vector<Score>& a, const std::vector<Score>& b) {
+    return a.size() == b.size() && memcmp(&a[0], &b[0], a.size() * sizeof(Score)) == 0;
+}
+
+}  // namespace
+
+TEST(Search, LookaheadPropagation, Levels) {
+    // 0, 1 leaves; 2 -> {0, 1}; 3 -> {2}; 4 -> {0}
+    std::vector<u32>     firstSuccessor = {0, 0, 0, 2, 3, 4};
+    std::vector<u32>     successors     = {0, 1, 2, 0};
+    LookaheadPropagation propagation;
+    propagation.build(5, firstSuccessor, successors);
+    EXPECT_EQ(u32(3), propagation.nLevels());
+    EXPECT_EQ(u32(2), propagation.nChunks());
+
+    for (u32 vectorized = 0; vectorized < 2; ++vectorized) {
+        propagation.setVectorized(vectorized);
+        std::vector<Score> scores = {3.0, 1.0, 2.0, 5.0, 4.0};
+        propagation.propagate(&scores[0]);
+        EXPECT_EQ(Score(1.0), scores[2]);
+        EXPECT_EQ(Score(1.0), scores[3]);
+        EXPECT_EQ(Score(3.0), scores[4]);
+    }
+}
+
+TEST(Search, LookaheadPropagation, Equivalence) {
+    std::mt19937 engine(42);
+    for (u32 n = 1; n <= 2000; n = n * 3 + 1) {
+        RandomTree tree(engine, n);
+
+        LookaheadPropagation propagation;
+        propagation.build(tree.nNodes, tree.firstSuccessor, tree.successors);
+
+        std::vector<std::vector<Score>> reference, tables;
+        for (u32 t = 0; t < 5; ++t) {
+            reference.push_back(randomScores(engine, n));
+            tables.push_back(reference.back());
+            tree.propagate(reference.back());
+        }
+
+        for (u32 vectorized = 0; vectorized < 2; ++vectorized) {
+            propagation.setVectorized(vectorized);
+            if (vectorized && !propagation.isVectorized())
+                continue;
+            for (u32 t = 0; t < tables.size(); ++t) {
+                std::vector<Score> scores = tables[t];
+                propagation.propagate(&scores[0]);
+                EXPECT_TRUE(bitEqual(reference[t], scores));
+            }
+        }
+    }
+}
@@ -0,0 +1,194 @@
+/** Copyright 2020 RWTH Aachen University. All rights reserved.
+ *
+ *  Licensed under the RWTH ASR License (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.hltpr.rwth-aachen.de/rwth-asr/rwth-asr-license.html
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+#include <Bliss/CorpusDescription.hh>
+#include <Core/Application.hh>
+#include <Core/Archive.hh>
+#include <Core/Configuration.hh>
+#include <Flow/Module.hh>
+#include <Flow/Node.hh>
+#include <Flow/Registry.hh>
+#include <Flow/Vector.hh>
+#include <Speech/CorpusVisitor.hh>
+#include <Speech/DataExtractor.hh>
+#include <Speech/Module.hh>
+#include <Speech/ProgressJournal.hh>
+#include <Test/File.hh>
+#include <Test/UnitTest.hh>
+#include <fstream>
+#include <set>
+
+using Speech::ProgressJournal;
+
+namespace {
+
+/** Sends ten vectors per segment, then end-of-stream */
+class FrameSourceNode : public Flow::SourceNode {
+public:
+    static std::string filterName() {
+        return "test-progress-journal-source";
+    }
+    FrameSourceNode(const Core::Configuration& c)
+            : Core::Component(c), Flow::SourceNode(c), frame_(0) {}
+
+    virtual bool setParameter(const std::string& name, const std::string& value) {
+        if (name != "id")
+            return false;
+        frame_ = 0;
+        return true;
+    }
+    virtual bool configure() {
+        Core::Ref<Flow::Attributes> a(new Flow::Attributes());
+        a->set("datatype", Flow::Vector<f32>::type()->name());
+        return putOutputAttributes(0, a);
+    }
+    virtual bool work(Flow::PortId out) {
+        if (frame_ >= 10)
+            return putEos(out);
+        Flow::Vector<f32>* v = Flow::Vector<f32>::create(4);
+        v->setStartTime(0.01 * frame_);
+        v->setEndTime(0.01 * (frame_ + 1));
+        ++frame_;
+        return putData(out, v);
+    }
+
+private:
+    u32 frame_;
+};
+
+void writeFile(const std::string& path, const std::string& data) {
+    std::ofstream os(path.c_str());
+    os << data;
+}
+
+}  // namespace
+
+TEST(Speech, ProgressJournal, Resume) {
+    ::Test::Directory dir;
+    ::Test::File      journalFile(dir, "progress.journal"), archiveFile(dir, "archive");
+
+    Core::Configuration config;
+    config.set("*.progress-journal.file", journalFile.path());
+    Core::Configuration journalConfig(config, "progress-journal");
+
+    // first run: one segment finished, the second one interrupted
+    {
+        ProgressJournal* journal = ProgressJournal::acquire(journalConfig);
+        EXPECT_TRUE(journal);
+        EXPECT_TRUE(ProgressJournal::acquire(journalConfig) == journal);
+        ProgressJournal::release(journal);
+        EXPECT_TRUE(!journal->isFinished("c/r/1"));
+
+        Core::Archive* archive = Core::Archive::create(config, archiveFile.path(), Core::Archive::AccessModeReadWrite);
+        EXPECT_TRUE(archive);
+        EXPECT_TRUE(archive->writeFile("1", "first", false));
+        journal->finish("c/r/1");
+        EXPECT_TRUE(archive->writeFile("2", "interrupted", false));
+        delete archive;
+        ProgressJournal::release(journal);
+    }
+    {
+        // cut off while journaling
+        std::ofstream os(journalFile.path().c_str(), std::ios::app);
+        os << "segment c/r/";
+    }
+
+    // second run: resume
+    {
+        ProgressJournal* journal = ProgressJournal::acquire(journalConfig);
+        EXPECT_TRUE(journal);
+        EXPECT_TRUE(journal->isFinished("c/r/1"));
+        EXPECT_TRUE(!journal->isFinished("c/r/2"));
+        EXPECT_TRUE(!journal->isFinished("c/r/"));
+
+        Core::Archive* archive = Core::Archive::create(config, archiveFile.path(), Core::Archive::AccessModeReadWrite);
+        EXPECT_TRUE(archive);
+        EXPECT_TRUE(archive->hasFile("1"));
+        EXPECT_TRUE(journal->replaceFile(*archive, "2"));
+        EXPECT_TRUE(!journal->replaceFile(*archive, "1"));
+        EXPECT_TRUE(archive->writeFile("2", "second", false));
+        journal->finish("c/r/2");
+        std::string data;
+        EXPECT_TRUE(archive->readFile("2", data));
+        EXPECT_EQ(std::string("second"), data);
+        delete archive;
+        ProgressJournal::release(journal);
+    }
+
+    // the journal is complete
+    {
+        ProgressJournal* journal = ProgressJournal::acquire(journalConfig);
+        EXPECT_TRUE(journal->isFinished("c/r/1"));
+        EXPECT_TRUE(journal->isFinished("c/r/2"));
+        ProgressJournal::release(journal);
+    }
+}
+
+TEST(Speech, ProgressJournal, SequentialCache) {
+    INIT_MODULE(Flow);
+    INIT_MODULE(Speech);
+    Flow::Registry::instance().registerFilter<FrameSourceNode>();
+
+    ::Test::Directory dir;
+    ::Test::File      journalFile(dir, "progress.journal"), corpusFile(dir, "corpus.xml"),
+            networkFile(dir, "network.flow"), cacheFile(dir, "features.cache");
+    writeFile(corpusFile.path(),
+              "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+              "<corpus name=\"c\">\n"
+              "  <recording name=\"r\" audio=\"r.wav\">\n"
+              "    <segment name=\"1\" start=\"0\" end=\"0.1\"/>\n"
+              "    <segment name=\"2\" start=\"0.1\" end=\"0.2\"/>\n"
+              "    <segment name=\"3\" start=\"0.2\" end=\"0.3\"/>\n"
+              "  </recording>\n"
+              "</corpus>\n");
+    std::string network = "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
+                          "<network name=\"network\">\n"
+                          "  <out name=\"features\"/>\n"
+                          "  <param name=\"id\"/>\n";
+    network += "  <node name=\"source\" filter=\"" + FrameSourceNode::filterName() + "\" id=\"$(id)\"/>\n";
+    network += "  <node name=\"cache\" filter=\"generic-cache\" id=\"$(id)\" path=\"" + cacheFile.path() + "\"/>\n";
+    network += "  <link from=\"source\" to=\"cache\"/>\n"
+               "  <link from=\"cache\" to=\"network:features\"/>\n"
+               "</network>\n";
+    writeFile(networkFile.path(), network);
+
+    Core::Configuration config;
+    config.set("*.corpus.file", corpusFile.path());
+    config.set("*.progress-journal.file", journalFile.path());
+    config.set("*.feature-extraction.file", networkFile.path());
+    config.set("*.feature-extraction.no-progress-indication", "true");
+    {
+        Speech::CorpusVisitor    visitor(Core::Configuration(config, "visitor"));
+        Speech::DataExtractor    extractor(Core::Configuration(config, "extractor"));
+        Bliss::CorpusDescription corpus(Core::Configuration(config, "corpus"));
+        extractor.signOn(visitor);
+        corpus.accept(&visitor);
+    }
+
+    // each segment is journaled after its cache file, not only when the next segment starts
+    std::ifstream         is(journalFile.path().c_str());
+    std::string           line;
+    std::set<std::string> written;
+    u32                   nSegments = 0;
+    while (std::getline(is, line)) {
+        if (line.compare(0, 5, "file ") == 0) {
+            written.insert(line.substr(line.find('\t') + 1));
+        }
+        else if (line.compare(0, 8, "segment ") == 0) {
+            EXPECT_TRUE(written.count(line.substr(8)) == 1);
+            ++nSegments;
+        }
+    }
+    EXPECT_EQ(nSegments, 3u);
+}
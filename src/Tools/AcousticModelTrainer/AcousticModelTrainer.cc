@@ -18,6 +18,7 @@
 #include <Flow/Module.hh>
 #include <Lm/Module.hh>
 #include <Math/Module.hh>
+#include <Mm/GaussianKernels.hh>
 #include <Mm/Module.hh>
 #include <Signal/Module.hh>
 #include <Speech/Module.hh>
@@ -33,6 +34,7 @@
 #include <Speech/LatticeSetProcessor.hh>
 #include <Speech/LatticeSetExtractor.hh>
 #include <Speech/MixtureSetTrainer.hh>
+#include <Speech/ParallelCorpusVisitor.hh>
 #include <Speech/ScatterMatricesEstimator.hh>
 #include <Speech/TextIndependentMixtureSetTrainer.hh>
 #ifdef MODULE_CART
@@ -93,6 +95,7 @@ const Core::Choice AcousticModelTrainer::choiceAction(
         "estimate-adaptation", actionEstimateModelTransform,
         "calculate-adaptation", actionCalculateModelTransform,
         "calculate-average-feature-scorer-activation", actionCalculateAverageFeatureScorerActivation,
+        "benchmark-gaussian-kernels", actionBenchmarkGaussianKernels,
         Core::Choice::endMark());
 
 const Core::ParameterChoice AcousticModelTrainer::paramAction(
@@ -226,6 +229,9 @@ int AcousticModelTrainer::main(const std::vector<std::string>& arguments) {
         case actionCalculateAverageFeatureScorerActivation:
             calculateAverageFeatureScorerActivation();
             break;
+        case actionBenchmarkGaussianKernels:
+            benchmarkGaussianKernels();
+            break;
         default:
             criticalError("Action not given.");
     };
@@ -326,22 +332,40 @@ void AcousticModelTrainer::mapMixtureSet() {
     delete trainer;
 }
 
+template<class Trainer>
+void AcousticModelTrainer::accumulateMixtureSet() {
+    if (Speech::ParallelCorpusVisitor::paramNumberOfThreads(select("corpus")) <= 1) {
+        Trainer trainer(select("mixture-set-trainer"));
+        visitCorpus(trainer);
+        trainer.write();
+        return;
+    }
+    std::vector<Speech::MixtureSetTrainer*> trainers;
+    {
+        Speech::ParallelCorpusVisitor corpusVisitor(select("corpus"), [this, &trainers]() {
+            Trainer* trainer = new Trainer(select("mixture-set-trainer"));
+            trainers.push_back(trainer);
+            return createCorpusProcessor(*trainer);
+        });
+        Bliss::CorpusDescription corpusDescription(select("corpus"));
+        corpusVisitor.accept(corpusDescription);
+    }
+    if (trainers.front()->combine(trainers))
+        trainers.front()->write();
+    for (size_t i = 0; i < trainers.size(); ++i)
+        delete trainers[i];
+}
+
 void AcousticModelTrainer::accumulateMixtureSetTextDependent() {
-    Speech::TextDependentMixtureSetTrainer trainer(select("mixture-set-trainer"));
-    visitCorpus(trainer);
-    trainer.write();
+    accumulateMixtureSet<Speech::TextDependentMixtureSetTrainer>();
 }
 
 void AcousticModelTrainer::accumulateMixtureSetTextDependentTied() {
-    Speech::TiedTextDependentMixtureSetTrainer trainer(select("mixture-set-trainer"));
-    visitCorpus(trainer);
-    trainer.write();
+    accumulateMixtureSet<Speech::TiedTextDependentMixtureSetTrainer>();
 }
 
 void AcousticModelTrainer::accumulateMixtureSetTextIndependent() {
-    Speech::TextIndependentMixtureSetTrainer trainer(select("mixture-set-trainer"));
-    visitCorpus(trainer);
-    trainer.write();
+    accumulateMixtureSet<Speech::TextIndependentMixtureSetTrainer>();
 }
 
 /*
@@ -552,6 +576,18 @@ void AcousticModelTrainer::calculateAverageFeatureScorerActivation() {
     afse.write();
 }
 
+/**
+ * Throughput of the Gaussian distance kernels of all instruction sets
+ * supported by the processor on the mixture set given by mixture-set.file.
+ */
+void AcousticModelTrainer::benchmarkGaussianKernels() {
+    Core::Ref<Mm::MixtureSet> mixtureSet = Mm::Module::instance().readMixtureSet(select("mixture-set"));
+    if (!mixtureSet)
+        criticalError("failed to read mixture set");
+    Mm::GaussianKernelBenchmark benchmark(select("gaussian-kernel-benchmark"));
+    benchmark.run(*mixtureSet);
+}
+
 void AcousticModelTrainer::visitCorpus(Speech::CorpusProcessor& corpusProcessor) {
     Speech::CorpusVisitor corpusVisitor(select("corpus"));
     corpusProcessor.signOn(corpusVisitor);
@@ -566,12 +602,19 @@ void AcousticModelTrainer::visitCorpus(Speech::CorpusProcessor* corpusProcessor)
 }
 
 void AcousticModelTrainer::visitCorpus(Speech::AlignedFeatureProcessor& alignedFeatureProcessor) {
-    visitCorpus(Speech::Module::instance().createAligningFeatureExtractor(
-            select("aligning-feature-extractor"), alignedFeatureProcessor));
+    visitCorpus(createCorpusProcessor(alignedFeatureProcessor));
 }
 
 void AcousticModelTrainer::visitCorpus(Speech::LabeledFeatureProcessor& labeledFeatureProcessor) {
-    Speech::LabelingFeatureExtractor labelingFeatureExtractor(select("labeling"), labeledFeatureProcessor);
-    visitCorpus(labelingFeatureExtractor);
+    visitCorpus(createCorpusProcessor(labeledFeatureProcessor));
+}
+
+Speech::CorpusProcessor* AcousticModelTrainer::createCorpusProcessor(Speech::AlignedFeatureProcessor& alignedFeatureProcessor) {
+    return Speech::Module::instance().createAligningFeatureExtractor(
+            select("aligning-feature-extractor"), alignedFeatureProcessor);
+}
+
+Speech::CorpusProcessor* AcousticModelTrainer::createCorpusProcessor(Speech::LabeledFeatureProcessor& labeledFeatureProcessor) {
+    return new Speech::LabelingFeatureExtractor(select("labeling"), labeledFeatureProcessor);
 }
 
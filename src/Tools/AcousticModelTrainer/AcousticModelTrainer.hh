@@ -86,7 +86,8 @@ public:
         actionEstimateModelTransform,
         actionCalculateModelTransform,
         actionAccumulateNearestNeighborTree,
-        actionCalculateAverageFeatureScorerActivation
+        actionCalculateAverageFeatureScorerActivation,
+        actionBenchmarkGaussianKernels
     };
 
     static const Core::Choice          choiceAction;
@@ -106,6 +107,11 @@ private:
     void visitCorpus(Speech::CorpusProcessor*);
     void visitCorpus(Speech::AlignedFeatureProcessor&);
     void visitCorpus(Speech::LabeledFeatureProcessor&);
+    Speech::CorpusProcessor* createCorpusProcessor(Speech::AlignedFeatureProcessor&);
+    Speech::CorpusProcessor* createCorpusProcessor(Speech::LabeledFeatureProcessor&);
+    /** Accumulates with one trainer per thread if corpus.threads > 1 and combines the trainers. */
+    template<class Trainer>
+    void accumulateMixtureSet();
 
     void dryRun();
     void createModelAcceptors();
@@ -159,6 +165,8 @@ private:
 
     void calculateAverageFeatureScorerActivation();
 
+    void benchmarkGaussianKernels();
+
 public:
     AcousticModelTrainer();
     virtual std::string getUsage() const {
@@ -23,6 +23,7 @@
 #include <Modules.hh>
 #include <Signal/Module.hh>
 #include <Speech/Module.hh>
+#include <Speech/ParallelCorpusVisitor.hh>
 #include <cstdlib>
 #include <unistd.h>
 #ifdef MODULE_NN
@@ -81,14 +82,24 @@ public:
             std::cout << std::endl;
         }
         else {
-            Speech::CorpusProcessor* corpusProcessor = createCorpusProcessor();
-
-            Speech::CorpusVisitor corpusVisitor(config);
-            corpusProcessor->signOn(corpusVisitor);
             Bliss::CorpusDescription corpusDescription(select("corpus"));
-            corpusDescription.accept(&corpusVisitor);
+            if (Speech::ParallelCorpusVisitor::paramNumberOfThreads(config) > 1) {
+                // one processor (and flow network) per thread
+                Speech::ParallelCorpusVisitor corpusVisitor(config, [this]() { return createCorpusProcessor(); });
+                corpusVisitor.accept(corpusDescription);
+            }
+            else {
+                Speech::CorpusProcessor* corpusProcessor = createCorpusProcessor();
+
+                Speech::CorpusVisitor corpusVisitor(config);
+                corpusProcessor->signOn(corpusVisitor);
+                corpusDescription.accept(&corpusVisitor);
 
-            delete corpusProcessor;
+                delete corpusProcessor;
+            }
+            Core::XmlChannel allocationChannel(config, "data-allocation");
+            if (allocationChannel.isOpen())
+                Flow::Registry::instance().writeAllocationStatistics(allocationChannel);
         }
         return EXIT_SUCCESS;
     }
@@ -19,6 +19,7 @@
 
 #include <Flf/Module.hh>
 #include <Flow/Module.hh>
+#include <Lm/BackingOff.hh>
 #include <Lm/Module.hh>
 #include <Math/Module.hh>
 #include <Mc/Module.hh>
@@ -64,7 +65,8 @@ class LmUtilityTool : public Core::Application {
 public:
     enum Action {
         actionNotGiven,
-        actionComputePerplexityFromTextFile
+        actionComputePerplexityFromTextFile,
+        actionBuildImage
     };
 
     static const Core::Choice          choiceAction;
@@ -74,6 +76,7 @@ public:
     static const Core::ParameterString paramScoreFile;
     static const Core::ParameterInt    paramBatchSize;
     static const Core::ParameterBool   paramRenormalize;
+    static const Core::ParameterString paramImage;
 
     LmUtilityTool();
     virtual ~LmUtilityTool() = default;
@@ -82,19 +85,23 @@ public:
 
 private:
     void computePerplexityFromTextFile();
+    void buildImage();
 };
 
 APPLICATION(LmUtilityTool)
 
 // ---------- Implementations ----------
 
-const Core::Choice          LmUtilityTool::choiceAction("compute-perplexity-from-text-file", actionComputePerplexityFromTextFile, Core::Choice::endMark());
+const Core::Choice          LmUtilityTool::choiceAction("compute-perplexity-from-text-file", actionComputePerplexityFromTextFile,
+                                                    "build-image", actionBuildImage,
+                                                    Core::Choice::endMark());
 const Core::ParameterChoice LmUtilityTool::paramAction("action", &choiceAction, "action to perform", actionNotGiven);
 const Core::ParameterString LmUtilityTool::paramFile("file", "input file");
 const Core::ParameterString LmUtilityTool::paramEncoding("encoding", "the encoding of the input file", "utf8");
 const Core::ParameterString LmUtilityTool::paramScoreFile("score-file", "output path for word scores", "");
 const Core::ParameterInt    LmUtilityTool::paramBatchSize("batch-size", "number of sequences to process in one batch", 100);
 const Core::ParameterBool   LmUtilityTool::paramRenormalize("renormalize", "wether to renormalize the word probabiliies", false);
+const Core::ParameterString LmUtilityTool::paramImage("image", "output path of the language model image (build-image)", "");
 
 LmUtilityTool::LmUtilityTool()
         : Core::Application() {
@@ -118,6 +125,7 @@ LmUtilityTool::LmUtilityTool()
 int LmUtilityTool::main(std::vector<std::string> const& arguments) {
     switch (paramAction(config)) {
         case actionComputePerplexityFromTextFile: computePerplexityFromTextFile(); break;
+        case actionBuildImage: buildImage(); break;
         default:
         case actionNotGiven: error("no action given");
     }
@@ -188,3 +196,26 @@ void LmUtilityTool::computePerplexityFromTextFile() {
           << Core::XmlOpen("num-tokens") << num_tokens << Core::XmlClose("num-tokens")
           << Core::XmlOpen("perplexity") << ppl << Core::XmlClose("perplexity");
 }
+
+/**
+ * Reads a backing-off language model (e.g. ARPA) and writes it as binary
+ * image, which decoders can mount by setting the image parameter of the
+ * language model.  The language model itself should be configured
+ * without image, otherwise an existing image is mounted and copied.
+ */
+void LmUtilityTool::buildImage() {
+    std::string image = paramImage(config);
+    if (image.empty()) {
+        error("no image file given");
+        return;
+    }
+    Bliss::LexiconRef            lexicon(Bliss::Lexicon::create(select("lexicon")));
+    Core::Ref<Lm::LanguageModel> lm(Lm::Module::instance().createLanguageModel(select("lm"), lexicon));
+    Lm::BackingOffLm*            backingOffLm = dynamic_cast<Lm::BackingOffLm*>(lm.get());
+    if (!backingOffLm) {
+        error("language model is not a backing-off language model, images are not supported");
+        return;
+    }
+    if (backingOffLm->writeImage(image))
+        log("image file \"%s\" written", image.c_str());
+}
@@ -14,6 +14,7 @@
  */
 #include "NnTrainer.hh"
 
+#include <thread>
 #include <typeinfo>
 
 #include <Audio/Module.hh>
@@ -32,6 +33,7 @@
 #include <Nn/BufferedSegmentFeatureProcessor.hh>
 #include <Nn/FeatureScorer.hh>
 #include <Nn/Module.hh>
+#include <Nn/MultiStreamFeatureScorer.hh>
 #include <Nn/NeuralNetwork.hh>
 #include <Nn/NeuralNetworkTrainer.hh>
 #include <Nn/Prior.hh>
@@ -61,6 +63,7 @@ const Core::Choice NnTrainer::choiceAction(
         "get-log-prior-from-mixture-set", actionGetLogPriorFromMixtureSet,
         "estimate-mean-and-standard-deviation", actionEstimateMeanAndStandardDeviation,
         "show-statistics", actionShowStatistics,
+        "benchmark-multi-stream-scoring", actionBenchmarkMultiStreamScoring,
         Core::Choice::endMark());
 
 const Core::ParameterChoice NnTrainer::paramAction(
@@ -80,6 +83,12 @@ const Core::ParameterStringVector NnTrainer::paramStatisticsFiles(
 const Core::ParameterString NnTrainer::paramStatisticsFile(
         "statistics-file", "filename to read/write statistics from/to", "");
 
+const Core::ParameterIntVector NnTrainer::paramBenchmarkStreams(
+        "benchmark-streams", "numbers of concurrent streams to benchmark", ",", 1);
+
+const Core::ParameterInt NnTrainer::paramBenchmarkFrames(
+        "benchmark-frames", "number of frames scored per stream in the benchmark", 1000, 1);
+
 const Core::ParameterString NnTrainer::paramFilenameInit(
         "parameters-init", "Name of the file to save the initialization parameters to", "");
 
@@ -172,6 +181,9 @@ int NnTrainer::main(const std::vector<std::string>& arguments) {
             else
                 showStatistics<f64>();
             break;
+        case actionBenchmarkMultiStreamScoring:
+            benchmarkMultiStreamScoring();
+            break;
         default:
             criticalError("Action not given.");
             break;
@@ -362,6 +374,50 @@ void NnTrainer::getLogPriorFromMixtureSet() {
     prior.write();
 }
 
+void NnTrainer::benchmarkMultiStreamScoring() {
+    Core::Ref<Mm::MixtureSet> mixtureSet = Mm::Module::instance().readMixtureSet(select("mixture-set"));
+    if (!mixtureSet)
+        criticalError("failed to read mixture set");
+    std::vector<s32> nStreamsList = paramBenchmarkStreams(config);
+    if (nStreamsList.empty()) {
+        for (s32 n = 1; n <= 256; n *= 2)
+            nStreamsList.push_back(n);
+    }
+    const u32 nFrames = paramBenchmarkFrames(config);
+
+    for (u32 i = 0; i < nStreamsList.size(); ++i) {
+        const u32                               nStreams = nStreamsList[i];
+        Core::Ref<Nn::MultiStreamFeatureScorer> scorer(new Nn::MultiStreamFeatureScorer(select("feature-scorer"), mixtureSet));
+        Mm::FeatureDescription                  description(*this);
+        scorer->getFeatureDescription(description);
+        size_t dimension = 0;
+        description.mainStream().getValue(Mm::FeatureDescription::nameDimension, dimension);
+
+        std::uniform_real_distribution<Mm::FeatureType> distribution(-1.0, 1.0);
+        std::vector<Mm::FeatureVector>                  features(nStreams, Mm::FeatureVector(dimension));
+        for (u32 s = 0; s < nStreams; ++s)
+            for (u32 d = 0; d < dimension; ++d)
+                features[s][d] = distribution(Math::randomEngine);
+
+        Core::Timer timer;
+        timer.start();
+        std::vector<std::thread> threads;
+        for (u32 s = 0; s < nStreams; ++s) {
+            threads.push_back(std::thread([&scorer, &features, nFrames, s]() {
+                for (u32 t = 0; t < nFrames; ++t)
+                    scorer->getScorer(features[s]);
+                scorer->finalize();
+            }));
+        }
+        for (u32 s = 0; s < nStreams; ++s)
+            threads[s].join();
+        timer.stop();
+
+        // batch statistics are logged by the scorer
+        log("%d streams: %.1f frames per second", nStreams, nStreams * nFrames / std::max(timer.elapsed(), 1e-6f));
+    }
+}
+
 void NnTrainer::visitCorpus(Speech::CorpusProcessor& corpusProcessor) {
     Speech::CorpusVisitor corpusVisitor(select("corpus"));
     corpusProcessor.signOn(corpusVisitor);
@@ -36,7 +36,8 @@ public:
         actionCombineStatistics,
         actionGetLogPriorFromMixtureSet,
         actionEstimateMeanAndStandardDeviation,
-        actionShowStatistics
+        actionShowStatistics,
+        actionBenchmarkMultiStreamScoring
     };
     static const Core::Choice          choiceAction;
     static const Core::ParameterChoice paramAction;
@@ -47,6 +48,9 @@ public:
     // statistics IO
     static const Core::ParameterStringVector paramStatisticsFiles;
     static const Core::ParameterString       paramStatisticsFile;
+    // multi-stream scoring benchmark
+    static const Core::ParameterIntVector paramBenchmarkStreams;
+    static const Core::ParameterInt       paramBenchmarkFrames;
 
 private:
     void visitCorpus(Speech::CorpusProcessor&);
@@ -89,6 +93,9 @@ private:
     template<typename T>
     void showStatistics();
 
+    // throughput of the nn-multi-stream feature scorer for different numbers of concurrent streams
+    void benchmarkMultiStreamScoring();
+
 public:
     NnTrainer();
     virtual std::string getUsage() const {
@@ -24,6 +24,8 @@
 #include <Signal/Module.hh>
 #include <Speech/CorpusVisitor.hh>
 #include <Speech/Module.hh>
+#include <Speech/OnlineRecognizer.hh>
+#include <Speech/ParallelRecognizer.hh>
 #include <Speech/Recognizer.hh>
 #ifdef MODULE_NN
 #include <Nn/Module.hh>
@@ -60,6 +62,8 @@ public:
     enum RecognitionMode {
         offlineRecognition,
         offlineConstrainedRecognition,
+        offlineParallelRecognition,
+        onlineRecognitionSimulation,
     };
     static const Core::Choice          recognitionModeChoice;
     static const Core::ParameterChoice paramRecognitionMode;
@@ -73,6 +77,8 @@ APPLICATION(SpeechRecognizer)
 const Core::Choice SpeechRecognizer::recognitionModeChoice(
         "offline", offlineRecognition,
         "constrained", offlineConstrainedRecognition,
+        "parallel", offlineParallelRecognition,
+        "online-simulation", onlineRecognitionSimulation,
         Core::Choice::endMark());
 const Core::ParameterChoice SpeechRecognizer::paramRecognitionMode(
         "recognition-mode", &recognitionModeChoice,
@@ -82,7 +88,8 @@ const Core::ParameterChoice SpeechRecognizer::paramRecognitionMode(
 int SpeechRecognizer::main(const std::vector<std::string>& arguments) {
     switch (paramRecognitionMode(config)) {
         case offlineRecognition:
-        case offlineConstrainedRecognition: {
+        case offlineConstrainedRecognition:
+        case onlineRecognitionSimulation: {
             Speech::CorpusProcessor* processor = 0;
             switch (paramRecognitionMode(config)) {
                 case offlineRecognition:
@@ -91,6 +98,9 @@ int SpeechRecognizer::main(const std::vector<std::string>& arguments) {
                 case offlineConstrainedRecognition:
                     processor = new Speech::ConstrainedOfflineRecognizer(config);
                     break;
+                case onlineRecognitionSimulation:
+                    processor = new Speech::OnlineRecognitionSimulator(config);
+                    break;
                 default: defect();
             }
             verify(processor);
@@ -100,6 +110,11 @@ int SpeechRecognizer::main(const std::vector<std::string>& arguments) {
             corpusDescription.accept(&corpusVisitor);
             delete processor;
         } break;
+        case offlineParallelRecognition: {
+            Speech::ParallelOfflineRecognizer recognizer(config);
+            Bliss::CorpusDescription          corpusDescription(select("corpus"));
+            recognizer.recognize(corpusDescription);
+        } break;
         default: defect();
     }
     return 0;